@@ -712,7 +712,7 @@ egg_buffer_read_data (EggBuffer  *buffer,
 		return FALSE;
 
 	if ((buffer->pos + u) <= buffer->ar->len) {
-		m = g_malloc(u);
+		m = g_malloc(u + 1);
 		memcpy(m, &buffer->ar->data[buffer->pos], u);
 		m[u] = '\0';
 
@@ -791,6 +791,9 @@ static const gchar * ManagerIntrospection =
 	"  </method>"
 	"  <method name=\"GetPlugins\">"
     "   <arg name=\"plugins\" direction=\"out\" type=\"ao\"/>"
+	"  </method>"
+	"  <method name=\"GetSnapshot\">"
+    "   <arg name=\"snapshot\" direction=\"out\" type=\"ay\"/>"
 	"  </method>"
 	"  <method name=\"GetSources\">"
     "   <arg name=\"sources\" direction=\"out\" type=\"ao\"/>"
@@ -1159,6 +1162,54 @@ pka_listener_dbus_manager_get_plugins_cb (GObject      *listener,  /* IN */
 	EXIT;
 }
 
+/**
+ * pka_listener_dbus_manager_get_snapshot_cb:
+ * @listener: A #PkaListenerDBus.
+ * @result: A #GAsyncResult.
+ * @user_data: A #DBusMessage containing the incoming method call.
+ *
+ * Handles the completion of the "manager_get_snapshot" RPC.  A response
+ * to the message is created and sent as a reply to the caller.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pka_listener_dbus_manager_get_snapshot_cb (GObject      *listener,  /* IN */
+                                           GAsyncResult *result,    /* IN */
+                                           gpointer      user_data) /* IN */
+{
+	PkaListenerDBusPrivate *priv;
+	DBusMessage *message = user_data;
+	DBusMessage *reply = NULL;
+	GError *error = NULL;
+	guint8 *snapshot = NULL;
+	gsize snapshot_len = 0;
+
+	ENTRY;
+	priv = PKA_LISTENER_DBUS(listener)->priv;
+	if (!pka_listener_manager_get_snapshot_finish(
+			PKA_LISTENER(listener),
+			result,
+			&snapshot,
+			&snapshot_len,
+			&error)) {
+		reply = dbus_message_new_error(message, DBUS_ERROR_FAILED,
+		                               error->message);
+		g_error_free(error);
+	} else {
+		reply = dbus_message_new_method_return(message);
+		dbus_message_append_args(reply,
+		                         DBUS_TYPE_ARRAY, DBUS_TYPE_BYTE, &snapshot, snapshot_len,
+		                         DBUS_TYPE_INVALID);
+		g_free(snapshot);
+	}
+	dbus_connection_send(priv->dbus, reply, NULL);
+	dbus_message_unref(reply);
+	dbus_message_unref(message);
+	EXIT;
+}
+
 /**
  * pka_listener_dbus_manager_get_sources_cb:
  * @listener: A #PkaListenerDBus.
@@ -1664,6 +1715,17 @@ pka_listener_dbus_handle_manager_message (DBusConnection *connection, /* IN */
 			                                       dbus_message_ref(message));
 			ret = DBUS_HANDLER_RESULT_HANDLED;
 		}
+		else if (IS_MEMBER(message, "GetSnapshot")) {
+			if (!dbus_message_get_args(message, NULL,
+			                           DBUS_TYPE_INVALID)) {
+				GOTO(oom);
+			}
+			pka_listener_manager_get_snapshot_async(PKA_LISTENER(listener),
+			                                        NULL,
+			                                        pka_listener_dbus_manager_get_snapshot_cb,
+			                                        dbus_message_ref(message));
+			ret = DBUS_HANDLER_RESULT_HANDLED;
+		}
 		else if (IS_MEMBER(message, "GetSources")) {
 			if (!dbus_message_get_args(message, NULL,
 			                           DBUS_TYPE_INVALID)) {
@@ -590,6 +590,50 @@ pka_channel_add_source (PkaChannel  *channel, /* IN */
 	RETURN(ret);
 }
 
+/**
+ * pka_channel_remove_source:
+ * @channel: A #PkaChannel.
+ *
+ * Removes a source from the channel.  Subscriptions to the channel stop
+ * receiving its samples.  The source may then be added to another channel.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+pka_channel_remove_source (PkaChannel  *channel, /* IN */
+                           PkaContext  *context, /* IN */
+                           PkaSource   *source,  /* IN */
+                           GError     **error)   /* OUT */
+{
+	PkaChannelPrivate *priv;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(PKA_IS_CHANNEL(channel), FALSE);
+	g_return_val_if_fail(context != NULL, FALSE);
+	g_return_val_if_fail(PKA_IS_SOURCE(source), FALSE);
+
+	ENTRY;
+	priv = channel->priv;
+	AUTHORIZE_IOCTL(context, MODIFY_CHANNEL, channel, unauthorized);
+	g_mutex_lock(priv->mutex);
+	if (!g_ptr_array_remove(priv->sources, source)) {
+		g_set_error(error, PKA_CHANNEL_ERROR, PKA_CHANNEL_ERROR_STATE,
+		            "Source not attached to channel.");
+		GOTO(failed);
+	}
+	pka_source_unset_channel(source, channel);
+	ret = TRUE;
+  failed:
+	g_mutex_unlock(priv->mutex);
+	if (ret) {
+		g_signal_emit(channel, signals[SOURCE_REMOVED], 0, source);
+		g_object_unref(source);
+	}
+  unauthorized:
+	RETURN(ret);
+}
+
 /**
  * pka_channel_inferior_exited:
  * @pid: A #GPid.
@@ -997,6 +1041,8 @@ pka_channel_stop (PkaChannel  *channel, /* IN */
 {
 	PkaChannelPrivate *priv;
 	gboolean ret = TRUE;
+	GPtrArray *sources = NULL;
+	gint i;
 
 	ENTRY;
 
@@ -1012,11 +1058,15 @@ pka_channel_stop (PkaChannel  *channel, /* IN */
 		priv->state = PKA_CHANNEL_STOPPED;
 
 		/*
-		 * Notify sources of channel stopping.
+		 * Sources are notified of the channel stopping once the lock is
+		 * released, since sources such as the relay remove their child
+		 * sources from the channel when they stop.
 		 */
-		g_ptr_array_foreach(priv->sources,
-		                    (GFunc)pka_source_notify_stopped,
-		                    NULL);
+		sources = g_ptr_array_sized_new(priv->sources->len);
+		for (i = 0; i < priv->sources->len; i++) {
+			g_ptr_array_add(sources,
+			                g_object_ref(g_ptr_array_index(priv->sources, i)));
+		}
 
 		/*
 		 * Kill the process only if settings permit and we spawned the
@@ -1048,6 +1098,11 @@ pka_channel_stop (PkaChannel  *channel, /* IN */
 		g_warn_if_reached();
 	}
 	g_mutex_unlock(priv->mutex);
+	if (sources) {
+		g_ptr_array_foreach(sources, (GFunc)pka_source_notify_stopped, NULL);
+		g_ptr_array_foreach(sources, (GFunc)g_object_unref, NULL);
+		g_ptr_array_free(sources, TRUE);
+	}
 	if (ret) {
 		g_signal_emit(channel, signals[STOPPED], 0);
 	}
@@ -136,6 +136,10 @@ gboolean        pka_channel_add_source      (PkaChannel   *channel,
                                              PkaContext   *context,
                                              PkaSource    *source,
                                              GError      **error);
+gboolean        pka_channel_remove_source   (PkaChannel   *channel,
+                                             PkaContext   *context,
+                                             PkaSource    *source,
+                                             GError      **error);
 gboolean        pka_channel_start           (PkaChannel   *channel,
                                              PkaContext   *context,
                                              GTimeVal     *started_at,
@@ -85,6 +85,10 @@ pka_config_dump (void)
  * into memory and will be used in the future to access specific configuration
  * variables.  This method should only be called once.
  *
+ * If @filename is %NULL, no file is loaded and the defaults passed to the
+ * accessors are used.  This is the case when the agent is embedded in a
+ * client process.
+ *
  * See pka_config_get_string() and others.
  *
  * Side effects: The backing file for the configuration is loaded into global
@@ -107,7 +111,8 @@ pka_config_init (const gchar *filename)
 		 * GKeyFile as a backing store for our configuration queries.
 		 */
 
-		if (!g_key_file_load_from_file(keyfile, filename, 0, &error)) {
+		if (filename &&
+		    !g_key_file_load_from_file(keyfile, filename, 0, &error)) {
 			WARNING(Config, _("%s: Could not load configuration: %s"),
 			                G_STRLOC, error->message);
 			g_error_free(error);
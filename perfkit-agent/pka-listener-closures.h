@@ -175,6 +175,10 @@ typedef struct
 {
 } ManagerGetPluginsCall;
 
+typedef struct
+{
+} ManagerGetSnapshotCall;
+
 typedef struct
 {
 } ManagerGetSourcesCall;
@@ -545,6 +549,14 @@ ManagerGetPluginsCall_Free (ManagerGetPluginsCall *call) /* IN */
 	EXIT;
 }
 
+void
+ManagerGetSnapshotCall_Free (ManagerGetSnapshotCall *call) /* IN */
+{
+	ENTRY;
+	g_slice_free(ManagerGetSnapshotCall, call);
+	EXIT;
+}
+
 void
 ManagerGetSourcesCall_Free (ManagerGetSourcesCall *call) /* IN */
 {
@@ -952,6 +964,13 @@ ManagerGetPluginsCall_Create (void)
 	RETURN(g_slice_new0(ManagerGetPluginsCall));
 }
 
+ManagerGetSnapshotCall*
+ManagerGetSnapshotCall_Create (void)
+{
+	ENTRY;
+	RETURN(g_slice_new0(ManagerGetSnapshotCall));
+}
+
 ManagerGetSourcesCall*
 ManagerGetSourcesCall_Create (void)
 {
@@ -280,6 +280,15 @@ gboolean      pka_listener_manager_get_plugins_finish         (PkaListener
                                                                GAsyncResult          *result,
                                                                gchar               ***plugins,
                                                                GError               **error);
+void          pka_listener_manager_get_snapshot_async         (PkaListener           *listener,
+                                                               GCancellable          *cancellable,
+                                                               GAsyncReadyCallback    callback,
+                                                               gpointer               user_data);
+gboolean      pka_listener_manager_get_snapshot_finish        (PkaListener           *listener,
+                                                               GAsyncResult          *result,
+                                                               guint8               **snapshot,
+                                                               gsize                 *snapshot_len,
+                                                               GError               **error);
 void          pka_listener_manager_get_sources_async          (PkaListener           *listener,
                                                                GCancellable          *cancellable,
                                                                GAsyncReadyCallback    callback,
@@ -2480,6 +2480,76 @@ pka_listener_manager_get_plugins_finish (PkaListener    *listener, /* IN */
 	RETURN(ret);
 }
 
+/**
+ * pk_connection_manager_get_snapshot_async:
+ * @connection: A #PkConnection.
+ * @cancellable: A #GCancellable.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: A #gpointer.
+ *
+ * Asynchronously requests the "manager_get_snapshot_async" RPC.  @callback
+ * MUST call pka_listener_manager_get_snapshot_finish().
+ *
+ * Retrieves the latest manifest and sample of every source within the agent.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pka_listener_manager_get_snapshot_async (PkaListener           *listener,    /* IN */
+                                         GCancellable          *cancellable, /* IN */
+                                         GAsyncReadyCallback    callback,    /* IN */
+                                         gpointer               user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PKA_IS_LISTENER(listener));
+
+	ENTRY;
+	result = g_simple_async_result_new(G_OBJECT(listener),
+	                                   callback,
+	                                   user_data,
+	                                   pka_listener_manager_get_snapshot_async);
+	g_simple_async_result_complete(result);
+	g_object_unref(result);
+	EXIT;
+}
+
+/**
+ * pk_connection_manager_get_snapshot_finish:
+ * @connection: A #PkConnection.
+ * @result: A #GAsyncResult.
+ * @snapshot: A #guint8.
+ * @snapshot_len: A #gsize.
+ * @error: A #GError.
+ *
+ * Completes an asynchronous request for the "manager_get_snapshot_finish" RPC.
+ *
+ * Retrieves the latest manifest and sample of every source within the agent.
+ * See pka_manager_get_snapshot() for the format of @snapshot.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+gboolean
+pka_listener_manager_get_snapshot_finish (PkaListener    *listener,     /* IN */
+                                          GAsyncResult   *result,       /* IN */
+                                          guint8        **snapshot,     /* OUT */
+                                          gsize          *snapshot_len, /* OUT */
+                                          GError        **error)        /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PKA_IS_LISTENER(listener), FALSE);
+	g_return_val_if_fail(snapshot != NULL, FALSE);
+	g_return_val_if_fail(snapshot_len != NULL, FALSE);
+
+	ENTRY;
+	ret = pka_manager_get_snapshot(DEFAULT_CONTEXT, snapshot, snapshot_len,
+	                               error);
+	RETURN(ret);
+}
+
 /**
  * pk_connection_manager_get_sources_async:
  * @connection: A #PkConnection.
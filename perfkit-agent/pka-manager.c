@@ -314,6 +314,73 @@ pka_manager_shutdown (void)
 	G_UNLOCK(channels);
 }
 
+/**
+ * pka_manager_add_listener:
+ * @listener: A #PkaListener.
+ * @error: A location for a #GError or %NULL.
+ *
+ * Registers a listener that was created outside of the plugin system, such
+ * as one embedded within a client process.  The listener is started and
+ * notified of the available plugins just like the configured listeners.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: @listener is started.
+ */
+gboolean
+pka_manager_add_listener (PkaListener  *listener, /* IN */
+                          GError      **error)    /* OUT */
+{
+	PkaPlugin *plugin;
+	gint i;
+
+	g_return_val_if_fail(PKA_IS_LISTENER(listener), FALSE);
+
+	ENTRY;
+	if (!pka_listener_listen(listener, error)) {
+		RETURN(FALSE);
+	}
+	G_LOCK(plugins);
+	G_LOCK(listeners);
+	g_ptr_array_add(manager.listeners, g_object_ref(listener));
+	for (i = 0; i < manager.plugins->len; i++) {
+		plugin = g_ptr_array_index(manager.plugins, i);
+		if (pka_plugin_get_plugin_type(plugin) != PKA_PLUGIN_LISTENER) {
+			pka_listener_plugin_added(listener, pka_plugin_get_id(plugin));
+		}
+	}
+	G_UNLOCK(listeners);
+	G_UNLOCK(plugins);
+	RETURN(TRUE);
+}
+
+/**
+ * pka_manager_remove_listener:
+ * @listener: A #PkaListener.
+ *
+ * Unregisters a listener previously added with pka_manager_add_listener()
+ * and closes it.
+ *
+ * Returns: None.
+ * Side effects: @listener is closed.
+ */
+void
+pka_manager_remove_listener (PkaListener *listener) /* IN */
+{
+	gboolean removed;
+
+	g_return_if_fail(PKA_IS_LISTENER(listener));
+
+	ENTRY;
+	G_LOCK(listeners);
+	removed = g_ptr_array_remove(manager.listeners, listener);
+	G_UNLOCK(listeners);
+	if (removed) {
+		pka_listener_close(listener);
+		g_object_unref(listener);
+	}
+	EXIT;
+}
+
 /**
  * pka_manager_add_channel:
  * @context: A #PkaContext.
@@ -354,6 +421,58 @@ pka_manager_add_channel (PkaContext  *context, /* IN */
 	RETURN(TRUE);
 }
 
+/**
+ * pka_manager_add_child_source:
+ * @context: A #PkaContext.
+ * @parent: The #PkaSource that created @source.
+ * @source: A #PkaSource.
+ * @error: A location for a #GError or %NULL.
+ *
+ * Adds @source, created by @parent rather than from a plugin, to the
+ * Perfkit Agent.  This allows a source, such as the relay, to present each
+ * of the streams it produces as a source of its own.  @source reports the
+ * plugin of @parent and is attached to the channel of @parent, so that
+ * subscriptions to the channel receive its samples.
+ *
+ * The caller keeps its reference to @source.  The source should be removed
+ * with pka_manager_remove_child_source() once @parent no longer needs it.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+gboolean
+pka_manager_add_child_source (PkaContext  *context, /* IN */
+                              PkaSource   *parent,  /* IN */
+                              PkaSource   *source,  /* IN */
+                              GError     **error)   /* OUT */
+{
+	PkaChannel *channel;
+	gint source_id;
+
+	g_return_val_if_fail(context != NULL, FALSE);
+	g_return_val_if_fail(PKA_IS_SOURCE(parent), FALSE);
+	g_return_val_if_fail(PKA_IS_SOURCE(source), FALSE);
+
+	ENTRY;
+	AUTHORIZE_IOCTL(context, ADD_SOURCE);
+	pka_source_set_plugin(source, pka_source_get_plugin(parent));
+	if ((channel = pka_source_get_channel(parent))) {
+		if (!pka_channel_add_source(channel, context, source, error)) {
+			g_object_unref(channel);
+			RETURN(FALSE);
+		}
+		g_object_unref(channel);
+	}
+	source_id = pka_source_get_id(source);
+	INFO(Source, "Added source %d as a child of source %d.",
+	     source_id, pka_source_get_id(parent));
+	G_LOCK(sources);
+	g_ptr_array_add(manager.sources, g_object_ref(source));
+	G_UNLOCK(sources);
+	NOTIFY_LISTENERS(source_added, source_id);
+	RETURN(TRUE);
+}
+
 /**
  * pka_manager_add_encoder:
  * @context: A #PkaContext.
@@ -875,6 +994,55 @@ pka_manager_get_plugins (PkaContext  *context, /* IN */
 	RETURN(TRUE);
 }
 
+/**
+ * pka_manager_get_snapshot:
+ * @context: A #PkaContext.
+ * @snapshot: A location for the snapshot buffer.
+ * @snapshot_len: A location for the length of @snapshot.
+ * @error: A location for a #GError, or %NULL.
+ *
+ * Retrieves the latest manifest and sample of every source in the Perfkit
+ * Agent in a single buffer.  The buffer is the concatenation of the
+ * snapshots from pka_source_get_snapshot(); each source starts with its
+ * encoded manifest as field 1, optionally followed by its most recent
+ * encoded sample as field 2.  Sources which have not yet delivered a
+ * manifest are skipped.
+ *
+ * The caller owns the buffer and should free it with g_free().
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+pka_manager_get_snapshot (PkaContext  *context,      /* IN */
+                          guint8     **snapshot,     /* OUT */
+                          gsize       *snapshot_len, /* OUT */
+                          GError     **error)        /* OUT */
+{
+	PkaSource *source;
+	GByteArray *ar;
+	gint i;
+
+	g_return_val_if_fail(context != NULL, FALSE);
+	g_return_val_if_fail(snapshot != NULL, FALSE);
+	g_return_val_if_fail(snapshot_len != NULL, FALSE);
+
+	ENTRY;
+	ar = g_byte_array_new();
+	G_LOCK(sources);
+	for (i = 0; i < manager.sources->len; i++) {
+		source = g_ptr_array_index(manager.sources, i);
+		/*
+		 * TODO: Verify permissions.
+		 */
+		pka_source_get_snapshot(source, ar);
+	}
+	G_UNLOCK(sources);
+	*snapshot_len = ar->len;
+	*snapshot = g_byte_array_free(ar, FALSE);
+	RETURN(TRUE);
+}
+
 /**
  * pka_manager_get_sources:
  * @context: A #PkaContext.
@@ -1049,6 +1217,46 @@ pka_manager_remove_encoder (PkaContext  *context, /* IN */
 	RETURN(TRUE);
 }
 
+/**
+ * pka_manager_remove_child_source:
+ * @context: A #PkaContext.
+ * @parent: The #PkaSource that created @source.
+ * @source: A #PkaSource.
+ * @error: A location for a #GError, or %NULL.
+ *
+ * Removes @source, added with pka_manager_add_child_source(), from the
+ * channel of @parent and from the Perfkit Agent.  Subscriptions to the
+ * channel stop receiving it.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+gboolean
+pka_manager_remove_child_source (PkaContext  *context, /* IN */
+                                 PkaSource   *parent,  /* IN */
+                                 PkaSource   *source,  /* IN */
+                                 GError     **error)   /* OUT */
+{
+	PkaChannel *channel;
+
+	g_return_val_if_fail(context != NULL, FALSE);
+	g_return_val_if_fail(PKA_IS_SOURCE(parent), FALSE);
+	g_return_val_if_fail(PKA_IS_SOURCE(source), FALSE);
+
+	ENTRY;
+	AUTHORIZE_IOCTL(context, REMOVE_SOURCE);
+	INFO(Source, "Removing source %d, a child of source %d.",
+	     pka_source_get_id(source), pka_source_get_id(parent));
+	if ((channel = pka_source_get_channel(source))) {
+		if (!pka_channel_remove_source(channel, context, source, error)) {
+			g_object_unref(channel);
+			RETURN(FALSE);
+		}
+		g_object_unref(channel);
+	}
+	RETURN(pka_manager_remove_source(context, source, error));
+}
+
 /**
  * pka_manager_remove_source:
  * @context: A #PkaContext.
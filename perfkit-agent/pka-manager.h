@@ -37,6 +37,10 @@ G_BEGIN_DECLS
 gboolean pka_manager_add_channel         (PkaContext       *context,
                                           PkaChannel      **channel,
                                           GError          **error);
+gboolean pka_manager_add_child_source    (PkaContext       *context,
+                                          PkaSource        *parent,
+                                          PkaSource        *source,
+                                          GError          **error);
 gboolean pka_manager_add_encoder         (PkaContext       *context,
                                           PkaPlugin        *plugin,
                                           PkaEncoder      **encoder,
@@ -77,6 +81,10 @@ gboolean pka_manager_get_encoders        (PkaContext       *context,
 gboolean pka_manager_get_plugins         (PkaContext       *context,
                                           GList           **plugins,
                                           GError          **error);
+gboolean pka_manager_get_snapshot        (PkaContext       *context,
+                                          guint8          **snapshot,
+                                          gsize            *snapshot_len,
+                                          GError          **error);
 gboolean pka_manager_get_sources         (PkaContext       *context,
                                           GList           **sources,
                                           GError          **error);
@@ -86,6 +94,10 @@ gboolean pka_manager_get_subscriptions   (PkaContext       *context,
 gboolean pka_manager_remove_channel      (PkaContext       *context,
                                           PkaChannel       *channel,
                                           GError          **error);
+gboolean pka_manager_remove_child_source (PkaContext       *context,
+                                          PkaSource        *parent,
+                                          PkaSource        *source,
+                                          GError          **error);
 gboolean pka_manager_remove_encoder      (PkaContext       *context,
                                           PkaEncoder       *encoder,
                                           GError          **error);
@@ -20,6 +20,7 @@
 #define __PKA_PRIVATE_H__
 
 #include "pka-channel.h"
+#include "pka-listener.h"
 #include "pka-manifest.h"
 #include "pka-plugin.h"
 #include "pka-sample.h"
@@ -29,33 +30,41 @@
 
 G_BEGIN_DECLS
 
-void     pka_config_init                   (const gchar     *filename);
-void     pka_config_shutdown               (void);
-void     pka_log_init                      (gboolean         stdout_,
-                                            const gchar     *filename);
-void     pka_log_shutdown                  (void);
-void     pka_manager_init                  (void);
-void     pka_manager_quit                  (void);
-void     pka_manager_run                   (void);
-void     pka_manager_shutdown              (void);
-void     pka_manifest_set_source_id        (PkaManifest     *manifest,
-                                            gint             source_id);
-void     pka_sample_set_source_id          (PkaSample       *sample,
-                                            gint             source_id);
-void     pka_source_add_subscription       (PkaSource       *source,
-                                            PkaSubscription *subscription);
-void     pka_source_notify_muted           (PkaSource       *source);
-void     pka_source_notify_reset           (PkaSource       *source);
-void     pka_source_notify_started         (PkaSource       *source,
-                                            PkaSpawnInfo    *spawn_info);
-void     pka_source_notify_stopped         (PkaSource       *source);
-void     pka_source_notify_unmuted         (PkaSource       *source);
-void     pka_source_remove_subscription    (PkaSource       *source,
-                                            PkaSubscription *subscription);
-gboolean pka_source_set_channel            (PkaSource       *source,
-                                            PkaChannel      *channel);
-void     pka_source_set_plugin             (PkaSource       *source,
-                                            PkaPlugin       *plugin);
+void        pka_config_init                   (const gchar     *filename);
+void        pka_config_shutdown               (void);
+void        pka_log_init                      (gboolean         stdout_,
+                                               const gchar     *filename);
+void        pka_log_shutdown                  (void);
+gboolean    pka_manager_add_listener          (PkaListener     *listener,
+                                               GError         **error);
+void        pka_manager_init                  (void);
+void        pka_manager_quit                  (void);
+void        pka_manager_remove_listener       (PkaListener     *listener);
+void        pka_manager_run                   (void);
+void        pka_manager_shutdown              (void);
+void        pka_manifest_set_source_id        (PkaManifest     *manifest,
+                                               gint             source_id);
+void        pka_sample_set_source_id          (PkaSample       *sample,
+                                               gint             source_id);
+void        pka_source_add_subscription       (PkaSource       *source,
+                                               PkaSubscription *subscription);
+PkaChannel* pka_source_get_channel            (PkaSource       *source);
+gboolean    pka_source_get_snapshot           (PkaSource       *source,
+                                               GByteArray      *snapshot);
+void        pka_source_notify_muted           (PkaSource       *source);
+void        pka_source_notify_reset           (PkaSource       *source);
+void        pka_source_notify_started         (PkaSource       *source,
+                                               PkaSpawnInfo    *spawn_info);
+void        pka_source_notify_stopped         (PkaSource       *source);
+void        pka_source_notify_unmuted         (PkaSource       *source);
+void        pka_source_remove_subscription    (PkaSource       *source,
+                                               PkaSubscription *subscription);
+gboolean    pka_source_set_channel            (PkaSource       *source,
+                                               PkaChannel      *channel);
+void        pka_source_unset_channel          (PkaSource       *source,
+                                               PkaChannel      *channel);
+void        pka_source_set_plugin             (PkaSource       *source,
+                                               PkaPlugin       *plugin);
 
 G_END_DECLS
 
@@ -16,11 +16,14 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <egg-buffer.h>
 #include <glib.h>
 #include <glib-object.h>
 #include <glib/gi18n.h>
+#include <string.h>
 
 #include "pka-channel.h"
+#include "pka-encoder.h"
 #include "pka-log.h"
 #include "pka-private.h"
 #include "pka-source.h"
@@ -66,6 +69,11 @@ struct _PkaSourcePrivate
 	PkaManifest   *manifest;
 	GPtrArray     *subscriptions;
 	PkaChannel    *channel;
+
+	GStaticMutex   snapshot_mutex;
+	PkaSample     *last_sample;
+	guint8        *snapshot;
+	gsize          snapshot_len;
 };
 
 enum
@@ -296,6 +304,33 @@ pka_source_queue_reset (PkaSource *source) /* IN */
 	EXIT;
 }
 
+/**
+ * pka_source_get_channel:
+ * @source: A #PkaSource
+ *
+ * Internal method to retrieve the channel @source is attached to.
+ *
+ * Returns: A new reference to the #PkaChannel, which should be freed
+ *   with g_object_unref(), or %NULL if @source is not attached.
+ * Side effects: None.
+ */
+PkaChannel*
+pka_source_get_channel (PkaSource *source) /* IN */
+{
+	PkaSourcePrivate *priv;
+	PkaChannel *channel = NULL;
+
+	g_return_val_if_fail(PKA_IS_SOURCE(source), NULL);
+
+	priv = source->priv;
+	g_static_rw_lock_reader_lock(&priv->rw_lock);
+	if (priv->channel) {
+		channel = g_object_ref(priv->channel);
+	}
+	g_static_rw_lock_reader_unlock(&priv->rw_lock);
+	return channel;
+}
+
 /**
  * pka_source_set_channel:
  * @source: A #PkaSource
@@ -334,6 +369,87 @@ pka_source_set_channel (PkaSource  *source,  /* IN */
 	RETURN(ret);
 }
 
+/**
+ * pka_source_unset_channel:
+ * @source: A #PkaSource
+ * @channel: A #PkaChannel
+ *
+ * Internal method used by channels to detach themselves from a source
+ * that is removed from them.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pka_source_unset_channel (PkaSource  *source,  /* IN */
+                          PkaChannel *channel) /* IN */
+{
+	PkaSourcePrivate *priv;
+
+	g_return_if_fail(PKA_IS_SOURCE(source));
+	g_return_if_fail(PKA_IS_CHANNEL(channel));
+
+	ENTRY;
+	priv = source->priv;
+	g_static_rw_lock_writer_lock(&priv->rw_lock);
+	if (priv->channel == channel) {
+		g_object_remove_weak_pointer(G_OBJECT(priv->channel),
+		                             (gpointer *)&priv->channel);
+		priv->channel = NULL;
+	}
+	g_static_rw_lock_writer_unlock(&priv->rw_lock);
+	EXIT;
+}
+
+/**
+ * pka_source_replace_last_sample:
+ * @source: A #PkaSource.
+ * @sample: A #PkaSample or %NULL.
+ *
+ * Stores @sample as the most recent sample of @source and invalidates the
+ * encoded snapshot.  The snapshot mutex must be held.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pka_source_replace_last_sample (PkaSource *source, /* IN */
+                                PkaSample *sample) /* IN */
+{
+	PkaSourcePrivate *priv = source->priv;
+
+	if (priv->last_sample) {
+		pka_sample_unref(priv->last_sample);
+	}
+	priv->last_sample = sample ? pka_sample_ref(sample) : NULL;
+	g_free(priv->snapshot);
+	priv->snapshot = NULL;
+	priv->snapshot_len = 0;
+}
+
+/**
+ * pka_source_set_last_sample:
+ * @source: A #PkaSource.
+ * @sample: A #PkaSample or %NULL.
+ *
+ * Stores @sample as the most recent sample of @source for use by
+ * pka_source_get_snapshot().  The encoded snapshot is invalidated and
+ * will be rebuilt the next time it is requested.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pka_source_set_last_sample (PkaSource *source, /* IN */
+                            PkaSample *sample) /* IN */
+{
+	PkaSourcePrivate *priv = source->priv;
+
+	g_static_mutex_lock(&priv->snapshot_mutex);
+	pka_source_replace_last_sample(source, sample);
+	g_static_mutex_unlock(&priv->snapshot_mutex);
+}
+
 /**
  * pka_source_deliver_sample:
  * @source: a #PkaSource.
@@ -363,6 +479,7 @@ pka_source_deliver_sample (PkaSource *source, /* IN */
 	ENTRY;
 	priv = source->priv;
 	pka_sample_set_source_id(sample, priv->id);
+	pka_source_set_last_sample(source, sample);
 	/*
 	 * Notify subscribers of the incoming sample.
 	 * Reader lock required to ensure subscriptions integrity.
@@ -377,6 +494,58 @@ pka_source_deliver_sample (PkaSource *source, /* IN */
 	EXIT;
 }
 
+/**
+ * pka_source_deliver_samples:
+ * @source: A #PkaSource.
+ * @samples: An array of #PkaSample.
+ * @n_samples: The number of samples in @samples.
+ *
+ * Delivers a batch of samples to all observing subscriptions.  Each
+ * subscription encodes the batch into a single buffer, which is much
+ * cheaper than calling pka_source_deliver_sample() for every sample when
+ * a source produces samples in bursts.
+ *
+ * The caller retains its references to the samples in @samples.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pka_source_deliver_samples (PkaSource  *source,    /* IN */
+                            PkaSample **samples,   /* IN */
+                            guint       n_samples) /* IN */
+{
+	PkaSourcePrivate *priv;
+	PkaSubscription *subscription;
+	gint i;
+
+	g_return_if_fail(PKA_IS_SOURCE(source));
+	g_return_if_fail(samples != NULL || n_samples == 0);
+
+	ENTRY;
+	priv = source->priv;
+	if (!n_samples) {
+		EXIT;
+	}
+	for (i = 0; i < n_samples; i++) {
+		pka_sample_set_source_id(samples[i], priv->id);
+	}
+	pka_source_set_last_sample(source, samples[n_samples - 1]);
+	/*
+	 * Notify subscribers of the incoming samples.
+	 * Reader lock required to ensure subscriptions integrity.
+	 */
+	g_static_rw_lock_reader_lock(&priv->rw_lock);
+	for (i = 0; i < priv->subscriptions->len; i++) {
+		subscription = g_ptr_array_index(priv->subscriptions, i);
+		pka_subscription_deliver_samples(subscription, source,
+		                                 priv->manifest, samples,
+		                                 n_samples);
+	}
+	g_static_rw_lock_reader_unlock(&priv->rw_lock);
+	EXIT;
+}
+
 /**
  * pka_source_deliver_manifest:
  * @source: A #PkaSource.
@@ -407,15 +576,21 @@ pka_source_deliver_manifest (PkaSource   *source,   /* IN */
 	priv = source->priv;
 	pka_manifest_set_source_id(manifest, priv->id);
 	/*
-	 * Update our cached copy of the manifest.
+	 * Update our cached copy of the manifest.  The last sample was
+	 * described by the previous manifest, so it is dropped along with it
+	 * under the snapshot mutex; a snapshot never pairs the new manifest
+	 * with the old sample.
 	 * Requires write lock.
 	 */
+	g_static_mutex_lock(&priv->snapshot_mutex);
 	g_static_rw_lock_writer_lock(&priv->rw_lock);
 	if (priv->manifest) {
 		pka_manifest_unref(priv->manifest);
 	}
 	priv->manifest = pka_manifest_ref(manifest);
 	g_static_rw_lock_writer_unlock(&priv->rw_lock);
+	pka_source_replace_last_sample(source, NULL);
+	g_static_mutex_unlock(&priv->snapshot_mutex);
 	/*
 	 * Notify all of our subscribers of the new manifest.
 	 * Requires read lock to ensure subscription integrity.  I wish that
@@ -763,6 +938,70 @@ pka_source_get_manifest (PkaSource *source) /* IN */
 	RETURN(ret);
 }
 
+/**
+ * pka_source_get_snapshot:
+ * @source: A #PkaSource.
+ * @snapshot: A #GByteArray to append the snapshot to.
+ *
+ * Appends the encoded snapshot of @source to @snapshot.  The snapshot
+ * contains the current manifest as field 1 and, if a sample has been
+ * delivered since the manifest, the most recent sample as field 2.
+ *
+ * The snapshot is encoded once and cached until the next sample or
+ * manifest is delivered, so repeated requests only copy the cached
+ * buffer.
+ *
+ * Returns: %TRUE if @source has delivered a manifest; otherwise %FALSE.
+ * Side effects: The encoded snapshot is cached.
+ */
+gboolean
+pka_source_get_snapshot (PkaSource  *source,   /* IN */
+                         GByteArray *snapshot) /* IN */
+{
+	PkaSourcePrivate *priv;
+	PkaManifest *manifest;
+	EggBuffer *buffer;
+	const guint8 *tbuf;
+	guint8 *encoded;
+	gsize tlen;
+	gsize encoded_len;
+
+	g_return_val_if_fail(PKA_IS_SOURCE(source), FALSE);
+	g_return_val_if_fail(snapshot != NULL, FALSE);
+
+	ENTRY;
+	priv = source->priv;
+	g_static_mutex_lock(&priv->snapshot_mutex);
+	if (!(manifest = pka_source_get_manifest(source))) {
+		g_static_mutex_unlock(&priv->snapshot_mutex);
+		RETURN(FALSE);
+	}
+	if (!priv->snapshot) {
+		buffer = egg_buffer_new();
+		if (pka_encoder_encode_manifest(NULL, manifest,
+		                                &encoded, &encoded_len)) {
+			egg_buffer_write_tag(buffer, 1, EGG_BUFFER_DATA);
+			egg_buffer_write_data(buffer, encoded, encoded_len);
+			g_free(encoded);
+		}
+		if (priv->last_sample &&
+		    pka_encoder_encode_samples(NULL, manifest, &priv->last_sample, 1,
+		                               &encoded, &encoded_len)) {
+			egg_buffer_write_tag(buffer, 2, EGG_BUFFER_DATA);
+			egg_buffer_write_data(buffer, encoded, encoded_len);
+			g_free(encoded);
+		}
+		egg_buffer_get_buffer(buffer, &tbuf, &tlen);
+		priv->snapshot = g_memdup(tbuf, tlen);
+		priv->snapshot_len = tlen;
+		egg_buffer_unref(buffer);
+	}
+	g_byte_array_append(snapshot, priv->snapshot, priv->snapshot_len);
+	g_static_mutex_unlock(&priv->snapshot_mutex);
+	pka_manifest_unref(manifest);
+	RETURN(TRUE);
+}
+
 /**
  * pka_source_finalize:
  * @source: A #PkaSource.
@@ -781,6 +1020,11 @@ pka_source_finalize (GObject *object) /* IN */
 	if (priv->plugin) {
 		g_object_unref(priv->plugin);
 	}
+	if (priv->last_sample) {
+		pka_sample_unref(priv->last_sample);
+	}
+	g_free(priv->snapshot);
+	g_static_mutex_free(&priv->snapshot_mutex);
 	if (priv->channel) {
 		g_object_remove_weak_pointer(G_OBJECT(priv->channel),
 		                             (gpointer *)&priv->channel);
@@ -934,6 +1178,7 @@ pka_source_init (PkaSource *source) /* IN */
 	                                           PkaSourcePrivate);
 	source->priv->id = g_atomic_int_add(&id_seq, 1);
 	g_static_rw_lock_init(&source->priv->rw_lock);
+	g_static_mutex_init(&source->priv->snapshot_mutex);
 	/*
 	 * TODO:  We should consider doing a bit array for the list of which
 	 *   subscribers are listening to the source.  This would allow us to
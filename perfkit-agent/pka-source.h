@@ -79,6 +79,9 @@ gboolean     pka_source_conflicts         (PkaSource      *source,
                                            GError        **error);
 void         pka_source_deliver_sample    (PkaSource      *source,
                                            PkaSample      *sample);
+void         pka_source_deliver_samples   (PkaSource      *source,
+                                           PkaSample     **samples,
+                                           guint           n_samples);
 void         pka_source_deliver_manifest  (PkaSource      *source,
                                            PkaManifest    *manifest);
 gboolean     pka_source_modify_spawn_info (PkaSource     *source,
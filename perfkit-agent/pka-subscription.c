@@ -628,14 +628,43 @@ pka_subscription_deliver_sample (PkaSubscription *subscription, /* IN */
                                  PkaSource       *source,       /* IN */
                                  PkaManifest     *manifest,     /* IN */
                                  PkaSample       *sample)       /* IN */
+{
+	g_return_if_fail(sample != NULL);
+
+	ENTRY;
+	pka_subscription_deliver_samples(subscription, source, manifest,
+	                                 &sample, 1);
+	EXIT;
+}
+
+/**
+ * pka_subscription_deliver_samples:
+ * @subscription: A #PkaSubscription.
+ * @source: The #PkaSource the samples originated from.
+ * @manifest: The current manifest for @source.
+ * @samples: An array of #PkaSample.
+ * @n_samples: The number of samples in @samples.
+ *
+ * Delivers a batch of samples from @source to the @subscription.  The
+ * samples are encoded into a single buffer and the sample handler is
+ * invoked once for the entire batch.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pka_subscription_deliver_samples (PkaSubscription  *subscription, /* IN */
+                                  PkaSource        *source,       /* IN */
+                                  PkaManifest      *manifest,     /* IN */
+                                  PkaSample       **samples,      /* IN */
+                                  guint             n_samples)    /* IN */
 {
 	GValue params[3] = { { 0 } };
 	guint8 *buffer = NULL;
 	gsize buffer_len = 0;
-	PkaSample *samples[1] = { sample };
 
 	g_return_if_fail(subscription != NULL);
-	g_return_if_fail(sample != NULL);
+	g_return_if_fail(samples != NULL);
 	g_return_if_fail(PKA_IS_SOURCE(source));
 
 	/*
@@ -645,9 +674,12 @@ pka_subscription_deliver_sample (PkaSubscription *subscription, /* IN */
 	 */
 
 	ENTRY;
+	if (!n_samples) {
+		EXIT;
+	}
 	g_static_rw_lock_reader_lock(&subscription->rw_lock);
 	if (G_LIKELY(subscription->sample_closure)) {
-		if (!pka_encoder_encode_samples(NULL, manifest, samples, 1,
+		if (!pka_encoder_encode_samples(NULL, manifest, samples, n_samples,
 		                                &buffer, &buffer_len)) {
 			WARNING(Subscription, "Subscription %d failed to encode sample.",
 			        subscription->id);
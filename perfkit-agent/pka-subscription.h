@@ -108,6 +108,11 @@ void             pka_subscription_deliver_sample   (PkaSubscription  *subscripti
                                                     PkaSource        *source,
                                                     PkaManifest      *manifest,
                                                     PkaSample        *sample);
+void             pka_subscription_deliver_samples  (PkaSubscription  *subscription,
+                                                    PkaSource        *source,
+                                                    PkaManifest      *manifest,
+                                                    PkaSample       **samples,
+                                                    guint             n_samples);
 void             pka_subscription_deliver_manifest (PkaSubscription  *subscription,
                                                     PkaSource        *source,
                                                     PkaManifest      *manifest);
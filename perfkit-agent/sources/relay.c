@@ -0,0 +1,852 @@
+/* relay.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <perfkit/perfkit.h>
+#include <perfkit-agent/perfkit-agent.h>
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Relay"
+
+/*
+ * The relay source subscribes to the sources of other agents and serves
+ * their streams from the local agent.  This allows a single client
+ * connection to observe many agents at once.
+ *
+ * Every upstream source is mirrored by a source of its own in the local
+ * agent, added to the channel of the relay source.  Subscribing to that
+ * channel therefore receives each upstream stream under a local source id,
+ * with the manifest and samples of the upstream source unchanged, so that
+ * consumers of a particular kind of source can consume relayed streams
+ * too.  The mirror sources report the "Relay" plugin and are removed when
+ * the relay stops.
+ *
+ * The upstream agents are configured with the "agents" key of the
+ * [source.relay] group, separated by semicolons.  For example:
+ *
+ *   [source.relay]
+ *   agents = dbus://unix:path=/tmp/agent1;dbus://unix:path=/tmp/agent2
+ *
+ * Upstream agents are connected to asynchronously.  An agent that does not
+ * finish the handshake within "connect-timeout" seconds (10 by default),
+ * or that stops answering once subscribed, is dropped along with its
+ * mirrors and connected to again after "retry-interval" seconds (5 by
+ * default).  Subscribed agents are checked at the same interval.
+ *
+ * All of the upstream callbacks are dispatched from the main loop, so no
+ * locking is required for the relay state.
+ */
+
+#define RELAY_TYPE_SOURCE            (relay_get_type())
+#define RELAY_SOURCE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), RELAY_TYPE_SOURCE, Relay))
+#define RELAY_SOURCE_CONST(obj)      (G_TYPE_CHECK_INSTANCE_CAST ((obj), RELAY_TYPE_SOURCE, Relay const))
+#define RELAY_SOURCE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  RELAY_TYPE_SOURCE, RelayClass))
+#define RELAY_IS_SOURCE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), RELAY_TYPE_SOURCE))
+#define RELAY_IS_SOURCE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  RELAY_TYPE_SOURCE))
+#define RELAY_SOURCE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  RELAY_TYPE_SOURCE, RelayClass))
+
+#define RELAY_TYPE_MIRROR            (relay_mirror_get_type())
+
+typedef struct _Relay        Relay;
+typedef struct _RelayClass   RelayClass;
+typedef struct _RelayPrivate RelayPrivate;
+
+struct _Relay
+{
+	PkaSource parent;
+
+	/*< private >*/
+	RelayPrivate *priv;
+};
+
+struct _RelayClass
+{
+	PkaSourceClass parent_class;
+};
+
+G_DEFINE_TYPE(Relay, relay, PKA_TYPE_SOURCE)
+
+/*
+ * Mirror sources only deliver what the relay hands them, so they need
+ * nothing beyond PkaSource.
+ */
+typedef PkaSource      RelayMirror;
+typedef PkaSourceClass RelayMirrorClass;
+
+G_DEFINE_TYPE(RelayMirror, relay_mirror, PKA_TYPE_SOURCE)
+
+struct _RelayPrivate
+{
+	GPtrArray *upstreams; /* Connected upstream agents */
+	GPtrArray *origins;   /* Mirrored upstream sources */
+};
+
+typedef struct
+{
+	gint          ref_count;     /* Held by the relay and pending replies */
+	Relay        *relay;         /* Relay owning the upstream, or NULL */
+	gchar        *uri;           /* URI of the upstream agent */
+	PkConnection *connection;    /* Current connection attempt */
+	gulong        state_handler; /* "state-changed" handler on connection */
+	gchar        *hostname;      /* Hostname of the upstream agent */
+	gint         *sources;       /* Sources of the upstream agent */
+	gsize         n_sources;     /* Length of sources */
+	gsize         n_checked;     /* Sources whose plugin is known */
+	gsize         n_relayed;     /* Sources kept for relaying */
+	guint         timeout_id;    /* Connect timeout, retry or liveness check */
+	gboolean      pinging;       /* A liveness check is outstanding */
+	gint          consumer;      /* Shared subscription consumer */
+} RelayUpstream;
+
+typedef struct
+{
+	RelayUpstream *upstream;  /* Agent the source lives on */
+	gint           source_id; /* Source identifier on the upstream agent */
+	PkaSource     *mirror;    /* Local source mirroring the upstream one */
+	PkManifest    *manifest;  /* Latest manifest from upstream */
+} RelayOrigin;
+
+/*
+ * Find the origin for an upstream source, creating it and its mirror
+ * source if needed.
+ */
+static RelayOrigin*
+relay_get_origin (Relay         *relay,
+                  RelayUpstream *upstream,
+                  gint           source_id,
+                  gboolean       create)
+{
+	RelayPrivate *priv = relay->priv;
+	RelayOrigin *origin;
+	PkaSource *mirror;
+	GError *error = NULL;
+	gint i;
+
+	for (i = 0; i < priv->origins->len; i++) {
+		origin = g_ptr_array_index(priv->origins, i);
+		if (origin->upstream == upstream && origin->source_id == source_id) {
+			return origin;
+		}
+	}
+	if (!create) {
+		return NULL;
+	}
+	mirror = g_object_new(RELAY_TYPE_MIRROR, NULL);
+	if (!pka_manager_add_child_source(pka_context_default(),
+	                                  PKA_SOURCE(relay), mirror, &error)) {
+		WARNING(Relay, "Failed to mirror source %d of %s: %s",
+		        source_id, upstream->hostname, error->message);
+		g_error_free(error);
+		g_object_unref(mirror);
+		return NULL;
+	}
+	origin = g_slice_new0(RelayOrigin);
+	origin->upstream = upstream;
+	origin->source_id = source_id;
+	origin->mirror = mirror;
+	g_ptr_array_add(priv->origins, origin);
+	INFO(Relay, "Relaying source %d of %s as source %d.",
+	     source_id, upstream->hostname, pka_source_get_id(mirror));
+	return origin;
+}
+
+static void
+relay_origin_free (gpointer data)
+{
+	RelayOrigin *origin = data;
+
+	pka_manager_remove_child_source(pka_context_default(),
+	                                PKA_SOURCE(origin->upstream->relay),
+	                                origin->mirror, NULL);
+	g_object_unref(origin->mirror);
+	if (origin->manifest) {
+		pk_manifest_unref(origin->manifest);
+	}
+	g_slice_free(RelayOrigin, origin);
+}
+
+/*
+ * Store the latest manifest for an upstream source and deliver a copy of
+ * it from the mirror source.
+ */
+static RelayOrigin*
+relay_update_manifest (RelayUpstream *upstream,
+                       PkManifest    *manifest)
+{
+	RelayOrigin *origin;
+	PkaManifest *mirrored;
+	struct timespec ts;
+	gint n_rows;
+	gint i;
+
+	ENTRY;
+	if (!(origin = relay_get_origin(upstream->relay, upstream,
+	                                pk_manifest_get_source_id(manifest),
+	                                TRUE))) {
+		RETURN(NULL);
+	}
+	if (origin->manifest) {
+		pk_manifest_unref(origin->manifest);
+	}
+	origin->manifest = pk_manifest_ref(manifest);
+
+	n_rows = pk_manifest_get_n_rows(manifest);
+	mirrored = pka_manifest_sized_new(n_rows);
+	pk_manifest_get_timespec(manifest, &ts);
+	pka_manifest_set_timespec(mirrored, &ts);
+	pka_manifest_set_resolution(mirrored,
+	                            (PkaResolution)pk_manifest_get_resolution(manifest));
+	for (i = 1; i <= n_rows; i++) {
+		pka_manifest_append(mirrored,
+		                    pk_manifest_get_row_name(manifest, i),
+		                    pk_manifest_get_row_type(manifest, i));
+	}
+	pka_source_deliver_manifest(origin->mirror, mirrored);
+	pka_manifest_unref(mirrored);
+	RETURN(origin);
+}
+
+/*
+ * Copy the value of an upstream row into a mirrored sample.
+ */
+static void
+relay_append_value (PkaSample    *sample,
+                    gint          row,
+                    const GValue *value)
+{
+	switch (G_VALUE_TYPE(value)) {
+	case G_TYPE_INT:
+		pka_sample_append_int(sample, row, g_value_get_int(value));
+		break;
+	case G_TYPE_UINT:
+		pka_sample_append_uint(sample, row, g_value_get_uint(value));
+		break;
+	case G_TYPE_INT64:
+		pka_sample_append_int64(sample, row, g_value_get_int64(value));
+		break;
+	case G_TYPE_UINT64:
+		pka_sample_append_uint64(sample, row, g_value_get_uint64(value));
+		break;
+	case G_TYPE_FLOAT:
+		pka_sample_append_float(sample, row, g_value_get_float(value));
+		break;
+	case G_TYPE_DOUBLE:
+		pka_sample_append_double(sample, row, g_value_get_double(value));
+		break;
+	case G_TYPE_STRING:
+		pka_sample_append_string(sample, row, g_value_get_string(value));
+		break;
+	default:
+		DEBUG(Relay, "Cannot relay value of type %s",
+		      g_type_name(G_VALUE_TYPE(value)));
+		break;
+	}
+}
+
+/*
+ * Handle a manifest from an upstream agent.
+ */
+static void
+relay_manifest_cb (PkManifest *manifest,
+                   gpointer    user_data)
+{
+	ENTRY;
+	relay_update_manifest(user_data, manifest);
+	EXIT;
+}
+
+/*
+ * Handle a batch of samples from an upstream agent.  The samples of a
+ * batch share a manifest, and so an upstream source, and are delivered as
+ * a single batch from its mirror source.  Manifest changes arrive through
+ * relay_manifest_cb(), so the manifest is only delivered here if the
+ * samples beat it.
+ */
+static void
+relay_samples_cb (PkManifest  *manifest,
+                  PkSample   **samples,
+                  guint        n_samples,
+                  gpointer     user_data)
+{
+	RelayUpstream *upstream = user_data;
+	RelayOrigin *origin;
+	PkaSample **relayed;
+	struct timespec ts;
+	GValue value = { 0 };
+	gint n_rows;
+	gint i;
+	gint j;
+
+	ENTRY;
+	origin = relay_get_origin(upstream->relay, upstream,
+	                          pk_manifest_get_source_id(manifest), FALSE);
+	if (!origin || !origin->manifest) {
+		if (!(origin = relay_update_manifest(upstream, manifest))) {
+			EXIT;
+		}
+	}
+	n_rows = pk_manifest_get_n_rows(manifest);
+	relayed = g_new(PkaSample*, n_samples);
+	for (i = 0; i < n_samples; i++) {
+		relayed[i] = pka_sample_new();
+		pk_sample_get_timespec(samples[i], &ts);
+		pka_sample_set_timespec(relayed[i], &ts);
+		for (j = 1; j <= n_rows; j++) {
+			if (pk_sample_get_value(samples[i], j, &value)) {
+				relay_append_value(relayed[i], j, &value);
+				g_value_unset(&value);
+			}
+		}
+	}
+	pka_source_deliver_samples(origin->mirror, relayed, n_samples);
+	for (i = 0; i < n_samples; i++) {
+		pka_sample_unref(relayed[i]);
+	}
+	g_free(relayed);
+	EXIT;
+}
+
+static RelayUpstream*
+relay_upstream_new (Relay       *relay,
+                    const gchar *uri)
+{
+	RelayUpstream *upstream;
+
+	upstream = g_slice_new0(RelayUpstream);
+	upstream->ref_count = 1;
+	upstream->relay = relay;
+	upstream->uri = g_strdup(uri);
+	upstream->hostname = g_strdup(uri);
+	upstream->consumer = -1;
+	return upstream;
+}
+
+static RelayUpstream*
+relay_upstream_ref (RelayUpstream *upstream)
+{
+	g_return_val_if_fail(upstream->ref_count > 0, NULL);
+
+	upstream->ref_count++;
+	return upstream;
+}
+
+static void
+relay_upstream_unref (gpointer data)
+{
+	RelayUpstream *upstream = data;
+
+	g_return_if_fail(upstream->ref_count > 0);
+
+	if (--upstream->ref_count == 0) {
+		g_assert(!upstream->connection);
+		g_free(upstream->uri);
+		g_free(upstream->hostname);
+		g_slice_free(RelayUpstream, upstream);
+	}
+}
+
+/*
+ * Check that an asynchronous reply belongs to the current connection
+ * attempt of a running upstream.  Replies to attempts that have since
+ * been dropped are ignored.
+ */
+static inline gboolean
+relay_upstream_is_current (RelayUpstream *upstream,
+                           GObject       *object)
+{
+	return upstream->relay &&
+	       upstream->connection &&
+	       upstream->connection == PK_CONNECTION(object);
+}
+
+/*
+ * Tear down the current connection attempt of an upstream, removing the
+ * mirrors of its sources and releasing its subscription.
+ */
+static void
+relay_upstream_drop (RelayUpstream *upstream)
+{
+	RelayPrivate *priv = upstream->relay->priv;
+	RelayOrigin *origin;
+	GError *error = NULL;
+	gint i;
+
+	ENTRY;
+	if (upstream->timeout_id) {
+		g_source_remove(upstream->timeout_id);
+		upstream->timeout_id = 0;
+	}
+	for (i = priv->origins->len; i > 0; i--) {
+		origin = g_ptr_array_index(priv->origins, i - 1);
+		if (origin->upstream == upstream) {
+			g_ptr_array_remove_index(priv->origins, i - 1);
+			relay_origin_free(origin);
+		}
+	}
+	if (upstream->consumer >= 0) {
+		if (!pk_connection_subscription_release(upstream->connection,
+		                                        upstream->consumer,
+		                                        &error)) {
+			WARNING(Relay, "Failed to release subscription on %s: %s",
+			        upstream->hostname, error->message);
+			g_clear_error(&error);
+		}
+		upstream->consumer = -1;
+	}
+	if (upstream->connection) {
+		g_signal_handler_disconnect(upstream->connection,
+		                            upstream->state_handler);
+		g_object_unref(upstream->connection);
+		upstream->connection = NULL;
+	}
+	g_free(upstream->sources);
+	upstream->sources = NULL;
+	upstream->n_sources = 0;
+	upstream->n_checked = 0;
+	upstream->n_relayed = 0;
+	upstream->pinging = FALSE;
+	EXIT;
+}
+
+static void relay_upstream_connect (RelayUpstream *upstream);
+
+static gboolean
+relay_upstream_retry_cb (gpointer data)
+{
+	RelayUpstream *upstream = data;
+
+	upstream->timeout_id = 0;
+	relay_upstream_connect(upstream);
+	return FALSE;
+}
+
+/*
+ * Drop the current connection attempt and try again after the configured
+ * retry interval.
+ */
+static void
+relay_upstream_retry (RelayUpstream *upstream)
+{
+	gint interval;
+
+	relay_upstream_drop(upstream);
+	interval = pka_config_get_integer("source.relay", "retry-interval", 5);
+	INFO(Relay, "Reconnecting to %s in %d seconds.", upstream->uri, interval);
+	upstream->timeout_id = g_timeout_add_seconds(MAX(interval, 1),
+	                                             relay_upstream_retry_cb,
+	                                             upstream);
+}
+
+/*
+ * Handle the reply to a liveness check of a subscribed upstream.
+ */
+static void
+relay_upstream_ping_cb (GObject      *object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+	RelayUpstream *upstream = user_data;
+	GError *error = NULL;
+	gchar *hostname = NULL;
+
+	ENTRY;
+	if (relay_upstream_is_current(upstream, object)) {
+		upstream->pinging = FALSE;
+		if (!pk_connection_manager_get_hostname_finish(
+				upstream->connection, result, &hostname, &error)) {
+			WARNING(Relay, "Lost connection to %s: %s",
+			        upstream->hostname, error->message);
+			g_error_free(error);
+			relay_upstream_retry(upstream);
+		}
+		g_free(hostname);
+	}
+	relay_upstream_unref(upstream);
+	EXIT;
+}
+
+/*
+ * Periodically check that a subscribed upstream is still answering, since
+ * a connection does not notice on its own when the agent goes away.
+ */
+static gboolean
+relay_upstream_watch_cb (gpointer data)
+{
+	RelayUpstream *upstream = data;
+
+	if (!upstream->pinging) {
+		upstream->pinging = TRUE;
+		pk_connection_manager_get_hostname_async(upstream->connection, NULL,
+		                                         relay_upstream_ping_cb,
+		                                         relay_upstream_ref(upstream));
+	}
+	return TRUE;
+}
+
+/*
+ * Subscribe to the sources of an upstream once they are known.  The
+ * connection timeout is replaced by the liveness check.
+ */
+static void
+relay_upstream_subscribe (RelayUpstream *upstream)
+{
+	GError *error = NULL;
+	gint interval;
+
+	ENTRY;
+	if (upstream->timeout_id) {
+		g_source_remove(upstream->timeout_id);
+		upstream->timeout_id = 0;
+	}
+	if (!pk_connection_subscription_acquire(
+			upstream->connection, upstream->sources, upstream->n_relayed, 0,
+			pka_config_get_integer("source.relay", "buffer-size", 0),
+			pka_config_get_integer("source.relay", "buffer-timeout", 250),
+			relay_manifest_cb, relay_samples_cb, upstream, NULL,
+			&upstream->consumer, &error)) {
+		WARNING(Relay, "Failed to subscribe to %s: %s",
+		        upstream->hostname, error->message);
+		g_error_free(error);
+		relay_upstream_retry(upstream);
+		EXIT;
+	}
+	INFO(Relay, "Subscribed to %d sources of %s.",
+	     (gint)upstream->n_relayed, upstream->hostname);
+	interval = pka_config_get_integer("source.relay", "retry-interval", 5);
+	upstream->timeout_id = g_timeout_add_seconds(MAX(interval, 1),
+	                                             relay_upstream_watch_cb,
+	                                             upstream);
+	EXIT;
+}
+
+/*
+ * Handle the plugin of an upstream source.  Relay sources on the upstream
+ * agent are skipped so that two relays, or a relay pointed at its own
+ * agent, cannot feed each other forever.  The plugins are requested one
+ * source at a time.
+ */
+static void
+relay_upstream_get_plugin_cb (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+	RelayUpstream *upstream = user_data;
+	gint source_id;
+	gchar *plugin = NULL;
+
+	ENTRY;
+	if (!relay_upstream_is_current(upstream, object)) {
+		GOTO(finish);
+	}
+	source_id = upstream->sources[upstream->n_checked++];
+	if (!pk_connection_source_get_plugin_finish(upstream->connection,
+	                                            result, &plugin, NULL) ||
+	    g_strcmp0(plugin, "Relay") != 0) {
+		upstream->sources[upstream->n_relayed++] = source_id;
+	}
+	g_free(plugin);
+	if (upstream->n_checked < upstream->n_sources) {
+		pk_connection_source_get_plugin_async(
+				upstream->connection,
+				upstream->sources[upstream->n_checked], NULL,
+				relay_upstream_get_plugin_cb,
+				relay_upstream_ref(upstream));
+		GOTO(finish);
+	}
+	relay_upstream_subscribe(upstream);
+  finish:
+	relay_upstream_unref(upstream);
+	EXIT;
+}
+
+static void
+relay_upstream_get_sources_cb (GObject      *object,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+	RelayUpstream *upstream = user_data;
+	GError *error = NULL;
+
+	ENTRY;
+	if (!relay_upstream_is_current(upstream, object)) {
+		GOTO(finish);
+	}
+	if (!pk_connection_manager_get_sources_finish(upstream->connection,
+	                                              result,
+	                                              &upstream->sources,
+	                                              &upstream->n_sources,
+	                                              &error)) {
+		WARNING(Relay, "Failed to list the sources of %s: %s",
+		        upstream->hostname, error->message);
+		g_error_free(error);
+		relay_upstream_retry(upstream);
+		GOTO(finish);
+	}
+	if (!upstream->n_sources) {
+		relay_upstream_subscribe(upstream);
+		GOTO(finish);
+	}
+	pk_connection_source_get_plugin_async(upstream->connection,
+	                                      upstream->sources[0], NULL,
+	                                      relay_upstream_get_plugin_cb,
+	                                      relay_upstream_ref(upstream));
+  finish:
+	relay_upstream_unref(upstream);
+	EXIT;
+}
+
+static void
+relay_upstream_get_hostname_cb (GObject      *object,
+                                GAsyncResult *result,
+                                gpointer      user_data)
+{
+	RelayUpstream *upstream = user_data;
+	gchar *hostname = NULL;
+
+	ENTRY;
+	if (!relay_upstream_is_current(upstream, object)) {
+		GOTO(finish);
+	}
+	if (pk_connection_manager_get_hostname_finish(upstream->connection,
+	                                              result, &hostname, NULL)) {
+		g_free(upstream->hostname);
+		upstream->hostname = hostname;
+	}
+	pk_connection_manager_get_sources_async(upstream->connection, NULL,
+	                                        relay_upstream_get_sources_cb,
+	                                        relay_upstream_ref(upstream));
+  finish:
+	relay_upstream_unref(upstream);
+	EXIT;
+}
+
+static void
+relay_upstream_connect_cb (GObject      *object,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+	RelayUpstream *upstream = user_data;
+	GError *error = NULL;
+
+	ENTRY;
+	if (!relay_upstream_is_current(upstream, object)) {
+		GOTO(finish);
+	}
+	if (!pk_connection_connect_finish(upstream->connection, result, &error)) {
+		WARNING(Relay, "Failed to connect to %s: %s",
+		        upstream->uri, error->message);
+		g_error_free(error);
+		relay_upstream_retry(upstream);
+		GOTO(finish);
+	}
+	pk_connection_manager_get_hostname_async(upstream->connection, NULL,
+	                                         relay_upstream_get_hostname_cb,
+	                                         relay_upstream_ref(upstream));
+  finish:
+	relay_upstream_unref(upstream);
+	EXIT;
+}
+
+/*
+ * Give up on an upstream that did not finish connecting in time.  Late
+ * replies to the abandoned attempt are ignored.
+ */
+static gboolean
+relay_upstream_timeout_cb (gpointer data)
+{
+	RelayUpstream *upstream = data;
+
+	WARNING(Relay, "Timed out connecting to %s.", upstream->uri);
+	upstream->timeout_id = 0;
+	relay_upstream_retry(upstream);
+	return FALSE;
+}
+
+/*
+ * Reconnect when a subscribed upstream reports that its connection went
+ * away.
+ */
+static void
+relay_upstream_state_changed_cb (PkConnection *connection,
+                                 guint         state,
+                                 gpointer      user_data)
+{
+	RelayUpstream *upstream = user_data;
+
+	ENTRY;
+	if (state != PK_CONNECTION_CONNECTED && upstream->consumer >= 0) {
+		WARNING(Relay, "Lost connection to %s.", upstream->hostname);
+		relay_upstream_retry(upstream);
+	}
+	EXIT;
+}
+
+/*
+ * Start connecting to an upstream agent.  Each step of the handshake is
+ * asynchronous so that an unreachable agent cannot stall the agent main
+ * loop, and the whole handshake must finish within the configured
+ * timeout.
+ */
+static void
+relay_upstream_connect (RelayUpstream *upstream)
+{
+	gint timeout;
+
+	ENTRY;
+	if (!(upstream->connection = pk_connection_new_from_uri(upstream->uri))) {
+		WARNING(Relay, "No connection protocol for %s", upstream->uri);
+		EXIT;
+	}
+	upstream->state_handler =
+		g_signal_connect(upstream->connection, "state-changed",
+		                 G_CALLBACK(relay_upstream_state_changed_cb),
+		                 upstream);
+	timeout = pka_config_get_integer("source.relay", "connect-timeout", 10);
+	upstream->timeout_id = g_timeout_add_seconds(MAX(timeout, 1),
+	                                             relay_upstream_timeout_cb,
+	                                             upstream);
+	if (pk_connection_is_connected(upstream->connection)) {
+		pk_connection_manager_get_hostname_async(
+				upstream->connection, NULL,
+				relay_upstream_get_hostname_cb,
+				relay_upstream_ref(upstream));
+		EXIT;
+	}
+	pk_connection_connect_async(upstream->connection, NULL,
+	                            relay_upstream_connect_cb,
+	                            relay_upstream_ref(upstream));
+	EXIT;
+}
+
+static void
+relay_started (PkaSource    *source,
+               PkaSpawnInfo *spawn_info)
+{
+	RelayPrivate *priv = RELAY_SOURCE(source)->priv;
+	RelayUpstream *upstream;
+	gchar **uris;
+	gchar *agents;
+	gint i;
+
+	ENTRY;
+	agents = pka_config_get_string("source.relay", "agents", NULL);
+	if (!agents) {
+		WARNING(Relay, "No upstream agents have been configured.");
+		EXIT;
+	}
+	uris = g_strsplit(agents, ";", 0);
+	for (i = 0; uris[i]; i++) {
+		g_strstrip(uris[i]);
+		if (!uris[i][0]) {
+			continue;
+		}
+		upstream = relay_upstream_new(RELAY_SOURCE(source), uris[i]);
+		g_ptr_array_add(priv->upstreams, upstream);
+		relay_upstream_connect(upstream);
+	}
+	g_strfreev(uris);
+	g_free(agents);
+	EXIT;
+}
+
+static void
+relay_stopped (PkaSource *source)
+{
+	RelayPrivate *priv = RELAY_SOURCE(source)->priv;
+	RelayUpstream *upstream;
+	gint i;
+
+	ENTRY;
+	/*
+	 * Upstreams may still be referenced by pending replies, which notice
+	 * that the upstream was detached from the relay and ignore them.
+	 */
+	for (i = 0; i < priv->upstreams->len; i++) {
+		upstream = g_ptr_array_index(priv->upstreams, i);
+		relay_upstream_drop(upstream);
+		upstream->relay = NULL;
+		relay_upstream_unref(upstream);
+	}
+	g_ptr_array_set_size(priv->upstreams, 0);
+	EXIT;
+}
+
+static void
+relay_finalize (GObject *object)
+{
+	RelayPrivate *priv = RELAY_SOURCE(object)->priv;
+
+	ENTRY;
+	relay_stopped(PKA_SOURCE(object));
+	g_ptr_array_free(priv->origins, TRUE);
+	g_ptr_array_free(priv->upstreams, TRUE);
+	G_OBJECT_CLASS(relay_parent_class)->finalize(object);
+	EXIT;
+}
+
+static void
+relay_class_init (RelayClass *klass)
+{
+	GObjectClass *object_class;
+	PkaSourceClass *source_class;
+
+	object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = relay_finalize;
+	g_type_class_add_private(object_class, sizeof(RelayPrivate));
+
+	source_class = PKA_SOURCE_CLASS(klass);
+	source_class->started = relay_started;
+	source_class->stopped = relay_stopped;
+}
+
+static void
+relay_mirror_class_init (RelayMirrorClass *klass)
+{
+}
+
+static void
+relay_mirror_init (RelayMirror *mirror)
+{
+}
+
+static void
+relay_init (Relay *relay)
+{
+	relay->priv = G_TYPE_INSTANCE_GET_PRIVATE(relay, RELAY_TYPE_SOURCE,
+	                                          RelayPrivate);
+	relay->priv->upstreams = g_ptr_array_new();
+	relay->priv->origins = g_ptr_array_new();
+}
+
+GObject *
+relay_new (GError **error)
+{
+	return g_object_new(RELAY_TYPE_SOURCE, NULL);
+}
+
+const PkaPluginInfo pka_plugin_info = {
+	.id          = "Relay",
+	.name        = "Agent relay",
+	.description = "This source serves the sources of other agents from "
+	               "the local agent so they may be observed from one "
+	               "connection.",
+	.version     = "0.1.1",
+	.copyright   = "Christian Hergert",
+	.factory     = relay_new,
+	.plugin_type = PKA_PLUGIN_SOURCE,
+};
@@ -22,6 +22,7 @@
 #include "ppg-color.h"
 #include "ppg-cpu-instrument.h"
 #include "ppg-log.h"
+#include "ppg-renderer-heatmap.h"
 #include "ppg-renderer-line.h"
 #include "ppg-util.h"
 #include "ppg-visualizer-simple.h"
@@ -29,6 +30,12 @@
 #undef G_LOG_DOMAIN
 #define G_LOG_DOMAIN "Cpu"
 
+/*
+ * The heatmap grows to give every CPU at least one pixel row, but is never
+ * shorter than HEATMAP_MIN_HEIGHT.
+ */
+#define HEATMAP_MIN_HEIGHT (25.0)
+
 
 struct _PpgCpuInstrumentPrivate
 {
@@ -37,8 +44,11 @@ struct _PpgCpuInstrumentPrivate
 		GHashTable *models;    /* Models (one per cpu) */
 		gint        cpu_row;   /* CPU row id */
 	} combined;
+	struct {
+		GPtrArray  *visualizers; /* Heatmaps in use */
+	} heatmap;
 	gint  source;              /* Perfkit cpu source id. */
-	gint  subscription;        /* Perfkit subscription id. */
+	gint  consumer;            /* Perfkit subscription consumer id. */
 };
 
 
@@ -116,6 +126,133 @@ ppg_cpu_instrument_renderer_disposed (gpointer  user_data,
 }
 
 
+/**
+ * ppg_cpu_instrument_heatmap_disposed:
+ * @user_data: (in): A #PpgCpuInstrument.
+ * @visualizer: (in): The location of the visualizer.
+ *
+ * Handles notification of a heatmap visualizer being disposed. The
+ * visualizer is removed from the instruments list of heatmaps.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_cpu_instrument_heatmap_disposed (gpointer  user_data,
+                                     GObject  *visualizer)
+{
+	PpgCpuInstrumentPrivate *priv;
+	g_return_if_fail(PPG_IS_CPU_INSTRUMENT(user_data));
+	priv = PPG_CPU_INSTRUMENT(user_data)->priv;
+	g_ptr_array_remove(priv->heatmap.visualizers, visualizer);
+}
+
+
+/**
+ * ppg_cpu_instrument_heatmap_append:
+ * @visualizer: (in): A heatmap #PpgVisualizer.
+ * @model: (in): The #PkModel of a CPU.
+ *
+ * Adds a row for the CPU to the heatmap and grows the heatmap so that
+ * each CPU keeps at least a pixel row.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_cpu_instrument_heatmap_append (PpgVisualizer *visualizer,
+                                   PkModel       *model)
+{
+	PpgRendererHeatmap *renderer;
+	guint n_rows;
+
+	renderer = g_object_get_data(G_OBJECT(visualizer), "heatmap.renderer");
+	ppg_renderer_heatmap_append(renderer, model, percent_quark);
+	n_rows = ppg_renderer_heatmap_get_rows(renderer);
+	g_object_set(visualizer,
+	             "natural-height", MAX(HEATMAP_MIN_HEIGHT, (gdouble)n_rows),
+	             NULL);
+}
+
+
+/**
+ * ppg_cpu_instrument_compare_cpu:
+ * @a: (in): A pointer to a CPU number.
+ * @b: (in): A pointer to a CPU number.
+ *
+ * Compares two CPU numbers so that CPUs can be listed in order.
+ *
+ * Returns: Less than, equal to, or greater than zero.
+ * Side effects: None.
+ */
+static gint
+ppg_cpu_instrument_compare_cpu (gconstpointer a,
+                                gconstpointer b)
+{
+	return *(const gint *)a - *(const gint *)b;
+}
+
+
+/**
+ * ppg_cpu_instrument_heatmap_cb:
+ * @instrument: (in): A #PpgCpuInstrument.
+ *
+ * Handles a callback to create the "heatmap" visualizer. Each CPU is a
+ * row of the heatmap, shaded by its utilization over time.
+ *
+ * Returns: A newly created #PpgVisualizer.
+ * Side effects: None.
+ */
+static PpgVisualizer*
+ppg_cpu_instrument_heatmap_cb (PpgVisualizerEntry  *entry,
+                               PpgCpuInstrument    *instrument,
+                               GError             **error)
+{
+	PpgCpuInstrumentPrivate *priv;
+	PpgRendererHeatmap *renderer;
+	PpgVisualizer *visualizer;
+	GList *cpus;
+	GList *iter;
+
+	ENTRY;
+
+	g_return_val_if_fail(PPG_IS_CPU_INSTRUMENT(instrument), NULL);
+
+	priv = instrument->priv;
+
+	renderer = g_object_new(PPG_TYPE_RENDERER_HEATMAP, NULL);
+	visualizer = g_object_new(PPG_TYPE_VISUALIZER_SIMPLE,
+	                          "name", "heatmap",
+	                          "natural-height", HEATMAP_MIN_HEIGHT,
+	                          "renderer", renderer,
+	                          "title", _("CPU Usage per Core"),
+	                          NULL);
+	g_object_set_data(G_OBJECT(visualizer), "heatmap.renderer", renderer);
+
+	/*
+	 * Store a reference so we can add rows as CPUs are discovered.
+	 */
+	g_ptr_array_add(priv->heatmap.visualizers, visualizer);
+	g_object_weak_ref(G_OBJECT(visualizer),
+	                  ppg_cpu_instrument_heatmap_disposed,
+	                  instrument);
+
+	/*
+	 * Add a row for each of the models, in CPU order.
+	 */
+	cpus = g_hash_table_get_keys(priv->combined.models);
+	cpus = g_list_sort(cpus, ppg_cpu_instrument_compare_cpu);
+	for (iter = cpus; iter; iter = iter->next) {
+		ppg_cpu_instrument_heatmap_append(
+			visualizer,
+			g_hash_table_lookup(priv->combined.models, iter->data));
+	}
+	g_list_free(cpus);
+
+	RETURN(visualizer);
+}
+
+
 /**
  * ppg_cpu_instrument_combined_cb:
  * @instrument: (in): A #PpgCpuInstrument.
@@ -149,6 +286,14 @@ ppg_cpu_instrument_combined_cb (PpgVisualizerEntry  *entry,
 	 */
 	renderer = g_object_new(PPG_TYPE_RENDERER_LINE, NULL);
 
+	/*
+	 * The lines are percentages, so keep them on a fixed 0 to 100 scale
+	 * rather than scaling to the visible samples.
+	 */
+	ppg_renderer_line_set_autoscale(renderer, FALSE);
+	gtk_adjustment_configure(ppg_renderer_get_adjustment(PPG_RENDERER(renderer)),
+	                         0.0, 0.0, 100.0, 1.0, 10.0, 0.0);
+
 	/*
 	 * Store a reference so we can add lines as CPUs are discovered.
 	 */
@@ -185,6 +330,10 @@ static PpgVisualizerEntry visualizer_entries[] = {
 	  N_("Combined CPU Usage"),
 	  NULL,
 	  G_CALLBACK(ppg_cpu_instrument_combined_cb) },
+	{ "heatmap",
+	  N_("CPU Usage per Core"),
+	  NULL,
+	  G_CALLBACK(ppg_cpu_instrument_heatmap_cb) },
 };
 
 
@@ -243,6 +392,11 @@ get_model (PpgCpuInstrument *instrument,
 			renderer = g_ptr_array_index(priv->combined.renderers, i);
 			ppg_renderer_line_append(renderer, model, percent_quark);
 		}
+		for (i = 0; i < priv->heatmap.visualizers->len; i++) {
+			ppg_cpu_instrument_heatmap_append(
+				g_ptr_array_index(priv->heatmap.visualizers, i),
+				model);
+		}
 	}
 
 	return model;
@@ -285,73 +439,65 @@ ppg_cpu_instrument_manifest_cb (PkManifest *manifest,
 
 
 /**
- * ppg_cpu_instrument_sample_cb:
+ * ppg_cpu_instrument_samples_cb:
  * @manifest: (in): The current #PkManifest.
- * @sample: (in): An incoming #PkSample.
+ * @samples: (in): An array of incoming #PkSample.
+ * @n_samples: (in): The number of samples in @samples.
  *
- * Handles an incoming sample from the Perfkit agent. The contents
- * are stored to the instruments data model.
+ * Handles a batch of incoming samples from the Perfkit agent. Samples are
+ * grouped by CPU so that each per-CPU model receives a single bulk insert.
  *
  * Returns: None.
  * Side effects: Data is stored.
  */
 static void
-ppg_cpu_instrument_sample_cb (PkManifest *manifest,
-                              PkSample   *sample,
-                              gpointer    user_data)
+ppg_cpu_instrument_samples_cb (PkManifest  *manifest,
+                               PkSample   **samples,
+                               guint        n_samples,
+                               gpointer     user_data)
 {
 	PpgCpuInstrument *instrument = (PpgCpuInstrument *)user_data;
 	PpgCpuInstrumentPrivate *priv;
+	GHashTableIter iter;
+	GHashTable *batches;
+	GPtrArray *batch;
 	PkModel *model;
 	GValue value = { 0 };
 	gint cpu;
+	guint i;
 
 	g_return_if_fail(PPG_IS_CPU_INSTRUMENT(instrument));
 
 	priv = instrument->priv;
 
 #ifdef PERFKIT_DEBUG
-	g_assert_cmpint(pk_sample_get_source_id(sample), ==, priv->source);
 	g_assert_cmpint(pk_manifest_get_source_id(manifest), ==, priv->source);
 #endif
 
-	pk_sample_get_value(sample, priv->combined.cpu_row, &value);
-	cpu = g_value_get_int(&value);
-	model = get_model(instrument, manifest, cpu);
-	pk_model_insert_sample(model, manifest, sample);
-}
-
+	batches = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+	                                (GDestroyNotify)g_ptr_array_unref);
 
-/**
- * ppg_cpu_instrument_set_handlers_cb:
- * @object: (in): A #PkConnection.
- * @result: (in): A #GAsyncResult.
- * @user_data: (in): User data for closure.
- *
- * Handles an asynchronous request to set the delivery closures for incoming
- * manifests and samples.
- *
- * Returns: None.
- * Side effects: None.
- */
-static void
-ppg_cpu_instrument_set_handlers_cb (GObject      *object,
-                                    GAsyncResult *result,
-                                    gpointer      user_data)
-{
-	PpgCpuInstrument *instrument = (PpgCpuInstrument *)user_data;
-	PpgCpuInstrumentPrivate *priv;
-	PkConnection *conn = (PkConnection *)object;
-	GError *error = NULL;
+	for (i = 0; i < n_samples; i++) {
+		pk_sample_get_value(samples[i], priv->combined.cpu_row, &value);
+		cpu = g_value_get_int(&value);
+		g_value_unset(&value);
 
-	g_return_if_fail(PPG_IS_CPU_INSTRUMENT(instrument));
-	g_return_if_fail(PK_IS_CONNECTION(object));
-
-	priv = instrument->priv;
+		model = get_model(instrument, manifest, cpu);
+		if (!(batch = g_hash_table_lookup(batches, model))) {
+			batch = g_ptr_array_new();
+			g_hash_table_insert(batches, model, batch);
+		}
+		g_ptr_array_add(batch, samples[i]);
+	}
 
-	if (!pk_connection_subscription_set_handlers_finish(conn, result, &error)) {
-		g_critical("Failed to subscribe to subscription: %d", priv->subscription);
+	g_hash_table_iter_init(&iter, batches);
+	while (g_hash_table_iter_next(&iter, (gpointer *)&model,
+	                              (gpointer *)&batch)) {
+		pk_model_insert_samples(model, manifest,
+		                        (PkSample **)batch->pdata, batch->len);
 	}
+
+	g_hash_table_destroy(batches);
 }
 
 
@@ -387,24 +533,22 @@ ppg_cpu_instrument_load (PpgInstrument  *instrument,
 	             "connection", &conn,
 	             NULL);
 
+	/*
+	 * The source lives in the session channel so that it only records
+	 * while the session does. The subscription is still shared with any
+	 * other consumer asking for the same source.
+	 */
 	RPC_OR_FAILURE(manager_add_source,
 	               (conn, "Cpu", &priv->source, error));
 
 	RPC_OR_FAILURE(channel_add_source,
 	               (conn, channel, priv->source, error));
 
-	RPC_OR_FAILURE(manager_add_subscription,
-	               (conn, 0, 0, &priv->subscription, error));
-
-	RPC_OR_FAILURE(subscription_add_source,
-	               (conn, priv->subscription, priv->source, error));
-
-	pk_connection_subscription_set_handlers_async(
-			conn, priv->subscription,
-			ppg_cpu_instrument_manifest_cb, cpu, NULL,
-			ppg_cpu_instrument_sample_cb, cpu, NULL,
-			NULL,
-			ppg_cpu_instrument_set_handlers_cb, instrument);
+	RPC_OR_FAILURE(subscription_acquire,
+	               (conn, &priv->source, 1, 0, 0, 0,
+	                ppg_cpu_instrument_manifest_cb,
+	                ppg_cpu_instrument_samples_cb,
+	                cpu, NULL, &priv->consumer, error));
 
 	ppg_instrument_add_visualizer(instrument, "combined");
 
@@ -433,7 +577,6 @@ ppg_cpu_instrument_unload (PpgInstrument  *instrument,
 	PpgCpuInstrumentPrivate *priv;
 	PkConnection *conn;
 	gboolean ret = FALSE;
-	gboolean removed;
 
 	g_return_val_if_fail(PPG_IS_CPU_INSTRUMENT(instrument), FALSE);
 	g_return_val_if_fail(PPG_IS_SESSION(session), FALSE);
@@ -444,13 +587,13 @@ ppg_cpu_instrument_unload (PpgInstrument  *instrument,
 	             "connection", &conn,
 	             NULL);
 
-	RPC_OR_FAILURE(manager_remove_subscription,
-	               (conn, priv->subscription, &removed, error));
+	RPC_OR_FAILURE(subscription_release,
+	               (conn, priv->consumer, error));
 	RPC_OR_FAILURE(manager_remove_source,
 	               (conn, priv->source, error));
 
   failure:
-	priv->subscription = 0;
+	priv->consumer = 0;
 	priv->source = 0;
 	g_object_unref(conn);
 	return ret;
@@ -461,6 +604,7 @@ static void
 ppg_cpu_instrument_finalize (GObject *object)
 {
 	PpgCpuInstrumentPrivate *priv = PPG_CPU_INSTRUMENT(object)->priv;
+	GObject *visualizer;
 	GObject *renderer;
 
 	g_hash_table_destroy(priv->combined.models);
@@ -471,6 +615,14 @@ ppg_cpu_instrument_finalize (GObject *object)
 	}
 	g_ptr_array_free(priv->combined.renderers, TRUE);
 
+	while (priv->heatmap.visualizers->len) {
+		visualizer = g_ptr_array_index(priv->heatmap.visualizers, 0);
+		g_object_weak_unref(visualizer, ppg_cpu_instrument_heatmap_disposed,
+		                    object);
+		g_ptr_array_remove_index(priv->heatmap.visualizers, 0);
+	}
+	g_ptr_array_free(priv->heatmap.visualizers, TRUE);
+
 	G_OBJECT_CLASS(ppg_cpu_instrument_parent_class)->finalize(object);
 }
 
@@ -537,4 +689,5 @@ ppg_cpu_instrument_init (PpgCpuInstrument *instrument)
 		g_hash_table_new_full(g_int_hash, g_int_equal,
 		                      g_free, g_object_unref);
 	instrument->priv->combined.renderers = g_ptr_array_new();
+	instrument->priv->heatmap.visualizers = g_ptr_array_new();
 }
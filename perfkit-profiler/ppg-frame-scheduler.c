@@ -0,0 +1,143 @@
+/* ppg-frame-scheduler.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ppg-frame-scheduler.h"
+#include "ppg-frame-source.h"
+#include "ppg-prefs.h"
+
+/*
+ * Redraw requests from all visualizers are collected and run together on
+ * a single frame clock, running at the "redraws-per-second" setting. The
+ * rate is read whenever the clock starts, and the clock stops on the
+ * first frame with nothing to do.
+ */
+#define MAX_FRAMES_PER_SECOND 119
+
+
+typedef struct
+{
+	GSourceFunc callback;
+	gpointer    user_data;
+} PpgFrameRequest;
+
+
+static GQueue      requests      = G_QUEUE_INIT;
+static GHashTable *links         = NULL; /* user_data to link in requests */
+static guint       frame_handler = 0;
+
+
+/**
+ * ppg_frame_scheduler_dispatch:
+ * @data: (in): Unused.
+ *
+ * A GSourceFunc run once per frame. The requests queued before the frame
+ * began are run, requests queued while running them wait for the next
+ * frame.
+ *
+ * Returns: %FALSE if there was nothing to do and the clock stopped.
+ * Side effects: None.
+ */
+static gboolean
+ppg_frame_scheduler_dispatch (gpointer data)
+{
+	PpgFrameRequest *request;
+	guint n_requests;
+
+	if (g_queue_is_empty(&requests)) {
+		frame_handler = 0;
+		return FALSE;
+	}
+
+	n_requests = requests.length;
+	while (n_requests-- && (request = g_queue_pop_head(&requests))) {
+		g_hash_table_remove(links, request->user_data);
+		request->callback(request->user_data);
+		g_slice_free(PpgFrameRequest, request);
+	}
+
+	return TRUE;
+}
+
+
+/**
+ * ppg_frame_scheduler_queue:
+ * @callback: (in): A #GSourceFunc to run on the next frame.
+ * @user_data: (in): User data for @callback.
+ *
+ * Requests that @callback be run on the next frame. Requests are
+ * coalesced by @user_data, so that however many times this is called
+ * between two frames, @callback runs once. The return value of @callback
+ * is ignored.
+ *
+ * Returns: None.
+ * Side effects: The frame clock is started if needed.
+ */
+void
+ppg_frame_scheduler_queue (GSourceFunc callback,
+                           gpointer    user_data)
+{
+	PpgFrameRequest *request;
+	gint fps;
+
+	g_return_if_fail(callback != NULL);
+
+	if (!links) {
+		links = g_hash_table_new(g_direct_hash, g_direct_equal);
+	}
+
+	if (g_hash_table_lookup(links, user_data)) {
+		return;
+	}
+
+	request = g_slice_new(PpgFrameRequest);
+	request->callback = callback;
+	request->user_data = user_data;
+	g_queue_push_tail(&requests, request);
+	g_hash_table_insert(links, user_data, requests.tail);
+
+	if (!frame_handler) {
+		fps = g_settings_get_int(ppg_prefs_get_window_settings(),
+		                         "redraws-per-second");
+		frame_handler =
+			ppg_frame_source_add(CLAMP(fps, 1, MAX_FRAMES_PER_SECOND),
+			                     ppg_frame_scheduler_dispatch,
+			                     NULL);
+	}
+}
+
+
+/**
+ * ppg_frame_scheduler_remove:
+ * @user_data: (in): The user data given to ppg_frame_scheduler_queue().
+ *
+ * Removes the pending request for @user_data, if any.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+ppg_frame_scheduler_remove (gpointer user_data)
+{
+	GList *link;
+
+	if (links && (link = g_hash_table_lookup(links, user_data))) {
+		g_hash_table_remove(links, user_data);
+		g_slice_free(PpgFrameRequest, link->data);
+		g_queue_delete_link(&requests, link);
+	}
+}
@@ -43,6 +43,10 @@ struct _PpgInstrumentViewPrivate
 	GooCanvasItem  *table;        /* Table containing visualizers */
 	gint            zoom;         /* What is the current zoom level */
 	gboolean        frozen;       /* Updates are frozen to visualizers */
+	gboolean        onscreen;     /* Row is within the visible area */
+	gboolean        time_pending; /* Time range not yet given to visualizers */
+	gdouble         begin_time;   /* Last time range requested */
+	gdouble         end_time;
 	gboolean        compact;      /* Are we in compact mode (important only) */
 };
 
@@ -240,6 +244,12 @@ ppg_instrument_view_visualizer_added (PpgInstrumentView *view,
 	                                     "row", priv->visualizers->len,
 	                                     NULL);
 	g_ptr_array_add(priv->visualizers, visualizer);
+	if (priv->frozen) {
+		ppg_visualizer_freeze(visualizer);
+	}
+	if (!priv->onscreen) {
+		ppg_visualizer_freeze(visualizer);
+	}
 	g_signal_connect_swapped(visualizer, "notify::natural-height",
 	                         G_CALLBACK(ppg_instrument_view_notify_natural_height),
 	                         view);
@@ -426,6 +436,17 @@ ppg_instrument_view_set_time (PpgInstrumentView *view,
 
 	priv = view->priv;
 
+	priv->begin_time = begin_time;
+	priv->end_time = end_time;
+
+	/*
+	 * Offscreen rows pick up the range when they are scrolled into view.
+	 */
+	if (!priv->onscreen) {
+		priv->time_pending = TRUE;
+		return;
+	}
+
 	for (i = 0; i < priv->visualizers->len; i++) {
 		visualizer = g_ptr_array_index(priv->visualizers, i);
 		ppg_visualizer_set_time(visualizer, begin_time, end_time);
@@ -433,6 +454,67 @@ ppg_instrument_view_set_time (PpgInstrumentView *view,
 }
 
 
+/**
+ * ppg_instrument_view_set_onscreen:
+ * @view: (in): A #PpgInstrumentView.
+ * @onscreen: (in): If the row is within the visible area.
+ *
+ * Tells the instrument view if it is within the visible area of the
+ * session. Offscreen visualizers are frozen so they do not consume
+ * render tasks, and are brought up to date with the current time range
+ * when they come back onscreen.
+ *
+ * The table holding the visualizers of an offscreen row is hidden so that
+ * the canvas does not lay out or paint it. The row keeps its height and
+ * header, so it stands in as a placeholder of the same size.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+ppg_instrument_view_set_onscreen (PpgInstrumentView *view,
+                                  gboolean           onscreen)
+{
+	PpgInstrumentViewPrivate *priv;
+	PpgVisualizer *visualizer;
+	gint i;
+
+	g_return_if_fail(PPG_IS_INSTRUMENT_VIEW(view));
+
+	priv = view->priv;
+
+	onscreen = !!onscreen;
+	if (onscreen == priv->onscreen) {
+		return;
+	}
+
+	priv->onscreen = onscreen;
+
+	for (i = 0; i < priv->visualizers->len; i++) {
+		visualizer = g_ptr_array_index(priv->visualizers, i);
+		if (onscreen) {
+			if (priv->time_pending) {
+				ppg_visualizer_set_time(visualizer, priv->begin_time,
+				                        priv->end_time);
+			}
+			ppg_visualizer_thaw(visualizer);
+		} else {
+			ppg_visualizer_freeze(visualizer);
+		}
+	}
+
+	if (onscreen) {
+		priv->time_pending = FALSE;
+	}
+
+	g_object_set(priv->table,
+	             "visibility", onscreen ?
+	                           GOO_CANVAS_ITEM_VISIBLE :
+	                           GOO_CANVAS_ITEM_HIDDEN,
+	             NULL);
+}
+
+
 /**
  * ppg_instrument_view_zoom_in:
  * @view: (in): A #PpgInstrumentView.
@@ -503,6 +585,11 @@ ppg_instrument_view_set_frozen (PpgInstrumentView *view,
 
 	priv = view->priv;
 
+	frozen = !!frozen;
+	if (frozen == priv->frozen) {
+		return;
+	}
+
 	priv->frozen = frozen;
 
 	for (i = 0; i < priv->visualizers->len; i++) {
@@ -757,6 +844,7 @@ ppg_instrument_view_init (PpgInstrumentView *view)
 	             NULL);
 
 	priv->state = GTK_STATE_NORMAL;
+	priv->onscreen = TRUE;
 	priv->visualizers = g_ptr_array_new();
 	priv->zoom = 1;
 
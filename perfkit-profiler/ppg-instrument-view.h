@@ -52,6 +52,8 @@ struct _PpgInstrumentViewClass
 };
 
 GType          ppg_instrument_view_get_type       (void) G_GNUC_CONST;
+void           ppg_instrument_view_set_onscreen   (PpgInstrumentView *view,
+                                                   gboolean           onscreen);
 void           ppg_instrument_view_set_style      (PpgInstrumentView *view,
                                                    GtkStyle          *style);
 void           ppg_instrument_view_set_state      (PpgInstrumentView *view,
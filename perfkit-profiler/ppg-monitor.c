@@ -34,6 +34,13 @@ static GHashTable *gRenderers = NULL;
 static GHashTable *gInitialized = NULL;
 
 
+/*
+ * The graphs show the last minute; keep a little more than that so the
+ * models do not grow for as long as the monitor is running.
+ */
+#define MONITOR_HISTORY (120.0)
+
+
 #define RPC_OR_FAIL(_r, _a) \
 	G_STMT_START { \
 		gboolean ret = pk_connection_##_r _a; \
@@ -116,7 +123,9 @@ get_model_for_cpu (PkConnection *connection,
 	}
 
 	if (!(model = g_hash_table_lookup(models, &cpu))) {
-		model = g_object_new(PK_TYPE_MODEL_MEMORY, NULL);
+		model = g_object_new(PK_TYPE_MODEL_COLUMNAR,
+		                     "max-age", MONITOR_HISTORY,
+		                     NULL);
 		pk_model_set_field_mode(model, gQuarkSystem, PK_MODEL_COUNTER);
 		pk_model_set_field_mode(model, gQuarkIdle, PK_MODEL_COUNTER);
 		pk_model_set_field_mode(model, gQuarkUser, PK_MODEL_COUNTER);
@@ -152,47 +161,30 @@ cpu_manifest_cb (PkManifest *manifest,
 
 
 static void
-cpu_sample_cb (PkManifest *manifest,
-               PkSample   *sample,
-               gpointer    user_data)
+cpu_samples_cb (PkManifest  *manifest,
+                PkSample   **samples,
+                guint        n_samples,
+                gpointer     user_data)
 {
 	PkConnection *connection = (PkConnection *)user_data;
 	PkModel *model;
 	GValue value = { 0 };
 	gint cpu;
 	gint row;
+	guint i;
 
 	if ((row = pk_manifest_get_row_id_from_quark(manifest, gQuarkCpu)) <= 0) {
 		return;
 	}
 
-	pk_sample_get_value(sample, row, &value);
-	cpu = g_value_get_int(&value);
-	g_value_unset(&value);
+	for (i = 0; i < n_samples; i++) {
+		pk_sample_get_value(samples[i], row, &value);
+		cpu = g_value_get_int(&value);
+		g_value_unset(&value);
 
-	model = get_model_for_cpu(connection, manifest, cpu);
-	pk_model_insert_sample(model, manifest, sample);
-}
-
-
-static void
-cpu_set_handlers_cb (GObject *object,
-                     GAsyncResult *result,
-                     gpointer user_data)
-{
-	PkConnection *connection = (PkConnection *)object;
-	GError *error = NULL;
-	gint channel;
-
-	if (!pk_connection_subscription_set_handlers_finish(connection,
-	                                                    result, &error)) {
-		g_critical("%s", error->message);
-		g_clear_error(&error);
-		return;
+		model = get_model_for_cpu(connection, manifest, cpu);
+		pk_model_insert_sample(model, manifest, samples[i]);
 	}
-
-	channel = GPOINTER_TO_INT(user_data);
-	pk_connection_channel_start(connection, channel, NULL, NULL);
 }
 
 
@@ -204,9 +196,8 @@ ppg_monitor_cpu_new (PkConnection *connection)
 	PpgRtGraph *graph;
 	GPtrArray *renderers;
 	GError *error = NULL;
-	gint channel;
 	gint source;
-	gint sub;
+	gint consumer;
 
 	/*
 	 * Make sure the models hash exists.
@@ -230,16 +221,11 @@ ppg_monitor_cpu_new (PkConnection *connection)
 	if (!g_hash_table_lookup(gInitialized, connection)) {
 		g_hash_table_insert(gInitialized, connection, GINT_TO_POINTER(1));
 
-		RPC_OR_FAIL(manager_add_channel, (connection, &channel, &error));
-		RPC_OR_FAIL(manager_add_source, (connection, "Cpu", &source, &error));
-		RPC_OR_FAIL(channel_add_source, (connection, channel, source, &error));
-		RPC_OR_FAIL(manager_add_subscription, (connection, 0, 0, &sub, &error));
-		RPC_OR_FAIL(subscription_add_source, (connection, sub, source, &error));
-		pk_connection_subscription_set_handlers_async(
-				connection, sub,
-		        cpu_manifest_cb, connection, NULL,
-		        cpu_sample_cb, connection, NULL,
-		        NULL, cpu_set_handlers_cb, GINT_TO_POINTER(channel));
+		RPC_OR_FAIL(source_acquire, (connection, "Cpu", &source, &error));
+		RPC_OR_FAIL(subscription_acquire,
+		            (connection, &source, 1, 0, 0, 0,
+		             cpu_manifest_cb, cpu_samples_cb, connection, NULL,
+		             &consumer, &error));
 	}
 
 	renderer = g_object_new(PPG_TYPE_RENDERER_LINE,
@@ -189,6 +189,8 @@ ppg_prefs_dialog_create_project_page (PpgPrefsDialog *dialog)
 	GSettings *settings;
 	GtkWidget *vbox;
 	GtkWidget *project_button;
+	GtkWidget *group;
+	GtkWidget *b;
 	GtkWidget *l;
 	gchar *default_dir;
 	gchar *tmp;
@@ -225,6 +227,48 @@ ppg_prefs_dialog_create_project_page (PpgPrefsDialog *dialog)
 	                 NULL);
 	ppg_prefs_dialog_add_group(vbox, l, project_button);
 
+	group = g_object_new(GTK_TYPE_VBOX,
+	                     "spacing", 6,
+	                     "visible", TRUE,
+	                     NULL);
+
+	b = g_object_new(GTK_TYPE_CHECK_BUTTON,
+	                 "visible", TRUE,
+	                 "label", _("Store samples on disk"),
+	                 "tooltip-text", _("Keep recorded samples in a file "
+	                                   "rather than in memory, allowing "
+	                                   "longer captures. Zoomed out views "
+	                                   "are slower to draw."),
+	                 NULL);
+	g_settings_bind(settings, "store-on-disk",
+	                b, "active",
+	                G_SETTINGS_BIND_DEFAULT);
+	gtk_container_add_with_properties(GTK_CONTAINER(group), b,
+	                                  "expand", FALSE,
+	                                  NULL);
+
+	b = g_object_new(GTK_TYPE_CHECK_BUTTON,
+	                 "visible", TRUE,
+	                 "label", _("Compress samples in memory"),
+	                 "tooltip-text", _("Keep recorded samples compressed, "
+	                                   "using several times less memory. "
+	                                   "Views are slower to draw."),
+	                 NULL);
+	g_settings_bind(settings, "compress-samples",
+	                b, "active",
+	                G_SETTINGS_BIND_DEFAULT);
+	gtk_container_add_with_properties(GTK_CONTAINER(group), b,
+	                                  "expand", FALSE,
+	                                  NULL);
+
+	l = g_object_new(GTK_TYPE_LABEL,
+	                 "label", _("<b>Recording</b>"),
+	                 "visible", TRUE,
+	                 "use-markup", TRUE,
+	                 "xalign", 0.0f,
+	                 NULL);
+	ppg_prefs_dialog_add_group(vbox, l, group);
+
 	return vbox;
 }
 
@@ -0,0 +1,39 @@
+/* ppg-raster.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_RASTER_H
+#define PPG_RASTER_H
+
+#include <cairo.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void ppg_raster_fill_spans (cairo_surface_t *surface,
+                            gint             x,
+                            const gfloat    *tops,
+                            const gfloat    *bottoms,
+                            gint             n_spans,
+                            gdouble          red,
+                            gdouble          green,
+                            gdouble          blue,
+                            gdouble          alpha);
+
+G_END_DECLS
+
+#endif /* PPG_RASTER_H */
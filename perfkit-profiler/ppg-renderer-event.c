@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 #include <perfkit/perfkit.h>
 #include <string.h>
 
@@ -24,6 +25,20 @@
 #include "ppg-task-render.h"
 #include "ppg-util.h"
 
+/*
+ * Pixel columns with more than one event are drawn as a strip whose shade
+ * darkens with the number of events, up to EVENT_SATURATION events.
+ */
+#define EVENT_SATURATION (1000.0)
+#define EVENT_MAX_SHADE  (0.6)
+
+
+typedef struct
+{
+	gdouble count;
+	gdouble x;     /* Position of the first event */
+} Column;
+
 
 typedef struct
 {
@@ -77,32 +92,129 @@ get_y_for_range (gdouble ratio,
 }
 
 
+/**
+ * ppg_renderer_event_bucket:
+ * @item: (in): An #Event.
+ * @columns: (out): An array of @n_columns #Column.
+ * @n_columns: (in): The number of pixel columns.
+ * @begin_time: (in): The time at the left edge of the first column.
+ * @end_time: (in): The time at the right edge of the last column.
+ *
+ * Counts the events of @item within each pixel column.  The model is
+ * asked to aggregate to the width of a column, so models keeping rollups
+ * answer from their bucket counts rather than every event.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
 static void
-ppg_renderer_event_render (PpgRendererEvent *event,
-                           PpgTask         *task)
+ppg_renderer_event_bucket (Event   *item,
+                           Column  *columns,
+                           gint     n_columns,
+                           gdouble  begin_time,
+                           gdouble  end_time)
 {
-	PpgRendererEventPrivate *priv;
-	cairo_surface_t *surface;
 	PkModelIter iter;
+	gdouble x_ratio;
+	gdouble iter_x;
+	gint col;
+
+	memset(columns, 0, sizeof(Column) * n_columns);
+	x_ratio = n_columns / (end_time - begin_time);
+
+	pk_model_lock(item->model);
+	if (pk_model_get_iter_for_range(item->model, &iter,
+	                                begin_time, end_time,
+	                                (end_time - begin_time) / n_columns)) {
+		do {
+			iter_x = get_x_for_time(x_ratio, 0.0, begin_time, iter.time);
+			col = (gint)floor(iter_x);
+
+			/*
+			 * Buckets are aligned to their own grid, so the first may
+			 * start before the range while still holding events within
+			 * it. Those are counted in the first column.
+			 */
+			if (col < 0) {
+				col = 0;
+				iter_x = 0.0;
+			} else if (col >= n_columns) {
+				continue;
+			}
+			if (columns[col].count == 0.0) {
+				columns[col].x = iter_x;
+			}
+			columns[col].count +=
+				pk_model_get_aggregate(item->model, &iter, item->key,
+				                       PK_MODEL_AGGREGATE_COUNT);
+		} while (pk_model_iter_next(item->model, &iter));
+	}
+	pk_model_unlock(item->model);
+}
+
+
+/**
+ * ppg_renderer_event_copy_event:
+ * @item: (in): An #Event.
+ *
+ * Copies @item for a render task, holding a reference to its model.
+ *
+ * Returns: A newly allocated #Event to be freed with
+ *   ppg_renderer_event_free_event().
+ * Side effects: None.
+ */
+static Event*
+ppg_renderer_event_copy_event (Event *item)
+{
+	Event *copy;
+
+	copy = g_memdup(item, sizeof *item);
+	copy->renderer = NULL;
+	copy->handler = 0;
+	copy->model = g_object_ref(item->model);
+	return copy;
+}
+
+
+static void
+ppg_renderer_event_free_event (Event *item)
+{
+	g_object_unref(item->model);
+	g_free(item);
+}
+
+
+static void
+ppg_renderer_event_free_snapshot (GPtrArray *events)
+{
+	g_ptr_array_foreach(events, (GFunc)ppg_renderer_event_free_event, NULL);
+	g_ptr_array_free(events, TRUE);
+}
+
+
+static void
+ppg_renderer_event_render (PpgTask   *task,
+                           GPtrArray *events)
+{
+	cairo_surface_t *surface;
+	Column *columns;
 	cairo_t *cr;
-	gdouble aggregate_time;
 	gdouble begin_time;
 	gdouble end_time;
 	gdouble height;
-	gdouble iter_x;
+	gdouble shade;
 	gdouble width;
 	gdouble x;
-	gdouble x_ratio;
 	gdouble y;
 	Event *item;
+	gint n_columns;
+	gint col;
 	gint i;
 
 	ENTRY;
 
-	g_return_if_fail(PPG_IS_RENDERER_EVENT(event));
 	g_return_if_fail(PPG_IS_TASK(task));
-
-	priv = event->priv;
+	g_return_if_fail(events != NULL);
 
 	g_object_get(task,
 	             "begin-time", &begin_time,
@@ -122,36 +234,58 @@ ppg_renderer_event_render (PpgRendererEvent *event,
 	g_assert(width > 0.0);
 	g_assert(height > 0.0);
 
-	x_ratio = width / (end_time - begin_time);
-
 	/*
-	 * To reduce the number of data points we look at, we will ask the
-	 * data model to aggregate values to a given range of time. We only
-	 * need a max of one data point per pixel.
+	 * Events are counted per pixel column, so that dense streams cost a
+	 * rectangle per column rather than a stroke per event.
 	 */
-	aggregate_time = (end_time - begin_time) / width;
+	n_columns = (gint)ceil(width);
+	columns = g_new(Column, n_columns);
 
 	cr = cairo_create(surface);
 
-	for (i = 0; i < priv->events->len; i++) {
-		item = g_ptr_array_index(priv->events, i);
+	for (i = 0; i < events->len; i++) {
+		item = g_ptr_array_index(events, i);
 
+		ppg_renderer_event_bucket(item, columns, n_columns,
+		                          begin_time,
+		                          begin_time + n_columns *
+		                          (end_time - begin_time) / width);
+
+		/*
+		 * Columns with a single event get a mark at the time of the
+		 * event.
+		 */
 		cairo_set_line_width(cr, item->width);
 		gdk_cairo_set_source_color(cr, &item->color);
-
-		if (pk_model_get_iter_for_range(item->model, &iter,
-		                                begin_time, end_time,
-		                                aggregate_time)) {
-			do {
-				iter_x = get_x_for_time(x_ratio, x, begin_time, iter.time);
-				cairo_move_to(cr, iter_x, y);
-				cairo_line_to(cr, iter_x, y + height);
-			} while (pk_model_iter_next(item->model, &iter));
-			cairo_stroke(cr);
+		for (col = 0; col < n_columns; col++) {
+			if (columns[col].count > 0.0 && columns[col].count < 2.0) {
+				cairo_move_to(cr, x + columns[col].x, y);
+				cairo_line_to(cr, x + columns[col].x, y + height);
+			}
+		}
+		cairo_stroke(cr);
+
+		/*
+		 * Columns where events overlap are filled, darker the more
+		 * events they hold.
+		 */
+		for (col = 0; col < n_columns; col++) {
+			if (columns[col].count < 2.0) {
+				continue;
+			}
+			shade = log(columns[col].count) / log(EVENT_SATURATION);
+			shade = 1.0 - EVENT_MAX_SHADE * MIN(shade, 1.0);
+			cairo_set_source_rgb(cr,
+			                     shade * item->color.red / 65535.0,
+			                     shade * item->color.green / 65535.0,
+			                     shade * item->color.blue / 65535.0);
+			cairo_rectangle(cr, x + col, y, 1.0, height);
+			cairo_fill(cr);
 		}
 	}
 
 	cairo_destroy(cr);
+	g_free(columns);
 
 	EXIT;
 }
@@ -167,12 +301,28 @@ ppg_renderer_event_draw (PpgRenderer     *renderer,
                          gdouble          width,
                          gdouble          height)
 {
+	PpgRendererEventPrivate *priv;
+	GPtrArray *events;
 	PpgTask *task;
+	gint i;
 
 	ENTRY;
 
 	g_return_val_if_fail(PPG_IS_RENDERER_EVENT(renderer), NULL);
 
+	priv = PPG_RENDERER_EVENT(renderer)->priv;
+
+	/*
+	 * The task may run on another thread, so it draws from a copy of
+	 * the events rather than from the renderer.
+	 */
+	events = g_ptr_array_sized_new(priv->events->len);
+	for (i = 0; i < priv->events->len; i++) {
+		g_ptr_array_add(events,
+		                ppg_renderer_event_copy_event(
+		                    g_ptr_array_index(priv->events, i)));
+	}
+
 	task = g_object_new(PPG_TYPE_TASK_RENDER,
 	                    "begin-time", begin_time,
 	                    "end-time", end_time,
@@ -182,10 +332,11 @@ ppg_renderer_event_draw (PpgRenderer     *renderer,
 	                    "x", x,
 	                    "y", y,
 	                    NULL);
-	g_signal_connect_object(task, "render",
-	                        G_CALLBACK(ppg_renderer_event_render),
-	                        renderer,
-	                        G_CONNECT_SWAPPED);
+	ppg_task_render_set_snapshot(PPG_TASK_RENDER(task), events,
+	                             (GDestroyNotify)ppg_renderer_event_free_snapshot);
+	g_signal_connect(task, "render",
+	                 G_CALLBACK(ppg_renderer_event_render),
+	                 events);
 	RETURN(task);
 }
 
@@ -0,0 +1,672 @@
+/* ppg-renderer-heatmap.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <perfkit/perfkit.h>
+
+#include "ppg-log.h"
+#include "ppg-renderer-heatmap.h"
+#include "ppg-task-render.h"
+#include "ppg-util.h"
+
+/*
+ * Values are mapped onto a palette of N_SHADES colors blended between
+ * the stops below, from idle to saturated.
+ */
+#define N_SHADES (256)
+
+
+typedef struct
+{
+	PpgRendererHeatmap *renderer;
+	gint                id;
+	GQuark              key;
+	PkModel            *model;
+	guint               handler;
+	gdouble             end_time;
+} Row;
+
+
+/*
+ * The state a render task draws from, copied from the renderer on the
+ * main thread when the task is created.
+ */
+typedef struct
+{
+	GPtrArray *rows;  /* Copies of each Row */
+	gdouble    lower;
+	gdouble    upper;
+} Snapshot;
+
+
+struct _PpgRendererHeatmapPrivate
+{
+	GPtrArray     *rows;
+	GtkAdjustment *range;
+};
+
+
+static void ppg_renderer_init (PpgRendererIface *iface);
+
+
+G_DEFINE_TYPE_EXTENDED(PpgRendererHeatmap,
+                       ppg_renderer_heatmap,
+                       G_TYPE_INITIALLY_UNOWNED,
+                       0,
+                       G_IMPLEMENT_INTERFACE(PPG_TYPE_RENDERER,
+                                             ppg_renderer_init))
+
+
+static const struct {
+	gdouble offset;
+	gdouble red;
+	gdouble green;
+	gdouble blue;
+} stops[] = {
+	{ 0.0, 0x20 / 255.0, 0x4a / 255.0, 0x87 / 255.0 },
+	{ 0.5, 0xed / 255.0, 0xd4 / 255.0, 0x00 / 255.0 },
+	{ 1.0, 0xcc / 255.0, 0x00 / 255.0, 0x00 / 255.0 },
+};
+
+
+static guint32 shades[N_SHADES];
+
+
+/**
+ * ppg_renderer_heatmap_init_shades:
+ *
+ * Fills the palette used to map values to colors, blending linearly
+ * between the color stops.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_heatmap_init_shades (void)
+{
+	gdouble offset;
+	gdouble f;
+	guint32 red;
+	guint32 green;
+	guint32 blue;
+	gint stop;
+	gint i;
+
+	stop = 0;
+	for (i = 0; i < N_SHADES; i++) {
+		offset = i / (gdouble)(N_SHADES - 1);
+		while (stop < G_N_ELEMENTS(stops) - 2 &&
+		       offset > stops[stop + 1].offset) {
+			stop++;
+		}
+		f = (offset - stops[stop].offset) /
+		    (stops[stop + 1].offset - stops[stop].offset);
+		red = (stops[stop].red +
+		       f * (stops[stop + 1].red - stops[stop].red)) * 255.0 + 0.5;
+		green = (stops[stop].green +
+		         f * (stops[stop + 1].green - stops[stop].green)) * 255.0 + 0.5;
+		blue = (stops[stop].blue +
+		        f * (stops[stop + 1].blue - stops[stop].blue)) * 255.0 + 0.5;
+		shades[i] = 0xFF000000 | (red << 16) | (green << 8) | blue;
+	}
+}
+
+
+/**
+ * ppg_renderer_heatmap_bucket:
+ * @item: (in): A #Row.
+ * @values: (out): An array of @n_columns values.
+ * @n_columns: (in): The number of pixel columns.
+ * @begin_time: (in): The time at the left edge of the first column.
+ * @end_time: (in): The time at the right edge of the last column.
+ *
+ * Retrieves the mean of @item within each pixel column. The model is
+ * asked to aggregate to the width of a column, so models keeping rollups
+ * answer from their buckets rather than every sample. Columns without
+ * samples are set to -1.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_heatmap_bucket (Row     *item,
+                             gfloat  *values,
+                             gint     n_columns,
+                             gdouble  begin_time,
+                             gdouble  end_time)
+{
+	PkModelIter iter;
+	gdouble *counts;
+	gdouble *sums;
+	gdouble x_ratio;
+	gdouble count;
+	gint col;
+
+	sums = g_new0(gdouble, n_columns * 2);
+	counts = sums + n_columns;
+
+	x_ratio = n_columns / (end_time - begin_time);
+
+	pk_model_lock(item->model);
+	if (pk_model_get_iter_for_range(item->model, &iter,
+	                                begin_time, end_time,
+	                                (end_time - begin_time) / n_columns)) {
+		do {
+			col = (gint)floor(x_ratio * (iter.time - begin_time));
+			if (col >= n_columns) {
+				continue;
+			}
+			col = MAX(col, 0);
+
+			/*
+			 * Weigh each bucket by its samples so that the column is
+			 * the mean of every sample it covers.
+			 */
+			count = pk_model_get_aggregate(item->model, &iter, item->key,
+			                               PK_MODEL_AGGREGATE_COUNT);
+			sums[col] += count *
+				pk_model_get_aggregate(item->model, &iter, item->key,
+				                       PK_MODEL_AGGREGATE_MEAN);
+			counts[col] += count;
+		} while (pk_model_iter_next(item->model, &iter));
+	}
+	pk_model_unlock(item->model);
+
+	for (col = 0; col < n_columns; col++) {
+		values[col] = counts[col] ? sums[col] / counts[col] : -1.0f;
+	}
+	g_free(sums);
+}
+
+
+/**
+ * ppg_renderer_heatmap_copy_row:
+ * @item: (in): A #Row.
+ *
+ * Copies @item for a render task, holding a reference to its model.
+ *
+ * Returns: A newly allocated #Row to be freed with
+ *   ppg_renderer_heatmap_free_row().
+ * Side effects: None.
+ */
+static Row*
+ppg_renderer_heatmap_copy_row (Row *item)
+{
+	Row *copy;
+
+	copy = g_memdup(item, sizeof *item);
+	copy->renderer = NULL;
+	copy->handler = 0;
+	copy->model = g_object_ref(item->model);
+	return copy;
+}
+
+
+static void
+ppg_renderer_heatmap_free_row (Row *item)
+{
+	g_object_unref(item->model);
+	g_free(item);
+}
+
+
+static void
+ppg_renderer_heatmap_free_snapshot (Snapshot *snapshot)
+{
+	g_ptr_array_foreach(snapshot->rows,
+	                    (GFunc)ppg_renderer_heatmap_free_row,
+	                    NULL);
+	g_ptr_array_free(snapshot->rows, TRUE);
+	g_slice_free(Snapshot, snapshot);
+}
+
+
+static void
+ppg_renderer_heatmap_render (PpgTask  *task,
+                             Snapshot *snapshot)
+{
+	cairo_surface_t *surface;
+	cairo_surface_t *cells;
+	cairo_pattern_t *pattern;
+	guint32 *pixels;
+	gfloat *values;
+	gfloat *grid;
+	cairo_t *cr;
+	gdouble begin_time;
+	gdouble end_time;
+	gdouble height;
+	gdouble width;
+	gdouble lower;
+	gdouble scale;
+	gdouble x;
+	gdouble y;
+	Row *item;
+	gint n_columns;
+	gint n_rows;
+	gint stride;
+	gint first;
+	gint last;
+	gint shade;
+	gint col;
+	gint i;
+	gint j;
+
+	ENTRY;
+
+	g_return_if_fail(PPG_IS_TASK(task));
+	g_return_if_fail(snapshot != NULL);
+
+	g_object_get(task,
+	             "begin-time", &begin_time,
+	             "end-time", &end_time,
+	             "height", &height,
+	             "surface", &surface,
+	             "x", &x,
+	             "y", &y,
+	             "width", &width,
+	             NULL);
+
+	if (begin_time == end_time || !snapshot->rows->len) {
+		EXIT;
+	}
+
+	g_assert(surface);
+	g_assert(width > 0.0);
+	g_assert(height > 0.0);
+
+	/*
+	 * Every row is bucketed to one value per pixel column and written to
+	 * a grid of one cell per pixel. When there are more rows than pixels,
+	 * rows sharing a pixel keep the hottest value so that a busy row is
+	 * never hidden by an idle one.
+	 */
+	n_columns = (gint)ceil(width);
+	n_rows = (gint)ceil(height);
+	values = g_new(gfloat, n_columns);
+	grid = g_new(gfloat, n_columns * n_rows);
+	for (i = 0; i < n_columns * n_rows; i++) {
+		grid[i] = -1.0f;
+	}
+
+	for (i = 0; i < snapshot->rows->len; i++) {
+		item = g_ptr_array_index(snapshot->rows, i);
+		ppg_renderer_heatmap_bucket(item, values, n_columns,
+		                            begin_time,
+		                            begin_time + n_columns *
+		                            (end_time - begin_time) / width);
+
+		first = i * n_rows / snapshot->rows->len;
+		last = MAX(first + 1, (i + 1) * n_rows / snapshot->rows->len);
+		for (j = first; j < last; j++) {
+			for (col = 0; col < n_columns; col++) {
+				grid[j * n_columns + col] = MAX(grid[j * n_columns + col],
+				                                values[col]);
+			}
+		}
+	}
+
+	/*
+	 * Shade the cells and copy them to the target with a single paint.
+	 */
+	lower = snapshot->lower;
+	scale = (N_SHADES - 1) / (snapshot->upper - lower);
+
+	cells = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+	                                   n_columns, n_rows);
+	cairo_surface_flush(cells);
+	pixels = (guint32 *)cairo_image_surface_get_data(cells);
+	stride = cairo_image_surface_get_stride(cells) / sizeof(guint32);
+	for (j = 0; j < n_rows; j++) {
+		for (col = 0; col < n_columns; col++) {
+			if (grid[j * n_columns + col] < 0.0f) {
+				pixels[j * stride + col] = 0;
+				continue;
+			}
+			shade = (gint)((grid[j * n_columns + col] - lower) * scale);
+			shade = CLAMP(shade, 0, N_SHADES - 1);
+			pixels[j * stride + col] = shades[shade];
+		}
+	}
+	cairo_surface_mark_dirty(cells);
+
+	cr = cairo_create(surface);
+	cairo_set_source_surface(cr, cells, x, y);
+	pattern = cairo_get_source(cr);
+	cairo_pattern_set_filter(pattern, CAIRO_FILTER_NEAREST);
+	cairo_rectangle(cr, x, y, width, height);
+	cairo_fill(cr);
+	cairo_destroy(cr);
+
+	cairo_surface_destroy(cells);
+	g_free(values);
+	g_free(grid);
+
+	EXIT;
+}
+
+
+static PpgTask*
+ppg_renderer_heatmap_draw (PpgRenderer     *renderer,
+                           cairo_surface_t *surface,
+                           gdouble          begin_time,
+                           gdouble          end_time,
+                           gdouble          x,
+                           gdouble          y,
+                           gdouble          width,
+                           gdouble          height)
+{
+	PpgRendererHeatmapPrivate *priv;
+	Snapshot *snapshot;
+	PpgTask *task;
+	gint i;
+
+	ENTRY;
+
+	g_return_val_if_fail(PPG_IS_RENDERER_HEATMAP(renderer), NULL);
+
+	priv = PPG_RENDERER_HEATMAP(renderer)->priv;
+
+	/*
+	 * The task may run on another thread, so it draws from a copy of
+	 * the rows and range rather than from the renderer.
+	 */
+	snapshot = g_slice_new0(Snapshot);
+	snapshot->rows = g_ptr_array_sized_new(priv->rows->len);
+	snapshot->lower = gtk_adjustment_get_lower(priv->range);
+	snapshot->upper = gtk_adjustment_get_upper(priv->range);
+	for (i = 0; i < priv->rows->len; i++) {
+		g_ptr_array_add(snapshot->rows,
+		                ppg_renderer_heatmap_copy_row(
+		                    g_ptr_array_index(priv->rows, i)));
+	}
+
+	task = g_object_new(PPG_TYPE_TASK_RENDER,
+	                    "begin-time", begin_time,
+	                    "end-time", end_time,
+	                    "height", height,
+	                    "surface", surface,
+	                    "width", width,
+	                    "x", x,
+	                    "y", y,
+	                    NULL);
+	ppg_task_render_set_snapshot(PPG_TASK_RENDER(task), snapshot,
+	                             (GDestroyNotify)ppg_renderer_heatmap_free_snapshot);
+	g_signal_connect(task, "render",
+	                 G_CALLBACK(ppg_renderer_heatmap_render),
+	                 snapshot);
+	RETURN(task);
+}
+
+
+static GtkAdjustment*
+ppg_renderer_heatmap_get_adjustment (PpgRenderer *renderer)
+{
+	PpgRendererHeatmap *heatmap = (PpgRendererHeatmap *)renderer;
+	g_return_val_if_fail(PPG_IS_RENDERER_HEATMAP(heatmap), NULL);
+	return heatmap->priv->range;
+}
+
+
+static void
+ppg_renderer_heatmap_notify_end_time (PkModel    *model,
+                                      GParamSpec *pspec,
+                                      Row        *item)
+{
+	gdouble last_end_time;
+
+	g_return_if_fail(PK_IS_MODEL(model));
+	g_return_if_fail(item != NULL);
+	g_return_if_fail(PPG_IS_RENDERER_HEATMAP(item->renderer));
+
+	last_end_time = item->end_time;
+	item->end_time = pk_model_get_end_time(model);
+	ppg_renderer_emit_invalidate(PPG_RENDERER(item->renderer),
+	                             last_end_time, item->end_time);
+}
+
+
+/**
+ * ppg_renderer_heatmap_append:
+ * @heatmap: (in): A #PpgRendererHeatmap.
+ * @model: (in): A #PkModel.
+ * @key: (in): The field of @model to shade.
+ *
+ * Appends a row to the bottom of the heatmap, shaded by the value of
+ * @key over time.
+ *
+ * Returns: An identifier for the row to be used with
+ *   ppg_renderer_heatmap_remove().
+ * Side effects: None.
+ */
+gint
+ppg_renderer_heatmap_append (PpgRendererHeatmap *heatmap,
+                             PkModel            *model,
+                             GQuark              key)
+{
+	static gint sequence = 0;
+	PpgRendererHeatmapPrivate *priv;
+	PpgRenderer *renderer = (PpgRenderer *)heatmap;
+	Row *row;
+
+	g_return_val_if_fail(PPG_IS_RENDERER_HEATMAP(heatmap), 0);
+	g_return_val_if_fail(PK_IS_MODEL(model), 0);
+	g_return_val_if_fail(key != 0, 0);
+
+	priv = heatmap->priv;
+
+	row = g_new0(Row, 1);
+	row->renderer = heatmap;
+	row->id = ++sequence;
+	row->key = key;
+	row->model = g_object_ref(model);
+	row->handler =
+		g_signal_connect(model, "notify::end-time",
+		                 G_CALLBACK(ppg_renderer_heatmap_notify_end_time),
+		                 row);
+
+	g_ptr_array_add(priv->rows, row);
+	ppg_renderer_emit_invalidate(renderer, 0.0, 0.0);
+
+	return row->id;
+}
+
+
+/**
+ * ppg_renderer_heatmap_get_rows:
+ * @heatmap: (in): A #PpgRendererHeatmap.
+ *
+ * Retrieves the number of rows in the heatmap.
+ *
+ * Returns: The number of rows.
+ * Side effects: None.
+ */
+guint
+ppg_renderer_heatmap_get_rows (PpgRendererHeatmap *heatmap)
+{
+	g_return_val_if_fail(PPG_IS_RENDERER_HEATMAP(heatmap), 0);
+	return heatmap->priv->rows->len;
+}
+
+
+/**
+ * ppg_renderer_heatmap_remove_index:
+ * @heatmap: (in): A #PpgRendererHeatmap.
+ * @index_: (in): The index of the row.
+ *
+ * Removes the row at @index_ and releases the model it shades.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_heatmap_remove_index (PpgRendererHeatmap *heatmap,
+                                   guint               index_)
+{
+	Row *row;
+
+	row = g_ptr_array_index(heatmap->priv->rows, index_);
+	g_signal_handler_disconnect(row->model, row->handler);
+	g_object_unref(row->model);
+	g_ptr_array_remove_index(heatmap->priv->rows, index_);
+	g_free(row);
+}
+
+
+/**
+ * ppg_renderer_heatmap_remove:
+ * @heatmap: (in): A #PpgRendererHeatmap.
+ * @identifier: (in): The identifier returned from
+ *   ppg_renderer_heatmap_append().
+ *
+ * Removes a row from the heatmap.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+ppg_renderer_heatmap_remove (PpgRendererHeatmap *heatmap,
+                             gint                identifier)
+{
+	PpgRendererHeatmapPrivate *priv;
+	Row *row;
+	gint i;
+
+	g_return_if_fail(PPG_IS_RENDERER_HEATMAP(heatmap));
+	g_return_if_fail(identifier > 0);
+
+	priv = heatmap->priv;
+
+	for (i = 0; i < priv->rows->len; i++) {
+		row = g_ptr_array_index(priv->rows, i);
+		if (row->id == identifier) {
+			ppg_renderer_heatmap_remove_index(heatmap, i);
+			ppg_renderer_emit_invalidate(PPG_RENDERER(heatmap), 0.0, 0.0);
+			break;
+		}
+	}
+}
+
+
+/**
+ * ppg_renderer_heatmap_dispose:
+ * @object: (in): A #GObject.
+ *
+ * Dispose callback for @object.  This method releases references held
+ * by the #GObject instance.
+ *
+ * Returns: None.
+ * Side effects: Plenty.
+ */
+static void
+ppg_renderer_heatmap_dispose (GObject *object)
+{
+	PpgRendererHeatmap *heatmap = (PpgRendererHeatmap *)object;
+
+	ENTRY;
+
+	while (heatmap->priv->rows->len) {
+		ppg_renderer_heatmap_remove_index(heatmap,
+		                                  heatmap->priv->rows->len - 1);
+	}
+	ppg_clear_object(&heatmap->priv->range);
+
+	G_OBJECT_CLASS(ppg_renderer_heatmap_parent_class)->dispose(object);
+
+	EXIT;
+}
+
+
+/**
+ * ppg_renderer_heatmap_finalize:
+ * @object: (in): A #PpgRendererHeatmap.
+ *
+ * Finalizer for a #PpgRendererHeatmap instance.  Frees any resources held
+ * by the instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_heatmap_finalize (GObject *object)
+{
+	PpgRendererHeatmapPrivate *priv = PPG_RENDERER_HEATMAP(object)->priv;
+
+	ENTRY;
+
+	g_ptr_array_free(priv->rows, TRUE);
+
+	G_OBJECT_CLASS(ppg_renderer_heatmap_parent_class)->finalize(object);
+
+	EXIT;
+}
+
+
+/**
+ * ppg_renderer_heatmap_class_init:
+ * @klass: (in): A #PpgRendererHeatmapClass.
+ *
+ * Initializes the #PpgRendererHeatmapClass and prepares the vtable.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_heatmap_class_init (PpgRendererHeatmapClass *klass)
+{
+	GObjectClass *object_class;
+
+	object_class = G_OBJECT_CLASS(klass);
+	object_class->dispose = ppg_renderer_heatmap_dispose;
+	object_class->finalize = ppg_renderer_heatmap_finalize;
+	g_type_class_add_private(object_class, sizeof(PpgRendererHeatmapPrivate));
+
+	ppg_renderer_heatmap_init_shades();
+}
+
+
+/**
+ * ppg_renderer_heatmap_init:
+ * @heatmap: (in): A #PpgRendererHeatmap.
+ *
+ * Initializes the newly created #PpgRendererHeatmap instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_heatmap_init (PpgRendererHeatmap *heatmap)
+{
+	heatmap->priv =
+		G_TYPE_INSTANCE_GET_PRIVATE(heatmap,
+		                            PPG_TYPE_RENDERER_HEATMAP,
+		                            PpgRendererHeatmapPrivate);
+	heatmap->priv->rows = g_ptr_array_new();
+	heatmap->priv->range = g_object_new(GTK_TYPE_ADJUSTMENT,
+	                                    "lower", 0.0,
+	                                    "upper", 100.0,
+	                                    NULL);
+	g_object_ref_sink(heatmap->priv->range);
+}
+
+
+static void
+ppg_renderer_init (PpgRendererIface *iface)
+{
+	iface->draw = ppg_renderer_heatmap_draw;
+	iface->get_adjustment = ppg_renderer_heatmap_get_adjustment;
+}
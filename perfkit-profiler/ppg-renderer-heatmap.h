@@ -0,0 +1,63 @@
+/* ppg-renderer-heatmap.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPG_RENDERER_HEATMAP_H
+#define PPG_RENDERER_HEATMAP_H
+
+#include <perfkit/perfkit.h>
+
+#include "ppg-renderer.h"
+
+G_BEGIN_DECLS
+
+#define PPG_TYPE_RENDERER_HEATMAP            (ppg_renderer_heatmap_get_type())
+#define PPG_RENDERER_HEATMAP(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), PPG_TYPE_RENDERER_HEATMAP, PpgRendererHeatmap))
+#define PPG_RENDERER_HEATMAP_CONST(obj)      (G_TYPE_CHECK_INSTANCE_CAST ((obj), PPG_TYPE_RENDERER_HEATMAP, PpgRendererHeatmap const))
+#define PPG_RENDERER_HEATMAP_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  PPG_TYPE_RENDERER_HEATMAP, PpgRendererHeatmapClass))
+#define PPG_IS_RENDERER_HEATMAP(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), PPG_TYPE_RENDERER_HEATMAP))
+#define PPG_IS_RENDERER_HEATMAP_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  PPG_TYPE_RENDERER_HEATMAP))
+#define PPG_RENDERER_HEATMAP_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  PPG_TYPE_RENDERER_HEATMAP, PpgRendererHeatmapClass))
+
+typedef struct _PpgRendererHeatmap        PpgRendererHeatmap;
+typedef struct _PpgRendererHeatmapClass   PpgRendererHeatmapClass;
+typedef struct _PpgRendererHeatmapPrivate PpgRendererHeatmapPrivate;
+
+struct _PpgRendererHeatmap
+{
+	GInitiallyUnowned parent;
+
+	/*< private >*/
+	PpgRendererHeatmapPrivate *priv;
+};
+
+struct _PpgRendererHeatmapClass
+{
+	GInitiallyUnownedClass parent_class;
+};
+
+GType ppg_renderer_heatmap_get_type (void) G_GNUC_CONST;
+gint  ppg_renderer_heatmap_append   (PpgRendererHeatmap *heatmap,
+                                     PkModel            *model,
+                                     GQuark              key);
+guint ppg_renderer_heatmap_get_rows (PpgRendererHeatmap *heatmap);
+void  ppg_renderer_heatmap_remove   (PpgRendererHeatmap *heatmap,
+                                     gint                identifier);
+
+G_END_DECLS
+
+#endif /* PPG_RENDERER_HEATMAP_H */
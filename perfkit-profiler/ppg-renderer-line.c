@@ -16,14 +16,27 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 #include <perfkit/perfkit.h>
 #include <string.h>
 
 #include "ppg-log.h"
+#include "ppg-raster.h"
 #include "ppg-renderer-line.h"
 #include "ppg-task-render.h"
 #include "ppg-util.h"
 
+/*
+ * The value range is scaled to the visible samples with some headroom,
+ * rounded to 1, 2 or 5 times a power of ten. It grows as soon as samples
+ * fall outside of it, but only shrinks once the samples use less than
+ * AUTOSCALE_SHRINK of it, so that it does not change with every frame.
+ * Rounding leaves at least 40% in use, so a new range never shrinks
+ * right away.
+ */
+#define AUTOSCALE_HEADROOM (1.1)
+#define AUTOSCALE_SHRINK   (0.25)
+
 
 typedef struct
 {
@@ -36,16 +49,61 @@ typedef struct
 	gdouble          width;    /* cairo_set_line_width() */
 	gdouble         *dashes;   /* cairo_set_dash() */
 	gdouble          n_dashes; /* cairo_set_dash() */
+	gboolean         smooth;   /* Draw curves instead of segments */
 	guint            handler;  /* notify:: handler id */
 	gdouble          end_time; /* End time of last item */
 } Line;
 
 
+/*
+ * The state a render task draws from, copied from the renderer on the
+ * main thread when the task is created.
+ */
+typedef struct
+{
+	GPtrArray *lines;     /* Copies of each Line */
+	gboolean   rasterize;
+	gdouble    lower;
+	gdouble    upper;
+} Snapshot;
+
+
+typedef struct
+{
+	gdouble x;
+	gdouble y;
+} Point;
+
+
+/*
+ * The envelope of the samples that fall within a single pixel column.
+ * top and bottom are surface coordinates, so top holds the largest value.
+ */
+typedef struct
+{
+	guint n_points;
+	Point first;
+	Point last;
+	Point top;
+	Point bottom;
+	guint top_seq;
+	guint bottom_seq;
+} Bucket;
+
+
 struct _PpgRendererLinePrivate
 {
 	GPtrArray     *lines;
 	GtkAdjustment *range;
 	gdouble        end_time;
+	gboolean       autoscale;
+	gboolean       rasterize;   /* Draw plain lines without cairo */
+	gdouble        lower;       /* Value at the bottom of the surface */
+	gdouble        upper;       /* Value at the top of the surface */
+	gdouble        begin_time;  /* Visible time range */
+	gdouble        end_time_visible;
+	gdouble        scaled_begin; /* Time range lower and upper fit */
+	gdouble        scaled_end;
 };
 
 
@@ -80,28 +138,295 @@ get_y_for_range (gdouble ratio,
 }
 
 
+static inline void
+bucket_add (Bucket      *bucket,
+            const Point *point,
+            guint        seq)
+{
+	if (!bucket->n_points++) {
+		bucket->first = *point;
+		bucket->top = *point;
+		bucket->bottom = *point;
+		bucket->top_seq = seq;
+		bucket->bottom_seq = seq;
+	} else if (point->y < bucket->top.y) {
+		bucket->top = *point;
+		bucket->top_seq = seq;
+	} else if (point->y > bucket->bottom.y) {
+		bucket->bottom = *point;
+		bucket->bottom_seq = seq;
+	}
+	bucket->last = *point;
+}
+
+
+/**
+ * ppg_renderer_line_envelope:
+ * @buckets: (in): An array of #Bucket, one per pixel column.
+ * @n_buckets: (in): The number of buckets.
+ * @points: (out): A #GArray of #Point to append to.
+ *
+ * Reduces the samples of each pixel column to the first, highest, lowest
+ * and last sample, in the order they were seen.  This keeps every spike
+ * visible while bounding the path to four points per pixel.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
 static void
-ppg_renderer_line_render (PpgRendererLine *line,
-                          PpgTask         *task)
+ppg_renderer_line_envelope (Bucket *buckets,
+                            guint   n_buckets,
+                            GArray *points)
 {
-	PpgRendererLinePrivate *priv;
+	Bucket *bucket;
+	Point *inner[2];
+	guint i;
+	guint j;
+
+	for (i = 0; i < n_buckets; i++) {
+		bucket = &buckets[i];
+		if (!bucket->n_points) {
+			continue;
+		}
+		g_array_append_val(points, bucket->first);
+		if (bucket->n_points == 1) {
+			continue;
+		}
+		inner[0] = &bucket->top;
+		inner[1] = &bucket->bottom;
+		if (bucket->bottom_seq < bucket->top_seq) {
+			inner[0] = &bucket->bottom;
+			inner[1] = &bucket->top;
+		}
+		for (j = 0; j < G_N_ELEMENTS(inner); j++) {
+			if (memcmp(inner[j], &bucket->first, sizeof(Point)) &&
+			    memcmp(inner[j], &bucket->last, sizeof(Point))) {
+				g_array_append_val(points, *inner[j]);
+			}
+		}
+		g_array_append_val(points, bucket->last);
+	}
+}
+
+
+/**
+ * ppg_renderer_line_downsample:
+ * @points: (in): A #GArray of #Point.
+ * @threshold: (in): The number of points to keep.
+ * @sampled: (out): A #GArray of #Point to append to.
+ *
+ * Picks @threshold points of @points using Largest-Triangle-Three-Buckets.
+ * Each point kept forms the largest triangle with the point kept before
+ * it and the average of the next bucket, which preserves the shape of the
+ * line better than keeping a fixed sample per bucket.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_line_downsample (GArray *points,
+                              guint   threshold,
+                              GArray *sampled)
+{
+	Point *data = (Point *)points->data;
+	Point avg;
+	gdouble every;
+	gdouble area;
+	gdouble max_area;
+	guint range_begin;
+	guint range_end;
+	guint avg_begin;
+	guint avg_end;
+	guint chosen = 0;
+	guint a = 0;
+	guint i;
+	guint j;
+
+	if (points->len <= threshold || threshold < 3) {
+		g_array_append_vals(sampled, data, points->len);
+		return;
+	}
+
+	every = (gdouble)(points->len - 2) / (threshold - 2);
+	g_array_append_val(sampled, data[0]);
+
+	for (i = 0; i < threshold - 2; i++) {
+		avg_begin = (guint)((i + 1) * every) + 1;
+		avg_end = MIN((guint)((i + 2) * every) + 1, points->len);
+		avg.x = avg.y = 0.0;
+		for (j = avg_begin; j < avg_end; j++) {
+			avg.x += data[j].x;
+			avg.y += data[j].y;
+		}
+		avg.x /= (avg_end - avg_begin);
+		avg.y /= (avg_end - avg_begin);
+
+		range_begin = (guint)(i * every) + 1;
+		range_end = (guint)((i + 1) * every) + 1;
+		max_area = -1.0;
+		for (j = range_begin; j < range_end; j++) {
+			area = ABS((data[a].x - avg.x) * (data[j].y - data[a].y) -
+			           (data[a].x - data[j].x) * (avg.y - data[a].y));
+			if (area > max_area) {
+				max_area = area;
+				chosen = j;
+			}
+		}
+		g_array_append_val(sampled, data[chosen]);
+		a = chosen;
+	}
+
+	g_array_append_val(sampled, data[points->len - 1]);
+}
+
+
+/**
+ * ppg_renderer_line_spans:
+ * @buckets: (in): An array of #Bucket, one per pixel column.
+ * @n_buckets: (in): The number of buckets.
+ * @x: (in): The X coordinate of the first pixel column.
+ * @tops: (out): The top of the line within each column.
+ * @bottoms: (out): The bottom of the line within each column.
+ *
+ * Computes the vertical extent of a line drawn through the samples of
+ * @buckets within each pixel column. That is the envelope of the samples
+ * in the column along with the segments joining them to the samples of
+ * the neighbouring columns.  Columns the line does not cross get a top
+ * below their bottom.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_line_spans (Bucket  *buckets,
+                         guint    n_buckets,
+                         gdouble  x,
+                         gfloat  *tops,
+                         gfloat  *bottoms)
+{
+	Point *from = NULL;
+	Point *to;
+	gdouble slope;
+	gdouble x0;
+	gdouble x1;
+	gdouble y0;
+	gdouble y1;
+	guint prev = 0;
+	guint i;
+	guint j;
+
+	for (i = 0; i < n_buckets; i++) {
+		tops[i] = G_MAXFLOAT;
+		bottoms[i] = -G_MAXFLOAT;
+	}
+
+	for (i = 0; i < n_buckets; i++) {
+		if (!buckets[i].n_points) {
+			continue;
+		}
+		tops[i] = MIN(tops[i], buckets[i].top.y);
+		bottoms[i] = MAX(bottoms[i], buckets[i].bottom.y);
+
+		/*
+		 * Cover the segment from the last sample of the previous column
+		 * with samples within each column it crosses.
+		 */
+		if (from) {
+			to = &buckets[i].first;
+			slope = 0.0;
+			if (to->x > from->x) {
+				slope = (to->y - from->y) / (to->x - from->x);
+			}
+			for (j = prev; j <= i; j++) {
+				x0 = CLAMP(x + j, from->x, MAX(from->x, to->x));
+				x1 = CLAMP(x + j + 1, from->x, MAX(from->x, to->x));
+				y0 = from->y + slope * (x0 - from->x);
+				y1 = from->y + slope * (x1 - from->x);
+				tops[j] = MIN(tops[j], MIN(y0, y1));
+				bottoms[j] = MAX(bottoms[j], MAX(y0, y1));
+			}
+		}
+		from = &buckets[i].last;
+		prev = i;
+	}
+}
+
+
+/**
+ * ppg_renderer_line_copy_line:
+ * @item: (in): A #Line.
+ *
+ * Copies @item for a render task, holding a reference to its model.
+ *
+ * Returns: A newly allocated #Line to be freed with
+ *   ppg_renderer_line_free_line().
+ * Side effects: None.
+ */
+static Line*
+ppg_renderer_line_copy_line (Line *item)
+{
+	Line *copy;
+
+	copy = g_memdup(item, sizeof *item);
+	copy->renderer = NULL;
+	copy->handler = 0;
+	copy->model = g_object_ref(item->model);
+	copy->dashes = g_memdup(item->dashes,
+	                        sizeof(gdouble) * (guint)item->n_dashes);
+	return copy;
+}
+
+
+static void
+ppg_renderer_line_free_line (Line *item)
+{
+	g_object_unref(item->model);
+	g_free(item->dashes);
+	g_free(item);
+}
+
+
+static void
+ppg_renderer_line_free_snapshot (Snapshot *snapshot)
+{
+	g_ptr_array_foreach(snapshot->lines,
+	                    (GFunc)ppg_renderer_line_free_line,
+	                    NULL);
+	g_ptr_array_free(snapshot->lines, TRUE);
+	g_slice_free(Snapshot, snapshot);
+}
+
+
+static void
+ppg_renderer_line_render (PpgTask  *task,
+                          Snapshot *snapshot)
+{
+	static const PkModelAggregate rollup[] = {
+		PK_MODEL_AGGREGATE_FIRST,
+		PK_MODEL_AGGREGATE_MIN,
+		PK_MODEL_AGGREGATE_MAX,
+		PK_MODEL_AGGREGATE_LAST,
+	};
 	cairo_surface_t *surface;
 	PkModelIter iter;
 	cairo_t *cr;
-	struct {
-		gdouble x;
-		gdouble y;
-	} point;
+	Bucket *buckets;
+	Bucket *bucket;
+	GArray *path;
+	GArray *points;
+	GArray *sampled;
+	gboolean rasterize;
+	gfloat *bottoms;
+	gfloat *tops;
+	Point *last;
+	Point point;
 	gdouble aggregate_time;
 	gdouble begin_value;
 	gdouble begin_time;
 	gdouble current_x;
 	gdouble current_y;
 	gdouble end_time;
-	gdouble first_x;
 	gdouble height;
-	gdouble last_x;
-	gdouble last_y;
 	gdouble value;
 	gdouble width;
 	gdouble x;
@@ -110,14 +435,15 @@ ppg_renderer_line_render (PpgRendererLine *line,
 	gdouble y2;
 	gdouble y_ratio;
 	Line *item;
+	guint n_buckets;
+	guint seq;
 	gint i;
+	gint j;
 
 	ENTRY;
 
-	g_return_if_fail(PPG_IS_RENDERER_LINE(line));
 	g_return_if_fail(PPG_IS_TASK(task));
-
-	priv = line->priv;
+	g_return_if_fail(snapshot != NULL);
 
 	g_object_get(task,
 	             "begin-time", &begin_time,
@@ -139,8 +465,8 @@ ppg_renderer_line_render (PpgRendererLine *line,
 
 	y2 = y + height;
 	x_ratio = width / (end_time - begin_time);
-	y_ratio = height / 100.0;  /* TODO Calculate/get from model */
-	begin_value = 0.0;         /* TODO Calculate/get from model */
+	y_ratio = height / (snapshot->upper - snapshot->lower);
+	begin_value = snapshot->lower;
 
 	/*
 	 * To reduce the number of data points we look at, we will ask the
@@ -149,10 +475,32 @@ ppg_renderer_line_render (PpgRendererLine *line,
 	 */
 	aggregate_time = (end_time - begin_time) / width;
 
+	/*
+	 * Models that do not aggregate return every sample, and rollups may
+	 * still be finer than a pixel, so reduce what we get to one bucket per
+	 * pixel column ourselves. This bounds the path handed to cairo by the
+	 * width of the surface rather than the number of samples.
+	 */
+	n_buckets = (guint)ceil(width) + 1;
+	buckets = g_new(Bucket, n_buckets);
+	points = g_array_sized_new(FALSE, FALSE, sizeof(Point), n_buckets * 4);
+	sampled = g_array_sized_new(FALSE, FALSE, sizeof(Point), n_buckets);
+	tops = g_new(gfloat, n_buckets);
+	bottoms = g_new(gfloat, n_buckets);
+
+	/*
+	 * We can only draw the pixels ourselves on image surfaces, and only
+	 * when the columns line up with the pixels.
+	 */
+	rasterize = (snapshot->rasterize &&
+	             x == floor(x) &&
+	             cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE &&
+	             cairo_image_surface_get_format(surface) == CAIRO_FORMAT_ARGB32);
+
 	cr = cairo_create(surface);
 
-	for (i = 0; i < priv->lines->len; i++) {
-		item = g_ptr_array_index(priv->lines, i);
+	for (i = 0; i < snapshot->lines->len; i++) {
+		item = g_ptr_array_index(snapshot->lines, i);
 
 		/*
 		 * Apply line styling.
@@ -161,44 +509,120 @@ ppg_renderer_line_render (PpgRendererLine *line,
 		cairo_set_dash(cr, item->dashes, item->n_dashes, 0.0);
 		gdk_cairo_set_source_color(cr, &item->color);
 
-		if (pk_model_get_iter_for_range(item->model, &iter,
-		                                begin_time, end_time,
-		                                aggregate_time)) {
-			first_x = get_x_for_time(x_ratio, x, begin_time, iter.time);
-			last_x = first_x;
+		/*
+		 * Only hold the model while collecting the envelope, the
+		 * drawing happens on our own copy.
+		 */
+		pk_model_lock(item->model);
+		if (!pk_model_get_iter_for_range(item->model, &iter,
+		                                 begin_time, end_time,
+		                                 aggregate_time)) {
+			pk_model_unlock(item->model);
+			continue;
+		}
+		memset(buckets, 0, sizeof(Bucket) * n_buckets);
+		seq = 0;
+		do {
+			point.x = get_x_for_time(x_ratio, x, begin_time, iter.time);
+			bucket = &buckets[CLAMP((gint)(point.x - x), 0,
+			                        (gint)n_buckets - 1)];
+
+			/*
+			 * The value of a rollup is the mean of its samples, which
+			 * would flatten any spikes, so add its extremes instead.
+			 */
+			if (pk_model_get_aggregate(item->model, &iter, item->key,
+			                           PK_MODEL_AGGREGATE_COUNT) > 1.0) {
+				for (j = 0; j < G_N_ELEMENTS(rollup); j++) {
+					value = pk_model_get_aggregate(item->model, &iter,
+					                               item->key, rollup[j]);
+					point.y = get_y_for_range(y_ratio, y2, begin_value, value);
+					bucket_add(bucket, &point, seq++);
+				}
+				continue;
+			}
+
 			value = pk_model_get_double(item->model, &iter, item->key);
-			last_y = get_y_for_range(y_ratio, y2, begin_value, value);
-			cairo_move_to(cr, last_x, last_y);
-			while (pk_model_iter_next(item->model, &iter)) {
-				value = pk_model_get_double(item->model, &iter, item->key);
-				point.x = get_x_for_time(x_ratio, x, begin_time, iter.time);
-				point.y = get_y_for_range(y_ratio, y2, begin_value, value);
+			point.y = get_y_for_range(y_ratio, y2, begin_value, value);
+			bucket_add(bucket, &point, seq++);
+		} while (pk_model_iter_next(item->model, &iter));
+		pk_model_unlock(item->model);
+
+		/*
+		 * Once there is a sample for every pixel column, curves and
+		 * segments look alike, so plain lines can be drawn as a span
+		 * per column rather than stroked by cairo.
+		 */
+		if (rasterize && !item->n_dashes &&
+		    (!item->smooth || seq >= n_buckets)) {
+			ppg_renderer_line_spans(buckets, n_buckets, x, tops, bottoms);
+			for (j = 0; j < n_buckets; j++) {
+				if (tops[j] <= bottoms[j]) {
+					tops[j] -= item->width / 2.0;
+					bottoms[j] = item->fill ? y2
+					                        : bottoms[j] + item->width / 2.0;
+				}
+			}
+			ppg_raster_fill_spans(surface, (gint)x, tops, bottoms, n_buckets,
+			                      item->color.red / 65535.0,
+			                      item->color.green / 65535.0,
+			                      item->color.blue / 65535.0,
+			                      1.0);
+			continue;
+		}
+
+		g_array_set_size(points, 0);
+		g_array_set_size(sampled, 0);
+		ppg_renderer_line_envelope(buckets, n_buckets, points);
+
+		/*
+		 * Curves through every point of the envelope would loop back
+		 * on themselves, so smooth lines keep about one point per
+		 * pixel instead.
+		 */
+		path = points;
+		if (item->smooth) {
+			ppg_renderer_line_downsample(points, n_buckets, sampled);
+			path = sampled;
+		}
+
+		last = &g_array_index(path, Point, 0);
+		cairo_move_to(cr, last->x, last->y);
+		for (j = 1; j < path->len; j++) {
+			point = g_array_index(path, Point, j);
+			if (item->smooth) {
 				cairo_curve_to(cr,
-				               last_x + ((point.x - last_x) / 2.0),
-				               last_y,
-				               last_x + ((point.x - last_x) / 2.0),
+				               last->x + ((point.x - last->x) / 2.0),
+				               last->y,
+				               last->x + ((point.x - last->x) / 2.0),
 				               point.y,
 				               point.x,
 				               point.y);
-				last_x = point.x;
-				last_y = point.y;
-			}
-
-			/*
-			 * Stroke or fill the path of data points.
-			 */
-			if (item->fill) {
-				cairo_get_current_point(cr, &current_x, &current_y);
-				cairo_line_to(cr, current_x, y + height);
-				cairo_line_to(cr, x, y + height);
-				cairo_fill(cr);
 			} else {
-				cairo_stroke(cr);
+				cairo_line_to(cr, point.x, point.y);
 			}
+			last = &g_array_index(path, Point, j);
+		}
+
+		/*
+		 * Stroke or fill the path of data points.
+		 */
+		if (item->fill) {
+			cairo_get_current_point(cr, &current_x, &current_y);
+			cairo_line_to(cr, current_x, y + height);
+			cairo_line_to(cr, x, y + height);
+			cairo_fill(cr);
+		} else {
+			cairo_stroke(cr);
 		}
 	}
 
 	cairo_destroy(cr);
+	g_array_free(points, TRUE);
+	g_array_free(sampled, TRUE);
+	g_free(buckets);
+	g_free(tops);
+	g_free(bottoms);
 
 	EXIT;
 }
@@ -214,12 +638,32 @@ ppg_renderer_line_draw (PpgRenderer     *renderer,
                         gdouble          width,
                         gdouble          height)
 {
+	PpgRendererLinePrivate *priv;
+	Snapshot *snapshot;
 	PpgTask *task;
+	gint i;
 
 	ENTRY;
 
 	g_return_val_if_fail(PPG_IS_RENDERER_LINE(renderer), NULL);
 
+	priv = PPG_RENDERER_LINE(renderer)->priv;
+
+	/*
+	 * The task may run on another thread, so it draws from a copy of
+	 * the lines and range rather than from the renderer.
+	 */
+	snapshot = g_slice_new0(Snapshot);
+	snapshot->lines = g_ptr_array_sized_new(priv->lines->len);
+	snapshot->rasterize = priv->rasterize;
+	snapshot->lower = priv->lower;
+	snapshot->upper = priv->upper;
+	for (i = 0; i < priv->lines->len; i++) {
+		g_ptr_array_add(snapshot->lines,
+		                ppg_renderer_line_copy_line(
+		                    g_ptr_array_index(priv->lines, i)));
+	}
+
 	task = g_object_new(PPG_TYPE_TASK_RENDER,
 	                    "begin-time", begin_time,
 	                    "end-time", end_time,
@@ -229,10 +673,11 @@ ppg_renderer_line_draw (PpgRenderer     *renderer,
 	                    "x", x,
 	                    "y", y,
 	                    NULL);
-	g_signal_connect_object(task, "render",
-	                        G_CALLBACK(ppg_renderer_line_render),
-	                        renderer,
-	                        G_CONNECT_SWAPPED);
+	ppg_task_render_set_snapshot(PPG_TASK_RENDER(task), snapshot,
+	                             (GDestroyNotify)ppg_renderer_line_free_snapshot);
+	g_signal_connect(task, "render",
+	                 G_CALLBACK(ppg_renderer_line_render),
+	                 snapshot);
 	RETURN(task);
 }
 
@@ -246,19 +691,226 @@ ppg_renderer_line_get_adjustment (PpgRenderer *renderer)
 }
 
 
+/**
+ * ppg_renderer_line_range_changed:
+ * @line: (in): A #PpgRendererLine.
+ * @range: (in): The #GtkAdjustment of @line.
+ *
+ * Handles the "changed" signal of the value range, such as when the
+ * range is set by hand.  Everything is rendered again for the new range.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_line_range_changed (PpgRendererLine *line,
+                                 GtkAdjustment   *range)
+{
+	PpgRendererLinePrivate *priv = line->priv;
+	gdouble lower;
+	gdouble upper;
+
+	g_object_get(range,
+	             "lower", &lower,
+	             "upper", &upper,
+	             NULL);
+	if (upper <= lower || (lower == priv->lower && upper == priv->upper)) {
+		return;
+	}
+
+	priv->lower = lower;
+	priv->upper = upper;
+	ppg_renderer_emit_invalidate(PPG_RENDERER(line), 0.0, 0.0);
+}
+
+
+static inline gdouble
+nice_ceil (gdouble value)
+{
+	gdouble scale;
+	gdouble fraction;
+
+	if (value <= 0.0) {
+		return 0.0;
+	}
+
+	scale = pow(10.0, floor(log10(value)));
+	fraction = value / scale;
+	if (fraction <= 1.0) {
+		return scale;
+	} else if (fraction <= 2.0) {
+		return 2.0 * scale;
+	} else if (fraction <= 5.0) {
+		return 5.0 * scale;
+	}
+	return 10.0 * scale;
+}
+
+
+/**
+ * ppg_renderer_line_get_extents:
+ * @line: (in): A #PpgRendererLine.
+ * @begin_time: (in): The beginning of the time range.
+ * @end_time: (in): The end of the time range.
+ * @min: (out): A location for the smallest value.
+ * @max: (out): A location for the largest value.
+ *
+ * Retrieves the smallest and largest value of the lines within the time
+ * range.  The models answer from their indexes where they have them, and
+ * otherwise walk the samples of the range once.
+ *
+ * Returns: %TRUE if there were any samples within the range.
+ * Side effects: None.
+ */
+static gboolean
+ppg_renderer_line_get_extents (PpgRendererLine *line,
+                               gdouble          begin_time,
+                               gdouble          end_time,
+                               gdouble         *min,
+                               gdouble         *max)
+{
+	PpgRendererLinePrivate *priv = line->priv;
+	gboolean found = FALSE;
+	gdouble item_min;
+	gdouble item_max;
+	Line *item;
+	gint i;
+
+	for (i = 0; i < priv->lines->len; i++) {
+		item = g_ptr_array_index(priv->lines, i);
+		pk_model_lock(item->model);
+		if (pk_model_get_range_extents(item->model, item->key,
+		                               begin_time, end_time,
+		                               &item_min, &item_max)) {
+			*min = found ? MIN(*min, item_min) : item_min;
+			*max = found ? MAX(*max, item_max) : item_max;
+			found = TRUE;
+		}
+		pk_model_unlock(item->model);
+	}
+
+	return found;
+}
+
+
+/**
+ * ppg_renderer_line_fit:
+ * @line: (in): A #PpgRendererLine.
+ * @min: (in): The smallest value to show.
+ * @max: (in): The largest value to show.
+ * @shrink: (in): If the range may also shrink.
+ *
+ * Adjusts the value range of @line to hold @min and @max.  Ranges always
+ * include zero.  If the range changes, everything is rendered again.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_renderer_line_fit (PpgRendererLine *line,
+                       gdouble          min,
+                       gdouble          max,
+                       gboolean         shrink)
+{
+	PpgRendererLinePrivate *priv = line->priv;
+	gdouble lower = priv->lower;
+	gdouble upper = priv->upper;
+
+	if (max > upper || (shrink && max < upper * AUTOSCALE_SHRINK)) {
+		upper = nice_ceil(max * AUTOSCALE_HEADROOM);
+	}
+	if (min < lower || (shrink && min > lower * AUTOSCALE_SHRINK)) {
+		lower = -nice_ceil(-min * AUTOSCALE_HEADROOM);
+	}
+
+	if (upper <= lower || (lower == priv->lower && upper == priv->upper)) {
+		return;
+	}
+
+	priv->lower = lower;
+	priv->upper = upper;
+	g_object_set(priv->range,
+	             "lower", lower,
+	             "upper", upper,
+	             NULL);
+	ppg_renderer_emit_invalidate(PPG_RENDERER(line), 0.0, 0.0);
+}
+
+
+static void
+ppg_renderer_line_set_time (PpgRenderer *renderer,
+                            gdouble      begin_time,
+                            gdouble      end_time)
+{
+	PpgRendererLine *line = (PpgRendererLine *)renderer;
+	PpgRendererLinePrivate *priv;
+	gdouble span;
+	gdouble min;
+	gdouble max;
+
+	g_return_if_fail(PPG_IS_RENDERER_LINE(line));
+
+	priv = line->priv;
+	priv->begin_time = begin_time;
+	priv->end_time_visible = end_time;
+
+	if (!priv->autoscale) {
+		return;
+	}
+
+	/*
+	 * New samples already grow the range as they arrive, so while the
+	 * view follows them the range only needs fitting again once the
+	 * view has moved on by a good part of its width.
+	 */
+	span = end_time - begin_time;
+	if (span == priv->scaled_end - priv->scaled_begin &&
+	    ABS(begin_time - priv->scaled_begin) < span * AUTOSCALE_SHRINK) {
+		return;
+	}
+
+	priv->scaled_begin = begin_time;
+	priv->scaled_end = end_time;
+	if (ppg_renderer_line_get_extents(line, begin_time, end_time,
+	                                  &min, &max)) {
+		ppg_renderer_line_fit(line, min, max, TRUE);
+	}
+}
+
+
 static void
 ppg_renderer_line_notify_end_time (PkModel    *model,
                                    GParamSpec *pspec,
                                    Line       *item)
 {
+	PpgRendererLinePrivate *priv;
 	gdouble last_end_time;
+	gdouble min;
+	gdouble max;
 
 	g_return_if_fail(PK_IS_MODEL(model));
 	g_return_if_fail(item != NULL);
 	g_return_if_fail(PPG_IS_RENDERER_LINE(item->renderer));
 
+	priv = item->renderer->priv;
 	last_end_time = item->end_time;
 	item->end_time = pk_model_get_end_time(model);
+
+	/*
+	 * Grow the range for new samples that are visible, or for any new
+	 * samples if we were not told what is visible. Only the new samples
+	 * need to be looked at.
+	 */
+	if (priv->autoscale &&
+	    (priv->end_time_visible == 0.0 ||
+	     (item->end_time >= priv->begin_time &&
+	      last_end_time <= priv->end_time_visible)) &&
+	    ppg_renderer_line_get_extents(item->renderer,
+	                                  MAX(last_end_time, priv->begin_time),
+	                                  item->end_time, &min, &max)) {
+		ppg_renderer_line_fit(item->renderer, min, max, FALSE);
+	}
+
 	ppg_renderer_emit_invalidate(PPG_RENDERER(item->renderer),
 	                             last_end_time, item->end_time);
 }
@@ -285,6 +937,7 @@ ppg_renderer_line_append (PpgRendererLine *line,
 	new_line->id = ++sequence;
 	new_line->key = key;
 	new_line->width = 1.0;
+	new_line->smooth = TRUE;
 	new_line->model = g_object_ref(model);
 	new_line->handler =
 		g_signal_connect(model, "notify::end-time",
@@ -328,6 +981,101 @@ ppg_renderer_line_remove (PpgRendererLine *line,
 }
 
 
+/**
+ * ppg_renderer_line_set_autoscale:
+ * @line: (in): A #PpgRendererLine.
+ * @autoscale: (in): If the value range follows the visible samples.
+ *
+ * Sets if the value range of @line is scaled to the samples within the
+ * visible time range.  Otherwise the range of the adjustment returned by
+ * ppg_renderer_get_adjustment() is used as is.  Lines autoscale by
+ * default.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+ppg_renderer_line_set_autoscale (PpgRendererLine *line,
+                                 gboolean         autoscale)
+{
+	PpgRendererLinePrivate *priv;
+
+	g_return_if_fail(PPG_IS_RENDERER_LINE(line));
+
+	priv = line->priv;
+	priv->autoscale = autoscale;
+	priv->scaled_begin = 0.0;
+	priv->scaled_end = 0.0;
+	if (autoscale && priv->end_time_visible > priv->begin_time) {
+		ppg_renderer_line_set_time(PPG_RENDERER(line), priv->begin_time,
+		                           priv->end_time_visible);
+	}
+}
+
+
+/**
+ * ppg_renderer_line_set_rasterize:
+ * @line: (in): A #PpgRendererLine.
+ * @rasterize: (in): If lines may be drawn without cairo.
+ *
+ * Sets if lines without dashes are drawn straight into the pixels of
+ * image surfaces, a span per pixel column, rather than stroked with
+ * cairo.  Smooth lines are only drawn this way when there is a sample for
+ * every pixel column.  This is enabled by default.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+ppg_renderer_line_set_rasterize (PpgRendererLine *line,
+                                 gboolean         rasterize)
+{
+	g_return_if_fail(PPG_IS_RENDERER_LINE(line));
+
+	line->priv->rasterize = rasterize;
+	ppg_renderer_emit_invalidate(PPG_RENDERER(line), 0.0, 0.0);
+}
+
+
+/**
+ * ppg_renderer_line_set_smooth:
+ * @line: (in): A #PpgRendererLine.
+ * @identifier: (in): The line identifier.
+ * @smooth: (in): If the line should be drawn with curves.
+ *
+ * Sets if the line is drawn as curves through about one point per pixel,
+ * or as straight segments through the highest and lowest sample of each
+ * pixel.  Lines are smooth by default.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+ppg_renderer_line_set_smooth (PpgRendererLine *line,
+                              gint             identifier,
+                              gboolean         smooth)
+{
+	PpgRendererLinePrivate *priv;
+	PpgRenderer *renderer = (PpgRenderer *)line;
+	Line *item;
+	gint i;
+
+	g_return_if_fail(PPG_IS_RENDERER_LINE(line));
+
+	priv = line->priv;
+
+	for (i = 0; i < priv->lines->len; i++) {
+		item = g_ptr_array_index(priv->lines, i);
+		if (item->id == identifier) {
+			item->smooth = smooth;
+			break;
+		}
+	}
+
+	ppg_renderer_emit_invalidate(renderer, 0.0, 0.0);
+}
+
+
 void
 ppg_renderer_line_set_styling (PpgRendererLine *line,
                                gint             identifier,
@@ -483,6 +1231,13 @@ ppg_renderer_line_init (PpgRendererLine *line)
 	                                 "lower", 0.0,
 	                                 "upper", 100.0,
 	                                 NULL);
+	line->priv->autoscale = TRUE;
+	line->priv->rasterize = TRUE;
+	line->priv->lower = 0.0;
+	line->priv->upper = 100.0;
+	g_signal_connect_swapped(line->priv->range, "changed",
+	                         G_CALLBACK(ppg_renderer_line_range_changed),
+	                         line);
 }
 
 
@@ -491,4 +1246,5 @@ ppg_renderer_init (PpgRendererIface *iface)
 {
 	iface->draw = ppg_renderer_line_draw;
 	iface->get_adjustment = ppg_renderer_line_get_adjustment;
+	iface->set_time = ppg_renderer_line_set_time;
 }
@@ -50,18 +50,25 @@ struct _PpgRendererLineClass
 	GInitiallyUnownedClass parent_class;
 };
 
-GType ppg_renderer_line_get_type    (void) G_GNUC_CONST;
-gint  ppg_renderer_line_append      (PpgRendererLine *line,
-                                     PkModel         *model,
-                                     GQuark           key);
-void  ppg_renderer_line_remove      (PpgRendererLine *line,
-                                     gint             identifier);
-void  ppg_renderer_line_set_styling (PpgRendererLine *line,
-                                     gint             identifier,
-                                     const GdkColor  *color,
-                                     gdouble          line_width,
-                                     gdouble         *dashes,
-                                     gint             n_dashes);
+GType ppg_renderer_line_get_type      (void) G_GNUC_CONST;
+gint  ppg_renderer_line_append        (PpgRendererLine *line,
+                                       PkModel         *model,
+                                       GQuark           key);
+void  ppg_renderer_line_remove        (PpgRendererLine *line,
+                                       gint             identifier);
+void  ppg_renderer_line_set_autoscale (PpgRendererLine *line,
+                                       gboolean         autoscale);
+void  ppg_renderer_line_set_rasterize (PpgRendererLine *line,
+                                       gboolean         rasterize);
+void  ppg_renderer_line_set_smooth    (PpgRendererLine *line,
+                                       gint             identifier,
+                                       gboolean         smooth);
+void  ppg_renderer_line_set_styling   (PpgRendererLine *line,
+                                       gint             identifier,
+                                       const GdkColor  *color,
+                                       gdouble          line_width,
+                                       gdouble         *dashes,
+                                       gint             n_dashes);
 
 G_END_DECLS
 
@@ -88,6 +88,35 @@ ppg_renderer_get_adjustment (PpgRenderer *renderer)
 }
 
 
+/**
+ * ppg_renderer_set_time:
+ * @renderer: (in): A #PpgRenderer.
+ * @begin_time: (in): The beginning of the visible time range.
+ * @end_time: (in): The end of the visible time range.
+ *
+ * Lets @renderer know which time range is visible, such as for scaling
+ * to the values within it. Renderers that scale differently will emit
+ * the "invalidate" signal.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+ppg_renderer_set_time (PpgRenderer *renderer,
+                       gdouble      begin_time,
+                       gdouble      end_time)
+{
+	PpgRendererIface *iface;
+
+	g_return_if_fail(PPG_IS_RENDERER(renderer));
+
+	iface = PPG_RENDERER_GET_INTERFACE(renderer);
+	if (iface->set_time) {
+		iface->set_time(renderer, begin_time, end_time);
+	}
+}
+
+
 static void
 ppg_renderer_base_init (PpgRendererIface *iface)
 {
@@ -47,6 +47,9 @@ struct _PpgRendererIface
 	                                  gdouble          width,
 	                                  gdouble          height);
 	GtkAdjustment* (*get_adjustment) (PpgRenderer     *renderer);
+	void           (*set_time)       (PpgRenderer     *renderer,
+	                                  gdouble          begin_time,
+	                                  gdouble          end_time);
 };
 
 GType          ppg_renderer_get_type        (void) G_GNUC_CONST;
@@ -62,6 +65,9 @@ void           ppg_renderer_emit_invalidate (PpgRenderer     *renderer,
                                              gdouble          begin_time,
                                              gdouble          end_time);
 GtkAdjustment* ppg_renderer_get_adjustment  (PpgRenderer     *renderer);
+void           ppg_renderer_set_time        (PpgRenderer     *renderer,
+                                             gdouble          begin_time,
+                                             gdouble          end_time);
 
 G_END_DECLS
 
@@ -39,6 +39,7 @@
 #define ZOOM_MAX           200.0
 #define ZOOM_MIN           0.005
 #define PIXELS_PER_SECOND  10
+#define ROW_OVERSCAN       2
 
 
 G_DEFINE_TYPE(PpgSessionView, ppg_session_view, GTK_TYPE_ALIGNMENT)
@@ -48,6 +49,8 @@ struct _PpgSessionViewPrivate
 {
 	PpgSession *session;         /* Current session */
 	GPtrArray *instrument_views; /* Array of PpgInstrumentViews */
+	gint first_onscreen;         /* First row realized for drawing */
+	gint last_onscreen;          /* Last row realized for drawing */
 	gdouble last_width;          /* Last widget resize width */
 	gdouble last_height;         /* Last widget resize height */
 	gdouble zoom;                /* Current zoom level; 1.0 is default */
@@ -403,6 +406,101 @@ ppg_session_view_instrument_button_press_event (PpgSessionView    *view,
 }
 
 
+/**
+ * ppg_session_view_find_row:
+ * @view: (in): A #PpgSessionView.
+ * @y: (in): A device y coordinate.
+ *
+ * Finds the first row whose bottom edge is below @y. Rows are laid out
+ * top to bottom so a binary search over their bounds is enough.
+ *
+ * Returns: The row index, or the number of rows if none are below @y.
+ * Side effects: None.
+ */
+static gint
+ppg_session_view_find_row (PpgSessionView *view,
+                           gdouble         y)
+{
+	PpgSessionViewPrivate *priv;
+	GooCanvasBounds bounds;
+	GooCanvasItem *item;
+	gint lo;
+	gint hi;
+	gint mid;
+
+	g_return_val_if_fail(PPG_IS_SESSION_VIEW(view), 0);
+
+	priv = view->priv;
+
+	lo = 0;
+	hi = priv->instrument_views->len;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		item = g_ptr_array_index(priv->instrument_views, mid);
+		goo_canvas_item_get_bounds(item, &bounds);
+		if (bounds.y2 > y) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	return lo;
+}
+
+
+/**
+ * ppg_session_view_update_onscreen:
+ * @view: (in): A #PpgSessionView.
+ *
+ * Realizes the rows within the visible area, plus a few rows of overscan
+ * on either side. The rest are frozen and their visualizers taken out of
+ * the canvas layout, leaving fixed-height placeholders, so that layout
+ * and rendering cost follows the visible rows rather than the total.
+ * Only the rows entering or leaving the range are touched.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_session_view_update_onscreen (PpgSessionView *view)
+{
+	PpgSessionViewPrivate *priv;
+	PpgInstrumentView *inst_view;
+	gdouble page_size;
+	gint first;
+	gint last;
+	gint i;
+
+	g_return_if_fail(PPG_IS_SESSION_VIEW(view));
+
+	priv = view->priv;
+
+	if (!priv->instrument_views) {
+		return;
+	}
+
+	page_size = gtk_adjustment_get_page_size(priv->vadj);
+	first = ppg_session_view_find_row(view, 0.0);
+	last = ppg_session_view_find_row(view, page_size);
+	first = MAX(0, first - ROW_OVERSCAN);
+	last = MIN((gint)priv->instrument_views->len - 1, last + ROW_OVERSCAN);
+
+	for (i = MIN(first, priv->first_onscreen);
+	     i <= MAX(last, priv->last_onscreen);
+	     i++) {
+		if (i < 0 || i >= priv->instrument_views->len) {
+			continue;
+		}
+		inst_view = g_ptr_array_index(priv->instrument_views, i);
+		ppg_instrument_view_set_onscreen(inst_view, i >= first && i <= last);
+	}
+
+	priv->first_onscreen = first;
+	priv->last_onscreen = last;
+}
+
+
 /**
  * ppg_session_view_vadj_value_changed:
  * @view: (in): A #PpgSessionView.
@@ -424,6 +522,7 @@ ppg_session_view_vadj_value_changed (PpgSessionView *view,
 
 	value = gtk_adjustment_get_value(vadj);
 	g_object_set(view->priv->all_content, "y", -value, NULL);
+	ppg_session_view_update_onscreen(view);
 }
 
 
@@ -473,6 +572,8 @@ ppg_session_view_update_vadj (PpgSessionView *view)
 	if ((bounds.y2 - SHADOW_HEIGHT) < (page_size / 2.0)) {
 		gtk_adjustment_set_value(priv->vadj, upper - page_size);
 	}
+
+	ppg_session_view_update_onscreen(view);
 }
 
 
@@ -550,12 +651,20 @@ ppg_session_view_instrument_added (PpgSessionView *view,
 	                         view);
 	g_ptr_array_add(priv->instrument_views, inst_view);
 
+	/*
+	 * New rows start out frozen and are realized below if they land within
+	 * the visible area.
+	 */
+	ppg_instrument_view_set_onscreen(inst_view, FALSE);
+
 	/*
 	 * Let the view know what its width should be.
 	 */
 	gtk_widget_get_allocation(GTK_WIDGET(priv->canvas), &a);
 	g_object_set(inst_view, "width", (gdouble)a.width, NULL);
 	g_object_notify(G_OBJECT(inst_view), "width");
+
+	ppg_session_view_update_onscreen(view);
 }
 
 
@@ -2237,6 +2346,7 @@ ppg_session_view_init (PpgSessionView *view)
 	view->priv = priv;
 
 	priv->instrument_views = g_ptr_array_new();
+	priv->last_onscreen = -1;
 	priv->zoom = 1.0;
 
 	priv->paned = g_object_new(GTK_TYPE_VPANED,
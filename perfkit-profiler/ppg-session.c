@@ -21,6 +21,7 @@
 #include "ppg-clock-source.h"
 #include "ppg-instrument.h"
 #include "ppg-log.h"
+#include "ppg-prefs.h"
 #include "ppg-session.h"
 #include "ppg-util.h"
 
@@ -632,16 +633,31 @@ ppg_session_get_started_at (PpgSession *session)
 PkModel*
 ppg_session_create_model (PpgSession *session)
 {
+	GSettings *settings;
 	PkModel *model;
+	GError *error = NULL;
 
 	g_return_val_if_fail(PPG_IS_SESSION(session), NULL);
 
 	/*
-	 * TODO: Eventually, use an mmap'able data model.
+	 * Samples are kept in columnar models, which keep rollups for
+	 * zoomed out views. Long captures may instead store samples in an
+	 * anonymous file so their length is not limited by memory, or
+	 * compress them in memory.
 	 */
-	model = g_object_new(PK_TYPE_MODEL_MEMORY, NULL);
+	settings = ppg_prefs_get_project_settings();
+	if (g_settings_get_boolean(settings, "store-on-disk")) {
+		if ((model = pk_model_mapped_new(NULL, &error))) {
+			return model;
+		}
+		g_warning("Failed to create model file: %s", error->message);
+		g_error_free(error);
+	}
+	if (g_settings_get_boolean(settings, "compress-samples")) {
+		return g_object_new(PK_TYPE_MODEL_COMPRESSED, NULL);
+	}
 
-	return model;
+	return g_object_new(PK_TYPE_MODEL_COLUMNAR, NULL);
 }
 
 
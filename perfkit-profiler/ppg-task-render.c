@@ -27,10 +27,14 @@ G_DEFINE_TYPE(PpgTaskRender, ppg_task_render, PPG_TYPE_TASK)
 
 
 /*
- * XXX: Until pixman is fixed, the max threads we can do here is really
- *      just the Xorg thread. Otherwise craziness happens. Ugh.
+ * Tasks render onto their own image surfaces, which are created and
+ * destroyed from the main thread, so only the drawing happens here.
+ * Renderers draw from a snapshot of their state handed to the task with
+ * ppg_task_render_set_snapshot(), and must hold pk_model_lock() while
+ * reading their models. Setting this to 1 renders from the main loop
+ * instead.
  */
-#define MAX_THREADS 1
+#define MAX_THREADS 4
 
 
 struct _PpgTaskRenderPrivate
@@ -43,6 +47,8 @@ struct _PpgTaskRenderPrivate
 	gdouble y;
 	gdouble width;
 	gdouble height;
+	gpointer snapshot;
+	GDestroyNotify snapshot_notify;
 };
 
 
@@ -81,6 +87,87 @@ static guint signals[LAST_SIGNAL] = { 0 };
 static guint render_handler = 0;
 
 
+/**
+ * ppg_task_render_release_snapshot:
+ * @render: (in): A #PpgTaskRender.
+ *
+ * Releases the snapshot set with ppg_task_render_set_snapshot(), if any.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_task_render_release_snapshot (PpgTaskRender *render)
+{
+	PpgTaskRenderPrivate *priv = render->priv;
+	GDestroyNotify notify = priv->snapshot_notify;
+	gpointer snapshot = priv->snapshot;
+
+	priv->snapshot = NULL;
+	priv->snapshot_notify = NULL;
+	if (notify) {
+		notify(snapshot);
+	}
+}
+
+
+/**
+ * ppg_task_render_notify_state:
+ * @render: (in): A #PpgTaskRender.
+ * @pspec: (in): A #GParamSpec.
+ * @user_data: (in): None.
+ *
+ * Handles the "notify::state" signal of @render, which is emitted from
+ * the main loop. Once the task has finished, its snapshot is released so
+ * that the models it references are released from the main thread.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_task_render_notify_state (PpgTaskRender *render,
+                              GParamSpec    *pspec,
+                              gpointer       user_data)
+{
+	PpgTaskState state;
+
+	g_object_get(render, "state", &state, NULL);
+	if (state & PPG_TASK_FINISHED_MASK) {
+		ppg_task_render_release_snapshot(render);
+	}
+}
+
+
+/**
+ * ppg_task_render_set_snapshot:
+ * @render: (in): A #PpgTaskRender.
+ * @snapshot: (in): The renderer state to draw from.
+ * @notify: (in): A #GDestroyNotify to release @snapshot.
+ *
+ * Hands @render a copy of the renderer state it draws, such as the
+ * models, styling and value range. Tasks may run on worker threads while
+ * the main thread changes the renderer, so they must not read the
+ * renderer itself.
+ *
+ * @snapshot is released from the main loop once the task has finished,
+ * or when the task is finalized if it never ran.
+ *
+ * Returns: None.
+ * Side effects: Any previous snapshot is released.
+ */
+void
+ppg_task_render_set_snapshot (PpgTaskRender  *render,
+                              gpointer        snapshot,
+                              GDestroyNotify  notify)
+{
+	g_return_if_fail(PPG_IS_TASK_RENDER(render));
+
+	ppg_task_render_release_snapshot(render);
+	render->priv->snapshot = snapshot;
+	render->priv->snapshot_notify = notify;
+}
+
+
 /**
  * ppg_task_render_run:
  * @task: (in): A #PpgTaskRender.
@@ -198,6 +285,8 @@ ppg_task_render_finalize (GObject *object)
 {
 	ENTRY;
 
+	ppg_task_render_release_snapshot(PPG_TASK_RENDER(object));
+
 	/*
 	 * Don't free surface, we do not own its reference. See issues
 	 * in comments about pixman.
@@ -462,4 +551,7 @@ ppg_task_render_init (PpgTaskRender *render)
 
 	render->priv->sequence = sequence++;
 	ppg_task_use_idle(PPG_TASK(render), TRUE);
+	g_signal_connect(render, "notify::state",
+	                 G_CALLBACK(ppg_task_render_notify_state),
+	                 NULL);
 }
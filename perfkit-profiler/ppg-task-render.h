@@ -50,7 +50,10 @@ struct _PpgTaskRenderClass
 	void (*render) (PpgTaskRender *render);
 };
 
-GType ppg_task_render_get_type (void) G_GNUC_CONST;
+GType ppg_task_render_get_type     (void) G_GNUC_CONST;
+void  ppg_task_render_set_snapshot (PpgTaskRender  *render,
+                                    gpointer        snapshot,
+                                    GDestroyNotify  notify);
 
 G_END_DECLS
 
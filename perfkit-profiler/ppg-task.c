@@ -30,6 +30,7 @@ struct _PpgTaskPrivate
 	GError *error;
 	GMutex *mutex;
 	gboolean use_idle;
+	gboolean cancelled;
 };
 
 
@@ -95,7 +96,8 @@ ppg_task_emit_notify_state (PpgTask *task)
  * @task: (in): A #PpgTask.
  *
  * Cancels a PpgTask. If the task is not already running, it will not ever
- * be run.
+ * be run. If it is running, it fails once it completes, so that anything
+ * the task is using stays valid until then.
  *
  * Returns: None.
  * Side effects: None.
@@ -114,12 +116,17 @@ ppg_task_cancel (PpgTask *task)
 
 	switch (priv->state) {
 	case PPG_TASK_INITIAL:
-	case PPG_TASK_RUNNING:
 		priv->state = PPG_TASK_FAILED;
 		g_set_error(&priv->error, PPG_TASK_ERROR, PPG_TASK_ERROR_CANCELLED,
 		            "The given task was cancelled.");
 		emit = TRUE;
 		break;
+	case PPG_TASK_RUNNING:
+		/*
+		 * Reported from ppg_task_finish().
+		 */
+		priv->cancelled = TRUE;
+		break;
 	case PPG_TASK_FAILED:
 	case PPG_TASK_SUCCESS:
 	case PPG_TASK_FINISHED_MASK:
@@ -206,7 +213,14 @@ ppg_task_finish (PpgTask *task)
 	switch (priv->state) {
 	case PPG_TASK_INITIAL:
 	case PPG_TASK_RUNNING:
-		priv->state = PPG_TASK_SUCCESS;
+		if (priv->cancelled) {
+			priv->state = PPG_TASK_FAILED;
+			g_set_error(&priv->error, PPG_TASK_ERROR,
+			            PPG_TASK_ERROR_CANCELLED,
+			            "The given task was cancelled.");
+		} else {
+			priv->state = PPG_TASK_SUCCESS;
+		}
 		emit = TRUE;
 		break;
 	case PPG_TASK_FAILED:
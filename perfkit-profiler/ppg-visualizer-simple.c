@@ -60,6 +60,36 @@ ppg_visualizer_simple_invalidate (PpgVisualizerSimple *simple,
 }
 
 
+/**
+ * ppg_visualizer_simple_notify_time:
+ * @simple: (in): A #PpgVisualizerSimple.
+ *
+ * Handles changes to the visible time range of the visualizer. The range
+ * is passed on to the renderer so it may scale to it.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_visualizer_simple_notify_time (PpgVisualizerSimple *simple,
+                                   GParamSpec          *pspec,
+                                   gpointer             user_data)
+{
+	gdouble begin_time;
+	gdouble end_time;
+
+	g_return_if_fail(PPG_IS_VISUALIZER_SIMPLE(simple));
+
+	g_object_get(simple,
+	             "begin-time", &begin_time,
+	             "end-time", &end_time,
+	             NULL);
+	if (simple->priv->renderer && end_time > begin_time) {
+		ppg_renderer_set_time(simple->priv->renderer, begin_time, end_time);
+	}
+}
+
+
 /**
  * ppg_visualizer_simple_set_renderer:
  * @simple: (in): A #PpgVisualizerSimple.
@@ -80,6 +110,12 @@ ppg_visualizer_simple_set_renderer (PpgVisualizerSimple *simple,
 		g_signal_connect_swapped(renderer, "invalidate",
 		                         G_CALLBACK(ppg_visualizer_simple_invalidate),
 		                         simple);
+	g_signal_connect(simple, "notify::begin-time",
+	                 G_CALLBACK(ppg_visualizer_simple_notify_time),
+	                 NULL);
+	g_signal_connect(simple, "notify::end-time",
+	                 G_CALLBACK(ppg_visualizer_simple_notify_time),
+	                 NULL);
 }
 
 
@@ -18,8 +18,8 @@
 
 #include <math.h>
 
+#include "ppg-frame-scheduler.h"
 #include "ppg-log.h"
-#include "ppg-prefs.h"
 #include "ppg-task-render.h"
 #include "ppg-util.h"
 #include "ppg-visualizer.h"
@@ -28,21 +28,50 @@
 G_DEFINE_ABSTRACT_TYPE(PpgVisualizer, ppg_visualizer, GOO_TYPE_CANVAS_IMAGE)
 
 
+/*
+ * The timeline is rendered in tiles of TILE_WIDTH pixels. A tile covers a
+ * fixed range of time for a given zoom level, so when the view is panned
+ * most tiles are already rendered and only need to be copied into place.
+ * The most recently used TILE_CACHE_SIZE tiles are kept per visualizer.
+ *
+ * When a renderer reports new data, only the time span it covers is
+ * rendered again and copied over the existing contents of the tile.
+ */
+#define TILE_WIDTH      (256)
+#define TILE_CACHE_SIZE (32)
+
+
+typedef struct
+{
+	PpgVisualizer   *visualizer;  /* NULL once dropped from the cache */
+	gdouble          zoom;        /* Pixels per second */
+	gint64           index;       /* Tiles since time 0.0 at zoom */
+	cairo_surface_t *surface;     /* Rendered contents, or NULL */
+	cairo_surface_t *pending;     /* Surface the task renders onto */
+	gdouble          pending_x;   /* Offset of pending within the tile */
+	PpgTask         *task;        /* Render task until it completes */
+	gboolean         dirty;       /* If the contents are out of date */
+	gdouble          dirty_begin;
+	gdouble          dirty_end;
+	gboolean         blitted;     /* If copied to the visualizer surface */
+	GList           *link;        /* Link within priv->tiles */
+} PpgVisualizerTile;
+
+
 struct _PpgVisualizerPrivate
 {
 	cairo_surface_t *surface;
 	gchar           *name;
 	gchar           *title;
-	PpgTask         *task;
+	GQueue          *tiles;
+	gint64           origin;      /* Tile space x of the surface */
+	gdouble          origin_zoom; /* Zoom of the surface contents */
 	gdouble          begin_time;
 	gdouble          end_time;
-	gdouble          draw_begin_time;
-	gdouble          draw_end_time;
 	gdouble          natural_height;
-	gboolean         frozen;
+	guint            frozen;      /* Nesting count of freezes */
 	gboolean         important;
-	guint            frame_limit;
-	guint            draw_handler;
+	guint            prefetch_handler;
 	guint            resize_handler;
 };
 
@@ -53,7 +82,6 @@ enum
 
 	PROP_BEGIN_TIME,
 	PROP_END_TIME,
-	PROP_FRAME_LIMIT,
 	PROP_IS_IMPORTANT,
 	PROP_NAME,
 	PROP_NATURAL_HEIGHT,
@@ -61,113 +89,537 @@ enum
 };
 
 
+static inline gboolean
+zoom_equal (gdouble a,
+            gdouble b)
+{
+	/*
+	 * Panning changes both ends of the range, so the zoom computed from
+	 * it may be off by a rounding error.
+	 */
+	return ABS(a - b) <= a * 1e-9;
+}
+
+
+static inline gdouble
+ppg_visualizer_get_zoom (PpgVisualizer *visualizer)
+{
+	PpgVisualizerPrivate *priv = visualizer->priv;
+	gdouble width;
+
+	g_object_get(visualizer, "width", &width, NULL);
+	return width / (priv->end_time - priv->begin_time);
+}
+
+
+static void
+ppg_visualizer_tile_free (PpgVisualizerTile *tile)
+{
+	if (tile->surface) {
+		cairo_surface_destroy(tile->surface);
+	}
+	if (tile->pending) {
+		cairo_surface_destroy(tile->pending);
+	}
+	g_slice_free(PpgVisualizerTile, tile);
+}
+
+
+/**
+ * ppg_visualizer_tile_get_span:
+ * @tile: (in): A #PpgVisualizerTile.
+ * @begin_time: (in): The beginning of the time span.
+ * @end_time: (in): The end of the time span.
+ * @x: (out): A location for the first pixel.
+ * @x2: (out): A location for the pixel after the last.
+ *
+ * Retrieves the pixels of @tile to render for the time span. The span is
+ * rounded out to whole pixels, with one more pixel on either side for
+ * lines crossing the edges.
+ *
+ * Returns: %TRUE if the span covers any part of the tile.
+ * Side effects: None.
+ */
+static gboolean
+ppg_visualizer_tile_get_span (PpgVisualizerTile *tile,
+                              gdouble            begin_time,
+                              gdouble            end_time,
+                              gdouble           *x,
+                              gdouble           *x2)
+{
+	gdouble tile_begin;
+
+	tile_begin = tile->index * TILE_WIDTH / tile->zoom;
+	*x = floor((begin_time - tile_begin) * tile->zoom) - 1.0;
+	*x2 = ceil((end_time - tile_begin) * tile->zoom) + 1.0;
+	*x = CLAMP(*x, 0.0, TILE_WIDTH);
+	*x2 = CLAMP(*x2, 0.0, TILE_WIDTH);
+	return *x2 > *x;
+}
+
+
 /**
- * ppg_visualizer_task_notify_state:
+ * ppg_visualizer_tile_is_queued:
+ * @tile: (in): A #PpgVisualizerTile.
+ *
+ * Checks if the render task of @tile is still waiting for a worker. Such
+ * a task has not read the models yet, so it will pick up any samples
+ * that have arrived since it was created.
+ *
+ * Returns: %TRUE if the task has not started.
+ * Side effects: None.
+ */
+static gboolean
+ppg_visualizer_tile_is_queued (PpgVisualizerTile *tile)
+{
+	PpgTaskState state;
+
+	if (!tile->task) {
+		return FALSE;
+	}
+	g_object_get(tile->task, "state", &state, NULL);
+	return state == PPG_TASK_INITIAL;
+}
+
+
+/**
+ * ppg_visualizer_drop_tile:
+ * @visualizer: (in): A #PpgVisualizer.
+ * @tile: (in): A #PpgVisualizerTile.
+ *
+ * Removes @tile from the cache.  If the tile is still rendering, its task
+ * is cancelled and the tile is freed when the task completes.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_visualizer_drop_tile (PpgVisualizer     *visualizer,
+                          PpgVisualizerTile *tile)
+{
+	g_queue_delete_link(visualizer->priv->tiles, tile->link);
+	tile->link = NULL;
+	tile->visualizer = NULL;
+	if (tile->task) {
+		ppg_task_cancel(tile->task);
+	} else {
+		ppg_visualizer_tile_free(tile);
+	}
+}
+
+
+/**
+ * ppg_visualizer_invalidate_tiles:
  * @visualizer: (in): A #PpgVisualizer.
+ * @begin_time: (in): The beginning of the time span.
+ * @end_time: (in): The end of the time span.
+ *
+ * Marks the time span as out of date in the tiles covering any part of
+ * it.  They are brought up to date the next time they are needed.  If
+ * @begin_time and @end_time are 0.0, all tiles are removed instead.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_visualizer_invalidate_tiles (PpgVisualizer *visualizer,
+                                 gdouble        begin_time,
+                                 gdouble        end_time)
+{
+	PpgVisualizerTile *tile;
+	GList *iter;
+	GList *next;
+	gdouble tile_begin;
+	gdouble tile_end;
+	gdouble x;
+	gdouble x2;
+
+	for (iter = visualizer->priv->tiles->head; iter; iter = next) {
+		next = iter->next;
+		tile = iter->data;
+		if (begin_time == 0.0 && end_time == 0.0) {
+			ppg_visualizer_drop_tile(visualizer, tile);
+			continue;
+		}
+		tile_begin = tile->index * TILE_WIDTH / tile->zoom;
+		tile_end = (tile->index + 1) * TILE_WIDTH / tile->zoom;
+		if (tile_begin > end_time || tile_end < begin_time) {
+			continue;
+		}
+		/*
+		 * A render task that has not started yet already covers the span,
+		 * there is no need for another one once it completes.
+		 */
+		if (ppg_visualizer_tile_is_queued(tile) &&
+		    ppg_visualizer_tile_get_span(tile, begin_time, end_time,
+		                                 &x, &x2) &&
+		    x >= tile->pending_x &&
+		    x2 <= tile->pending_x +
+		          cairo_image_surface_get_width(tile->pending)) {
+			continue;
+		}
+		if (!tile->dirty) {
+			tile->dirty = TRUE;
+			tile->dirty_begin = begin_time;
+			tile->dirty_end = end_time;
+		} else {
+			tile->dirty_begin = MIN(tile->dirty_begin, begin_time);
+			tile->dirty_end = MAX(tile->dirty_end, end_time);
+		}
+	}
+}
+
+
+/**
+ * ppg_visualizer_blit_tile:
+ * @visualizer: (in): A #PpgVisualizer.
+ * @tile: (in): A #PpgVisualizerTile.
+ *
+ * Copies the contents of @tile into place on the surface of the
+ * visualizer.  Tiles that have not been rendered yet are cleared.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_visualizer_blit_tile (PpgVisualizer     *visualizer,
+                          PpgVisualizerTile *tile)
+{
+	PpgVisualizerPrivate *priv = visualizer->priv;
+	cairo_t *cr;
+	gdouble height;
+	gdouble x;
+
+	g_object_get(visualizer, "height", &height, NULL);
+
+	/*
+	 * Tiles and the surface are aligned on whole pixels, so neighbouring
+	 * tiles always line up.
+	 */
+	x = tile->index * TILE_WIDTH - priv->origin;
+
+	cr = cairo_create(priv->surface);
+	cairo_rectangle(cr, x, 0, TILE_WIDTH, height);
+	cairo_clip_preserve(cr);
+
+	/*
+	 * Clear the draw area.
+	 */
+	cairo_save(cr);
+	cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+	cairo_fill_preserve(cr);
+	cairo_restore(cr);
+
+	/*
+	 * Fill in the rendered image.
+	 */
+	if (tile->surface) {
+		cairo_set_source_surface(cr, tile->surface, x, 0);
+		cairo_fill(cr);
+	}
+	cairo_destroy(cr);
+
+	tile->blitted = TRUE;
+	goo_canvas_item_request_update(GOO_CANVAS_ITEM(visualizer));
+}
+
+
+/**
+ * ppg_visualizer_tile_notify_state:
+ * @tile: (in): A #PpgVisualizerTile.
  * @pspec: (in): A #GParamSpec.
  * @task: (in): A #PpgTask.
  *
- * Handle the "notify::state" signal from @task. Update the visualizer
- * pattern if necessary.
+ * Handle the "notify::state" signal from the render task of @tile. The
+ * rendered area is copied into the tile, and the tile onto the visualizer
+ * if it is showing the zoom level of the tile.
  *
  * Returns: None.
  * Side effects: None.
  */
 static void
-ppg_visualizer_task_notify_state (PpgVisualizer *visualizer,
-                                  GParamSpec    *pspec,
-                                  PpgTask       *task)
+ppg_visualizer_tile_notify_state (PpgVisualizerTile *tile,
+                                  GParamSpec        *pspec,
+                                  PpgTask           *task)
 {
-	PpgVisualizerPrivate *priv;
-	cairo_surface_t *surface;
+	PpgVisualizer *visualizer = tile->visualizer;
 	PpgTaskState state;
 	cairo_t *cr;
-	gdouble begin_time;
 	gdouble height;
-	gdouble total_width;
-	gdouble span;
 	gdouble width;
-	gdouble x;
-	gdouble y;
 
-	g_return_if_fail(PPG_IS_VISUALIZER(visualizer));
 	g_return_if_fail(PPG_IS_TASK(task));
-	g_return_if_fail(visualizer->priv->surface);
 
-	priv = visualizer->priv;
+	g_object_get(task, "state", &state, NULL);
+	if (!(state & PPG_TASK_FINISHED_MASK)) {
+		return;
+	}
 
 	/*
-	 * We don't own the reference, so safe to just drop our pointer. Using
-	 * GObjects weak pointers here would be a lot of maintenance pain.
+	 * We don't own the reference to the task, it is released by the
+	 * task scheduler.
 	 */
-	if (priv->task == task) {
-		priv->task = NULL;
+	tile->task = NULL;
+
+	if (!visualizer) {
+		ppg_visualizer_tile_free(tile);
+		return;
 	}
 
-	g_object_get(task,
-	             "state", &state,
-	             "surface", &surface,
-	             NULL);
+	if (state != PPG_TASK_SUCCESS) {
+		ppg_visualizer_drop_tile(visualizer, tile);
+		return;
+	}
 
-	if (state == PPG_TASK_SUCCESS) {
-		g_object_get(task,
-		             "begin-time", &begin_time,
-		             "height", &height,
-		             "width", &width,
-		             "x", &x,
-		             "y", &y,
-		             NULL);
+	/*
+	 * Replace the rendered area of the tile.
+	 */
+	width = cairo_image_surface_get_width(tile->pending);
+	height = cairo_image_surface_get_height(tile->pending);
+	if (!tile->surface) {
+		tile->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+		                                           TILE_WIDTH, height);
+	}
+	cr = cairo_create(tile->surface);
+	cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_surface(cr, tile->pending, tile->pending_x, 0);
+	cairo_rectangle(cr, tile->pending_x, 0, width, height);
+	cairo_fill(cr);
+	cairo_destroy(cr);
+	cairo_surface_destroy(tile->pending);
+	tile->pending = NULL;
+
+	if (tile->dirty) {
+		ppg_visualizer_queue_draw_time_span(visualizer,
+		                                    tile->dirty_begin,
+		                                    tile->dirty_end,
+		                                    FALSE);
+	}
 
-		span = priv->end_time - priv->begin_time;
-		g_object_get(visualizer, "width", &total_width, NULL);
-		x = (begin_time - priv->begin_time) / span * total_width;
+	if (visualizer->priv->surface &&
+	    zoom_equal(visualizer->priv->origin_zoom, tile->zoom)) {
+		ppg_visualizer_blit_tile(visualizer, tile);
+	}
+}
 
-		/*
-		 * Only draw what we can do on integer aligned offsets.
-		 *
-		 * TODO: We need to make sure we render extra area to prevent
-		 *       a striping effect.
-		 */
-		width -= ceil(x) - x;
-		x = ceil(x);
-
-		cr = cairo_create(priv->surface);
-		cairo_set_source_surface(cr, surface, x, y);
-		if (cairo_status(cr) != 0) {
-			cairo_destroy(cr);
-			GOTO(failure);
+
+/**
+ * ppg_visualizer_render_tile:
+ * @visualizer: (in): A #PpgVisualizer.
+ * @tile: (in): A #PpgVisualizerTile.
+ * @begin_time: (in): The beginning of the time span to render.
+ * @end_time: (in): The end of the time span to render.
+ *
+ * Starts a render task for the part of @tile covering the time span.  The
+ * task renders onto a surface of its own, which is copied into the tile
+ * when the task completes.
+ *
+ * Returns: %TRUE if a task was started.
+ * Side effects: None.
+ */
+static gboolean
+ppg_visualizer_render_tile (PpgVisualizer     *visualizer,
+                            PpgVisualizerTile *tile,
+                            gdouble            begin_time,
+                            gdouble            end_time)
+{
+	gdouble tile_begin;
+	gdouble height;
+	gdouble x;
+	gdouble x2;
+
+	g_assert(!tile->task);
+
+	if (!ppg_visualizer_tile_get_span(tile, begin_time, end_time, &x, &x2)) {
+		return FALSE;
+	}
+
+	g_object_get(visualizer, "height", &height, NULL);
+	tile_begin = tile->index * TILE_WIDTH / tile->zoom;
+
+	tile->pending_x = x;
+	tile->pending = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+	                                           x2 - x, height);
+
+	/*
+	 * Create the task to do the rendering. The surface is ours, the task
+	 * only borrows it.
+	 */
+	tile->task = PPG_VISUALIZER_GET_CLASS(visualizer)->
+		draw(visualizer, tile->pending,
+		     tile_begin + x / tile->zoom,
+		     tile_begin + x2 / tile->zoom,
+		     0, 0, x2 - x, height);
+	if (!tile->task) {
+		cairo_surface_destroy(tile->pending);
+		tile->pending = NULL;
+		return FALSE;
+	}
+	g_signal_connect_swapped(tile->task, "notify::state",
+	                         G_CALLBACK(ppg_visualizer_tile_notify_state),
+	                         tile);
+	ppg_task_schedule(tile->task);
+	return TRUE;
+}
+
+
+/**
+ * ppg_visualizer_get_tile:
+ * @visualizer: (in): A #PpgVisualizer.
+ * @zoom: (in): The zoom level in pixels per second.
+ * @index_: (in): The index of the tile at @zoom.
+ *
+ * Retrieves the tile at @index_ for @zoom from the cache, or starts
+ * rendering it if it is not cached.  Out of date areas of a cached tile
+ * are rendered again.  The tile becomes the most recently used tile.
+ *
+ * Returns: A #PpgVisualizerTile or %NULL.
+ * Side effects: None.
+ */
+static PpgVisualizerTile*
+ppg_visualizer_get_tile (PpgVisualizer *visualizer,
+                         gdouble        zoom,
+                         gint64         index_)
+{
+	PpgVisualizerPrivate *priv = visualizer->priv;
+	PpgVisualizerTile *tile;
+	GList *iter;
+
+	for (iter = priv->tiles->head; iter; iter = iter->next) {
+		tile = iter->data;
+		if (tile->index == index_ && zoom_equal(tile->zoom, zoom)) {
+			g_queue_unlink(priv->tiles, iter);
+			g_queue_push_head_link(priv->tiles, iter);
+			if (tile->dirty && !tile->task) {
+				tile->dirty = FALSE;
+				ppg_visualizer_render_tile(visualizer, tile,
+				                           tile->dirty_begin,
+				                           tile->dirty_end);
+			}
+			return tile;
 		}
+	}
 
-		/*
-		 * Clip the range of the draw.
-		 */
-		cairo_rectangle(cr, x, y, width, height);
-		cairo_clip_preserve(cr);
+	tile = g_slice_new0(PpgVisualizerTile);
+	tile->visualizer = visualizer;
+	tile->zoom = zoom;
+	tile->index = index_;
+	if (!ppg_visualizer_render_tile(visualizer, tile,
+	                                index_ * TILE_WIDTH / zoom,
+	                                (index_ + 1) * TILE_WIDTH / zoom)) {
+		ppg_visualizer_tile_free(tile);
+		return NULL;
+	}
 
-		/*
-		 * Clear the draw area.
-		 */
-		cairo_save(cr);
-		cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-		cairo_fill_preserve(cr);
-		cairo_restore(cr);
+	g_queue_push_head(priv->tiles, tile);
+	tile->link = priv->tiles->head;
+	while (priv->tiles->length > TILE_CACHE_SIZE) {
+		ppg_visualizer_drop_tile(visualizer, g_queue_peek_tail(priv->tiles));
+	}
 
-		/*
-		 * Fill in the rendered image.
-		 */
-		cairo_fill(cr);
-		cairo_destroy(cr);
+	return tile;
+}
+
+
+/**
+ * ppg_visualizer_get_visible_tiles:
+ * @visualizer: (in): A #PpgVisualizer.
+ * @zoom: (out): A location for the zoom level.
+ * @first: (out): A location for the first visible tile.
+ * @last: (out): A location for the last visible tile.
+ *
+ * Retrieves the range of tiles that are currently visible.
+ *
+ * Returns: %TRUE if there is anything to render.
+ * Side effects: None.
+ */
+static gboolean
+ppg_visualizer_get_visible_tiles (PpgVisualizer *visualizer,
+                                  gdouble       *zoom,
+                                  gint64        *first,
+                                  gint64        *last)
+{
+	PpgVisualizerPrivate *priv = visualizer->priv;
+
+	if (!priv->surface || priv->end_time <= priv->begin_time) {
+		return FALSE;
+	}
+
+	*zoom = ppg_visualizer_get_zoom(visualizer);
+	*first = (gint64)floor(priv->begin_time * *zoom / TILE_WIDTH);
+	*last = MAX(*first, (gint64)ceil(priv->end_time * *zoom / TILE_WIDTH) - 1);
+	return TRUE;
+}
+
+
+/**
+ * ppg_visualizer_prefetch_idle:
+ * @visualizer: (in): A #PpgVisualizer.
+ *
+ * A GSourceFunc to render the tiles next to the visible ones, so that
+ * they are ready when the view is panned.
+ *
+ * Returns: %FALSE always.
+ * Side effects: None.
+ */
+static gboolean
+ppg_visualizer_prefetch_idle (gpointer data)
+{
+	PpgVisualizer *visualizer = (PpgVisualizer *)data;
+	gdouble zoom;
+	gint64 first;
+	gint64 last;
+
+	g_return_val_if_fail(PPG_IS_VISUALIZER(visualizer), FALSE);
+
+	visualizer->priv->prefetch_handler = 0;
+
+	if (ppg_visualizer_get_visible_tiles(visualizer, &zoom, &first, &last)) {
+		if (first > 0) {
+			ppg_visualizer_get_tile(visualizer, zoom, first - 1);
+		}
+		ppg_visualizer_get_tile(visualizer, zoom, last + 1);
+	}
+
+	return FALSE;
+}
+
+
+/**
+ * ppg_visualizer_scroll:
+ * @visualizer: (in): A #PpgVisualizer.
+ * @shift: (in): The number of pixels to move the contents to the right.
+ *
+ * Moves the contents of the visualizer surface horizontally. The area
+ * exposed is cleared.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_visualizer_scroll (PpgVisualizer *visualizer,
+                       gint64         shift)
+{
+	cairo_t *cr;
 
-		goo_canvas_item_request_update(GOO_CANVAS_ITEM(visualizer));
+	if (!shift) {
+		return;
 	}
 
-  failure:
 	/*
-	 * Release our surface that was allocated for the draw request.
+	 * Go through a group, copying a surface onto itself is not defined
+	 * when the areas overlap.
 	 */
-	if ((state & PPG_TASK_FINISHED_MASK) != 0) {
-		cairo_surface_destroy(surface);
-	}
+	cr = cairo_create(visualizer->priv->surface);
+	cairo_push_group(cr);
+	cairo_set_source_surface(cr, visualizer->priv->surface, shift, 0);
+	cairo_paint(cr);
+	cairo_pop_group_to_source(cr);
+	cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+	cairo_paint(cr);
+	cairo_destroy(cr);
+
+	goo_canvas_item_request_update(GOO_CANVAS_ITEM(visualizer));
 }
 
 
@@ -175,7 +627,8 @@ ppg_visualizer_task_notify_state (PpgVisualizer *visualizer,
  * ppg_visualizer_draw_timeout:
  * @visualizer: (in): A #PpgVisualizer.
  *
- * A GSourceFunc to start a new drawing task.
+ * A GSourceFunc to draw the visible area. Cached tiles are copied into
+ * place and render tasks are started for the others.
  *
  * Returns: %FALSE always.
  * Side effects: None.
@@ -185,93 +638,132 @@ ppg_visualizer_draw_timeout (gpointer data)
 {
 	PpgVisualizer *visualizer = (PpgVisualizer *)data;
 	PpgVisualizerPrivate *priv;
-	cairo_surface_t *surface = NULL;
-	gpointer instance;
-	gdouble begin_time;
-	gdouble end_time;
-	gdouble height;
-	gdouble span;
+	PpgVisualizerTile *tile;
+	GList *iter;
+	GList *next;
+	gdouble exposed_begin;
+	gdouble exposed_end;
 	gdouble width;
+	gdouble zoom;
 	gdouble x;
+	gint64 first;
+	gint64 last;
+	gint64 origin;
+	gint64 shift;
+	gint64 i;
 
 	g_return_val_if_fail(PPG_IS_VISUALIZER(visualizer), FALSE);
 
 	priv = visualizer->priv;
 
-	/*
-	 * Cancel any active tasks. The task will lose its reference after
-	 * the task scheduler completes; so we can just NULL it out.
-	 */
-	if ((instance = priv->task)) {
-		priv->task = NULL;
-		ppg_task_cancel(instance);
-	}
-
 	/*
 	 * Make sure we have a time range to even render.
 	 */
-	if (priv->begin_time == 0.0 && priv->end_time == 0.0) {
-		goto cleanup;
+	if (!ppg_visualizer_get_visible_tiles(visualizer, &zoom, &first, &last)) {
+		return FALSE;
 	}
 
 	/*
-	 * Get the time range for the render.
+	 * Stop rendering tiles for other zoom levels, they will not be shown.
+	 * New tiles the view has moved away from before their task started
+	 * are dropped too, rather than rendered behind the visible ones.
 	 */
-	begin_time = CLAMP(priv->draw_begin_time, 0.0, priv->end_time);
-	end_time = CLAMP(priv->draw_end_time, 0.0, priv->end_time);
-	if (begin_time == 0.0 && end_time == 0.0) {
-		begin_time = priv->begin_time;
-		end_time = priv->end_time;
+	for (iter = priv->tiles->head; iter; iter = next) {
+		next = iter->next;
+		tile = iter->data;
+		if (tile->task && !zoom_equal(tile->zoom, zoom)) {
+			ppg_visualizer_drop_tile(visualizer, tile);
+		} else if (!tile->surface &&
+		           (tile->index < first - 1 || tile->index > last + 1) &&
+		           ppg_visualizer_tile_is_queued(tile)) {
+			ppg_visualizer_drop_tile(visualizer, tile);
+		}
 	}
 
 	/*
-	 * Get the area for the render. This could probably be optimized to
-	 * remove the division by keeping a ratio of (time range / width).
+	 * If only the position of the view changed, such as when following
+	 * the end of a live session, scroll the existing contents and copy in
+	 * just the area that was exposed.
 	 */
-	g_object_get(visualizer, "height", &height, "width", &width, NULL);
-	span = priv->end_time - priv->begin_time;
-	x = (begin_time - priv->begin_time) / span * width;
-	width = ((end_time - priv->begin_time) / span * width) - x;
+	g_object_get(visualizer, "width", &width, NULL);
+	origin = (gint64)floor(priv->begin_time * zoom + 0.5);
+	exposed_begin = 0.0;
+	exposed_end = width;
+	if (zoom_equal(priv->origin_zoom, zoom)) {
+		shift = priv->origin - origin;
+		if (ABS(shift) < width) {
+			ppg_visualizer_scroll(visualizer, shift);
+			if (shift < 0) {
+				exposed_begin = width + shift;
+			} else {
+				exposed_end = shift;
+			}
+		}
+	}
+	priv->origin = origin;
+	priv->origin_zoom = zoom;
 
-	/*
-	 * Create a surface for the rendering.
-	 */
-	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
-	                                     width, height);
+	for (i = first; i <= last; i++) {
+		if (!(tile = ppg_visualizer_get_tile(visualizer, zoom, i))) {
+			continue;
+		}
+		x = i * TILE_WIDTH - origin;
+		if (!tile->blitted ||
+		    (x < exposed_end && x + TILE_WIDTH > exposed_begin)) {
+			ppg_visualizer_blit_tile(visualizer, tile);
+		}
+	}
 
-	/*
-	 * Create the task to do the rendering.
-	 */
-	priv->task = PPG_VISUALIZER_GET_CLASS(visualizer)->
-		draw(visualizer,
-	         cairo_surface_reference(surface),
-	         begin_time, end_time,
-	         0, 0, width, height);
-	g_signal_connect_swapped(priv->task, "notify::state",
-	                         G_CALLBACK(ppg_visualizer_task_notify_state),
-	                         visualizer);
-	ppg_task_schedule(priv->task);
-
-  cleanup:
-	if (surface) {
-		cairo_surface_destroy(surface);
-	}
-	priv->draw_handler = 0;
-	priv->draw_begin_time = 0.0;
-	priv->draw_end_time = 0.0;
+	if (!priv->prefetch_handler) {
+		priv->prefetch_handler =
+			g_idle_add_full(G_PRIORITY_LOW, ppg_visualizer_prefetch_idle,
+			                visualizer, NULL);
+	}
 
 	return FALSE;
 }
 
 
+/**
+ * ppg_visualizer_schedule_draw:
+ * @visualizer: (in): A #PpgVisualizer.
+ * @now: (in): If the draw should happen immediately.
+ *
+ * Schedules a draw of the visible area on the next frame unless @now is
+ * set. Requests are coalesced with those of every other visualizer, so
+ * however many arrive within a frame, the visualizer draws once.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+ppg_visualizer_schedule_draw (PpgVisualizer *visualizer,
+                              gboolean       now)
+{
+	PpgVisualizerPrivate *priv = visualizer->priv;
+
+	if (!priv->frozen) {
+		if (now) {
+			ppg_frame_scheduler_remove(visualizer);
+			ppg_visualizer_draw_timeout(visualizer);
+		} else {
+			ppg_frame_scheduler_queue(ppg_visualizer_draw_timeout,
+			                          visualizer);
+		}
+	}
+}
+
+
 /**
  * ppg_visualizer_queue_draw_time_span:
  * @visualizer: (in): A #PpgVisualizer.
  * @begin_time: (in): A #gdouble contianing the beggining time.
  * @end_time: (in): A #gdouble contianing the ending time.
  *
- * Queues a draw for a particular time span. If @begin_time and #end_time
- * are 0.0, then the entire visibile area will be drawn.
+ * Queues a draw for a particular time span whose contents have changed.
+ * Only the time span is rendered again, so when new samples arrive just
+ * the new samples are drawn. If @begin_time and #end_time are 0.0, then
+ * everything will be rendered again.
  *
  * Returns: None.
  * Side effects: None.
@@ -282,40 +774,12 @@ ppg_visualizer_queue_draw_time_span (PpgVisualizer *visualizer,
                                      gdouble        end_time,
                                      gboolean       now)
 {
-	PpgVisualizerPrivate *priv;
-	guint msec;
-
 	g_return_if_fail(PPG_IS_VISUALIZER(visualizer));
 	g_return_if_fail(begin_time >= 0.0);
 	g_return_if_fail(end_time >= 0.0);
 
-	priv = visualizer->priv;
-
-	if (begin_time == 0.0) {
-		begin_time = priv->begin_time;
-	}
-
-	if (end_time == 0.0) {
-		end_time = priv->end_time;
-	}
-
-	if (!priv->frozen) {
-		if (now) {
-			priv->draw_begin_time = begin_time;
-			priv->draw_end_time = end_time;
-			ppg_visualizer_draw_timeout(visualizer);
-		} else if (!priv->draw_handler) {
-			msec = 1000 / priv->frame_limit;
-			priv->draw_begin_time = begin_time;
-			priv->draw_end_time = end_time;
-			priv->draw_handler = g_timeout_add(msec,
-			                                   ppg_visualizer_draw_timeout,
-			                                   visualizer);
-		} else {
-			priv->draw_begin_time = MIN(priv->draw_begin_time, begin_time);
-			priv->draw_end_time = MAX(priv->draw_end_time, end_time);
-		}
-	}
+	ppg_visualizer_invalidate_tiles(visualizer, begin_time, end_time);
+	ppg_visualizer_schedule_draw(visualizer, now);
 }
 
 
@@ -324,6 +788,7 @@ ppg_visualizer_queue_draw_time_span (PpgVisualizer *visualizer,
  * @visualizer: (in): A #PpgVisualizer.
  *
  * Queues a draw request for the entire visible area of the visualizer.
+ * Tiles that are already rendered are reused.
  *
  * Returns: None.
  * Side effects: None.
@@ -332,7 +797,7 @@ void
 ppg_visualizer_queue_draw (PpgVisualizer *visualizer)
 {
 	g_return_if_fail(PPG_IS_VISUALIZER(visualizer));
-	ppg_visualizer_queue_draw_time_span(visualizer, 0.0, 0.0, TRUE);
+	ppg_visualizer_schedule_draw(visualizer, TRUE);
 }
 
 
@@ -386,6 +851,12 @@ ppg_visualizer_resize_timeout (gpointer data)
 	pattern = cairo_pattern_create_for_surface(priv->surface);
 	g_object_set(visualizer, "pattern", pattern, NULL);
 	cairo_pattern_destroy(pattern);
+
+	/*
+	 * Tiles are rendered for the old height.
+	 */
+	priv->origin_zoom = 0.0;
+	ppg_visualizer_invalidate_tiles(visualizer, 0.0, 0.0);
 	ppg_visualizer_queue_draw(visualizer);
 
 	priv->resize_handler = 0;
@@ -436,6 +907,7 @@ ppg_visualizer_set_begin_time (PpgVisualizer *visualizer,
 	g_return_if_fail(begin_time >= 0.0);
 
 	visualizer->priv->begin_time = begin_time;
+	g_object_notify(G_OBJECT(visualizer), "begin-time");
 	ppg_visualizer_queue_draw(visualizer);
 }
 
@@ -458,6 +930,7 @@ ppg_visualizer_set_end_time (PpgVisualizer *visualizer,
 	g_return_if_fail(end_time >= 0.0);
 
 	visualizer->priv->end_time = end_time;
+	g_object_notify(G_OBJECT(visualizer), "end-time");
 	ppg_visualizer_queue_draw(visualizer);
 }
 
@@ -511,6 +984,10 @@ ppg_visualizer_set_time (PpgVisualizer *visualizer,
 	if ((priv->begin_time != begin_time) || (priv->end_time != end_time)) {
 		priv->begin_time = begin_time;
 		priv->end_time = end_time;
+		g_object_freeze_notify(G_OBJECT(visualizer));
+		g_object_notify(G_OBJECT(visualizer), "begin-time");
+		g_object_notify(G_OBJECT(visualizer), "end-time");
+		g_object_thaw_notify(G_OBJECT(visualizer));
 		ppg_visualizer_queue_draw(visualizer);
 	}
 }
@@ -630,26 +1107,37 @@ ppg_visualizer_set_title (PpgVisualizer *visualizer,
  * @visualizer: (in): A #PpgVisualizer.
  *
  * Freezes the visualizer preventing it from drawing updates. Drawing will
- * continue when ppg_visualizer_thaw() is called.
+ * continue when ppg_visualizer_thaw() has been called once for every call
+ * to ppg_visualizer_freeze().
  *
  * Returns: None.
- * Side effects: None.
+ * Side effects: Tiles still being rendered are dropped.
  */
 void
 ppg_visualizer_freeze (PpgVisualizer *visualizer)
 {
 	PpgVisualizerPrivate *priv;
+	PpgVisualizerTile *tile;
+	GList *iter;
+	GList *next;
 
 	g_return_if_fail(PPG_IS_VISUALIZER(visualizer));
 
 	priv = visualizer->priv;
 
-	priv->frozen = TRUE;
-	if (priv->draw_handler) {
-		g_source_remove(priv->draw_handler);
-		priv->draw_handler = 0;
-		priv->draw_begin_time = 0.0;
-		priv->draw_end_time = 0.0;
+	if (!priv->frozen++) {
+		ppg_frame_scheduler_remove(visualizer);
+		ppg_clear_source(&priv->prefetch_handler);
+		/*
+		 * Give the workers back to the visualizers that are still drawing.
+		 */
+		for (iter = priv->tiles->head; iter; iter = next) {
+			next = iter->next;
+			tile = iter->data;
+			if (tile->task) {
+				ppg_visualizer_drop_tile(visualizer, tile);
+			}
+		}
 	}
 }
 
@@ -658,8 +1146,8 @@ ppg_visualizer_freeze (PpgVisualizer *visualizer)
  * ppg_visualizer_thaw:
  * @visualizer: (in): A #PpgVisualizer.
  *
- * Thaws a call to ppg_visualizer_freeze() and queues a new draw request of
- * the visualizer.
+ * Thaws a call to ppg_visualizer_freeze(). When the last freeze is thawed
+ * a new draw request of the visualizer is queued.
  *
  * Returns: None.
  * Side effects: None.
@@ -671,10 +1159,13 @@ ppg_visualizer_thaw (PpgVisualizer *visualizer)
 
 	g_return_if_fail(PPG_IS_VISUALIZER(visualizer));
 
+	g_return_if_fail(visualizer->priv->frozen > 0);
+
 	priv = visualizer->priv;
 
-	priv->frozen = FALSE;
-	ppg_visualizer_queue_draw(visualizer);
+	if (!--priv->frozen) {
+		ppg_visualizer_queue_draw(visualizer);
+	}
 }
 
 
@@ -708,7 +1199,15 @@ ppg_visualizer_get_name (PpgVisualizer *visualizer)
 static void
 ppg_visualizer_finalize (GObject *object)
 {
-	PpgVisualizerPrivate *priv = PPG_VISUALIZER(object)->priv;
+	PpgVisualizer *visualizer = PPG_VISUALIZER(object);
+	PpgVisualizerPrivate *priv = visualizer->priv;
+
+	ppg_frame_scheduler_remove(visualizer);
+	ppg_clear_source(&priv->prefetch_handler);
+	ppg_clear_source(&priv->resize_handler);
+
+	ppg_visualizer_invalidate_tiles(visualizer, 0.0, 0.0);
+	g_queue_free(priv->tiles);
 
 	if (priv->surface) {
 		cairo_surface_destroy(priv->surface);
@@ -788,9 +1287,6 @@ ppg_visualizer_set_property (GObject      *object,
 	case PROP_END_TIME:
 		ppg_visualizer_set_end_time(visualizer, g_value_get_double(value));
 		break;
-	case PROP_FRAME_LIMIT:
-		visualizer->priv->frame_limit = g_value_get_int(value);
-		break;
 	case PROP_IS_IMPORTANT:
 		ppg_visualizer_set_is_important(visualizer, g_value_get_boolean(value));
 		break;
@@ -882,16 +1378,6 @@ ppg_visualizer_class_init (PpgVisualizerClass *klass)
 	                                                    "title",
 	                                                    NULL,
 	                                                    G_PARAM_READWRITE));
-
-	g_object_class_install_property(object_class,
-	                                PROP_FRAME_LIMIT,
-	                                g_param_spec_int("frame-limit",
-	                                                 "frame-limit",
-	                                                 "frame-limit",
-	                                                 1,
-	                                                 G_MAXINT,
-	                                                 2,
-	                                                 G_PARAM_WRITABLE));
 }
 
 
@@ -907,18 +1393,12 @@ ppg_visualizer_class_init (PpgVisualizerClass *klass)
 static void
 ppg_visualizer_init (PpgVisualizer *visualizer)
 {
-	GSettings *settings;
-
 	visualizer->priv = G_TYPE_INSTANCE_GET_PRIVATE(visualizer,
 	                                               PPG_TYPE_VISUALIZER,
 	                                               PpgVisualizerPrivate);
 
 	visualizer->priv->natural_height = 25.0;
-
-	settings = ppg_prefs_get_window_settings();
-	g_settings_bind(settings, "redraws-per-second",
-	                visualizer, "frame-limit",
-	                G_SETTINGS_BIND_GET);
+	visualizer->priv->tiles = g_queue_new();
 
 	g_signal_connect(visualizer, "notify::width",
 	                 G_CALLBACK(ppg_visualizer_queue_resize), NULL);
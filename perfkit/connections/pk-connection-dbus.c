@@ -27,6 +27,7 @@
 
 #include "pk-connection-dbus.h"
 #include "pk-log.h"
+#include "pk-marshal.h"
 
 #undef G_LOG_DOMAIN
 #define G_LOG_DOMAIN "DBus"
@@ -152,6 +153,7 @@ struct _PkConnectionDBusPrivate
 	GMutex         *mutex;         /* General purpose lock */
 	gint            state;         /* Current connection state */
 	DBusConnection *dbus;          /* Handle to shared DBus */
+	gboolean        private_bus;   /* Bus was opened from the uri address */
 	DBusServer     *server;        /* Handle to private DBus socket */
 	DBusConnection *client;        /* Handle to client on private DBus */
 	GStaticRWLock   handlers_lock; /* RWLock for subscription handlers */
@@ -169,6 +171,7 @@ typedef struct
 	gint        subscription;      /* Subscription id in agent */
 	GClosure   *manifest;          /* Manifest callback closure */
 	GClosure   *sample;            /* Sample callback closure */
+	GClosure   *samples;           /* Batched sample callback closure */
 	GTree      *manifests;         /* Source manifests indexed by source id */
 } Handler;
 
@@ -178,11 +181,49 @@ static void
 handler_free (Handler *handler) /* IN */
 {
 	g_closure_unref(handler->manifest);
-	g_closure_unref(handler->sample);
+	if (handler->sample) {
+		g_closure_unref(handler->sample);
+	}
+	if (handler->samples) {
+		g_closure_unref(handler->samples);
+	}
 	g_tree_unref(handler->manifests);
 	g_slice_free(Handler, handler);
 }
 
+/**
+ * pk_connection_dbus_remove_handler:
+ * @connection: A #PkConnectionDBus.
+ * @subscription: The subscription id.
+ *
+ * Removes the handler of @subscription, if any, releasing its closures.
+ * Buffers arriving for @subscription afterwards are dropped.
+ *
+ * Returns: None.
+ * Side effects: The handler object path is unregistered.
+ */
+static void
+pk_connection_dbus_remove_handler (PkConnection *connection,   /* IN */
+                                   gint          subscription) /* IN */
+{
+	PkConnectionDBusPrivate *priv;
+	gchar *path;
+
+	ENTRY;
+	priv = PK_CONNECTION_DBUS(connection)->priv;
+	g_static_rw_lock_writer_lock(&priv->handlers_lock);
+	g_hash_table_remove(priv->handlers, &subscription);
+	g_static_rw_lock_writer_unlock(&priv->handlers_lock);
+	g_mutex_lock(priv->mutex);
+	if (priv->client) {
+		path = g_strdup_printf("/Handler/%d", subscription);
+		dbus_connection_unregister_object_path(priv->client, path);
+		g_free(path);
+	}
+	g_mutex_unlock(priv->mutex);
+	EXIT;
+}
+
 static inline gboolean
 pk_connection_dbus_dispatch_manifest (PkConnectionDBus  *connection,   /* IN */
                                       gint               subscription, /* IN */
@@ -226,13 +267,25 @@ pk_connection_dbus_dispatch_manifest (PkConnectionDBus  *connection,   /* IN */
 	DUMP_MANIFEST(manifest);
 	g_static_rw_lock_reader_unlock(&priv->handlers_lock);
 
+	/*
+	 * The handler may be removed while the lock is not held, so look it
+	 * up again each time the lock is taken.
+	 */
 	key = g_new(gint, 1);
 	*key = pk_manifest_get_source_id(manifest);
 	g_static_rw_lock_writer_lock(&priv->handlers_lock);
-	g_tree_insert(handler->manifests, key, pk_manifest_ref(manifest));
+	if ((handler = g_hash_table_lookup(priv->handlers, &subscription))) {
+		g_tree_insert(handler->manifests, key, pk_manifest_ref(manifest));
+	} else {
+		g_free(key);
+	}
 	g_static_rw_lock_writer_unlock(&priv->handlers_lock);
 
 	g_static_rw_lock_reader_lock(&priv->handlers_lock);
+	if (!(handler = g_hash_table_lookup(priv->handlers, &subscription))) {
+		pk_manifest_unref(manifest);
+		GOTO(handler_not_found);
+	}
 	g_value_init(&manifest_value, PK_TYPE_MANIFEST);
 	g_value_take_boxed(&manifest_value, manifest);
 	g_closure_invoke(handler->manifest, NULL, 1, &manifest_value, NULL);
@@ -270,6 +323,44 @@ g_int_compare (gint *a, /* IN */
 	return (*a - *b);
 }
 
+/**
+ * pk_connection_dbus_flush_samples:
+ * @handler: A #Handler.
+ * @manifest: The #PkManifest shared by all samples in @batch.
+ * @batch: A #GPtrArray of #PkSample.
+ *
+ * Delivers the pending batch of samples to the batched sample closure of
+ * @handler in a single invocation. The samples are released afterwards and
+ * @batch is emptied so that it may be reused.
+ *
+ * Returns: None.
+ * Side effects: @batch is emptied.
+ */
+static void
+pk_connection_dbus_flush_samples (Handler    *handler,  /* IN */
+                                  PkManifest *manifest, /* IN */
+                                  GPtrArray  *batch)    /* IN */
+{
+	GValue params[3] = { { 0 } };
+
+	ENTRY;
+	if (batch->len) {
+		g_value_init(&params[0], PK_TYPE_MANIFEST);
+		g_value_init(&params[1], G_TYPE_POINTER);
+		g_value_init(&params[2], G_TYPE_UINT);
+		g_value_set_boxed(&params[0], manifest);
+		g_value_set_pointer(&params[1], batch->pdata);
+		g_value_set_uint(&params[2], batch->len);
+		g_closure_invoke(handler->samples, NULL, 3, &params[0], NULL);
+		g_value_unset(&params[0]);
+		g_value_unset(&params[1]);
+		g_value_unset(&params[2]);
+		g_ptr_array_foreach(batch, (GFunc)pk_sample_unref, NULL);
+		g_ptr_array_set_size(batch, 0);
+	}
+	EXIT;
+}
+
 static inline gboolean
 pk_connection_dbus_dispatch_sample (PkConnectionDBus  *connection,   /* IN */
                                     gint               subscription, /* IN */
@@ -286,6 +377,8 @@ pk_connection_dbus_dispatch_sample (PkConnectionDBus  *connection,   /* IN */
 	GValue params[2] = { { 0 } };
 	gboolean ret = FALSE;
 	PkManifest *manifest;
+	PkManifest *batch_manifest = NULL;
+	GPtrArray *batch = NULL;
 	gint key;
 
 	ENTRY;
@@ -306,6 +399,9 @@ pk_connection_dbus_dispatch_sample (PkConnectionDBus  *connection,   /* IN */
 		dbus_error_free(&dbus_error);
 		GOTO(invalid_data);
 	}
+	if (handler->samples) {
+		batch = g_ptr_array_sized_new(32);
+	}
 	/*
 	 * TODO: This should be using a matching "decoder" for the subscription
 	 *  rather than being hard coded to the default encoder/decoder.  However,
@@ -328,6 +424,18 @@ pk_connection_dbus_dispatch_sample (PkConnectionDBus  *connection,   /* IN */
 #ifdef PERFKIT_DEBUG
 		g_assert_cmpint(pk_sample_get_source_id(sample), ==, key);
 #endif
+		if (batch) {
+			/*
+			 * Samples from a single buffer are grouped by manifest so the
+			 * handler is invoked once per run instead of once per sample.
+			 */
+			if (manifest != batch_manifest) {
+				pk_connection_dbus_flush_samples(handler, batch_manifest, batch);
+				batch_manifest = manifest;
+			}
+			g_ptr_array_add(batch, sample);
+			continue;
+		}
 		g_value_init(&params[0], PK_TYPE_MANIFEST);
 		g_value_init(&params[1], PK_TYPE_SAMPLE);
 		g_value_set_boxed(&params[0], manifest);
@@ -336,9 +444,16 @@ pk_connection_dbus_dispatch_sample (PkConnectionDBus  *connection,   /* IN */
 		g_value_unset(&params[0]);
 		g_value_unset(&params[1]);
 	}
+	if (batch) {
+		pk_connection_dbus_flush_samples(handler, batch_manifest, batch);
+	}
 	ret = TRUE;
   handler_not_found:
   invalid_data:
+	if (batch) {
+		g_ptr_array_foreach(batch, (GFunc)pk_sample_unref, NULL);
+		g_ptr_array_free(batch, TRUE);
+	}
 	g_static_rw_lock_reader_unlock(&priv->handlers_lock);
 	RETURN(ret);
 }
@@ -895,6 +1010,7 @@ pk_connection_dbus_connect_finish (PkConnection  *connection, /* IN */
 	DBusError db_error = { NULL };
 	DBusMessage *msg;
 	DBusMessage *reply;
+	const gchar *address;
 	gboolean ret = FALSE;
 	gchar *path;
 	gchar *socket;
@@ -918,9 +1034,22 @@ pk_connection_dbus_connect_finish (PkConnection  *connection, /* IN */
 	}
 
 	/*
-	 * Retrieve the session bus.
+	 * Retrieve the session bus, or the bus at the address following
+	 * "dbus://" in the uri.  The latter allows talking to agents that
+	 * were started on private buses.
 	 */
-	priv->dbus = dbus_bus_get(DBUS_BUS_SESSION, &db_error);
+	address = pk_connection_get_uri(connection) + strlen("dbus://");
+	if (!address[0]) {
+		priv->dbus = dbus_bus_get(DBUS_BUS_SESSION, &db_error);
+	} else if ((priv->dbus = dbus_connection_open_private(address, &db_error))) {
+		priv->private_bus = TRUE;
+		dbus_connection_set_exit_on_disconnect(priv->dbus, FALSE);
+		if (!dbus_bus_register(priv->dbus, &db_error)) {
+			dbus_connection_close(priv->dbus);
+			dbus_connection_unref(priv->dbus);
+			priv->dbus = NULL;
+		}
+	}
 	if (!priv->dbus) {
 		g_set_error(error, PK_CONNECTION_DBUS_ERROR,
 		            PK_CONNECTION_DBUS_ERROR_NOT_AVAILABLE,
@@ -1097,6 +1226,9 @@ pk_connection_dbus_disconnect_finish (PkConnection  *connection, /* IN */
 	priv = PK_CONNECTION_DBUS(connection)->priv;
 	g_mutex_lock(priv->mutex);
 	if (priv->dbus) {
+		if (priv->private_bus) {
+			dbus_connection_close(priv->dbus);
+		}
 		dbus_connection_unref(priv->dbus);
 		priv->dbus = NULL;
 	}
@@ -5515,6 +5647,158 @@ finish:
 }
 
 
+static void
+pk_connection_dbus_manager_get_snapshot_async (PkConnection        *connection,  /* IN */
+                                               GCancellable        *cancellable, /* IN */
+                                               GAsyncReadyCallback  callback,    /* IN */
+                                               gpointer             user_data)   /* IN */
+{
+	PkConnectionDBusPrivate *priv;
+	DBusPendingCall *call = NULL;
+	GSimpleAsyncResult *result;
+	DBusMessage *msg;
+
+	g_return_if_fail(PK_IS_CONNECTION_DBUS(connection));
+
+	ENTRY;
+	priv = PK_CONNECTION_DBUS(connection)->priv;
+
+	/*
+	 * Allocate DBus message.
+	 */
+	msg = dbus_message_new(DBUS_MESSAGE_TYPE_METHOD_CALL);
+	g_assert(msg);
+
+	/*
+	 * Create asynchronous connection handle.
+	 */
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_dbus_manager_get_snapshot_async);
+
+	/*
+	 * Wire cancellable if needed.
+	 */
+	if (cancellable) {
+		g_cancellable_connect(cancellable,
+		                      G_CALLBACK(pk_connection_dbus_cancel),
+		                      g_object_ref(result), g_object_unref);
+	}
+
+	/*
+	 * Build the DBus message.
+	 */
+	dbus_message_set_destination(msg, "org.perfkit.Agent");
+	dbus_message_set_interface(msg, "org.perfkit.Agent.Manager");
+	dbus_message_set_member(msg, "GetSnapshot");
+	dbus_message_set_path(msg, "/org/perfkit/Agent/Manager");
+
+	/*
+	 * Send message to agent and schedule to be notified of the result.
+	 */
+	if (!dbus_connection_send_with_reply(priv->dbus, msg, &call, -1)) {
+		g_warning("Error dispatching message to %s/%s",
+		          dbus_message_get_path(msg),
+		          dbus_message_get_member(msg));
+		dbus_message_unref(msg);
+		EXIT;
+	}
+
+	/*
+	 * Get notified when the reply is received or timeout expires.
+	 */
+	dbus_pending_call_set_notify(call, pk_connection_dbus_notify,
+	                             result, g_object_unref);
+
+	/*
+	 * Release resources.
+	 */
+	dbus_message_unref(msg);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_dbus_manager_get_snapshot_finish (PkConnection  *connection,   /* IN */
+                                                GAsyncResult  *result,       /* IN */
+                                                guint8       **snapshot,     /* OUT */
+                                                gsize         *snapshot_len, /* OUT */
+                                                GError       **error)        /* OUT */
+{
+	DBusPendingCall *call;
+	DBusMessage *msg;
+	gboolean ret = FALSE;
+	gchar *error_str = NULL;
+	DBusError dbus_error = { 0 };
+	guint8 *data = NULL;
+	gint data_len = 0;
+
+	g_return_val_if_fail(snapshot != NULL, FALSE);
+	g_return_val_if_fail(snapshot_len != NULL, FALSE);
+	g_return_val_if_fail(G_IS_SIMPLE_ASYNC_RESULT(result), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_get_snapshot), FALSE);
+
+	if (!(call = GET_RESULT_POINTER(DBusPendingCall, result))) {
+		return FALSE;
+	}
+
+	/*
+	 * Clear out params.
+	 */
+	*snapshot = NULL;
+	*snapshot_len = 0;
+
+	/*
+	 * Check if call was cancelled.
+	 */
+	if (!(msg = dbus_pending_call_steal_reply(call))) {
+		g_simple_async_result_propagate_error(
+				G_SIMPLE_ASYNC_RESULT(result),
+				error);
+		goto finish;
+	}
+
+	/*
+	 * Check if response is an error.
+	 */
+	if (dbus_message_get_type(msg) == DBUS_MESSAGE_TYPE_ERROR) {
+		dbus_message_get_args(msg, NULL,
+		                      DBUS_TYPE_STRING, &error_str,
+		                      DBUS_TYPE_INVALID);
+		g_set_error(error, PK_CONNECTION_DBUS_ERROR,
+		            PK_CONNECTION_DBUS_ERROR_DBUS,
+		            "%s: %s",
+		            dbus_message_get_error_name(msg),
+		            error_str);
+		goto finish;
+	}
+
+	/*
+	 * Process message arguments.
+	 */
+	if (!dbus_message_get_args(msg,
+	                           &dbus_error,
+	                           DBUS_TYPE_ARRAY, DBUS_TYPE_BYTE, &data, &data_len,
+	                           DBUS_TYPE_INVALID)) {
+		g_set_error(error, PK_CONNECTION_DBUS_ERROR,
+		            PK_CONNECTION_DBUS_ERROR_DBUS,
+		            "%s: %s", dbus_error.name, dbus_error.message);
+		dbus_error_free(&dbus_error);
+		GOTO(finish);
+	}
+
+	*snapshot = g_memdup(data, data_len);
+	*snapshot_len = data_len;
+
+	ret = TRUE;
+
+finish:
+	dbus_message_unref(msg);
+	g_object_unref(result);
+	RETURN(ret);
+}
+
+
 static void
 pk_connection_dbus_manager_get_sources_async (PkConnection        *connection,  /* IN */
                                               GCancellable        *cancellable, /* IN */
@@ -6437,6 +6721,11 @@ pk_connection_dbus_manager_remove_subscription_async (PkConnection        *conne
 	ENTRY;
 	priv = PK_CONNECTION_DBUS(connection)->priv;
 
+	/*
+	 * Stop delivering to the subscription and release its handler.
+	 */
+	pk_connection_dbus_remove_handler(connection, subscription);
+
 	/*
 	 * Allocate DBus message.
 	 */
@@ -9003,49 +9292,35 @@ finish:
 }
 
 
-static void
-pk_connection_dbus_subscription_set_handlers_async (PkConnection        *connection,       /* IN */
-                                                    gint                 subscription,     /* IN */
-                                                    PkManifestFunc       manifest_func,    /* IN */
-                                                    gpointer             manifest_data,    /* IN */
-                                                    GDestroyNotify       manifest_destroy, /* IN */
-                                                    PkSampleFunc         sample_func,      /* IN */
-                                                    gpointer             sample_data,      /* IN */
-                                                    GDestroyNotify       sample_destroy,   /* IN */
-                                                    GCancellable        *cancellable,      /* IN */
-                                                    GAsyncReadyCallback  callback,         /* IN */
-                                                    gpointer             user_data)        /* IN */
+/**
+ * pk_connection_dbus_add_handler:
+ * @connection: A #PkConnectionDBus.
+ * @handler: A #Handler.
+ *
+ * Registers @handler for incoming manifests and samples of its subscription
+ * and asks the agent to begin delivering to it. @handler is owned by
+ * @connection afterwards.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: The agent subscription is pointed at our handler path.
+ */
+static gboolean
+pk_connection_dbus_add_handler (PkConnection *connection, /* IN */
+                                Handler      *handler)    /* IN */
 {
-	GSimpleAsyncResult *result;
 	PkConnectionDBusPrivate *priv;
 	DBusMessage *message;
-	Handler *handler;
 	gchar *sub_path;
 	gchar *path;
 	gboolean ret = FALSE;
 
-	g_return_if_fail(PK_IS_CONNECTION_DBUS(connection));
-	g_return_if_fail(subscription >= 0);
-	g_return_if_fail(manifest_func != NULL);
-	g_return_if_fail(sample_func != NULL);
-	g_return_if_fail(callback != NULL);
-
 	ENTRY;
 	priv = PK_CONNECTION_DBUS(connection)->priv;
-	handler = g_slice_new0(Handler);
 	handler->id = pk_connection_dbus_next_handler_id();
-	handler->subscription = subscription;
-	handler->manifest = g_cclosure_new(G_CALLBACK(manifest_func),
-	                                   manifest_data,
-	                                   (GClosureNotify)manifest_destroy);
-	handler->sample = g_cclosure_new(G_CALLBACK(sample_func),
-	                                 sample_data,
-	                                 (GClosureNotify)sample_destroy);
 	handler->manifests = g_tree_new_full((GCompareDataFunc)g_int_compare,
 	                                     NULL, g_free,
 	                                     (GDestroyNotify)pk_manifest_unref);
 	g_closure_set_marshal(handler->manifest, g_cclosure_marshal_VOID__VOID);
-	g_closure_set_marshal(handler->sample, g_cclosure_marshal_VOID__BOXED);
 	g_static_rw_lock_writer_lock(&priv->handlers_lock);
 	g_hash_table_insert(priv->handlers, &handler->subscription, handler);
 	g_static_rw_lock_writer_unlock(&priv->handlers_lock);
@@ -9075,6 +9350,44 @@ pk_connection_dbus_subscription_set_handlers_async (PkConnection        *connect
 	ret = TRUE;
   oom:
 	g_mutex_unlock(priv->mutex);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_dbus_subscription_set_handlers_async (PkConnection        *connection,       /* IN */
+                                                    gint                 subscription,     /* IN */
+                                                    PkManifestFunc       manifest_func,    /* IN */
+                                                    gpointer             manifest_data,    /* IN */
+                                                    GDestroyNotify       manifest_destroy, /* IN */
+                                                    PkSampleFunc         sample_func,      /* IN */
+                                                    gpointer             sample_data,      /* IN */
+                                                    GDestroyNotify       sample_destroy,   /* IN */
+                                                    GCancellable        *cancellable,      /* IN */
+                                                    GAsyncReadyCallback  callback,         /* IN */
+                                                    gpointer             user_data)        /* IN */
+{
+	GSimpleAsyncResult *result;
+	Handler *handler;
+	gboolean ret;
+
+	g_return_if_fail(PK_IS_CONNECTION_DBUS(connection));
+	g_return_if_fail(subscription >= 0);
+	g_return_if_fail(manifest_func != NULL);
+	g_return_if_fail(sample_func != NULL);
+	g_return_if_fail(callback != NULL);
+
+	ENTRY;
+	handler = g_slice_new0(Handler);
+	handler->subscription = subscription;
+	handler->manifest = g_cclosure_new(G_CALLBACK(manifest_func),
+	                                   manifest_data,
+	                                   (GClosureNotify)manifest_destroy);
+	handler->sample = g_cclosure_new(G_CALLBACK(sample_func),
+	                                 sample_data,
+	                                 (GClosureNotify)sample_destroy);
+	g_closure_set_marshal(handler->sample, g_cclosure_marshal_VOID__BOXED);
+	ret = pk_connection_dbus_add_handler(connection, handler);
 	result = g_simple_async_result_new(
 			G_OBJECT(connection), callback, user_data,
 			pk_connection_dbus_subscription_set_handlers_async);
@@ -9095,6 +9408,61 @@ pk_connection_dbus_subscription_set_handlers_finish (PkConnection  *connection,
 }
 
 
+static void
+pk_connection_dbus_subscription_set_batch_handlers_async (PkConnection        *connection,       /* IN */
+                                                          gint                 subscription,     /* IN */
+                                                          PkManifestFunc       manifest_func,    /* IN */
+                                                          gpointer             manifest_data,    /* IN */
+                                                          GDestroyNotify       manifest_destroy, /* IN */
+                                                          PkSamplesFunc        samples_func,     /* IN */
+                                                          gpointer             samples_data,     /* IN */
+                                                          GDestroyNotify       samples_destroy,  /* IN */
+                                                          GCancellable        *cancellable,      /* IN */
+                                                          GAsyncReadyCallback  callback,         /* IN */
+                                                          gpointer             user_data)        /* IN */
+{
+	GSimpleAsyncResult *result;
+	Handler *handler;
+	gboolean ret;
+
+	g_return_if_fail(PK_IS_CONNECTION_DBUS(connection));
+	g_return_if_fail(subscription >= 0);
+	g_return_if_fail(manifest_func != NULL);
+	g_return_if_fail(samples_func != NULL);
+	g_return_if_fail(callback != NULL);
+
+	ENTRY;
+	handler = g_slice_new0(Handler);
+	handler->subscription = subscription;
+	handler->manifest = g_cclosure_new(G_CALLBACK(manifest_func),
+	                                   manifest_data,
+	                                   (GClosureNotify)manifest_destroy);
+	handler->samples = g_cclosure_new(G_CALLBACK(samples_func),
+	                                  samples_data,
+	                                  (GClosureNotify)samples_destroy);
+	g_closure_set_marshal(handler->samples,
+	                      pk_cclosure_marshal_VOID__POINTER_UINT);
+	ret = pk_connection_dbus_add_handler(connection, handler);
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_dbus_subscription_set_batch_handlers_async);
+	g_simple_async_result_set_op_res_gboolean(result, ret);
+	g_simple_async_result_complete(result);
+	g_object_unref(result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_dbus_subscription_set_batch_handlers_finish (PkConnection  *connection, /* IN */
+                                                           GAsyncResult  *result,     /* IN */
+                                                           GError       **error)      /* OUT */
+{
+	ENTRY;
+	RETURN(TRUE);
+}
+
+
 static void
 pk_connection_dbus_subscription_unmute_async (PkConnection        *connection,   /* IN */
                                               gint                 subscription, /* IN */
@@ -9245,8 +9613,13 @@ finish:
 static gboolean
 pk_connection_dbus_is_local (PkConnection *connection)
 {
+	const gchar *uri;
+
 	g_return_val_if_fail(PK_IS_CONNECTION_DBUS(connection), FALSE);
-	return g_str_equal(pk_connection_get_uri(connection), "dbus://");
+
+	uri = pk_connection_get_uri(connection);
+	return (g_str_equal(uri, "dbus://") ||
+	        g_str_has_prefix(uri, "dbus://unix:"));
 }
 
 
@@ -9267,6 +9640,9 @@ pk_connection_dbus_finalize (GObject *object)
 	priv = PK_CONNECTION_DBUS(object)->priv;
 
 	if (priv->dbus) {
+		if (priv->private_bus) {
+			dbus_connection_close(priv->dbus);
+		}
 		dbus_connection_unref(priv->dbus);
 	}
 
@@ -9358,6 +9734,7 @@ pk_connection_dbus_class_init (PkConnectionDBusClass *klass)
 	OVERRIDE_VTABLE(manager_get_channels);
 	OVERRIDE_VTABLE(manager_get_hostname);
 	OVERRIDE_VTABLE(manager_get_plugins);
+	OVERRIDE_VTABLE(manager_get_snapshot);
 	OVERRIDE_VTABLE(manager_get_sources);
 	OVERRIDE_VTABLE(manager_get_subscriptions);
 	OVERRIDE_VTABLE(manager_get_version);
@@ -9382,6 +9759,7 @@ pk_connection_dbus_class_init (PkConnectionDBusClass *klass)
 	OVERRIDE_VTABLE(subscription_set_buffer);
 	OVERRIDE_VTABLE(subscription_set_encoder);
 	OVERRIDE_VTABLE(subscription_set_handlers);
+	OVERRIDE_VTABLE(subscription_set_batch_handlers);
 	OVERRIDE_VTABLE(subscription_unmute);
 	#undef ADD_RPC
 
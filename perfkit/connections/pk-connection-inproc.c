@@ -0,0 +1,3338 @@
+/* pk-connection-inproc.c
+ *
+ * Copyright 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <perfkit-agent/perfkit-agent.h>
+#include <perfkit-agent/pka-private.h>
+#include <string.h>
+
+#include "pk-connection-inproc.h"
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Inproc"
+
+/**
+ * SECTION:pk-connection-inproc:
+ * @title: PkConnectionInproc
+ * @short_description: Perfkit client connection to an in-process agent
+ *
+ * #PkConnectionInproc links the Perfkit Agent into the client process.
+ * RPCs are direct calls into the agent and encoded buffers are delivered
+ * to subscription handlers without passing through DBus.
+ *
+ * The agent is started upon the first connection.  Its configuration can
+ * be provided as the path of the URI, such as
+ * "inproc:///etc/perfkit/agent.conf"; with "inproc://" the defaults are
+ * used and no external listeners are started.
+ *
+ * Subscription handlers are called from the thread in which the agent
+ * delivers the buffer.
+ */
+
+#define RESULT_IS_VALID(_t)                                         \
+    g_simple_async_result_is_valid(                                 \
+            G_ASYNC_RESULT((result)),                               \
+            G_OBJECT((connection)),                                 \
+            pk_connection_inproc_##_t##_async)
+
+#define INNER_RESULT(_r)                                            \
+    ((GAsyncResult *)g_simple_async_result_get_op_res_gpointer(     \
+        G_SIMPLE_ASYNC_RESULT((_r))))
+
+#define LISTENER(_c) (PKA_LISTENER(PK_CONNECTION_INPROC((_c))->priv->listener))
+
+G_DEFINE_TYPE(PkConnectionInproc, pk_connection_inproc, PK_TYPE_CONNECTION)
+
+/*
+ * The in-process listener registered with the agent on behalf of each
+ * connection.  It translates agent notifications into #PkConnection
+ * signals.
+ */
+#define PK_TYPE_CONNECTION_INPROC_LISTENER (pk_connection_inproc_listener_get_type())
+
+typedef struct
+{
+	PkaListener   parent;
+	PkConnection *connection; /* Owning connection, not referenced */
+} PkConnectionInprocListener;
+
+typedef struct
+{
+	PkaListenerClass parent_class;
+} PkConnectionInprocListenerClass;
+
+static GType pk_connection_inproc_listener_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE(PkConnectionInprocListener,
+              pk_connection_inproc_listener,
+              PKA_TYPE_LISTENER)
+
+struct _PkConnectionInprocPrivate
+{
+	GMutex                     *mutex;     /* General purpose lock */
+	gboolean                    connected; /* Listener is registered */
+	PkConnectionInprocListener *listener;  /* Listener within the agent */
+};
+
+typedef struct
+{
+	GMutex         *mutex;            /* Synchronizes manifests */
+	gint            subscription;     /* Subscription id in agent */
+	PkManifestFunc  manifest_func;    /* Manifest callback */
+	gpointer        manifest_data;    /* Data for manifest_func */
+	GDestroyNotify  manifest_destroy; /* Notify for manifest_data */
+	PkSampleFunc    sample_func;      /* Sample callback */
+	PkSamplesFunc   samples_func;     /* Batched sample callback */
+	gpointer        sample_data;      /* Data for sample(s)_func */
+	GDestroyNotify  sample_destroy;   /* Notify for sample_data */
+	GTree          *manifests;        /* Source manifests indexed by source id */
+} Handler;
+
+typedef struct
+{
+	PkConnection *connection;
+	void        (*emit_int) (PkConnection *connection,
+	                         gint          id);
+	void        (*emit_str) (PkConnection *connection,
+	                         const gchar  *id);
+	gint          id;
+	gchar        *str;
+} Event;
+
+static void
+handler_free (gpointer data) /* IN */
+{
+	Handler *handler = data;
+
+	if (handler->manifest_destroy) {
+		handler->manifest_destroy(handler->manifest_data);
+	}
+	if (handler->sample_destroy) {
+		handler->sample_destroy(handler->sample_data);
+	}
+	g_tree_unref(handler->manifests);
+	g_mutex_free(handler->mutex);
+	g_slice_free(Handler, handler);
+}
+
+static gint
+g_int_compare (gconstpointer a, /* IN */
+               gconstpointer b) /* IN */
+{
+	return *(const gint *)a - *(const gint *)b;
+}
+
+/**
+ * pk_connection_inproc_emit_event:
+ * @data: An #Event.
+ *
+ * Emits the signal for an agent notification from the main loop.  Agent
+ * notifications are made while the agent holds its listener lock, so
+ * signal handlers must not run until it has been released.
+ *
+ * Returns: %FALSE always.
+ * Side effects: The event is freed.
+ */
+static gboolean
+pk_connection_inproc_emit_event (gpointer data) /* IN */
+{
+	Event *event = data;
+
+	if (event->emit_int) {
+		event->emit_int(event->connection, event->id);
+	} else {
+		event->emit_str(event->connection, event->str);
+	}
+	g_object_unref(event->connection);
+	g_free(event->str);
+	g_slice_free(Event, event);
+	return FALSE;
+}
+
+/**
+ * pk_connection_inproc_queue_event:
+ * @listener: A #PkConnectionInprocListener.
+ *
+ * Queues a notification from the agent to be emitted as a signal on the
+ * connection owning @listener.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_queue_event (PkaListener  *listener,                /* IN */
+                                  void        (*emit_int) (PkConnection*,
+                                                           gint),        /* IN */
+                                  void        (*emit_str) (PkConnection*,
+                                                           const gchar*),/* IN */
+                                  gint          id,                      /* IN */
+                                  const gchar  *str)                     /* IN */
+{
+	PkConnectionInprocListener *inproc = (PkConnectionInprocListener *)listener;
+	Event *event;
+
+	if (!inproc->connection) {
+		return;
+	}
+	event = g_slice_new0(Event);
+	event->connection = g_object_ref(inproc->connection);
+	event->emit_int = emit_int;
+	event->emit_str = emit_str;
+	event->id = id;
+	event->str = g_strdup(str);
+	g_idle_add(pk_connection_inproc_emit_event, event);
+}
+
+#define LISTENER_INT_EVENT(_n)                                               \
+static void                                                                  \
+pk_connection_inproc_listener_##_n (PkaListener *listener, /* IN */          \
+                                    gint         id)       /* IN */          \
+{                                                                            \
+	pk_connection_inproc_queue_event(listener, pk_connection_emit_##_n,      \
+	                                 NULL, id, NULL);                        \
+}
+
+#define LISTENER_STR_EVENT(_n)                                               \
+static void                                                                  \
+pk_connection_inproc_listener_##_n (PkaListener *listener, /* IN */          \
+                                    const gchar *id)       /* IN */          \
+{                                                                            \
+	pk_connection_inproc_queue_event(listener, NULL,                         \
+	                                 pk_connection_emit_##_n, 0, id);        \
+}
+
+LISTENER_STR_EVENT(plugin_added)
+LISTENER_STR_EVENT(plugin_removed)
+LISTENER_INT_EVENT(encoder_added)
+LISTENER_INT_EVENT(encoder_removed)
+LISTENER_INT_EVENT(source_added)
+LISTENER_INT_EVENT(source_removed)
+LISTENER_INT_EVENT(channel_added)
+LISTENER_INT_EVENT(channel_removed)
+LISTENER_INT_EVENT(subscription_added)
+LISTENER_INT_EVENT(subscription_removed)
+
+static gboolean
+pk_connection_inproc_listener_listen (PkaListener  *listener, /* IN */
+                                      GError      **error)    /* OUT */
+{
+	return TRUE;
+}
+
+static void
+pk_connection_inproc_listener_close (PkaListener *listener) /* IN */
+{
+	((PkConnectionInprocListener *)listener)->connection = NULL;
+}
+
+static void
+pk_connection_inproc_listener_class_init (PkConnectionInprocListenerClass *klass) /* IN */
+{
+	PkaListenerClass *listener_class;
+
+	listener_class = PKA_LISTENER_CLASS(klass);
+	listener_class->listen = pk_connection_inproc_listener_listen;
+	listener_class->close = pk_connection_inproc_listener_close;
+	listener_class->plugin_added = pk_connection_inproc_listener_plugin_added;
+	listener_class->plugin_removed = pk_connection_inproc_listener_plugin_removed;
+	listener_class->encoder_added = pk_connection_inproc_listener_encoder_added;
+	listener_class->encoder_removed = pk_connection_inproc_listener_encoder_removed;
+	listener_class->source_added = pk_connection_inproc_listener_source_added;
+	listener_class->source_removed = pk_connection_inproc_listener_source_removed;
+	listener_class->channel_added = pk_connection_inproc_listener_channel_added;
+	listener_class->channel_removed = pk_connection_inproc_listener_channel_removed;
+	listener_class->subscription_added = pk_connection_inproc_listener_subscription_added;
+	listener_class->subscription_removed = pk_connection_inproc_listener_subscription_removed;
+}
+
+static void
+pk_connection_inproc_listener_init (PkConnectionInprocListener *listener) /* IN */
+{
+}
+
+/**
+ * pk_connection_inproc_init_agent:
+ * @data: The configuration filename or %NULL.
+ *
+ * Initializes the agent subsystems within the process.  This is performed
+ * once for the lifetime of the process.
+ *
+ * Returns: None.
+ * Side effects: Agent plugins are loaded.
+ */
+static gpointer
+pk_connection_inproc_init_agent (gpointer data) /* IN */
+{
+	pka_config_init(data);
+	pka_manager_init();
+	return NULL;
+}
+
+/**
+ * pk_connection_inproc_forward_cb:
+ * @listener: A #PkaListener.
+ * @result: A #GAsyncResult from the agent.
+ * @user_data: The #GSimpleAsyncResult for the connection.
+ *
+ * Completes the asynchronous request on the connection once the agent has
+ * completed its half.  The agent result is kept so that the _finish()
+ * function can retrieve the outcome.
+ *
+ * The agent completes its requests immediately, so the connection result
+ * is completed from an idle callback to keep the semantics of an
+ * asynchronous operation.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_forward_cb (GObject      *listener,  /* IN */
+                                 GAsyncResult *result,    /* IN */
+                                 gpointer      user_data) /* IN */
+{
+	GSimpleAsyncResult *outer = user_data;
+
+	g_simple_async_result_set_op_res_gpointer(outer, g_object_ref(result),
+	                                          g_object_unref);
+	g_simple_async_result_complete_in_idle(outer);
+	g_object_unref(outer);
+}
+
+/**
+ * pk_connection_inproc_dispatch_manifest:
+ * @subscription: A #PkaSubscription.
+ * @buf: The encoded manifest.
+ * @buflen: The length of @buf.
+ * @user_data: A #Handler.
+ *
+ * Decodes a manifest delivered by the agent and passes it to the handler.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_dispatch_manifest (PkaSubscription *subscription, /* IN */
+                                        const guint8    *buf,          /* IN */
+                                        gsize            buflen,       /* IN */
+                                        gpointer         user_data)    /* IN */
+{
+	Handler *handler = user_data;
+	PkManifest *manifest;
+	gint *key;
+
+	ENTRY;
+	if (!(manifest = pk_manifest_new_from_data(buf, buflen))) {
+		WARNING(Inproc, "Subscription %d delivered an invalid manifest.",
+		        handler->subscription);
+		EXIT;
+	}
+	key = g_new(gint, 1);
+	*key = pk_manifest_get_source_id(manifest);
+	g_mutex_lock(handler->mutex);
+	g_tree_insert(handler->manifests, key, pk_manifest_ref(manifest));
+	g_mutex_unlock(handler->mutex);
+	handler->manifest_func(manifest, handler->manifest_data);
+	pk_manifest_unref(manifest);
+	EXIT;
+}
+
+static gboolean
+handler_manifest_lookup (gint         source_id, /* IN */
+                         PkManifest **manifest,  /* OUT */
+                         gpointer     user_data) /* IN */
+{
+	Handler *handler = user_data;
+
+	*manifest = g_tree_lookup(handler->manifests, &source_id);
+	return (*manifest != NULL);
+}
+
+/**
+ * pk_connection_inproc_dispatch_sample:
+ * @subscription: A #PkaSubscription.
+ * @buf: The encoded samples.
+ * @buflen: The length of @buf.
+ * @user_data: A #Handler.
+ *
+ * Decodes the samples delivered by the agent and passes them to the
+ * handler.  Batched handlers receive each run of samples sharing a
+ * manifest in a single call.  The samples are decoded while holding the
+ * handler's lock but the callbacks run after releasing it, so they may
+ * call back into the connection.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_dispatch_sample (PkaSubscription *subscription, /* IN */
+                                      const guint8    *buf,          /* IN */
+                                      gsize            buflen,       /* IN */
+                                      gpointer         user_data)    /* IN */
+{
+	Handler *handler = user_data;
+	PkManifest *manifest;
+	PkSample *sample;
+	GPtrArray *samples;
+	GPtrArray *manifests;
+	gsize n_read = 0;
+	gint key;
+	gint begin;
+	gint i;
+
+	ENTRY;
+	samples = g_ptr_array_sized_new(32);
+	manifests = g_ptr_array_sized_new(32);
+	g_mutex_lock(handler->mutex);
+	while (buflen > 0) {
+		if (!(sample = pk_sample_new_from_data(handler_manifest_lookup,
+		                                       handler, buf, buflen,
+		                                       &n_read))) {
+			WARNING(Inproc, "Subscription %d delivered an invalid sample.",
+			        handler->subscription);
+			break;
+		}
+		buflen -= n_read;
+		buf += n_read;
+		key = pk_sample_get_source_id(sample);
+		if ((manifest = g_tree_lookup(handler->manifests, &key))) {
+			pk_manifest_ref(manifest);
+		}
+		g_ptr_array_add(samples, sample);
+		g_ptr_array_add(manifests, manifest);
+	}
+	g_mutex_unlock(handler->mutex);
+
+	/*
+	 * Deliver each run of samples sharing a manifest.
+	 */
+	for (begin = 0; begin < samples->len; begin = i) {
+		manifest = g_ptr_array_index(manifests, begin);
+		i = begin + 1;
+		if (handler->samples_func) {
+			while (i < samples->len &&
+			       g_ptr_array_index(manifests, i) == manifest) {
+				i++;
+			}
+			handler->samples_func(manifest,
+			                      (PkSample **)&samples->pdata[begin],
+			                      i - begin, handler->sample_data);
+		} else {
+			handler->sample_func(manifest,
+			                     g_ptr_array_index(samples, begin),
+			                     handler->sample_data);
+		}
+	}
+
+	for (i = 0; i < samples->len; i++) {
+		pk_sample_unref(g_ptr_array_index(samples, i));
+		if ((manifest = g_ptr_array_index(manifests, i))) {
+			pk_manifest_unref(manifest);
+		}
+	}
+	g_ptr_array_free(samples, TRUE);
+	g_ptr_array_free(manifests, TRUE);
+	EXIT;
+}
+
+/**
+ * pk_connection_inproc_set_handler:
+ * @connection: A #PkConnectionInproc.
+ * @handler: A #Handler.
+ * @error: A location for a #GError, or %NULL.
+ *
+ * Installs @handler as the delivery target of its subscription within the
+ * agent.  The subscription takes ownership of @handler.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+static gboolean
+pk_connection_inproc_set_handler (PkConnection  *connection, /* IN */
+                                  Handler       *handler,    /* IN */
+                                  GError       **error)      /* OUT */
+{
+	PkaSubscription *subscription;
+
+	ENTRY;
+	handler->mutex = g_mutex_new();
+	handler->manifests = g_tree_new_full((GCompareDataFunc)g_int_compare,
+	                                     NULL, g_free,
+	                                     (GDestroyNotify)pk_manifest_unref);
+	if (!pka_manager_find_subscription(pka_context_default(),
+	                                   handler->subscription,
+	                                   &subscription, error)) {
+		handler_free(handler);
+		RETURN(FALSE);
+	}
+	pka_subscription_set_handlers(subscription, pka_context_default(),
+	                              pk_connection_inproc_dispatch_manifest,
+	                              handler, NULL,
+	                              pk_connection_inproc_dispatch_sample,
+	                              handler, handler_free,
+	                              NULL);
+	pka_subscription_unref(subscription);
+	RETURN(TRUE);
+}
+
+/**
+ * pk_connection_inproc_complete:
+ * @connection: A #PkConnectionInproc.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: User data for @callback.
+ * @source_tag: The source tag for the result.
+ * @error: A #GError or %NULL if the operation succeeded.
+ *
+ * Completes an operation that was performed immediately from the main loop
+ * so that @callback is not called before the _async() function returns.
+ *
+ * Returns: None.
+ * Side effects: @error is freed.
+ */
+static void
+pk_connection_inproc_complete (PkConnection        *connection, /* IN */
+                               GAsyncReadyCallback  callback,   /* IN */
+                               gpointer             user_data,  /* IN */
+                               gpointer             source_tag, /* IN */
+                               GError              *error)      /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	result = g_simple_async_result_new(G_OBJECT(connection), callback,
+	                                   user_data, source_tag);
+	if (error) {
+		g_simple_async_result_set_from_error(result, error);
+		g_error_free(error);
+	}
+	g_simple_async_result_complete_in_idle(result);
+	g_object_unref(result);
+}
+
+/**
+ * pk_connection_inproc_connect_async:
+ * @connection: A #PkConnectionInproc.
+ * @cancellable: A #GCancellable.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: user data for @callback.
+ *
+ * Asynchronously connects to the in-process agent, starting it if needed.
+ * @callback MUST call pk_connection_inproc_connect_finish().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_connect_async (PkConnection        *connection,  /* IN */
+                                    GCancellable        *cancellable, /* IN */
+                                    GAsyncReadyCallback  callback,    /* IN */
+                                    gpointer             user_data)   /* IN */
+{
+	static GOnce agent_once = G_ONCE_INIT;
+	PkConnectionInprocPrivate *priv;
+	const gchar *uri;
+	GError *error = NULL;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+	g_return_if_fail(callback != NULL);
+
+	ENTRY;
+	priv = PK_CONNECTION_INPROC(connection)->priv;
+	uri = pk_connection_get_uri(connection);
+	if (uri && g_str_has_prefix(uri, "inproc://") && uri[9]) {
+		g_once(&agent_once, pk_connection_inproc_init_agent,
+		       (gpointer)&uri[9]);
+	} else {
+		g_once(&agent_once, pk_connection_inproc_init_agent, NULL);
+	}
+	g_mutex_lock(priv->mutex);
+	if (priv->connected) {
+		g_set_error(&error, PK_CONNECTION_INPROC_ERROR,
+		            PK_CONNECTION_INPROC_ERROR_STATE,
+		            "The connection is already connected.");
+	} else if (pka_manager_add_listener(PKA_LISTENER(priv->listener),
+	                                    &error)) {
+		priv->connected = TRUE;
+	}
+	g_mutex_unlock(priv->mutex);
+	pk_connection_inproc_complete(connection, callback, user_data,
+	                              pk_connection_inproc_connect_async,
+	                              error);
+	EXIT;
+}
+
+/**
+ * pk_connection_inproc_connect_finish:
+ * @connection: A #PkConnectionInproc.
+ * @result: A #GAsyncResult.
+ * @error: A location for a #GError, or %NULL.
+ *
+ * Completes an asynchronous request to connect to the in-process agent.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+pk_connection_inproc_connect_finish (PkConnection  *connection, /* IN */
+                                     GAsyncResult  *result,     /* IN */
+                                     GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(connect), FALSE);
+
+	ENTRY;
+	ret = !g_simple_async_result_propagate_error(
+			G_SIMPLE_ASYNC_RESULT(result), error);
+	pk_connection_emit_state_changed(
+			connection,
+			ret ? PK_CONNECTION_CONNECTED : PK_CONNECTION_FAILED);
+	RETURN(ret);
+}
+
+/**
+ * pk_connection_inproc_disconnect_async:
+ * @connection: A #PkConnectionInproc.
+ * @cancellable: A #GCancellable.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: user data for @callback.
+ *
+ * Asynchronously disconnects from the in-process agent.  The agent itself
+ * keeps running for the lifetime of the process.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_disconnect_async (PkConnection        *connection,  /* IN */
+                                       GCancellable        *cancellable, /* IN */
+                                       GAsyncReadyCallback  callback,    /* IN */
+                                       gpointer             user_data)   /* IN */
+{
+	PkConnectionInprocPrivate *priv;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+	g_return_if_fail(callback != NULL);
+
+	ENTRY;
+	priv = PK_CONNECTION_INPROC(connection)->priv;
+	g_mutex_lock(priv->mutex);
+	if (priv->connected) {
+		pka_manager_remove_listener(PKA_LISTENER(priv->listener));
+		priv->connected = FALSE;
+	}
+	g_mutex_unlock(priv->mutex);
+	pk_connection_inproc_complete(connection, callback, user_data,
+	                              pk_connection_inproc_disconnect_async,
+	                              NULL);
+	EXIT;
+}
+
+/**
+ * pk_connection_inproc_disconnect_finish:
+ * @connection: A #PkConnectionInproc.
+ * @result: A #GAsyncResult.
+ * @error: A location for a #GError, or %NULL.
+ *
+ * Completes an asynchronous request to disconnect from the agent.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+pk_connection_inproc_disconnect_finish (PkConnection  *connection, /* IN */
+                                        GAsyncResult  *result,     /* IN */
+                                        GError       **error)      /* OUT */
+{
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(disconnect), FALSE);
+
+	ENTRY;
+	pk_connection_emit_state_changed(connection, PK_CONNECTION_DISCONNECTED);
+	RETURN(TRUE);
+}
+
+/**
+ * pk_connection_inproc_subscription_set_handlers_async:
+ * @connection: A #PkConnectionInproc.
+ *
+ * Asynchronously installs the manifest and sample handlers for a
+ * subscription.  Samples are delivered one at a time to @sample_func.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_subscription_set_handlers_async (PkConnection        *connection,       /* IN */
+                                                      gint                 subscription,     /* IN */
+                                                      PkManifestFunc       manifest_func,    /* IN */
+                                                      gpointer             manifest_data,    /* IN */
+                                                      GDestroyNotify       manifest_destroy, /* IN */
+                                                      PkSampleFunc         sample_func,      /* IN */
+                                                      gpointer             sample_data,      /* IN */
+                                                      GDestroyNotify       sample_destroy,   /* IN */
+                                                      GCancellable        *cancellable,      /* IN */
+                                                      GAsyncReadyCallback  callback,         /* IN */
+                                                      gpointer             user_data)        /* IN */
+{
+	Handler *handler;
+	GError *error = NULL;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	handler = g_slice_new0(Handler);
+	handler->subscription = subscription;
+	handler->manifest_func = manifest_func;
+	handler->manifest_data = manifest_data;
+	handler->manifest_destroy = manifest_destroy;
+	handler->sample_func = sample_func;
+	handler->sample_data = sample_data;
+	handler->sample_destroy = sample_destroy;
+	pk_connection_inproc_set_handler(connection, handler, &error);
+	pk_connection_inproc_complete(
+			connection, callback, user_data,
+			pk_connection_inproc_subscription_set_handlers_async,
+			error);
+	EXIT;
+}
+
+static gboolean
+pk_connection_inproc_subscription_set_handlers_finish (PkConnection  *connection, /* IN */
+                                                       GAsyncResult  *result,     /* IN */
+                                                       GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_set_handlers), FALSE);
+
+	ENTRY;
+	ret = !g_simple_async_result_propagate_error(
+			G_SIMPLE_ASYNC_RESULT(result), error);
+	RETURN(ret);
+}
+
+/**
+ * pk_connection_inproc_subscription_set_batch_handlers_async:
+ * @connection: A #PkConnectionInproc.
+ *
+ * Like pk_connection_inproc_subscription_set_handlers_async() except that
+ * the samples decoded from each buffer are passed to @samples_func in runs
+ * sharing a manifest.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_subscription_set_batch_handlers_async (PkConnection        *connection,       /* IN */
+                                                            gint                 subscription,     /* IN */
+                                                            PkManifestFunc       manifest_func,    /* IN */
+                                                            gpointer             manifest_data,    /* IN */
+                                                            GDestroyNotify       manifest_destroy, /* IN */
+                                                            PkSamplesFunc        samples_func,     /* IN */
+                                                            gpointer             samples_data,     /* IN */
+                                                            GDestroyNotify       samples_destroy,  /* IN */
+                                                            GCancellable        *cancellable,      /* IN */
+                                                            GAsyncReadyCallback  callback,         /* IN */
+                                                            gpointer             user_data)        /* IN */
+{
+	Handler *handler;
+	GError *error = NULL;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	handler = g_slice_new0(Handler);
+	handler->subscription = subscription;
+	handler->manifest_func = manifest_func;
+	handler->manifest_data = manifest_data;
+	handler->manifest_destroy = manifest_destroy;
+	handler->samples_func = samples_func;
+	handler->sample_data = samples_data;
+	handler->sample_destroy = samples_destroy;
+	pk_connection_inproc_set_handler(connection, handler, &error);
+	pk_connection_inproc_complete(
+			connection, callback, user_data,
+			pk_connection_inproc_subscription_set_batch_handlers_async,
+			error);
+	EXIT;
+}
+
+static gboolean
+pk_connection_inproc_subscription_set_batch_handlers_finish (PkConnection  *connection, /* IN */
+                                                             GAsyncResult  *result,     /* IN */
+                                                             GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_set_batch_handlers), FALSE);
+
+	ENTRY;
+	ret = !g_simple_async_result_propagate_error(
+			G_SIMPLE_ASYNC_RESULT(result), error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_add_source_async (PkConnection        *connection,  /* IN */
+                                               gint                 channel,     /* IN */
+                                               gint                 source,      /* IN */
+                                               GCancellable        *cancellable, /* IN */
+                                               GAsyncReadyCallback  callback,    /* IN */
+                                               gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_add_source_async);
+	pka_listener_channel_add_source_async(LISTENER(connection),
+	                                      channel,
+	                                      source,
+	                                      cancellable,
+	                                      pk_connection_inproc_forward_cb,
+	                                      result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_add_source_finish (PkConnection  *connection, /* IN */
+                                                GAsyncResult  *result,     /* IN */
+                                                GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_add_source), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_add_source_finish(LISTENER(connection),
+	                                             INNER_RESULT(result),
+	                                             error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_args_async (PkConnection        *connection,  /* IN */
+                                             gint                 channel,     /* IN */
+                                             GCancellable        *cancellable, /* IN */
+                                             GAsyncReadyCallback  callback,    /* IN */
+                                             gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_args_async);
+	pka_listener_channel_get_args_async(LISTENER(connection),
+	                                    channel,
+	                                    cancellable,
+	                                    pk_connection_inproc_forward_cb,
+	                                    result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_args_finish (PkConnection   *connection, /* IN */
+                                              GAsyncResult   *result,     /* IN */
+                                              gchar        ***args,       /* OUT */
+                                              GError        **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_args), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_args_finish(LISTENER(connection),
+	                                           INNER_RESULT(result),
+	                                           args,
+	                                           error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_created_at_async (PkConnection        *connection,  /* IN */
+                                                   gint                 channel,     /* IN */
+                                                   GCancellable        *cancellable, /* IN */
+                                                   GAsyncReadyCallback  callback,    /* IN */
+                                                   gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_created_at_async);
+	pka_listener_channel_get_created_at_async(LISTENER(connection),
+	                                          channel,
+	                                          cancellable,
+	                                          pk_connection_inproc_forward_cb,
+	                                          result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_created_at_finish (PkConnection  *connection, /* IN */
+                                                    GAsyncResult  *result,     /* IN */
+                                                    GTimeVal      *tv,         /* OUT */
+                                                    GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_created_at), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_created_at_finish(LISTENER(connection),
+	                                                 INNER_RESULT(result),
+	                                                 tv,
+	                                                 error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_env_async (PkConnection        *connection,  /* IN */
+                                            gint                 channel,     /* IN */
+                                            GCancellable        *cancellable, /* IN */
+                                            GAsyncReadyCallback  callback,    /* IN */
+                                            gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_env_async);
+	pka_listener_channel_get_env_async(LISTENER(connection),
+	                                   channel,
+	                                   cancellable,
+	                                   pk_connection_inproc_forward_cb,
+	                                   result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_env_finish (PkConnection   *connection, /* IN */
+                                             GAsyncResult   *result,     /* IN */
+                                             gchar        ***env,        /* OUT */
+                                             GError        **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_env), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_env_finish(LISTENER(connection),
+	                                          INNER_RESULT(result),
+	                                          env,
+	                                          error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_exit_status_async (PkConnection        *connection,  /* IN */
+                                                    gint                 channel,     /* IN */
+                                                    GCancellable        *cancellable, /* IN */
+                                                    GAsyncReadyCallback  callback,    /* IN */
+                                                    gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_exit_status_async);
+	pka_listener_channel_get_exit_status_async(LISTENER(connection),
+	                                           channel,
+	                                           cancellable,
+	                                           pk_connection_inproc_forward_cb,
+	                                           result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_exit_status_finish (PkConnection  *connection,  /* IN */
+                                                     GAsyncResult  *result,      /* IN */
+                                                     gint          *exit_status, /* OUT */
+                                                     GError       **error)       /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_exit_status), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_exit_status_finish(LISTENER(connection),
+	                                                  INNER_RESULT(result),
+	                                                  exit_status,
+	                                                  error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_kill_pid_async (PkConnection        *connection,  /* IN */
+                                                 gint                 channel,     /* IN */
+                                                 GCancellable        *cancellable, /* IN */
+                                                 GAsyncReadyCallback  callback,    /* IN */
+                                                 gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_kill_pid_async);
+	pka_listener_channel_get_kill_pid_async(LISTENER(connection),
+	                                        channel,
+	                                        cancellable,
+	                                        pk_connection_inproc_forward_cb,
+	                                        result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_kill_pid_finish (PkConnection  *connection, /* IN */
+                                                  GAsyncResult  *result,     /* IN */
+                                                  gboolean      *kill_pid,   /* OUT */
+                                                  GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_kill_pid), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_kill_pid_finish(LISTENER(connection),
+	                                               INNER_RESULT(result),
+	                                               kill_pid,
+	                                               error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_pid_async (PkConnection        *connection,  /* IN */
+                                            gint                 channel,     /* IN */
+                                            GCancellable        *cancellable, /* IN */
+                                            GAsyncReadyCallback  callback,    /* IN */
+                                            gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_pid_async);
+	pka_listener_channel_get_pid_async(LISTENER(connection),
+	                                   channel,
+	                                   cancellable,
+	                                   pk_connection_inproc_forward_cb,
+	                                   result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_pid_finish (PkConnection  *connection, /* IN */
+                                             GAsyncResult  *result,     /* IN */
+                                             gint          *pid,        /* OUT */
+                                             GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_pid), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_pid_finish(LISTENER(connection),
+	                                          INNER_RESULT(result),
+	                                          pid,
+	                                          error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_pid_set_async (PkConnection        *connection,  /* IN */
+                                                gint                 channel,     /* IN */
+                                                GCancellable        *cancellable, /* IN */
+                                                GAsyncReadyCallback  callback,    /* IN */
+                                                gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_pid_set_async);
+	pka_listener_channel_get_pid_set_async(LISTENER(connection),
+	                                       channel,
+	                                       cancellable,
+	                                       pk_connection_inproc_forward_cb,
+	                                       result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_pid_set_finish (PkConnection  *connection, /* IN */
+                                                 GAsyncResult  *result,     /* IN */
+                                                 gboolean      *pid_set,    /* OUT */
+                                                 GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_pid_set), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_pid_set_finish(LISTENER(connection),
+	                                              INNER_RESULT(result),
+	                                              pid_set,
+	                                              error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_sources_async (PkConnection        *connection,  /* IN */
+                                                gint                 channel,     /* IN */
+                                                GCancellable        *cancellable, /* IN */
+                                                GAsyncReadyCallback  callback,    /* IN */
+                                                gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_sources_async);
+	pka_listener_channel_get_sources_async(LISTENER(connection),
+	                                       channel,
+	                                       cancellable,
+	                                       pk_connection_inproc_forward_cb,
+	                                       result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_sources_finish (PkConnection  *connection,  /* IN */
+                                                 GAsyncResult  *result,      /* IN */
+                                                 gint         **sources,     /* OUT */
+                                                 gsize         *sources_len, /* OUT */
+                                                 GError       **error)       /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_sources), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_sources_finish(LISTENER(connection),
+	                                              INNER_RESULT(result),
+	                                              sources,
+	                                              sources_len,
+	                                              error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_state_async (PkConnection        *connection,  /* IN */
+                                              gint                 channel,     /* IN */
+                                              GCancellable        *cancellable, /* IN */
+                                              GAsyncReadyCallback  callback,    /* IN */
+                                              gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_state_async);
+	pka_listener_channel_get_state_async(LISTENER(connection),
+	                                     channel,
+	                                     cancellable,
+	                                     pk_connection_inproc_forward_cb,
+	                                     result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_state_finish (PkConnection  *connection, /* IN */
+                                               GAsyncResult  *result,     /* IN */
+                                               gint          *state,      /* OUT */
+                                               GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_state), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_state_finish(LISTENER(connection),
+	                                            INNER_RESULT(result),
+	                                            state,
+	                                            error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_target_async (PkConnection        *connection,  /* IN */
+                                               gint                 channel,     /* IN */
+                                               GCancellable        *cancellable, /* IN */
+                                               GAsyncReadyCallback  callback,    /* IN */
+                                               gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_target_async);
+	pka_listener_channel_get_target_async(LISTENER(connection),
+	                                      channel,
+	                                      cancellable,
+	                                      pk_connection_inproc_forward_cb,
+	                                      result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_target_finish (PkConnection  *connection, /* IN */
+                                                GAsyncResult  *result,     /* IN */
+                                                gchar        **target,     /* OUT */
+                                                GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_target), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_target_finish(LISTENER(connection),
+	                                             INNER_RESULT(result),
+	                                             target,
+	                                             error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_get_working_dir_async (PkConnection        *connection,  /* IN */
+                                                    gint                 channel,     /* IN */
+                                                    GCancellable        *cancellable, /* IN */
+                                                    GAsyncReadyCallback  callback,    /* IN */
+                                                    gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_get_working_dir_async);
+	pka_listener_channel_get_working_dir_async(LISTENER(connection),
+	                                           channel,
+	                                           cancellable,
+	                                           pk_connection_inproc_forward_cb,
+	                                           result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_get_working_dir_finish (PkConnection  *connection,  /* IN */
+                                                     GAsyncResult  *result,      /* IN */
+                                                     gchar        **working_dir, /* OUT */
+                                                     GError       **error)       /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_get_working_dir), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_get_working_dir_finish(LISTENER(connection),
+	                                                  INNER_RESULT(result),
+	                                                  working_dir,
+	                                                  error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_mute_async (PkConnection        *connection,  /* IN */
+                                         gint                 channel,     /* IN */
+                                         GCancellable        *cancellable, /* IN */
+                                         GAsyncReadyCallback  callback,    /* IN */
+                                         gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_mute_async);
+	pka_listener_channel_mute_async(LISTENER(connection),
+	                                channel,
+	                                cancellable,
+	                                pk_connection_inproc_forward_cb,
+	                                result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_mute_finish (PkConnection  *connection, /* IN */
+                                          GAsyncResult  *result,     /* IN */
+                                          GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_mute), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_mute_finish(LISTENER(connection),
+	                                       INNER_RESULT(result),
+	                                       error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_set_args_async (PkConnection         *connection,  /* IN */
+                                             gint                  channel,     /* IN */
+                                             const gchar         **args,        /* IN */
+                                             GCancellable         *cancellable, /* IN */
+                                             GAsyncReadyCallback   callback,    /* IN */
+                                             gpointer              user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_set_args_async);
+	pka_listener_channel_set_args_async(LISTENER(connection),
+	                                    channel,
+	                                    (gchar **)args,
+	                                    cancellable,
+	                                    pk_connection_inproc_forward_cb,
+	                                    result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_set_args_finish (PkConnection  *connection, /* IN */
+                                              GAsyncResult  *result,     /* IN */
+                                              GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_set_args), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_set_args_finish(LISTENER(connection),
+	                                           INNER_RESULT(result),
+	                                           error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_set_env_async (PkConnection         *connection,  /* IN */
+                                            gint                  channel,     /* IN */
+                                            const gchar         **env,         /* IN */
+                                            GCancellable         *cancellable, /* IN */
+                                            GAsyncReadyCallback   callback,    /* IN */
+                                            gpointer              user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_set_env_async);
+	pka_listener_channel_set_env_async(LISTENER(connection),
+	                                   channel,
+	                                   (gchar **)env,
+	                                   cancellable,
+	                                   pk_connection_inproc_forward_cb,
+	                                   result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_set_env_finish (PkConnection  *connection, /* IN */
+                                             GAsyncResult  *result,     /* IN */
+                                             GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_set_env), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_set_env_finish(LISTENER(connection),
+	                                          INNER_RESULT(result),
+	                                          error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_set_kill_pid_async (PkConnection        *connection,  /* IN */
+                                                 gint                 channel,     /* IN */
+                                                 gboolean             kill_pid,    /* IN */
+                                                 GCancellable        *cancellable, /* IN */
+                                                 GAsyncReadyCallback  callback,    /* IN */
+                                                 gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_set_kill_pid_async);
+	pka_listener_channel_set_kill_pid_async(LISTENER(connection),
+	                                        channel,
+	                                        kill_pid,
+	                                        cancellable,
+	                                        pk_connection_inproc_forward_cb,
+	                                        result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_set_kill_pid_finish (PkConnection  *connection, /* IN */
+                                                  GAsyncResult  *result,     /* IN */
+                                                  GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_set_kill_pid), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_set_kill_pid_finish(LISTENER(connection),
+	                                               INNER_RESULT(result),
+	                                               error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_set_pid_async (PkConnection        *connection,  /* IN */
+                                            gint                 channel,     /* IN */
+                                            gint                 pid,         /* IN */
+                                            GCancellable        *cancellable, /* IN */
+                                            GAsyncReadyCallback  callback,    /* IN */
+                                            gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_set_pid_async);
+	pka_listener_channel_set_pid_async(LISTENER(connection),
+	                                   channel,
+	                                   pid,
+	                                   cancellable,
+	                                   pk_connection_inproc_forward_cb,
+	                                   result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_set_pid_finish (PkConnection  *connection, /* IN */
+                                             GAsyncResult  *result,     /* IN */
+                                             GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_set_pid), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_set_pid_finish(LISTENER(connection),
+	                                          INNER_RESULT(result),
+	                                          error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_set_target_async (PkConnection        *connection,  /* IN */
+                                               gint                 channel,     /* IN */
+                                               const gchar         *target,      /* IN */
+                                               GCancellable        *cancellable, /* IN */
+                                               GAsyncReadyCallback  callback,    /* IN */
+                                               gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_set_target_async);
+	pka_listener_channel_set_target_async(LISTENER(connection),
+	                                      channel,
+	                                      target,
+	                                      cancellable,
+	                                      pk_connection_inproc_forward_cb,
+	                                      result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_set_target_finish (PkConnection  *connection, /* IN */
+                                                GAsyncResult  *result,     /* IN */
+                                                GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_set_target), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_set_target_finish(LISTENER(connection),
+	                                             INNER_RESULT(result),
+	                                             error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_set_working_dir_async (PkConnection        *connection,  /* IN */
+                                                    gint                 channel,     /* IN */
+                                                    const gchar         *working_dir, /* IN */
+                                                    GCancellable        *cancellable, /* IN */
+                                                    GAsyncReadyCallback  callback,    /* IN */
+                                                    gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_set_working_dir_async);
+	pka_listener_channel_set_working_dir_async(LISTENER(connection),
+	                                           channel,
+	                                           working_dir,
+	                                           cancellable,
+	                                           pk_connection_inproc_forward_cb,
+	                                           result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_set_working_dir_finish (PkConnection  *connection, /* IN */
+                                                     GAsyncResult  *result,     /* IN */
+                                                     GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_set_working_dir), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_set_working_dir_finish(LISTENER(connection),
+	                                                  INNER_RESULT(result),
+	                                                  error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_start_async (PkConnection        *connection,  /* IN */
+                                          gint                 channel,     /* IN */
+                                          GCancellable        *cancellable, /* IN */
+                                          GAsyncReadyCallback  callback,    /* IN */
+                                          gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_start_async);
+	pka_listener_channel_start_async(LISTENER(connection),
+	                                 channel,
+	                                 cancellable,
+	                                 pk_connection_inproc_forward_cb,
+	                                 result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_start_finish (PkConnection  *connection, /* IN */
+                                           GAsyncResult  *result,     /* IN */
+                                           GTimeVal      *started_at, /* OUT */
+                                           GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_start), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_start_finish(LISTENER(connection),
+	                                        INNER_RESULT(result),
+	                                        started_at,
+	                                        error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_stop_async (PkConnection        *connection,  /* IN */
+                                         gint                 channel,     /* IN */
+                                         GCancellable        *cancellable, /* IN */
+                                         GAsyncReadyCallback  callback,    /* IN */
+                                         gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_stop_async);
+	pka_listener_channel_stop_async(LISTENER(connection),
+	                                channel,
+	                                cancellable,
+	                                pk_connection_inproc_forward_cb,
+	                                result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_stop_finish (PkConnection  *connection, /* IN */
+                                          GAsyncResult  *result,     /* IN */
+                                          GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_stop), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_stop_finish(LISTENER(connection),
+	                                       INNER_RESULT(result),
+	                                       error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_channel_unmute_async (PkConnection        *connection,  /* IN */
+                                           gint                 channel,     /* IN */
+                                           GCancellable        *cancellable, /* IN */
+                                           GAsyncReadyCallback  callback,    /* IN */
+                                           gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_channel_unmute_async);
+	pka_listener_channel_unmute_async(LISTENER(connection),
+	                                  channel,
+	                                  cancellable,
+	                                  pk_connection_inproc_forward_cb,
+	                                  result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_channel_unmute_finish (PkConnection  *connection, /* IN */
+                                            GAsyncResult  *result,     /* IN */
+                                            GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(channel_unmute), FALSE);
+
+	ENTRY;
+	ret = pka_listener_channel_unmute_finish(LISTENER(connection),
+	                                         INNER_RESULT(result),
+	                                         error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_encoder_get_plugin_async (PkConnection        *connection,  /* IN */
+                                               gint                 encoder,     /* IN */
+                                               GCancellable        *cancellable, /* IN */
+                                               GAsyncReadyCallback  callback,    /* IN */
+                                               gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_encoder_get_plugin_async);
+	pka_listener_encoder_get_plugin_async(LISTENER(connection),
+	                                      encoder,
+	                                      cancellable,
+	                                      pk_connection_inproc_forward_cb,
+	                                      result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_encoder_get_plugin_finish (PkConnection  *connection, /* IN */
+                                                GAsyncResult  *result,     /* IN */
+                                                gchar        **plugin,     /* OUT */
+                                                GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(encoder_get_plugin), FALSE);
+
+	ENTRY;
+	ret = pka_listener_encoder_get_plugin_finish(LISTENER(connection),
+	                                             INNER_RESULT(result),
+	                                             plugin,
+	                                             error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_add_channel_async (PkConnection        *connection,  /* IN */
+                                                GCancellable        *cancellable, /* IN */
+                                                GAsyncReadyCallback  callback,    /* IN */
+                                                gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_add_channel_async);
+	pka_listener_manager_add_channel_async(LISTENER(connection),
+	                                       cancellable,
+	                                       pk_connection_inproc_forward_cb,
+	                                       result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_add_channel_finish (PkConnection  *connection, /* IN */
+                                                 GAsyncResult  *result,     /* IN */
+                                                 gint          *channel,    /* OUT */
+                                                 GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_add_channel), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_add_channel_finish(LISTENER(connection),
+	                                              INNER_RESULT(result),
+	                                              channel,
+	                                              error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_add_source_async (PkConnection        *connection,  /* IN */
+                                               const gchar         *plugin,      /* IN */
+                                               GCancellable        *cancellable, /* IN */
+                                               GAsyncReadyCallback  callback,    /* IN */
+                                               gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_add_source_async);
+	pka_listener_manager_add_source_async(LISTENER(connection),
+	                                      plugin,
+	                                      cancellable,
+	                                      pk_connection_inproc_forward_cb,
+	                                      result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_add_source_finish (PkConnection  *connection, /* IN */
+                                                GAsyncResult  *result,     /* IN */
+                                                gint          *source,     /* OUT */
+                                                GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_add_source), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_add_source_finish(LISTENER(connection),
+	                                             INNER_RESULT(result),
+	                                             source,
+	                                             error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_add_subscription_async (PkConnection        *connection,  /* IN */
+                                                     gsize                buffer_size, /* IN */
+                                                     gsize                timeout,     /* IN */
+                                                     GCancellable        *cancellable, /* IN */
+                                                     GAsyncReadyCallback  callback,    /* IN */
+                                                     gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_add_subscription_async);
+	pka_listener_manager_add_subscription_async(LISTENER(connection),
+	                                            buffer_size,
+	                                            timeout,
+	                                            cancellable,
+	                                            pk_connection_inproc_forward_cb,
+	                                            result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_add_subscription_finish (PkConnection  *connection,   /* IN */
+                                                      GAsyncResult  *result,       /* IN */
+                                                      gint          *subscription, /* OUT */
+                                                      GError       **error)        /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_add_subscription), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_add_subscription_finish(LISTENER(connection),
+	                                                   INNER_RESULT(result),
+	                                                   subscription,
+	                                                   error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_get_channels_async (PkConnection        *connection,  /* IN */
+                                                 GCancellable        *cancellable, /* IN */
+                                                 GAsyncReadyCallback  callback,    /* IN */
+                                                 gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_get_channels_async);
+	pka_listener_manager_get_channels_async(LISTENER(connection),
+	                                        cancellable,
+	                                        pk_connection_inproc_forward_cb,
+	                                        result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_get_channels_finish (PkConnection  *connection,   /* IN */
+                                                  GAsyncResult  *result,       /* IN */
+                                                  gint         **channels,     /* OUT */
+                                                  gsize         *channels_len, /* OUT */
+                                                  GError       **error)        /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_get_channels), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_get_channels_finish(LISTENER(connection),
+	                                               INNER_RESULT(result),
+	                                               channels,
+	                                               channels_len,
+	                                               error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_get_hostname_async (PkConnection        *connection,  /* IN */
+                                                 GCancellable        *cancellable, /* IN */
+                                                 GAsyncReadyCallback  callback,    /* IN */
+                                                 gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_get_hostname_async);
+	pka_listener_manager_get_hostname_async(LISTENER(connection),
+	                                        cancellable,
+	                                        pk_connection_inproc_forward_cb,
+	                                        result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_get_hostname_finish (PkConnection  *connection, /* IN */
+                                                  GAsyncResult  *result,     /* IN */
+                                                  gchar        **hostname,   /* OUT */
+                                                  GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_get_hostname), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_get_hostname_finish(LISTENER(connection),
+	                                               INNER_RESULT(result),
+	                                               hostname,
+	                                               error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_get_plugins_async (PkConnection        *connection,  /* IN */
+                                                GCancellable        *cancellable, /* IN */
+                                                GAsyncReadyCallback  callback,    /* IN */
+                                                gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_get_plugins_async);
+	pka_listener_manager_get_plugins_async(LISTENER(connection),
+	                                       cancellable,
+	                                       pk_connection_inproc_forward_cb,
+	                                       result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_get_plugins_finish (PkConnection   *connection, /* IN */
+                                                 GAsyncResult   *result,     /* IN */
+                                                 gchar        ***plugins,    /* OUT */
+                                                 GError        **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_get_plugins), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_get_plugins_finish(LISTENER(connection),
+	                                              INNER_RESULT(result),
+	                                              plugins,
+	                                              error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_get_snapshot_async (PkConnection        *connection,  /* IN */
+                                                 GCancellable        *cancellable, /* IN */
+                                                 GAsyncReadyCallback  callback,    /* IN */
+                                                 gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_get_snapshot_async);
+	pka_listener_manager_get_snapshot_async(LISTENER(connection),
+	                                        cancellable,
+	                                        pk_connection_inproc_forward_cb,
+	                                        result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_get_snapshot_finish (PkConnection  *connection,   /* IN */
+                                                  GAsyncResult  *result,       /* IN */
+                                                  guint8       **snapshot,     /* OUT */
+                                                  gsize         *snapshot_len, /* OUT */
+                                                  GError       **error)        /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_get_snapshot), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_get_snapshot_finish(LISTENER(connection),
+	                                               INNER_RESULT(result),
+	                                               snapshot,
+	                                               snapshot_len,
+	                                               error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_get_sources_async (PkConnection        *connection,  /* IN */
+                                                GCancellable        *cancellable, /* IN */
+                                                GAsyncReadyCallback  callback,    /* IN */
+                                                gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_get_sources_async);
+	pka_listener_manager_get_sources_async(LISTENER(connection),
+	                                       cancellable,
+	                                       pk_connection_inproc_forward_cb,
+	                                       result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_get_sources_finish (PkConnection  *connection,  /* IN */
+                                                 GAsyncResult  *result,      /* IN */
+                                                 gint         **sources,     /* OUT */
+                                                 gsize         *sources_len, /* OUT */
+                                                 GError       **error)       /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_get_sources), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_get_sources_finish(LISTENER(connection),
+	                                              INNER_RESULT(result),
+	                                              sources,
+	                                              sources_len,
+	                                              error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_get_subscriptions_async (PkConnection        *connection,  /* IN */
+                                                      GCancellable        *cancellable, /* IN */
+                                                      GAsyncReadyCallback  callback,    /* IN */
+                                                      gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_get_subscriptions_async);
+	pka_listener_manager_get_subscriptions_async(LISTENER(connection),
+	                                             cancellable,
+	                                             pk_connection_inproc_forward_cb,
+	                                             result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_get_subscriptions_finish (PkConnection  *connection,        /* IN */
+                                                       GAsyncResult  *result,            /* IN */
+                                                       gint         **subscriptions,     /* OUT */
+                                                       gsize         *subscriptions_len, /* OUT */
+                                                       GError       **error)             /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_get_subscriptions), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_get_subscriptions_finish(LISTENER(connection),
+	                                                    INNER_RESULT(result),
+	                                                    subscriptions,
+	                                                    subscriptions_len,
+	                                                    error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_get_version_async (PkConnection        *connection,  /* IN */
+                                                GCancellable        *cancellable, /* IN */
+                                                GAsyncReadyCallback  callback,    /* IN */
+                                                gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_get_version_async);
+	pka_listener_manager_get_version_async(LISTENER(connection),
+	                                       cancellable,
+	                                       pk_connection_inproc_forward_cb,
+	                                       result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_get_version_finish (PkConnection  *connection, /* IN */
+                                                 GAsyncResult  *result,     /* IN */
+                                                 gchar        **version,    /* OUT */
+                                                 GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_get_version), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_get_version_finish(LISTENER(connection),
+	                                              INNER_RESULT(result),
+	                                              version,
+	                                              error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_ping_async (PkConnection        *connection,  /* IN */
+                                         GCancellable        *cancellable, /* IN */
+                                         GAsyncReadyCallback  callback,    /* IN */
+                                         gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_ping_async);
+	pka_listener_manager_ping_async(LISTENER(connection),
+	                                cancellable,
+	                                pk_connection_inproc_forward_cb,
+	                                result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_ping_finish (PkConnection  *connection, /* IN */
+                                          GAsyncResult  *result,     /* IN */
+                                          GTimeVal      *tv,         /* OUT */
+                                          GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_ping), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_ping_finish(LISTENER(connection),
+	                                       INNER_RESULT(result),
+	                                       tv,
+	                                       error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_remove_channel_async (PkConnection        *connection,  /* IN */
+                                                   gint                 channel,     /* IN */
+                                                   GCancellable        *cancellable, /* IN */
+                                                   GAsyncReadyCallback  callback,    /* IN */
+                                                   gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_remove_channel_async);
+	pka_listener_manager_remove_channel_async(LISTENER(connection),
+	                                          channel,
+	                                          cancellable,
+	                                          pk_connection_inproc_forward_cb,
+	                                          result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_remove_channel_finish (PkConnection  *connection, /* IN */
+                                                    GAsyncResult  *result,     /* IN */
+                                                    gboolean      *removed,    /* OUT */
+                                                    GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_remove_channel), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_remove_channel_finish(LISTENER(connection),
+	                                                 INNER_RESULT(result),
+	                                                 removed,
+	                                                 error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_remove_source_async (PkConnection        *connection,  /* IN */
+                                                  gint                 source,      /* IN */
+                                                  GCancellable        *cancellable, /* IN */
+                                                  GAsyncReadyCallback  callback,    /* IN */
+                                                  gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_remove_source_async);
+	pka_listener_manager_remove_source_async(LISTENER(connection),
+	                                         source,
+	                                         cancellable,
+	                                         pk_connection_inproc_forward_cb,
+	                                         result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_remove_source_finish (PkConnection  *connection, /* IN */
+                                                   GAsyncResult  *result,     /* IN */
+                                                   GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_remove_source), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_remove_source_finish(LISTENER(connection),
+	                                                INNER_RESULT(result),
+	                                                error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_manager_remove_subscription_async (PkConnection        *connection,   /* IN */
+                                                        gint                 subscription, /* IN */
+                                                        GCancellable        *cancellable,  /* IN */
+                                                        GAsyncReadyCallback  callback,     /* IN */
+                                                        gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_manager_remove_subscription_async);
+	pka_listener_manager_remove_subscription_async(LISTENER(connection),
+	                                               subscription,
+	                                               cancellable,
+	                                               pk_connection_inproc_forward_cb,
+	                                               result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_manager_remove_subscription_finish (PkConnection  *connection, /* IN */
+                                                         GAsyncResult  *result,     /* IN */
+                                                         gboolean      *removed,    /* OUT */
+                                                         GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(manager_remove_subscription), FALSE);
+
+	ENTRY;
+	ret = pka_listener_manager_remove_subscription_finish(LISTENER(connection),
+	                                                      INNER_RESULT(result),
+	                                                      removed,
+	                                                      error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_plugin_get_copyright_async (PkConnection        *connection,  /* IN */
+                                                 const gchar         *plugin,      /* IN */
+                                                 GCancellable        *cancellable, /* IN */
+                                                 GAsyncReadyCallback  callback,    /* IN */
+                                                 gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_plugin_get_copyright_async);
+	pka_listener_plugin_get_copyright_async(LISTENER(connection),
+	                                        plugin,
+	                                        cancellable,
+	                                        pk_connection_inproc_forward_cb,
+	                                        result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_plugin_get_copyright_finish (PkConnection  *connection, /* IN */
+                                                  GAsyncResult  *result,     /* IN */
+                                                  gchar        **copyright,  /* OUT */
+                                                  GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(plugin_get_copyright), FALSE);
+
+	ENTRY;
+	ret = pka_listener_plugin_get_copyright_finish(LISTENER(connection),
+	                                               INNER_RESULT(result),
+	                                               copyright,
+	                                               error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_plugin_get_description_async (PkConnection        *connection,  /* IN */
+                                                   const gchar         *plugin,      /* IN */
+                                                   GCancellable        *cancellable, /* IN */
+                                                   GAsyncReadyCallback  callback,    /* IN */
+                                                   gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_plugin_get_description_async);
+	pka_listener_plugin_get_description_async(LISTENER(connection),
+	                                          plugin,
+	                                          cancellable,
+	                                          pk_connection_inproc_forward_cb,
+	                                          result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_plugin_get_description_finish (PkConnection  *connection,  /* IN */
+                                                    GAsyncResult  *result,      /* IN */
+                                                    gchar        **description, /* OUT */
+                                                    GError       **error)       /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(plugin_get_description), FALSE);
+
+	ENTRY;
+	ret = pka_listener_plugin_get_description_finish(LISTENER(connection),
+	                                                 INNER_RESULT(result),
+	                                                 description,
+	                                                 error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_plugin_get_name_async (PkConnection        *connection,  /* IN */
+                                            const gchar         *plugin,      /* IN */
+                                            GCancellable        *cancellable, /* IN */
+                                            GAsyncReadyCallback  callback,    /* IN */
+                                            gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_plugin_get_name_async);
+	pka_listener_plugin_get_name_async(LISTENER(connection),
+	                                   plugin,
+	                                   cancellable,
+	                                   pk_connection_inproc_forward_cb,
+	                                   result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_plugin_get_name_finish (PkConnection  *connection, /* IN */
+                                             GAsyncResult  *result,     /* IN */
+                                             gchar        **name,       /* OUT */
+                                             GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(plugin_get_name), FALSE);
+
+	ENTRY;
+	ret = pka_listener_plugin_get_name_finish(LISTENER(connection),
+	                                          INNER_RESULT(result),
+	                                          name,
+	                                          error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_plugin_get_plugin_type_async (PkConnection        *connection,  /* IN */
+                                                   const gchar         *plugin,      /* IN */
+                                                   GCancellable        *cancellable, /* IN */
+                                                   GAsyncReadyCallback  callback,    /* IN */
+                                                   gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_plugin_get_plugin_type_async);
+	pka_listener_plugin_get_plugin_type_async(LISTENER(connection),
+	                                          plugin,
+	                                          cancellable,
+	                                          pk_connection_inproc_forward_cb,
+	                                          result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_plugin_get_plugin_type_finish (PkConnection  *connection, /* IN */
+                                                    GAsyncResult  *result,     /* IN */
+                                                    gint          *type,       /* OUT */
+                                                    GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(plugin_get_plugin_type), FALSE);
+
+	ENTRY;
+	ret = pka_listener_plugin_get_plugin_type_finish(LISTENER(connection),
+	                                                 INNER_RESULT(result),
+	                                                 type,
+	                                                 error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_plugin_get_version_async (PkConnection        *connection,  /* IN */
+                                               const gchar         *plugin,      /* IN */
+                                               GCancellable        *cancellable, /* IN */
+                                               GAsyncReadyCallback  callback,    /* IN */
+                                               gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_plugin_get_version_async);
+	pka_listener_plugin_get_version_async(LISTENER(connection),
+	                                      plugin,
+	                                      cancellable,
+	                                      pk_connection_inproc_forward_cb,
+	                                      result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_plugin_get_version_finish (PkConnection  *connection, /* IN */
+                                                GAsyncResult  *result,     /* IN */
+                                                gchar        **version,    /* OUT */
+                                                GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(plugin_get_version), FALSE);
+
+	ENTRY;
+	ret = pka_listener_plugin_get_version_finish(LISTENER(connection),
+	                                             INNER_RESULT(result),
+	                                             version,
+	                                             error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_source_get_plugin_async (PkConnection        *connection,  /* IN */
+                                              gint                 source,      /* IN */
+                                              GCancellable        *cancellable, /* IN */
+                                              GAsyncReadyCallback  callback,    /* IN */
+                                              gpointer             user_data)   /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_source_get_plugin_async);
+	pka_listener_source_get_plugin_async(LISTENER(connection),
+	                                     source,
+	                                     cancellable,
+	                                     pk_connection_inproc_forward_cb,
+	                                     result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_source_get_plugin_finish (PkConnection  *connection, /* IN */
+                                               GAsyncResult  *result,     /* IN */
+                                               gchar        **plugin,     /* OUT */
+                                               GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(source_get_plugin), FALSE);
+
+	ENTRY;
+	ret = pka_listener_source_get_plugin_finish(LISTENER(connection),
+	                                            INNER_RESULT(result),
+	                                            plugin,
+	                                            error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_add_channel_async (PkConnection        *connection,   /* IN */
+                                                     gint                 subscription, /* IN */
+                                                     gint                 channel,      /* IN */
+                                                     gboolean             monitor,      /* IN */
+                                                     GCancellable        *cancellable,  /* IN */
+                                                     GAsyncReadyCallback  callback,     /* IN */
+                                                     gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_add_channel_async);
+	pka_listener_subscription_add_channel_async(LISTENER(connection),
+	                                            subscription,
+	                                            channel,
+	                                            monitor,
+	                                            cancellable,
+	                                            pk_connection_inproc_forward_cb,
+	                                            result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_add_channel_finish (PkConnection  *connection, /* IN */
+                                                      GAsyncResult  *result,     /* IN */
+                                                      GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_add_channel), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_add_channel_finish(LISTENER(connection),
+	                                                   INNER_RESULT(result),
+	                                                   error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_add_source_async (PkConnection        *connection,   /* IN */
+                                                    gint                 subscription, /* IN */
+                                                    gint                 source,       /* IN */
+                                                    GCancellable        *cancellable,  /* IN */
+                                                    GAsyncReadyCallback  callback,     /* IN */
+                                                    gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_add_source_async);
+	pka_listener_subscription_add_source_async(LISTENER(connection),
+	                                           subscription,
+	                                           source,
+	                                           cancellable,
+	                                           pk_connection_inproc_forward_cb,
+	                                           result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_add_source_finish (PkConnection  *connection, /* IN */
+                                                     GAsyncResult  *result,     /* IN */
+                                                     GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_add_source), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_add_source_finish(LISTENER(connection),
+	                                                  INNER_RESULT(result),
+	                                                  error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_get_buffer_async (PkConnection        *connection,   /* IN */
+                                                    gint                 subscription, /* IN */
+                                                    GCancellable        *cancellable,  /* IN */
+                                                    GAsyncReadyCallback  callback,     /* IN */
+                                                    gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_get_buffer_async);
+	pka_listener_subscription_get_buffer_async(LISTENER(connection),
+	                                           subscription,
+	                                           cancellable,
+	                                           pk_connection_inproc_forward_cb,
+	                                           result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_get_buffer_finish (PkConnection  *connection, /* IN */
+                                                     GAsyncResult  *result,     /* IN */
+                                                     gint          *timeout,    /* OUT */
+                                                     gint          *size,       /* OUT */
+                                                     GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_get_buffer), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_get_buffer_finish(LISTENER(connection),
+	                                                  INNER_RESULT(result),
+	                                                  timeout,
+	                                                  size,
+	                                                  error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_get_created_at_async (PkConnection        *connection,   /* IN */
+                                                        gint                 subscription, /* IN */
+                                                        GCancellable        *cancellable,  /* IN */
+                                                        GAsyncReadyCallback  callback,     /* IN */
+                                                        gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_get_created_at_async);
+	pka_listener_subscription_get_created_at_async(LISTENER(connection),
+	                                               subscription,
+	                                               cancellable,
+	                                               pk_connection_inproc_forward_cb,
+	                                               result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_get_created_at_finish (PkConnection  *connection, /* IN */
+                                                         GAsyncResult  *result,     /* IN */
+                                                         GTimeVal      *tv,         /* OUT */
+                                                         GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_get_created_at), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_get_created_at_finish(LISTENER(connection),
+	                                                      INNER_RESULT(result),
+	                                                      tv,
+	                                                      error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_get_sources_async (PkConnection        *connection,   /* IN */
+                                                     gint                 subscription, /* IN */
+                                                     GCancellable        *cancellable,  /* IN */
+                                                     GAsyncReadyCallback  callback,     /* IN */
+                                                     gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_get_sources_async);
+	pka_listener_subscription_get_sources_async(LISTENER(connection),
+	                                            subscription,
+	                                            cancellable,
+	                                            pk_connection_inproc_forward_cb,
+	                                            result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_get_sources_finish (PkConnection  *connection,  /* IN */
+                                                      GAsyncResult  *result,      /* IN */
+                                                      gint         **sources,     /* OUT */
+                                                      gsize         *sources_len, /* OUT */
+                                                      GError       **error)       /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_get_sources), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_get_sources_finish(LISTENER(connection),
+	                                                   INNER_RESULT(result),
+	                                                   sources,
+	                                                   sources_len,
+	                                                   error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_mute_async (PkConnection        *connection,   /* IN */
+                                              gint                 subscription, /* IN */
+                                              gboolean             drain,        /* IN */
+                                              GCancellable        *cancellable,  /* IN */
+                                              GAsyncReadyCallback  callback,     /* IN */
+                                              gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_mute_async);
+	pka_listener_subscription_mute_async(LISTENER(connection),
+	                                     subscription,
+	                                     drain,
+	                                     cancellable,
+	                                     pk_connection_inproc_forward_cb,
+	                                     result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_mute_finish (PkConnection  *connection, /* IN */
+                                               GAsyncResult  *result,     /* IN */
+                                               GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_mute), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_mute_finish(LISTENER(connection),
+	                                            INNER_RESULT(result),
+	                                            error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_remove_channel_async (PkConnection        *connection,   /* IN */
+                                                        gint                 subscription, /* IN */
+                                                        gint                 channel,      /* IN */
+                                                        GCancellable        *cancellable,  /* IN */
+                                                        GAsyncReadyCallback  callback,     /* IN */
+                                                        gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_remove_channel_async);
+	pka_listener_subscription_remove_channel_async(LISTENER(connection),
+	                                               subscription,
+	                                               channel,
+	                                               cancellable,
+	                                               pk_connection_inproc_forward_cb,
+	                                               result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_remove_channel_finish (PkConnection  *connection, /* IN */
+                                                         GAsyncResult  *result,     /* IN */
+                                                         GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_remove_channel), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_remove_channel_finish(LISTENER(connection),
+	                                                      INNER_RESULT(result),
+	                                                      error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_remove_source_async (PkConnection        *connection,   /* IN */
+                                                       gint                 subscription, /* IN */
+                                                       gint                 source,       /* IN */
+                                                       GCancellable        *cancellable,  /* IN */
+                                                       GAsyncReadyCallback  callback,     /* IN */
+                                                       gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_remove_source_async);
+	pka_listener_subscription_remove_source_async(LISTENER(connection),
+	                                              subscription,
+	                                              source,
+	                                              cancellable,
+	                                              pk_connection_inproc_forward_cb,
+	                                              result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_remove_source_finish (PkConnection  *connection, /* IN */
+                                                        GAsyncResult  *result,     /* IN */
+                                                        GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_remove_source), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_remove_source_finish(LISTENER(connection),
+	                                                     INNER_RESULT(result),
+	                                                     error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_set_buffer_async (PkConnection        *connection,   /* IN */
+                                                    gint                 subscription, /* IN */
+                                                    gint                 timeout,      /* IN */
+                                                    gint                 size,         /* IN */
+                                                    GCancellable        *cancellable,  /* IN */
+                                                    GAsyncReadyCallback  callback,     /* IN */
+                                                    gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_set_buffer_async);
+	pka_listener_subscription_set_buffer_async(LISTENER(connection),
+	                                           subscription,
+	                                           timeout,
+	                                           size,
+	                                           cancellable,
+	                                           pk_connection_inproc_forward_cb,
+	                                           result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_set_buffer_finish (PkConnection  *connection, /* IN */
+                                                     GAsyncResult  *result,     /* IN */
+                                                     GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_set_buffer), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_set_buffer_finish(LISTENER(connection),
+	                                                  INNER_RESULT(result),
+	                                                  error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_set_encoder_async (PkConnection        *connection,   /* IN */
+                                                     gint                 subscription, /* IN */
+                                                     gint                 encoder,      /* IN */
+                                                     GCancellable        *cancellable,  /* IN */
+                                                     GAsyncReadyCallback  callback,     /* IN */
+                                                     gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_set_encoder_async);
+	pka_listener_subscription_set_encoder_async(LISTENER(connection),
+	                                            subscription,
+	                                            encoder,
+	                                            cancellable,
+	                                            pk_connection_inproc_forward_cb,
+	                                            result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_set_encoder_finish (PkConnection  *connection, /* IN */
+                                                      GAsyncResult  *result,     /* IN */
+                                                      GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_set_encoder), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_set_encoder_finish(LISTENER(connection),
+	                                                   INNER_RESULT(result),
+	                                                   error);
+	RETURN(ret);
+}
+
+
+static void
+pk_connection_inproc_subscription_unmute_async (PkConnection        *connection,   /* IN */
+                                                gint                 subscription, /* IN */
+                                                GCancellable        *cancellable,  /* IN */
+                                                GAsyncReadyCallback  callback,     /* IN */
+                                                gpointer             user_data)    /* IN */
+{
+	GSimpleAsyncResult *result;
+
+	g_return_if_fail(PK_IS_CONNECTION_INPROC(connection));
+
+	ENTRY;
+	result = g_simple_async_result_new(
+			G_OBJECT(connection), callback, user_data,
+			pk_connection_inproc_subscription_unmute_async);
+	pka_listener_subscription_unmute_async(LISTENER(connection),
+	                                       subscription,
+	                                       cancellable,
+	                                       pk_connection_inproc_forward_cb,
+	                                       result);
+	EXIT;
+}
+
+
+static gboolean
+pk_connection_inproc_subscription_unmute_finish (PkConnection  *connection, /* IN */
+                                                 GAsyncResult  *result,     /* IN */
+                                                 GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION_INPROC(connection), FALSE);
+	g_return_val_if_fail(RESULT_IS_VALID(subscription_unmute), FALSE);
+
+	ENTRY;
+	ret = pka_listener_subscription_unmute_finish(LISTENER(connection),
+	                                              INNER_RESULT(result),
+	                                              error);
+	RETURN(ret);
+}
+
+
+/**
+ * pk_connection_inproc_is_local:
+ * @connection: A #PkConnectionInproc.
+ *
+ * Determines if the connection is to the local host.  The agent runs
+ * within this process, so this is always the case.
+ *
+ * Returns: %TRUE always.
+ * Side effects: None.
+ */
+static gboolean
+pk_connection_inproc_is_local (PkConnection *connection) /* IN */
+{
+	return TRUE;
+}
+
+/**
+ * pk_connection_inproc_finalize:
+ * @object: A #PkConnectionInproc.
+ *
+ * Finalizer for a #PkConnectionInproc instance.  Frees any resources held
+ * by the instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_finalize (GObject *object) /* IN */
+{
+	PkConnectionInprocPrivate *priv;
+
+	priv = PK_CONNECTION_INPROC(object)->priv;
+
+	if (priv->connected) {
+		pka_manager_remove_listener(PKA_LISTENER(priv->listener));
+	}
+	priv->listener->connection = NULL;
+	g_object_unref(priv->listener);
+	g_mutex_free(priv->mutex);
+
+	G_OBJECT_CLASS(pk_connection_inproc_parent_class)->finalize(object);
+}
+
+/**
+ * pk_connection_inproc_class_init:
+ * @klass: A #PkConnectionInprocClass.
+ *
+ * Initializes the vtable for the #PkConnectionClass.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_class_init (PkConnectionInprocClass *klass) /* IN */
+{
+	GObjectClass *object_class;
+	PkConnectionClass *connection_class;
+
+	object_class = G_OBJECT_CLASS(klass);
+	connection_class = PK_CONNECTION_CLASS(klass);
+
+	object_class->finalize = pk_connection_inproc_finalize;
+	g_type_class_add_private(object_class, sizeof(PkConnectionInprocPrivate));
+
+	connection_class->is_local = pk_connection_inproc_is_local;
+
+	#define OVERRIDE_VTABLE(_n) G_STMT_START {                                  \
+            connection_class->_n##_async = pk_connection_inproc_##_n##_async;   \
+            connection_class->_n##_finish = pk_connection_inproc_##_n##_finish; \
+        } G_STMT_END
+	OVERRIDE_VTABLE(channel_add_source);
+	OVERRIDE_VTABLE(channel_get_args);
+	OVERRIDE_VTABLE(channel_get_created_at);
+	OVERRIDE_VTABLE(channel_get_env);
+	OVERRIDE_VTABLE(channel_get_exit_status);
+	OVERRIDE_VTABLE(channel_get_kill_pid);
+	OVERRIDE_VTABLE(channel_get_pid);
+	OVERRIDE_VTABLE(channel_get_pid_set);
+	OVERRIDE_VTABLE(channel_get_sources);
+	OVERRIDE_VTABLE(channel_get_state);
+	OVERRIDE_VTABLE(channel_get_target);
+	OVERRIDE_VTABLE(channel_get_working_dir);
+	OVERRIDE_VTABLE(channel_mute);
+	OVERRIDE_VTABLE(channel_set_args);
+	OVERRIDE_VTABLE(channel_set_env);
+	OVERRIDE_VTABLE(channel_set_kill_pid);
+	OVERRIDE_VTABLE(channel_set_pid);
+	OVERRIDE_VTABLE(channel_set_target);
+	OVERRIDE_VTABLE(channel_set_working_dir);
+	OVERRIDE_VTABLE(channel_start);
+	OVERRIDE_VTABLE(channel_stop);
+	OVERRIDE_VTABLE(channel_unmute);
+	OVERRIDE_VTABLE(connect);
+	OVERRIDE_VTABLE(disconnect);
+	OVERRIDE_VTABLE(encoder_get_plugin);
+	OVERRIDE_VTABLE(manager_add_channel);
+	OVERRIDE_VTABLE(manager_add_source);
+	OVERRIDE_VTABLE(manager_add_subscription);
+	OVERRIDE_VTABLE(manager_get_channels);
+	OVERRIDE_VTABLE(manager_get_hostname);
+	OVERRIDE_VTABLE(manager_get_plugins);
+	OVERRIDE_VTABLE(manager_get_snapshot);
+	OVERRIDE_VTABLE(manager_get_sources);
+	OVERRIDE_VTABLE(manager_get_subscriptions);
+	OVERRIDE_VTABLE(manager_get_version);
+	OVERRIDE_VTABLE(manager_ping);
+	OVERRIDE_VTABLE(manager_remove_channel);
+	OVERRIDE_VTABLE(manager_remove_source);
+	OVERRIDE_VTABLE(manager_remove_subscription);
+	OVERRIDE_VTABLE(plugin_get_copyright);
+	OVERRIDE_VTABLE(plugin_get_description);
+	OVERRIDE_VTABLE(plugin_get_name);
+	OVERRIDE_VTABLE(plugin_get_plugin_type);
+	OVERRIDE_VTABLE(plugin_get_version);
+	OVERRIDE_VTABLE(source_get_plugin);
+	OVERRIDE_VTABLE(subscription_add_channel);
+	OVERRIDE_VTABLE(subscription_add_source);
+	OVERRIDE_VTABLE(subscription_get_buffer);
+	OVERRIDE_VTABLE(subscription_get_created_at);
+	OVERRIDE_VTABLE(subscription_get_sources);
+	OVERRIDE_VTABLE(subscription_mute);
+	OVERRIDE_VTABLE(subscription_remove_channel);
+	OVERRIDE_VTABLE(subscription_remove_source);
+	OVERRIDE_VTABLE(subscription_set_batch_handlers);
+	OVERRIDE_VTABLE(subscription_set_buffer);
+	OVERRIDE_VTABLE(subscription_set_encoder);
+	OVERRIDE_VTABLE(subscription_set_handlers);
+	OVERRIDE_VTABLE(subscription_unmute);
+	#undef OVERRIDE_VTABLE
+}
+
+/**
+ * pk_connection_inproc_init:
+ * @inproc: A #PkConnectionInproc.
+ *
+ * Initializes a new instance of #PkConnectionInproc.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_inproc_init (PkConnectionInproc *inproc) /* IN */
+{
+	inproc->priv = G_TYPE_INSTANCE_GET_PRIVATE(inproc,
+	                                           PK_TYPE_CONNECTION_INPROC,
+	                                           PkConnectionInprocPrivate);
+	inproc->priv->mutex = g_mutex_new();
+	inproc->priv->listener =
+		g_object_new(PK_TYPE_CONNECTION_INPROC_LISTENER, NULL);
+	inproc->priv->listener->connection = PK_CONNECTION(inproc);
+}
+
+/**
+ * pk_connection_inproc_error_quark:
+ *
+ * Retrieves the #GQuark representing the #PkConnectionInproc error domain.
+ *
+ * Returns: A #GQuark.
+ * Side effects: The error quark may be registered.
+ */
+GQuark
+pk_connection_inproc_error_quark (void)
+{
+	return g_quark_from_string("pk-connection-inproc-error-quark");
+}
+
+/**
+ * pk_connection_register:
+ *
+ * Module entry point.  Retrieves the #GType for the PkConnectionInproc class.
+ *
+ * Returns: A #GType.
+ * Side effects: None.
+ */
+G_MODULE_EXPORT GType
+pk_connection_register (void)
+{
+	return PK_TYPE_CONNECTION_INPROC;
+}
@@ -0,0 +1,69 @@
+/* pk-connection-inproc.h
+ *
+ * Copyright 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PK_CONNECTION_INPROC_H__
+#define __PK_CONNECTION_INPROC_H__
+
+#include <perfkit/perfkit.h>
+
+G_BEGIN_DECLS
+
+#define PK_TYPE_CONNECTION_INPROC            (pk_connection_inproc_get_type())
+#define PK_CONNECTION_INPROC(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), PK_TYPE_CONNECTION_INPROC, PkConnectionInproc))
+#define PK_CONNECTION_INPROC_CONST(obj)      (G_TYPE_CHECK_INSTANCE_CAST ((obj), PK_TYPE_CONNECTION_INPROC, PkConnectionInproc const))
+#define PK_CONNECTION_INPROC_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  PK_TYPE_CONNECTION_INPROC, PkConnectionInprocClass))
+#define PK_IS_CONNECTION_INPROC(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), PK_TYPE_CONNECTION_INPROC))
+#define PK_IS_CONNECTION_INPROC_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  PK_TYPE_CONNECTION_INPROC))
+#define PK_CONNECTION_INPROC_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  PK_TYPE_CONNECTION_INPROC, PkConnectionInprocClass))
+#define PK_CONNECTION_INPROC_ERROR           (pk_connection_inproc_error_quark())
+
+typedef struct _PkConnectionInproc        PkConnectionInproc;
+typedef struct _PkConnectionInprocClass   PkConnectionInprocClass;
+typedef struct _PkConnectionInprocPrivate PkConnectionInprocPrivate;
+
+/**
+ * PkConnectionInprocError:
+ * @PK_CONNECTION_INPROC_ERROR_STATE:
+ *
+ * The #PkConnectionInproc error enumeration.
+ */
+typedef enum
+{
+	PK_CONNECTION_INPROC_ERROR_STATE,
+	PK_CONNECTION_INPROC_ERROR_INVALID_DATA,
+} PkConnectionInprocError;
+
+struct _PkConnectionInproc
+{
+	PkConnection parent;
+
+	/*< private >*/
+	PkConnectionInprocPrivate *priv;
+};
+
+struct _PkConnectionInprocClass
+{
+	PkConnectionClass parent_class;
+};
+
+GType         pk_connection_inproc_get_type    (void) G_GNUC_CONST;
+GQuark        pk_connection_inproc_error_quark (void);
+
+G_END_DECLS
+
+#endif /* __PK_CONNECTION_INPROC_H__ */
@@ -25,8 +25,12 @@
 #include "pk-connection-lowlevel.h"
 #include "pk-manifest.h"
 #include "pk-model.h"
+#include "pk-model-columnar.h"
+#include "pk-model-compressed.h"
+#include "pk-model-mapped.h"
 #include "pk-model-memory.h"
 #include "pk-sample.h"
+#include "pk-sketch.h"
 #include "pk-version.h"
 
 typedef enum
@@ -392,6 +392,19 @@ gboolean      pk_connection_manager_get_plugins_finish        (PkConnection
                                                                GAsyncResult          *result,
                                                                gchar               ***plugins,
                                                                GError               **error);
+gboolean      pk_connection_manager_get_snapshot              (PkConnection          *connection,
+                                                               guint8               **snapshot,
+                                                               gsize                 *snapshot_len,
+                                                               GError               **error);
+void          pk_connection_manager_get_snapshot_async        (PkConnection          *connection,
+                                                               GCancellable          *cancellable,
+                                                               GAsyncReadyCallback    callback,
+                                                               gpointer               user_data);
+gboolean      pk_connection_manager_get_snapshot_finish       (PkConnection          *connection,
+                                                               GAsyncResult          *result,
+                                                               guint8               **snapshot,
+                                                               gsize                 *snapshot_len,
+                                                               GError               **error);
 gboolean      pk_connection_manager_get_sources               (PkConnection          *connection,
                                                                gint                 **sources,
                                                                gsize                 *sources_len,
@@ -693,6 +706,20 @@ void          pk_connection_subscription_set_encoder_async    (PkConnection
 gboolean      pk_connection_subscription_set_encoder_finish   (PkConnection          *connection,
                                                                GAsyncResult          *result,
                                                                GError               **error);
+void          pk_connection_subscription_set_batch_handlers_async  (PkConnection          *connection,
+                                                                    gint                   subscription,
+                                                                    PkManifestFunc         manifest_func,
+                                                                    gpointer               manifest_data,
+                                                                    GDestroyNotify         manifest_destroy,
+                                                                    PkSamplesFunc          samples_func,
+                                                                    gpointer               samples_data,
+                                                                    GDestroyNotify         samples_destroy,
+                                                                    GCancellable          *cancellable,
+                                                                    GAsyncReadyCallback    callback,
+                                                                    gpointer               user_data);
+gboolean      pk_connection_subscription_set_batch_handlers_finish (PkConnection          *connection,
+                                                                    GAsyncResult          *result,
+                                                                    GError               **error);
 void          pk_connection_subscription_set_handlers_async   (PkConnection          *connection,
                                                                gint                   subscription,
                                                                PkManifestFunc         manifest_func,
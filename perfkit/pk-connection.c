@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <egg-buffer.h>
 #include <gmodule.h>
 #include <stdio.h>
 #include <string.h>
@@ -76,11 +77,45 @@ G_DEFINE_TYPE(PkConnection, pk_connection, G_TYPE_OBJECT)
 
 struct _PkConnectionPrivate
 {
-	GStaticRWLock      rw_lock; /* Synchronization */
-	gchar             *uri;     /* Connection path/uri */
-	PkConnectionState  state;   /* Current connection state */
+	GStaticRWLock      rw_lock;       /* Synchronization */
+	gchar             *uri;           /* Connection path/uri */
+	PkConnectionState  state;         /* Current connection state */
+	GHashTable        *shared;        /* Key -> PkSharedSubscription */
+	GHashTable        *consumers;     /* Consumer id -> PkConsumer */
+	gint               last_consumer; /* Consumer id sequence */
+	GHashTable        *sources;       /* Plugin -> PkSharedSource */
 };
 
+typedef struct
+{
+	gint   ref_count; /* Number of consumers, protected by rw_lock */
+	gchar *plugin;    /* Registry key */
+	gint   channel;   /* Agent channel id */
+	gint   source;    /* Agent source id */
+} PkSharedSource;
+
+typedef struct
+{
+	volatile gint  ref_count;
+	PkConnection  *connection;   /* Owning connection, not referenced */
+	gchar         *key;          /* Registry key */
+	gint           subscription; /* Agent subscription id */
+	GPtrArray     *consumers;    /* Array of PkConsumer */
+	GHashTable    *manifests;    /* Source id -> latest PkManifest */
+} PkSharedSubscription;
+
+typedef struct
+{
+	volatile gint         ref_count;
+	volatile gint         released;  /* Set once released by its owner */
+	gint                  id;
+	PkSharedSubscription *shared;
+	PkManifestFunc        manifest_func;
+	PkSamplesFunc         samples_func;
+	gpointer              user_data;
+	GDestroyNotify        notify;
+} PkConsumer;
+
 typedef struct
 {
 	GMutex     *mutex;
@@ -3963,6 +3998,145 @@ pk_connection_manager_get_plugins_finish (PkConnection   *connection, /* IN */
 	RETURN(ret);
 }
 
+/**
+ * pk_connection_manager_get_snapshot_cb:
+ * @source: A #PkConnection.
+ * @result: A #GAsyncResult.
+ * @user_data: A #GAsyncResult.
+ *
+ * Callback to notify a synchronous call to the "manager_get_snapshot" RPC that it
+ * has completed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_manager_get_snapshot_cb (GObject      *source,    /* IN */
+                                       GAsyncResult *result,    /* IN */
+                                       gpointer      user_data) /* IN */
+{
+	PkConnectionSync *async = user_data;
+
+	g_return_if_fail(PK_IS_CONNECTION(source));
+	g_return_if_fail(async != NULL);
+
+	ENTRY;
+	async->result = pk_connection_manager_get_snapshot_finish(PK_CONNECTION(source),
+	                                                         result,
+	                                                         async->params[0],
+	                                                         async->params[1],
+	                                                         async->error);
+	pk_connection_sync_signal(async);
+	EXIT;
+}
+
+/**
+ * pk_connection_manager_get_snapshot:
+ * @connection: A #PkConnection.
+ * @snapshot: (out) (transfer full): A location for the encoded snapshot.
+ * @snapshot_len: (out): A location for the length of @snapshot.
+ * @error: (out): A location for a #GError or %NULL.
+ *
+ * Synchronous implemenation of the "manager_get_snapshot" RPC.  Using
+ * synchronous RPCs is generally frowned upon.
+ *
+ * Retrieves the manifest and most recent sample of every source within
+ * the agent in a single call.  Use pk_connection_parse_snapshot() to
+ * decode the result.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+gboolean
+pk_connection_manager_get_snapshot (PkConnection  *connection,   /* IN */
+                                    guint8       **snapshot,     /* OUT */
+                                    gsize         *snapshot_len, /* OUT */
+                                    GError       **error)        /* OUT */
+{
+	PkConnectionSync async;
+
+	g_return_val_if_fail(PK_IS_CONNECTION(connection), FALSE);
+
+	ENTRY;
+	CHECK_FOR_RPC(manager_get_snapshot);
+	pk_connection_sync_init(&async);
+	async.error = error;
+	async.params[0] = snapshot;
+	async.params[1] = snapshot_len;
+	pk_connection_manager_get_snapshot_async(connection,
+	                                         NULL,
+	                                         pk_connection_manager_get_snapshot_cb,
+	                                         &async);
+	pk_connection_sync_wait(&async);
+	pk_connection_sync_destroy(&async);
+	RETURN(async.result);
+}
+
+/**
+ * pk_connection_manager_get_snapshot_async:
+ * @connection: A #PkConnection.
+ *
+ * Asynchronous implementation of the "manager_get_snapshot_async" RPC.
+ *
+ * Retrieves the manifest and most recent sample of every source within
+ * the agent in a single call.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_connection_manager_get_snapshot_async (PkConnection        *connection,  /* IN */
+                                          GCancellable        *cancellable, /* IN */
+                                          GAsyncReadyCallback  callback,    /* IN */
+                                          gpointer             user_data)   /* IN */
+{
+	g_return_if_fail(PK_IS_CONNECTION(connection));
+	g_return_if_fail(callback != NULL);
+
+	ENTRY;
+	RPC_ASYNC(manager_get_snapshot)(connection,
+	                                cancellable,
+	                                callback,
+	                                user_data);
+	EXIT;
+}
+
+/**
+ * pk_connection_manager_get_snapshot_finish:
+ * @connection: A #PkConnection.
+ * @result: A #GAsyncResult.
+ * @snapshot: (out) (transfer full): A location for the encoded snapshot.
+ * @snapshot_len: (out): A location for the length of @snapshot.
+ * @error: (out): A location for a #GError or %NULL.
+ *
+ * Completion of an asynchronous call to the "manager_get_snapshot_finish" RPC.
+ *
+ * Retrieves the manifest and most recent sample of every source within
+ * the agent in a single call.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+gboolean
+pk_connection_manager_get_snapshot_finish (PkConnection  *connection,   /* IN */
+                                           GAsyncResult  *result,       /* IN */
+                                           guint8       **snapshot,     /* OUT */
+                                           gsize         *snapshot_len, /* OUT */
+                                           GError       **error)        /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION(connection), FALSE);
+
+	ENTRY;
+	RPC_FINISH(ret, manager_get_snapshot)(connection,
+	                                      result,
+	                                      snapshot,
+	                                      snapshot_len,
+	                                      error);
+	RETURN(ret);
+}
+
 /**
  * pk_connection_manager_get_sources_cb:
  * @source: A #PkConnection.
@@ -7090,6 +7264,76 @@ pk_connection_subscription_set_handlers_finish (PkConnection  *connection, /* IN
 	RETURN(ret);
 }
 
+/**
+ * pk_connection_subscription_set_batch_handlers_async:
+ * @connection: A #PkConnection.
+ *
+ * Asynchronously requests the "subscription_set_batch_handlers" RPC.
+ *
+ * Like pk_connection_subscription_set_handlers_async() except that
+ * @samples_func receives every sample decoded from an incoming buffer
+ * that shares a manifest in a single call, instead of once per sample.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_connection_subscription_set_batch_handlers_async (PkConnection        *connection,       /* IN */
+                                                     gint                 subscription,     /* IN */
+                                                     PkManifestFunc       manifest_func,    /* IN */
+                                                     gpointer             manifest_data,    /* IN */
+                                                     GDestroyNotify       manifest_destroy, /* IN */
+                                                     PkSamplesFunc        samples_func,     /* IN */
+                                                     gpointer             samples_data,     /* IN */
+                                                     GDestroyNotify       samples_destroy,  /* IN */
+                                                     GCancellable        *cancellable,      /* IN */
+                                                     GAsyncReadyCallback  callback,         /* IN */
+                                                     gpointer             user_data)        /* IN */
+{
+	g_return_if_fail(PK_IS_CONNECTION(connection));
+	g_return_if_fail(callback != NULL);
+	g_return_if_fail(manifest_func != NULL);
+	g_return_if_fail(samples_func != NULL);
+
+	ENTRY;
+	RPC_ASYNC(subscription_set_batch_handlers)(connection,
+	                                           subscription,
+	                                           manifest_func,
+	                                           manifest_data,
+	                                           manifest_destroy,
+	                                           samples_func,
+	                                           samples_data,
+	                                           samples_destroy,
+	                                           cancellable,
+	                                           callback,
+	                                           user_data);
+	EXIT;
+}
+
+/**
+ * pk_connection_subscription_set_batch_handlers_finish:
+ * @connection: A #PkConnection.
+ *
+ * Completes an asynchronous request to the "subscription_set_batch_handlers"
+ * RPC.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+gboolean
+pk_connection_subscription_set_batch_handlers_finish (PkConnection  *connection, /* IN */
+                                                      GAsyncResult  *result,     /* IN */
+                                                      GError       **error)      /* OUT */
+{
+	gboolean ret;
+
+	g_return_val_if_fail(PK_IS_CONNECTION(connection), FALSE);
+
+	ENTRY;
+	RPC_FINISH(ret, subscription_set_batch_handlers)(connection, result, error);
+	RETURN(ret);
+}
+
 /**
  * pk_connection_subscription_unmute_cb:
  * @source: A #PkConnection.
@@ -7447,6 +7691,748 @@ pk_connection_get_uri (PkConnection *connection) /* IN */
 	return connection->priv->uri;
 }
 
+/**
+ * pk_connection_compare_int:
+ * @a: A pointer to a #gint.
+ * @b: A pointer to a #gint.
+ *
+ * Compares two integers for use with g_array_sort().
+ *
+ * Returns: Less than, equal to, or greater than zero.
+ * Side effects: None.
+ */
+static gint
+pk_connection_compare_int (gconstpointer a, /* IN */
+                           gconstpointer b) /* IN */
+{
+	return *(const gint *)a - *(const gint *)b;
+}
+
+/**
+ * pk_connection_shared_ref:
+ * @shared: A #PkSharedSubscription.
+ *
+ * Increments the reference count of @shared.
+ *
+ * Returns: @shared.
+ * Side effects: None.
+ */
+static PkSharedSubscription*
+pk_connection_shared_ref (PkSharedSubscription *shared) /* IN */
+{
+	g_return_val_if_fail(shared != NULL, NULL);
+	g_return_val_if_fail(shared->ref_count > 0, NULL);
+
+	g_atomic_int_inc(&shared->ref_count);
+	return shared;
+}
+
+/**
+ * pk_connection_shared_unref:
+ * @shared: A #PkSharedSubscription.
+ *
+ * Decrements the reference count of @shared and frees it when the
+ * count reaches zero.
+ *
+ * Returns: None.
+ * Side effects: @shared may be freed.
+ */
+static void
+pk_connection_shared_unref (gpointer data) /* IN */
+{
+	PkSharedSubscription *shared = data;
+
+	g_return_if_fail(shared != NULL);
+	g_return_if_fail(shared->ref_count > 0);
+
+	if (g_atomic_int_dec_and_test(&shared->ref_count)) {
+		g_free(shared->key);
+		g_ptr_array_unref(shared->consumers);
+		g_hash_table_destroy(shared->manifests);
+		g_slice_free(PkSharedSubscription, shared);
+	}
+}
+
+/**
+ * pk_connection_consumer_unref:
+ * @consumer: A #PkConsumer.
+ *
+ * Decrements the reference count of @consumer. When the count reaches
+ * zero the consumer's notify function is called and it is freed.
+ *
+ * Returns: None.
+ * Side effects: @consumer may be freed.
+ */
+static void
+pk_connection_consumer_unref (gpointer data) /* IN */
+{
+	PkConsumer *consumer = data;
+
+	g_return_if_fail(consumer != NULL);
+	g_return_if_fail(consumer->ref_count > 0);
+
+	if (g_atomic_int_dec_and_test(&consumer->ref_count)) {
+		if (consumer->notify) {
+			consumer->notify(consumer->user_data);
+		}
+		g_slice_free(PkConsumer, consumer);
+	}
+}
+
+/**
+ * pk_connection_shared_get_consumers:
+ * @shared: A #PkSharedSubscription.
+ *
+ * Copies the current consumers of @shared so that they may be called
+ * without holding the lock. Each consumer is referenced so that it, and
+ * its user data, stay alive even if it is released during the dispatch.
+ *
+ * Returns: A #GPtrArray which should be freed with g_ptr_array_unref().
+ * Side effects: None.
+ */
+static GPtrArray*
+pk_connection_shared_get_consumers (PkSharedSubscription *shared) /* IN */
+{
+	PkConnectionPrivate *priv = shared->connection->priv;
+	PkConsumer *consumer;
+	GPtrArray *consumers;
+	gint i;
+
+	g_static_rw_lock_reader_lock(&priv->rw_lock);
+	consumers = g_ptr_array_new_with_free_func(pk_connection_consumer_unref);
+	for (i = 0; i < shared->consumers->len; i++) {
+		consumer = g_ptr_array_index(shared->consumers, i);
+		g_atomic_int_inc(&consumer->ref_count);
+		g_ptr_array_add(consumers, consumer);
+	}
+	g_static_rw_lock_reader_unlock(&priv->rw_lock);
+	return consumers;
+}
+
+/**
+ * pk_connection_shared_manifest_cb:
+ * @manifest: A #PkManifest.
+ * @user_data: A #PkSharedSubscription.
+ *
+ * Handles a manifest arriving on a shared subscription. The manifest is
+ * cached so that consumers joining later can be brought up to date, and
+ * then handed to every current consumer.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_shared_manifest_cb (PkManifest *manifest,  /* IN */
+                                  gpointer    user_data) /* IN */
+{
+	PkSharedSubscription *shared = user_data;
+	PkConnectionPrivate *priv = shared->connection->priv;
+	PkConsumer *consumer;
+	GPtrArray *consumers;
+	gint i;
+
+	g_static_rw_lock_writer_lock(&priv->rw_lock);
+	g_hash_table_replace(shared->manifests,
+	                     GINT_TO_POINTER(pk_manifest_get_source_id(manifest)),
+	                     pk_manifest_ref(manifest));
+	g_static_rw_lock_writer_unlock(&priv->rw_lock);
+
+	consumers = pk_connection_shared_get_consumers(shared);
+	for (i = 0; i < consumers->len; i++) {
+		consumer = g_ptr_array_index(consumers, i);
+		if (consumer->manifest_func && !g_atomic_int_get(&consumer->released)) {
+			consumer->manifest_func(manifest, consumer->user_data);
+		}
+	}
+	g_ptr_array_unref(consumers);
+}
+
+/**
+ * pk_connection_shared_samples_cb:
+ * @manifest: A #PkManifest.
+ * @samples: An array of #PkSample.
+ * @n_samples: The number of samples in @samples.
+ * @user_data: A #PkSharedSubscription.
+ *
+ * Handles a batch of samples arriving on a shared subscription. The
+ * samples are decoded once by the connection and the same batch is
+ * handed to every consumer.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_shared_samples_cb (PkManifest  *manifest,  /* IN */
+                                 PkSample   **samples,   /* IN */
+                                 guint        n_samples, /* IN */
+                                 gpointer     user_data) /* IN */
+{
+	PkSharedSubscription *shared = user_data;
+	PkConsumer *consumer;
+	GPtrArray *consumers;
+	gint i;
+
+	consumers = pk_connection_shared_get_consumers(shared);
+	for (i = 0; i < consumers->len; i++) {
+		consumer = g_ptr_array_index(consumers, i);
+		if (consumer->samples_func && !g_atomic_int_get(&consumer->released)) {
+			consumer->samples_func(manifest, samples, n_samples,
+			                       consumer->user_data);
+		}
+	}
+	g_ptr_array_unref(consumers);
+}
+
+/**
+ * pk_connection_shared_set_handlers_cb:
+ * @object: A #PkConnection.
+ * @result: A #GAsyncResult.
+ * @user_data: None.
+ *
+ * Completes installing the handlers for a shared subscription.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_shared_set_handlers_cb (GObject      *object,    /* IN */
+                                      GAsyncResult *result,    /* IN */
+                                      gpointer      user_data) /* IN */
+{
+	GError *error = NULL;
+
+	if (!pk_connection_subscription_set_batch_handlers_finish(
+			PK_CONNECTION(object), result, &error)) {
+		g_warning("Failed to set shared subscription handlers: %s",
+		          error->message);
+		g_error_free(error);
+	}
+}
+
+/**
+ * pk_connection_shared_build_key:
+ * @sources: An array of source identifiers.
+ * @n_sources: The length of @sources.
+ * @encoder: The encoder identifier or 0.
+ * @buffer_size: The subscription buffer size.
+ * @buffer_timeout: The subscription buffer timeout.
+ *
+ * Builds the key used to find an existing shared subscription. Sources
+ * are sorted so that the order they were requested in does not matter.
+ *
+ * Returns: A newly allocated string which should be freed with g_free().
+ * Side effects: None.
+ */
+static gchar*
+pk_connection_shared_build_key (const gint *sources,        /* IN */
+                                guint       n_sources,      /* IN */
+                                gint        encoder,        /* IN */
+                                gsize       buffer_size,    /* IN */
+                                gsize       buffer_timeout) /* IN */
+{
+	GString *str;
+	GArray *sorted;
+	gint i;
+
+	sorted = g_array_sized_new(FALSE, FALSE, sizeof(gint), n_sources);
+	g_array_append_vals(sorted, sources, n_sources);
+	g_array_sort(sorted, pk_connection_compare_int);
+	str = g_string_new(NULL);
+	g_string_append_printf(str, "%d:%"G_GSIZE_FORMAT":%"G_GSIZE_FORMAT":",
+	                       encoder, buffer_size, buffer_timeout);
+	for (i = 0; i < sorted->len; i++) {
+		g_string_append_printf(str, "%d,", g_array_index(sorted, gint, i));
+	}
+	g_array_unref(sorted);
+	return g_string_free(str, FALSE);
+}
+
+/**
+ * pk_connection_shared_create:
+ * @connection: A #PkConnection.
+ *
+ * Creates a new subscription on the agent for @sources and installs the
+ * handlers that fan samples out to the consumers of the resulting shared
+ * subscription.
+ *
+ * Returns: A #PkSharedSubscription with a reference count of 1 if
+ *   successful; otherwise %NULL and @error is set.
+ * Side effects: A subscription is created on the agent.
+ */
+static PkSharedSubscription*
+pk_connection_shared_create (PkConnection  *connection,     /* IN */
+                             const gint    *sources,        /* IN */
+                             guint          n_sources,      /* IN */
+                             gint           encoder,        /* IN */
+                             gsize          buffer_size,    /* IN */
+                             gsize          buffer_timeout, /* IN */
+                             GError       **error)          /* OUT */
+{
+	PkSharedSubscription *shared;
+	gboolean removed;
+	gint subscription = 0;
+	gint i;
+
+	if (!pk_connection_manager_add_subscription(connection, buffer_size,
+	                                            buffer_timeout, &subscription,
+	                                            error)) {
+		return NULL;
+	}
+	for (i = 0; i < n_sources; i++) {
+		if (!pk_connection_subscription_add_source(connection, subscription,
+		                                           sources[i], error)) {
+			goto failed;
+		}
+	}
+	if (encoder > 0) {
+		if (!pk_connection_subscription_set_encoder(connection, subscription,
+		                                            encoder, error)) {
+			goto failed;
+		}
+	}
+
+	shared = g_slice_new0(PkSharedSubscription);
+	shared->ref_count = 1;
+	shared->connection = connection;
+	shared->subscription = subscription;
+	shared->key = pk_connection_shared_build_key(sources, n_sources, encoder,
+	                                             buffer_size, buffer_timeout);
+	shared->consumers = g_ptr_array_new();
+	shared->manifests = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+	                                          NULL,
+	                                          (GDestroyNotify)pk_manifest_unref);
+
+	/*
+	 * The handlers are released along with the agent subscription, which
+	 * may be after the last consumer has been released. Each of them
+	 * holds a reference to keep @shared alive until then.
+	 */
+	pk_connection_subscription_set_batch_handlers_async(
+			connection, subscription,
+			pk_connection_shared_manifest_cb,
+			pk_connection_shared_ref(shared),
+			pk_connection_shared_unref,
+			pk_connection_shared_samples_cb,
+			pk_connection_shared_ref(shared),
+			pk_connection_shared_unref,
+			NULL,
+			pk_connection_shared_set_handlers_cb,
+			NULL);
+
+	return shared;
+
+  failed:
+	pk_connection_manager_remove_subscription(connection, subscription,
+	                                          &removed, NULL);
+	return NULL;
+}
+
+/**
+ * pk_connection_subscription_acquire:
+ * @connection: A #PkConnection.
+ * @sources: An array of source identifiers.
+ * @n_sources: The length of @sources.
+ * @encoder: The encoder identifier or 0 for none.
+ * @buffer_size: The subscription buffer size.
+ * @buffer_timeout: The subscription buffer timeout.
+ * @manifest_func: A #PkManifestFunc to receive manifests.
+ * @samples_func: A #PkSamplesFunc to receive batches of samples.
+ * @user_data: User data for @manifest_func and @samples_func.
+ * @notify: A #GDestroyNotify called with @user_data upon release.
+ * @consumer: A location for the consumer identifier.
+ *
+ * Registers a consumer for the samples of @sources. Consumers asking for
+ * the same set of sources with the same encoder and buffering share a
+ * single subscription on the agent; its buffers are transferred and
+ * decoded once and the resulting samples are handed to each consumer.
+ *
+ * A consumer joining an existing subscription immediately receives the
+ * latest manifest of each source through @manifest_func.
+ *
+ * The consumer must be released with pk_connection_subscription_release().
+ * The subscription on the agent is removed with its last consumer. The
+ * handlers are called without any lock held, so either function may be
+ * called from within a consumer's handlers.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: A subscription may be created on the agent.
+ */
+gboolean
+pk_connection_subscription_acquire (PkConnection    *connection,     /* IN */
+                                    const gint      *sources,        /* IN */
+                                    guint            n_sources,      /* IN */
+                                    gint             encoder,        /* IN */
+                                    gsize            buffer_size,    /* IN */
+                                    gsize            buffer_timeout, /* IN */
+                                    PkManifestFunc   manifest_func,  /* IN */
+                                    PkSamplesFunc    samples_func,   /* IN */
+                                    gpointer         user_data,      /* IN */
+                                    GDestroyNotify   notify,         /* IN */
+                                    gint            *consumer,       /* OUT */
+                                    GError         **error)          /* OUT */
+{
+	PkConnectionPrivate *priv;
+	PkSharedSubscription *shared;
+	PkSharedSubscription *created = NULL;
+	PkConsumer *info;
+	GList *manifests = NULL;
+	GList *iter;
+	gboolean removed;
+	gchar *key;
+
+	g_return_val_if_fail(PK_IS_CONNECTION(connection), FALSE);
+	g_return_val_if_fail(sources != NULL || n_sources == 0, FALSE);
+	g_return_val_if_fail(consumer != NULL, FALSE);
+
+	ENTRY;
+	priv = connection->priv;
+	key = pk_connection_shared_build_key(sources, n_sources, encoder,
+	                                     buffer_size, buffer_timeout);
+
+	/*
+	 * Creating the subscription blocks on the agent and may iterate the
+	 * main loop, during which the shared handlers take the lock. So look
+	 * first, create without the lock held, and check again afterwards.
+	 */
+	g_static_rw_lock_reader_lock(&priv->rw_lock);
+	shared = g_hash_table_lookup(priv->shared, key);
+	g_static_rw_lock_reader_unlock(&priv->rw_lock);
+
+	if (!shared) {
+		if (!(created = pk_connection_shared_create(connection, sources,
+		                                            n_sources, encoder,
+		                                            buffer_size,
+		                                            buffer_timeout, error))) {
+			g_free(key);
+			RETURN(FALSE);
+		}
+	}
+
+	g_static_rw_lock_writer_lock(&priv->rw_lock);
+	if (!(shared = g_hash_table_lookup(priv->shared, key))) {
+		shared = created;
+		created = NULL;
+		g_hash_table_insert(priv->shared, g_strdup(shared->key), shared);
+	}
+	info = g_slice_new0(PkConsumer);
+	info->ref_count = 1;
+	info->id = ++priv->last_consumer;
+	info->shared = shared;
+	info->manifest_func = manifest_func;
+	info->samples_func = samples_func;
+	info->user_data = user_data;
+	info->notify = notify;
+	g_ptr_array_add(shared->consumers, info);
+	g_hash_table_insert(priv->consumers, GINT_TO_POINTER(info->id), info);
+	*consumer = info->id;
+	if (manifest_func) {
+		manifests = g_hash_table_get_values(shared->manifests);
+		g_list_foreach(manifests, (GFunc)pk_manifest_ref, NULL);
+	}
+	g_static_rw_lock_writer_unlock(&priv->rw_lock);
+
+	/*
+	 * Someone else created the same subscription while ours was being
+	 * set up; drop ours and use theirs.
+	 */
+	if (created) {
+		pk_connection_manager_remove_subscription(connection,
+		                                          created->subscription,
+		                                          &removed, NULL);
+		pk_connection_shared_unref(created);
+	}
+
+	for (iter = manifests; iter; iter = iter->next) {
+		manifest_func(iter->data, user_data);
+		pk_manifest_unref(iter->data);
+	}
+	g_list_free(manifests);
+
+	g_free(key);
+	RETURN(TRUE);
+}
+
+/**
+ * pk_connection_subscription_release:
+ * @connection: A #PkConnection.
+ * @consumer: A consumer identifier.
+ *
+ * Releases a consumer registered with pk_connection_subscription_acquire().
+ * Its handlers are not called again and, if this was the last consumer,
+ * the subscription is removed from the agent. The notify function given
+ * at registration is called once no dispatch to the consumer is still in
+ * progress, which may be after this function returns.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: A subscription may be removed from the agent.
+ */
+gboolean
+pk_connection_subscription_release (PkConnection  *connection, /* IN */
+                                    gint           consumer,   /* IN */
+                                    GError       **error)      /* OUT */
+{
+	PkConnectionPrivate *priv;
+	PkSharedSubscription *shared;
+	PkConsumer *info;
+	gboolean removed;
+	gboolean ret = TRUE;
+	gint subscription = 0;
+
+	g_return_val_if_fail(PK_IS_CONNECTION(connection), FALSE);
+
+	ENTRY;
+	priv = connection->priv;
+	g_static_rw_lock_writer_lock(&priv->rw_lock);
+	if (!(info = g_hash_table_lookup(priv->consumers,
+	                                 GINT_TO_POINTER(consumer)))) {
+		g_static_rw_lock_writer_unlock(&priv->rw_lock);
+		g_warning("No such subscription consumer %d.", consumer);
+		RETURN(FALSE);
+	}
+	g_hash_table_remove(priv->consumers, GINT_TO_POINTER(consumer));
+	g_atomic_int_set(&info->released, TRUE);
+	shared = info->shared;
+	g_ptr_array_remove(shared->consumers, info);
+	if (!shared->consumers->len) {
+		subscription = shared->subscription;
+		g_hash_table_remove(priv->shared, shared->key);
+	}
+	g_static_rw_lock_writer_unlock(&priv->rw_lock);
+
+	pk_connection_consumer_unref(info);
+
+	if (subscription) {
+		ret = pk_connection_manager_remove_subscription(connection,
+		                                                subscription,
+		                                                &removed, error);
+	}
+	RETURN(ret);
+}
+
+/**
+ * pk_connection_shared_source_free:
+ * @data: A #PkSharedSource.
+ *
+ * Frees a #PkSharedSource. The source is not removed from the agent.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_connection_shared_source_free (gpointer data) /* IN */
+{
+	PkSharedSource *shared = data;
+
+	g_free(shared->plugin);
+	g_slice_free(PkSharedSource, shared);
+}
+
+/**
+ * pk_connection_shared_source_destroy:
+ * @connection: A #PkConnection.
+ * @shared: A #PkSharedSource.
+ * @error: A location for a #GError, or %NULL.
+ *
+ * Removes the source and channel of @shared from the agent and frees
+ * @shared.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: The source and its channel are removed from the agent.
+ */
+static gboolean
+pk_connection_shared_source_destroy (PkConnection    *connection, /* IN */
+                                     PkSharedSource  *shared,     /* IN */
+                                     GError         **error)      /* OUT */
+{
+	gboolean removed;
+	gboolean ret;
+
+	ret = pk_connection_manager_remove_source(connection, shared->source,
+	                                          error) &&
+	      pk_connection_manager_remove_channel(connection, shared->channel,
+	                                           &removed, error);
+	pk_connection_shared_source_free(shared);
+	return ret;
+}
+
+/**
+ * pk_connection_shared_source_create:
+ * @connection: A #PkConnection.
+ * @plugin: The plugin identifier.
+ * @error: A location for a #GError, or %NULL.
+ *
+ * Creates a new source of @plugin on the agent within a channel of its
+ * own, and starts the channel.
+ *
+ * Returns: A newly allocated #PkSharedSource if successful; otherwise
+ *   %NULL and @error is set.
+ * Side effects: A channel and source are created on the agent.
+ */
+static PkSharedSource*
+pk_connection_shared_source_create (PkConnection  *connection, /* IN */
+                                    const gchar   *plugin,     /* IN */
+                                    GError       **error)      /* OUT */
+{
+	PkSharedSource *shared;
+	gboolean removed;
+	gint channel = 0;
+	gint source = 0;
+
+	if (!pk_connection_manager_add_channel(connection, &channel, error)) {
+		return NULL;
+	}
+	if (!pk_connection_manager_add_source(connection, plugin, &source,
+	                                      error)) {
+		goto failed;
+	}
+	if (!pk_connection_channel_add_source(connection, channel, source,
+	                                      error) ||
+	    !pk_connection_channel_start(connection, channel, NULL, error)) {
+		pk_connection_manager_remove_source(connection, source, NULL);
+		goto failed;
+	}
+
+	shared = g_slice_new0(PkSharedSource);
+	shared->ref_count = 1;
+	shared->plugin = g_strdup(plugin);
+	shared->channel = channel;
+	shared->source = source;
+	return shared;
+
+  failed:
+	pk_connection_manager_remove_channel(connection, channel, &removed, NULL);
+	return NULL;
+}
+
+/**
+ * pk_connection_source_acquire:
+ * @connection: A #PkConnection.
+ * @plugin: The plugin identifier, such as "Cpu".
+ * @source: A location for the source identifier.
+ * @error: A location for a #GError, or %NULL.
+ *
+ * Acquires a source of @plugin shared by every consumer of @connection.
+ * The first consumer creates the source on the agent, within a channel
+ * of its own that is started immediately; later consumers are given the
+ * same source. Subscribing to a shared source with
+ * pk_connection_subscription_acquire() therefore shares the subscription
+ * too, so that the samples are only recorded, transferred and decoded
+ * once.
+ *
+ * Since the source is always running, consumers that only want samples
+ * for part of the time must filter them themselves.
+ *
+ * The source must be released with pk_connection_source_release(). It is
+ * removed from the agent with its last consumer.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: A channel and source may be created on the agent.
+ */
+gboolean
+pk_connection_source_acquire (PkConnection  *connection, /* IN */
+                              const gchar   *plugin,     /* IN */
+                              gint          *source,     /* OUT */
+                              GError       **error)      /* OUT */
+{
+	PkConnectionPrivate *priv;
+	PkSharedSource *shared;
+	PkSharedSource *created = NULL;
+
+	g_return_val_if_fail(PK_IS_CONNECTION(connection), FALSE);
+	g_return_val_if_fail(plugin != NULL, FALSE);
+	g_return_val_if_fail(source != NULL, FALSE);
+
+	ENTRY;
+	priv = connection->priv;
+
+	/*
+	 * As with subscriptions, the source is created without the lock held
+	 * and we check again afterwards.
+	 */
+	g_static_rw_lock_reader_lock(&priv->rw_lock);
+	shared = g_hash_table_lookup(priv->sources, plugin);
+	g_static_rw_lock_reader_unlock(&priv->rw_lock);
+
+	if (!shared) {
+		if (!(created = pk_connection_shared_source_create(connection,
+		                                                   plugin,
+		                                                   error))) {
+			RETURN(FALSE);
+		}
+	}
+
+	g_static_rw_lock_writer_lock(&priv->rw_lock);
+	if ((shared = g_hash_table_lookup(priv->sources, plugin))) {
+		shared->ref_count++;
+	} else {
+		shared = created;
+		created = NULL;
+		g_hash_table_insert(priv->sources, shared->plugin, shared);
+	}
+	*source = shared->source;
+	g_static_rw_lock_writer_unlock(&priv->rw_lock);
+
+	if (created) {
+		pk_connection_shared_source_destroy(connection, created, NULL);
+	}
+
+	RETURN(TRUE);
+}
+
+/**
+ * pk_connection_source_release:
+ * @connection: A #PkConnection.
+ * @source: A source identifier from pk_connection_source_acquire().
+ * @error: A location for a #GError, or %NULL.
+ *
+ * Releases a source acquired with pk_connection_source_acquire(). If this
+ * was the last consumer of the source, the source and its channel are
+ * removed from the agent.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: A channel and source may be removed from the agent.
+ */
+gboolean
+pk_connection_source_release (PkConnection  *connection, /* IN */
+                              gint           source,     /* IN */
+                              GError       **error)      /* OUT */
+{
+	PkConnectionPrivate *priv;
+	PkSharedSource *shared = NULL;
+	GHashTableIter iter;
+	gpointer value;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(PK_IS_CONNECTION(connection), FALSE);
+
+	ENTRY;
+	priv = connection->priv;
+	g_static_rw_lock_writer_lock(&priv->rw_lock);
+	g_hash_table_iter_init(&iter, priv->sources);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		if (((PkSharedSource *)value)->source == source) {
+			shared = value;
+			break;
+		}
+	}
+	if (!shared) {
+		g_static_rw_lock_writer_unlock(&priv->rw_lock);
+		g_warning("No such shared source %d.", source);
+		RETURN(FALSE);
+	}
+	if (--shared->ref_count) {
+		shared = NULL;
+	} else {
+		g_hash_table_iter_steal(&iter);
+	}
+	g_static_rw_lock_writer_unlock(&priv->rw_lock);
+
+	if (shared) {
+		ret = pk_connection_shared_source_destroy(connection, shared, error);
+	}
+	RETURN(ret);
+}
+
 /**
  * pk_connection_error_quark:
  *
@@ -7745,6 +8731,100 @@ pk_connection_is_local (PkConnection *connection)
 	return FALSE;
 }
 
+static gboolean
+pk_connection_snapshot_resolve (gint         source_id, /* IN */
+                                PkManifest **manifest,  /* OUT */
+                                gpointer     user_data) /* IN */
+{
+	*manifest = user_data;
+	return (pk_manifest_get_source_id(*manifest) == source_id);
+}
+
+/**
+ * pk_connection_parse_snapshot:
+ * @snapshot: A snapshot retrieved with pk_connection_manager_get_snapshot().
+ * @snapshot_len: The length of @snapshot.
+ * @manifest_func: A #PkManifestFunc.
+ * @sample_func: A #PkSampleFunc or %NULL.
+ * @user_data: user data for @manifest_func and @sample_func.
+ *
+ * Decodes a snapshot of the agent's sources.  @manifest_func is called
+ * with the manifest of every source, followed by @sample_func with its
+ * most recent sample if the source has delivered one.
+ *
+ * Returns: %TRUE if @snapshot was decoded; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+pk_connection_parse_snapshot (const guint8   *snapshot,     /* IN */
+                              gsize           snapshot_len, /* IN */
+                              PkManifestFunc  manifest_func, /* IN */
+                              PkSampleFunc    sample_func,  /* IN */
+                              gpointer        user_data)    /* IN */
+{
+	EggBuffer *buffer;
+	PkManifest *manifest = NULL;
+	PkSample *sample;
+	EggBufferTag tag;
+	guint8 *data;
+	gsize data_len;
+	gsize n_read;
+	guint field;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(snapshot != NULL || snapshot_len == 0, FALSE);
+	g_return_val_if_fail(manifest_func != NULL, FALSE);
+
+	ENTRY;
+	buffer = egg_buffer_new_from_data(snapshot, snapshot_len);
+	while (egg_buffer_get_pos(buffer) < snapshot_len) {
+		if (!egg_buffer_read_tag(buffer, &field, &tag) ||
+		    tag != EGG_BUFFER_DATA ||
+		    !egg_buffer_read_data(buffer, &data, &data_len)) {
+			GOTO(failed);
+		}
+		switch (field) {
+		case 1:
+			if (manifest) {
+				pk_manifest_unref(manifest);
+			}
+			if (!(manifest = pk_manifest_new_from_data(data, data_len))) {
+				g_free(data);
+				GOTO(failed);
+			}
+			manifest_func(manifest, user_data);
+			break;
+		case 2:
+			if (!manifest) {
+				g_free(data);
+				GOTO(failed);
+			}
+			sample = pk_sample_new_from_data(pk_connection_snapshot_resolve,
+			                                 manifest, data, data_len,
+			                                 &n_read);
+			if (!sample) {
+				g_free(data);
+				GOTO(failed);
+			}
+			if (sample_func) {
+				sample_func(manifest, sample, user_data);
+			}
+			pk_sample_unref(sample);
+			break;
+		default:
+			break;
+		}
+		g_free(data);
+	}
+	ret = TRUE;
+  failed:
+	if (manifest) {
+		pk_manifest_unref(manifest);
+	}
+	egg_buffer_unref(buffer);
+	RETURN(ret);
+}
+
 /**
  * pk_connection_emit_state_changed:
  * @connection: A #PkConnection.
@@ -7961,6 +9041,10 @@ pk_connection_finalize (GObject *object) /* IN */
 	PkConnectionPrivate *priv = PK_CONNECTION(object)->priv;
 
 	g_free(priv->uri);
+	g_hash_table_destroy(priv->consumers);
+	g_hash_table_destroy(priv->shared);
+	g_hash_table_destroy(priv->sources);
+	g_static_rw_lock_free(&priv->rw_lock);
 
 	G_OBJECT_CLASS(pk_connection_parent_class)->finalize(object);
 }
@@ -8061,4 +9145,13 @@ pk_connection_init (PkConnection *connection) /* IN */
 	connection->priv = G_TYPE_INSTANCE_GET_PRIVATE(connection,
 	                                               PK_TYPE_CONNECTION,
 	                                               PkConnectionPrivate);
+	g_static_rw_lock_init(&connection->priv->rw_lock);
+	connection->priv->shared =
+		g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		                      pk_connection_shared_unref);
+	connection->priv->consumers = g_hash_table_new(g_direct_hash,
+	                                               g_direct_equal);
+	connection->priv->sources =
+		g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		                      pk_connection_shared_source_free);
 }
@@ -352,6 +352,15 @@ struct _PkConnectionClass
 	                                                     GAsyncResult          *result,
 	                                                     gchar               ***plugins,
 	                                                     GError               **error);
+	void          (*manager_get_snapshot_async)         (PkConnection          *connection,
+	                                                     GCancellable          *cancellable,
+	                                                     GAsyncReadyCallback    callback,
+	                                                     gpointer               user_data);
+	gboolean      (*manager_get_snapshot_finish)        (PkConnection          *connection,
+	                                                     GAsyncResult          *result,
+	                                                     guint8               **snapshot,
+	                                                     gsize                 *snapshot_len,
+	                                                     GError               **error);
 	void          (*manager_get_sources_async)          (PkConnection          *connection,
 	                                                     GCancellable          *cancellable,
 	                                                     GAsyncReadyCallback    callback,
@@ -574,6 +583,20 @@ struct _PkConnectionClass
 	gboolean      (*subscription_set_handlers_finish)   (PkConnection          *connection,
 	                                                     GAsyncResult          *result,
 	                                                     GError               **error);
+	void          (*subscription_set_batch_handlers_async)  (PkConnection          *connection,
+	                                                         gint                   subscription,
+	                                                         PkManifestFunc         manifest_func,
+	                                                         gpointer               manifest_data,
+	                                                         GDestroyNotify         manifest_destroy,
+	                                                         PkSamplesFunc          samples_func,
+	                                                         gpointer               samples_data,
+	                                                         GDestroyNotify         samples_destroy,
+	                                                         GCancellable          *cancellable,
+	                                                         GAsyncReadyCallback    callback,
+	                                                         gpointer               user_data);
+	gboolean      (*subscription_set_batch_handlers_finish) (PkConnection          *connection,
+	                                                         GAsyncResult          *result,
+	                                                         GError               **error);
 	void          (*subscription_unmute_async)          (PkConnection          *connection,
 	                                                     gint                   subscription,
 	                                                     GCancellable          *cancellable,
@@ -639,6 +662,33 @@ guint         pk_connection_hash                              (PkConnection
 gboolean      pk_connection_is_connected                      (PkConnection          *connection);
 gboolean      pk_connection_is_local                          (PkConnection          *connection);
 PkConnection* pk_connection_new_from_uri                      (const gchar           *uri);
+gboolean      pk_connection_parse_snapshot                    (const guint8          *snapshot,
+                                                               gsize                  snapshot_len,
+                                                               PkManifestFunc         manifest_func,
+                                                               PkSampleFunc           sample_func,
+                                                               gpointer               user_data);
+gboolean      pk_connection_source_acquire                    (PkConnection          *connection,
+                                                               const gchar           *plugin,
+                                                               gint                  *source,
+                                                               GError               **error);
+gboolean      pk_connection_source_release                    (PkConnection          *connection,
+                                                               gint                   source,
+                                                               GError               **error);
+gboolean      pk_connection_subscription_acquire              (PkConnection          *connection,
+                                                               const gint            *sources,
+                                                               guint                  n_sources,
+                                                               gint                   encoder,
+                                                               gsize                  buffer_size,
+                                                               gsize                  buffer_timeout,
+                                                               PkManifestFunc         manifest_func,
+                                                               PkSamplesFunc          samples_func,
+                                                               gpointer               user_data,
+                                                               GDestroyNotify         notify,
+                                                               gint                  *consumer,
+                                                               GError               **error);
+gboolean      pk_connection_subscription_release              (PkConnection          *connection,
+                                                               gint                   consumer,
+                                                               GError               **error);
 
 G_END_DECLS
 
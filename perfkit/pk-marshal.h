@@ -14,6 +14,14 @@ extern void pk_cclosure_marshal_VOID__POINTER_UINT_POINTER (GClosure     *closur
                                                             gpointer      invocation_hint,
                                                             gpointer      marshal_data);
 
+/* VOID:POINTER,UINT (./pk-marshal.list:2) */
+extern void pk_cclosure_marshal_VOID__POINTER_UINT (GClosure     *closure,
+                                                    GValue       *return_value,
+                                                    guint         n_param_values,
+                                                    const GValue *param_values,
+                                                    gpointer      invocation_hint,
+                                                    gpointer      marshal_data);
+
 G_END_DECLS
 
 #endif /* __pk_cclosure_marshal_MARSHAL_H__ */
@@ -0,0 +1,2331 @@
+/* pk-model-columnar.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "pk-log.h"
+#include "pk-model-columnar.h"
+#include "pk-sketch.h"
+
+
+/*
+ * PkModelColumnar stores samples in a "struct of arrays" layout. There is
+ * one contiguous array of sample times and one typed array per field. All
+ * of the arrays are kept the same length so that an iterator is simply an
+ * index into them. Fields that were not present in a sample are stored
+ * as zero (or NULL for strings).
+ *
+ * Counter deltas are computed once as samples are inserted and kept in an
+ * array beside the counter's values. Registered builders are evaluated
+ * for each inserted sample and stored as derived double columns, so
+ * renderers read precomputed values rather than invoking the builder.
+ *
+ * To answer zoomed out range queries without touching every sample, the
+ * numeric columns are also rolled up into a pyramid of levels. Level n
+ * groups samples into buckets aligned to 2^(n + PYRAMID_MIN_EXP) seconds
+ * and keeps the min, max and sum of every column per bucket. Buckets are
+ * updated incrementally as samples are appended. Levels are created
+ * lazily: once the sample interval has been observed, the pyramid starts
+ * at the finest level whose buckets hold about two samples, and coarser
+ * levels are merged from the level below the first time a query asks for
+ * them. Levels that would not reduce the number of items by at least half
+ * are dropped.
+ *
+ * With a retention policy, expired samples are removed from the front of
+ * the arrays in batches so that the arrays stay contiguous for
+ * pk_model_columnar_get_times() and pk_model_columnar_get_column(). The
+ * buckets covering them are normally removed too. If rollups are kept,
+ * each level instead holds on to as many expired buckets as there are
+ * samples retained, so older history remains visible at coarser zoom
+ * levels while memory stays bounded.
+ */
+
+
+#define PYRAMID_MIN_EXP     (-10)
+#define PYRAMID_N_LEVELS    (27)
+#define PYRAMID_MIN_SAMPLES (256)
+#define PYRAMID_PLAN_SAMPLES (16)
+#define EXPIRE_MIN_SAMPLES  (64)
+#define INDEX_BLOCK_SIZE    (64)
+
+
+typedef struct
+{
+	gdouble min;
+	gdouble max;
+	gdouble sum;
+	gdouble first;
+	gdouble last;
+} PkModelBucketStat;
+
+
+typedef struct
+{
+	gdouble min;
+	gdouble max;
+} PkModelExtent;
+
+
+typedef struct
+{
+	gdouble    width;
+	gint64     last_key;
+	guint      n_expired; /* Buckets kept for expired samples */
+	GArray    *times;     /* Time of the first sample in each bucket */
+	GArray    *offsets;   /* Index of the first sample in each bucket */
+	GArray    *counts;    /* Number of samples in each bucket */
+	GPtrArray *stats;     /* Array of PkModelBucketStat per column */
+	GPtrArray *sketches;  /* Array of PkSketch per sketched column */
+} PkModelLevel;
+
+
+typedef struct
+{
+	guint        index;
+	GQuark       key;
+	GType        type;
+	PkModelMode  mode;
+	gboolean     derived; /* Values come from a builder */
+	gboolean     sketched; /* Buckets keep quantile sketches */
+	GArray      *values;
+	GArray      *deltas;  /* Deltas for PK_MODEL_COUNTER, or NULL */
+
+	/*
+	 * Range index over the samples of numeric columns. prefix holds the
+	 * running sum before each sample and extents is a sparse table of
+	 * block extremes; level k holds the extent of 2^k blocks starting at
+	 * each complete block. Level 0 also holds the trailing partial block.
+	 */
+	GArray      *prefix;
+	GPtrArray   *extents;
+} PkModelColumn;
+
+
+struct _PkModelColumnarPrivate
+{
+	GArray     *times;
+	GPtrArray  *columns;
+	GHashTable *columns_by_key;
+	GHashTable *modes;
+	GHashTable *sketched;
+	GPtrArray  *derived;
+
+	/*
+	 * Column for each row of the most recently seen manifest, indexed by
+	 * row id - 1. This saves looking up columns by name for every sample.
+	 */
+	PkManifest *manifest;
+	GPtrArray  *manifest_columns;
+
+	/*
+	 * Rollup levels, finest first. Levels that were dropped or have not
+	 * been created yet are NULL. coarsest is the index of the coarsest
+	 * level created so far, or -1 until the sample interval is known.
+	 */
+	PkModelLevel *levels[PYRAMID_N_LEVELS];
+	gint          coarsest;
+	gboolean      keep_rollups;
+};
+
+
+G_DEFINE_TYPE(PkModelColumnar, pk_model_columnar, PK_TYPE_MODEL)
+
+
+static GType
+pk_model_column_storage_type (GType type)
+{
+	switch (type) {
+	case G_TYPE_DOUBLE:
+	case G_TYPE_FLOAT:
+	case G_TYPE_INT:
+	case G_TYPE_INT64:
+	case G_TYPE_UINT:
+	case G_TYPE_UINT64:
+	case G_TYPE_STRING:
+		return type;
+	default:
+		/*
+		 * Anything else that can be transformed is stored as a double.
+		 */
+		return G_TYPE_DOUBLE;
+	}
+}
+
+
+static guint
+pk_model_column_element_size (GType type)
+{
+	switch (type) {
+	case G_TYPE_DOUBLE:
+		return sizeof(gdouble);
+	case G_TYPE_FLOAT:
+		return sizeof(gfloat);
+	case G_TYPE_INT:
+		return sizeof(gint32);
+	case G_TYPE_INT64:
+		return sizeof(gint64);
+	case G_TYPE_UINT:
+		return sizeof(guint32);
+	case G_TYPE_UINT64:
+		return sizeof(guint64);
+	case G_TYPE_STRING:
+		return sizeof(gchar *);
+	default:
+		g_assert_not_reached();
+		return 0;
+	}
+}
+
+
+static PkModelColumn*
+pk_model_column_new (GQuark      key,
+                     GType       type,
+                     PkModelMode mode,
+                     guint       length)
+{
+	PkModelColumn *column;
+
+	column = g_slice_new0(PkModelColumn);
+	column->key = key;
+	column->type = pk_model_column_storage_type(type);
+	column->mode = mode;
+	column->values = g_array_sized_new(FALSE, TRUE,
+	                                   pk_model_column_element_size(column->type),
+	                                   MAX(length, 16));
+	g_array_set_size(column->values, length);
+	return column;
+}
+
+
+static void
+pk_model_column_append (PkModelColumn *column,
+                        PkSample      *sample,
+                        gint           row_id)
+{
+	GValue value = { 0 };
+	gchar *str;
+
+#define APPEND(_type, _name)                             \
+	G_STMT_START {                                       \
+		_type v = g_value_get_##_name(&value);           \
+		g_array_append_val(column->values, v);           \
+	} G_STMT_END
+
+	g_value_init(&value, column->type);
+	pk_sample_get_value(sample, row_id, &value);
+	switch (column->type) {
+	case G_TYPE_DOUBLE:
+		APPEND(gdouble, double);
+		break;
+	case G_TYPE_FLOAT:
+		APPEND(gfloat, float);
+		break;
+	case G_TYPE_INT:
+		APPEND(gint32, int);
+		break;
+	case G_TYPE_INT64:
+		APPEND(gint64, int64);
+		break;
+	case G_TYPE_UINT:
+		APPEND(guint32, uint);
+		break;
+	case G_TYPE_UINT64:
+		APPEND(guint64, uint64);
+		break;
+	case G_TYPE_STRING:
+		str = g_value_dup_string(&value);
+		g_array_append_val(column->values, str);
+		break;
+	default:
+		g_assert_not_reached();
+	}
+	g_value_unset(&value);
+
+#undef APPEND
+}
+
+
+static inline gdouble
+pk_model_column_get_double (PkModelColumn *column,
+                            guint          index_)
+{
+	switch (column->type) {
+	case G_TYPE_DOUBLE:
+		return g_array_index(column->values, gdouble, index_);
+	case G_TYPE_FLOAT:
+		return g_array_index(column->values, gfloat, index_);
+	case G_TYPE_INT:
+		return g_array_index(column->values, gint32, index_);
+	case G_TYPE_INT64:
+		return g_array_index(column->values, gint64, index_);
+	case G_TYPE_UINT:
+		return g_array_index(column->values, guint32, index_);
+	case G_TYPE_UINT64:
+		return g_array_index(column->values, guint64, index_);
+	default:
+		return 0.0;
+	}
+}
+
+
+static void
+pk_model_column_update_deltas (PkModelColumn *column)
+{
+	gdouble delta;
+	guint i;
+
+	if (!column->deltas) {
+		return;
+	}
+
+	for (i = column->deltas->len; i < column->values->len; i++) {
+		delta = 0.0;
+		if (i > 0) {
+			delta = pk_model_column_get_double(column, i) -
+			        pk_model_column_get_double(column, i - 1);
+		}
+		g_array_append_val(column->deltas, delta);
+	}
+}
+
+
+static inline gdouble
+pk_model_column_get_sample (PkModelColumn *column,
+                            guint          index_)
+{
+	if (column->deltas) {
+		return g_array_index(column->deltas, gdouble, index_);
+	}
+	return pk_model_column_get_double(column, index_);
+}
+
+
+static void
+pk_model_column_update_index (PkModelColumn *column)
+{
+	PkModelExtent extent;
+	PkModelExtent *block;
+	GArray *level;
+	GArray *prev;
+	gdouble value;
+	gdouble sum;
+	guint n_blocks;
+	guint half;
+	guint i;
+	guint k;
+
+	if (!column->prefix) {
+		return;
+	}
+
+	for (i = column->prefix->len - 1; i < column->values->len; i++) {
+		value = pk_model_column_get_sample(column, i);
+		sum = g_array_index(column->prefix, gdouble, i) + value;
+		g_array_append_val(column->prefix, sum);
+
+		level = g_ptr_array_index(column->extents, 0);
+		if (!(i % INDEX_BLOCK_SIZE)) {
+			extent.min = extent.max = value;
+			g_array_append_val(level, extent);
+		} else {
+			block = &g_array_index(level, PkModelExtent, level->len - 1);
+			block->min = MIN(block->min, value);
+			block->max = MAX(block->max, value);
+		}
+		if ((i + 1) % INDEX_BLOCK_SIZE) {
+			continue;
+		}
+
+		/*
+		 * The block is complete, so each level gains the span of 2^k
+		 * blocks that ends with it.
+		 */
+		n_blocks = (i + 1) / INDEX_BLOCK_SIZE;
+		for (k = 1; (1 << k) <= n_blocks; k++) {
+			if (k == column->extents->len) {
+				g_ptr_array_add(column->extents,
+				                g_array_new(FALSE, FALSE,
+				                            sizeof(PkModelExtent)));
+			}
+			prev = g_ptr_array_index(column->extents, k - 1);
+			level = g_ptr_array_index(column->extents, k);
+			half = 1 << (k - 1);
+			block = &g_array_index(prev, PkModelExtent, level->len);
+			extent = *block;
+			block = &g_array_index(prev, PkModelExtent, level->len + half);
+			extent.min = MIN(extent.min, block->min);
+			extent.max = MAX(extent.max, block->max);
+			g_array_append_val(level, extent);
+		}
+	}
+}
+
+
+static void
+pk_model_column_free_index (PkModelColumn *column)
+{
+	guint i;
+
+	if (column->prefix) {
+		for (i = 0; i < column->extents->len; i++) {
+			g_array_free(g_ptr_array_index(column->extents, i), TRUE);
+		}
+		g_ptr_array_free(column->extents, TRUE);
+		g_array_free(column->prefix, TRUE);
+		column->extents = NULL;
+		column->prefix = NULL;
+	}
+}
+
+
+/**
+ * pk_model_column_reset_index:
+ * @column: (in): A #PkModelColumn.
+ *
+ * Rebuilds the range index of @column from scratch.  This is needed
+ * whenever existing samples change, such as when they expire or the
+ * field mode changes.  Appended samples only need
+ * pk_model_column_update_index().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_column_reset_index (PkModelColumn *column)
+{
+	gdouble zero = 0.0;
+
+	pk_model_column_free_index(column);
+	if (column->type == G_TYPE_STRING) {
+		return;
+	}
+
+	column->prefix = g_array_sized_new(FALSE, FALSE, sizeof(gdouble),
+	                                   MAX(column->values->len + 1, 16));
+	g_array_append_val(column->prefix, zero);
+	column->extents = g_ptr_array_new();
+	g_ptr_array_add(column->extents,
+	                g_array_new(FALSE, FALSE, sizeof(PkModelExtent)));
+	pk_model_column_update_index(column);
+}
+
+
+static void
+pk_model_column_scan_extent (PkModelColumn *column,
+                             guint          begin,
+                             guint          end,
+                             PkModelExtent *extent)
+{
+	gdouble value;
+	guint i;
+
+	for (i = begin; i < end; i++) {
+		value = pk_model_column_get_sample(column, i);
+		extent->min = MIN(extent->min, value);
+		extent->max = MAX(extent->max, value);
+	}
+}
+
+
+/**
+ * pk_model_column_get_extent:
+ * @column: (in): A #PkModelColumn.
+ * @begin: (in): The index of the first sample.
+ * @end: (in): The index after the last sample.
+ * @extent: (out): A location for the extremes.
+ *
+ * Retrieves the minimum and maximum sample in [@begin, @end).  At most
+ * two partial blocks are scanned; the whole blocks in between are
+ * covered by two overlapping spans from the sparse table.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_column_get_extent (PkModelColumn *column,
+                            guint          begin,
+                            guint          end,
+                            PkModelExtent *extent)
+{
+	PkModelExtent *block;
+	GArray *level;
+	guint first_block;
+	guint last_block;
+	guint k = 0;
+
+	extent->min = G_MAXDOUBLE;
+	extent->max = -G_MAXDOUBLE;
+
+	first_block = (begin + INDEX_BLOCK_SIZE - 1) / INDEX_BLOCK_SIZE;
+	last_block = end / INDEX_BLOCK_SIZE;
+	if (first_block >= last_block) {
+		pk_model_column_scan_extent(column, begin, end, extent);
+		return;
+	}
+
+	pk_model_column_scan_extent(column, begin,
+	                            first_block * INDEX_BLOCK_SIZE, extent);
+	pk_model_column_scan_extent(column, last_block * INDEX_BLOCK_SIZE,
+	                            end, extent);
+
+	while ((2 << k) <= last_block - first_block) {
+		k++;
+	}
+	level = g_ptr_array_index(column->extents, k);
+	block = &g_array_index(level, PkModelExtent, first_block);
+	extent->min = MIN(extent->min, block->min);
+	extent->max = MAX(extent->max, block->max);
+	block = &g_array_index(level, PkModelExtent, last_block - (1 << k));
+	extent->min = MIN(extent->min, block->min);
+	extent->max = MAX(extent->max, block->max);
+}
+
+
+static void
+pk_model_column_free (PkModelColumn *column)
+{
+	gint i;
+
+	if (column->type == G_TYPE_STRING) {
+		for (i = 0; i < column->values->len; i++) {
+			g_free(g_array_index(column->values, gchar*, i));
+		}
+	}
+	g_array_free(column->values, TRUE);
+	if (column->deltas) {
+		g_array_free(column->deltas, TRUE);
+	}
+	pk_model_column_free_index(column);
+	g_slice_free(PkModelColumn, column);
+}
+
+
+static void
+pk_model_column_set_mode (PkModelColumn *column,
+                          PkModelMode    mode)
+{
+	column->mode = mode;
+	if (mode == PK_MODEL_COUNTER && column->type != G_TYPE_STRING) {
+		if (!column->deltas) {
+			column->deltas = g_array_sized_new(FALSE, FALSE, sizeof(gdouble),
+			                                   MAX(column->values->len, 16));
+			pk_model_column_update_deltas(column);
+		}
+	} else if (column->deltas) {
+		g_array_free(column->deltas, TRUE);
+		column->deltas = NULL;
+	}
+	pk_model_column_reset_index(column);
+}
+
+
+static void
+pk_model_column_get_value (PkModelColumn *column,
+                           guint          index_,
+                           GValue        *value)
+{
+	GValue tmp = { 0 };
+	GValue *dst;
+
+	/*
+	 * Avoid the transform when the requested type matches our storage,
+	 * which is the common case for renderers asking for doubles.
+	 */
+	if (G_VALUE_TYPE(value) == column->type) {
+		dst = value;
+	} else {
+		g_value_init(&tmp, column->type);
+		dst = &tmp;
+	}
+
+	switch (column->type) {
+	case G_TYPE_DOUBLE:
+		g_value_set_double(dst, g_array_index(column->values, gdouble, index_));
+		break;
+	case G_TYPE_FLOAT:
+		g_value_set_float(dst, g_array_index(column->values, gfloat, index_));
+		break;
+	case G_TYPE_INT:
+		g_value_set_int(dst, g_array_index(column->values, gint32, index_));
+		break;
+	case G_TYPE_INT64:
+		g_value_set_int64(dst, g_array_index(column->values, gint64, index_));
+		break;
+	case G_TYPE_UINT:
+		g_value_set_uint(dst, g_array_index(column->values, guint32, index_));
+		break;
+	case G_TYPE_UINT64:
+		g_value_set_uint64(dst, g_array_index(column->values, guint64, index_));
+		break;
+	case G_TYPE_STRING:
+		g_value_set_string(dst, g_array_index(column->values, gchar*, index_));
+		break;
+	default:
+		g_assert_not_reached();
+	}
+
+	if (dst == &tmp) {
+		g_value_transform(&tmp, value);
+		g_value_unset(&tmp);
+	}
+}
+
+
+static PkModelColumn*
+pk_model_columnar_get_or_create_column (PkModelColumnar *columnar,
+                                        GQuark           key,
+                                        GType            type)
+{
+	PkModelColumnarPrivate *priv = columnar->priv;
+	PkModelColumn *column;
+	PkModelMode mode;
+
+	if (!(column = g_hash_table_lookup(priv->columns_by_key,
+	                                   GUINT_TO_POINTER(key)))) {
+		mode = GPOINTER_TO_INT(g_hash_table_lookup(priv->modes,
+		                                           GUINT_TO_POINTER(key)));
+		column = pk_model_column_new(key, type, PK_MODEL_RAW, priv->times->len);
+		pk_model_column_set_mode(column, mode);
+		column->sketched = (column->type != G_TYPE_STRING &&
+		                    g_hash_table_lookup(priv->sketched,
+		                                        GUINT_TO_POINTER(key)));
+		column->index = priv->columns->len;
+		g_ptr_array_add(priv->columns, column);
+		g_hash_table_insert(priv->columns_by_key, GUINT_TO_POINTER(key),
+		                    column);
+	}
+	return column;
+}
+
+
+static PkModelLevel*
+pk_model_level_new (gdouble width)
+{
+	PkModelLevel *level;
+
+	level = g_slice_new0(PkModelLevel);
+	level->width = width;
+	level->times = g_array_new(FALSE, FALSE, sizeof(gdouble));
+	level->offsets = g_array_new(FALSE, FALSE, sizeof(gint));
+	level->counts = g_array_new(FALSE, FALSE, sizeof(guint));
+	level->stats = g_ptr_array_new();
+	level->sketches = g_ptr_array_new();
+	return level;
+}
+
+
+static void
+pk_model_level_free (PkModelLevel *level)
+{
+	GPtrArray *sketches;
+	gint i;
+
+	for (i = 0; i < level->sketches->len; i++) {
+		if ((sketches = g_ptr_array_index(level->sketches, i))) {
+			g_ptr_array_foreach(sketches, (GFunc)pk_sketch_unref, NULL);
+			g_ptr_array_free(sketches, TRUE);
+		}
+	}
+	g_ptr_array_free(level->sketches, TRUE);
+	for (i = 0; i < level->stats->len; i++) {
+		if (g_ptr_array_index(level->stats, i)) {
+			g_array_free(g_ptr_array_index(level->stats, i), TRUE);
+		}
+	}
+	g_ptr_array_free(level->stats, TRUE);
+	g_array_free(level->times, TRUE);
+	g_array_free(level->offsets, TRUE);
+	g_array_free(level->counts, TRUE);
+	g_slice_free(PkModelLevel, level);
+}
+
+
+static void
+pk_model_level_add_columns (PkModelLevel *level,
+                            GPtrArray    *columns)
+{
+	PkModelColumn *column;
+	GArray *stats;
+
+	/*
+	 * Columns created after the level already has buckets are zero for
+	 * those samples, which is what an all zero stat describes.
+	 */
+	while (level->stats->len < columns->len) {
+		column = g_ptr_array_index(columns, level->stats->len);
+		stats = NULL;
+		if (column->type != G_TYPE_STRING) {
+			stats = g_array_new(FALSE, TRUE, sizeof(PkModelBucketStat));
+			g_array_set_size(stats, level->times->len);
+		}
+		g_ptr_array_add(level->stats, stats);
+	}
+}
+
+
+/**
+ * pk_model_level_build_sketches:
+ * @level: (in): A #PkModelLevel.
+ * @column: (in): A sketched #PkModelColumn.
+ *
+ * Creates the quantile sketches for the buckets of @level that do not
+ * have one yet, from the samples they cover.  Buckets whose samples have
+ * expired get an empty sketch.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_level_build_sketches (PkModelLevel  *level,
+                               PkModelColumn *column)
+{
+	GPtrArray *sketches;
+	PkSketch *sketch;
+	gint offset;
+	gint end;
+	gint i;
+
+	while (level->sketches->len <= column->index) {
+		g_ptr_array_add(level->sketches, NULL);
+	}
+	if (!(sketches = g_ptr_array_index(level->sketches, column->index))) {
+		sketches = g_ptr_array_sized_new(MAX(level->times->len, 16));
+		g_ptr_array_index(level->sketches, column->index) = sketches;
+	}
+
+	while (sketches->len < level->times->len) {
+		offset = g_array_index(level->offsets, gint, sketches->len);
+		end = offset + g_array_index(level->counts, guint, sketches->len);
+		end = MIN(end, (gint)column->values->len);
+		sketch = pk_sketch_new(PK_SKETCH_DEFAULT_ACCURACY);
+		for (i = MAX(offset, 0); i < end; i++) {
+			pk_sketch_add(sketch, pk_model_column_get_sample(column, i));
+		}
+		g_ptr_array_add(sketches, sketch);
+	}
+}
+
+
+static void
+pk_model_level_append (PkModelLevel *level,
+                       GPtrArray    *columns,
+                       gdouble       time_,
+                       gint          index_)
+{
+	PkModelColumn *column;
+	PkModelBucketStat *stat;
+	PkModelBucketStat new_stat;
+	GPtrArray *sketches;
+	GArray *stats;
+	gboolean new_bucket;
+	gint64 key;
+	gdouble v;
+	guint count;
+	gint i;
+
+	pk_model_level_add_columns(level, columns);
+
+	key = (gint64)floor(time_ / level->width);
+	new_bucket = (!level->times->len || key != level->last_key);
+	if (new_bucket) {
+		count = 1;
+		level->last_key = key;
+		g_array_append_val(level->times, time_);
+		g_array_append_val(level->offsets, index_);
+		g_array_append_val(level->counts, count);
+	} else {
+		g_array_index(level->counts, guint, level->counts->len - 1)++;
+	}
+
+	for (i = 0; i < columns->len; i++) {
+		if (!(stats = g_ptr_array_index(level->stats, i))) {
+			continue;
+		}
+		column = g_ptr_array_index(columns, i);
+		v = 0.0;
+		if (index_ < column->values->len) {
+			v = pk_model_column_get_double(column, index_);
+		}
+		if (new_bucket) {
+			new_stat.min = new_stat.max = new_stat.sum = v;
+			new_stat.first = new_stat.last = v;
+			g_array_append_val(stats, new_stat);
+		} else {
+			stat = &g_array_index(stats, PkModelBucketStat, stats->len - 1);
+			if (v < stat->min) {
+				stat->min = v;
+			}
+			if (v > stat->max) {
+				stat->max = v;
+			}
+			stat->sum += v;
+			stat->last = v;
+		}
+
+		/*
+		 * Sketches describe the samples, so counters are sketched by
+		 * their deltas. A new bucket is built from its single sample.
+		 */
+		if (column->sketched) {
+			sketches = NULL;
+			if (i < level->sketches->len) {
+				sketches = g_ptr_array_index(level->sketches, i);
+			}
+			if (sketches && sketches->len == level->times->len &&
+			    index_ < column->values->len) {
+				pk_sketch_add(g_ptr_array_index(sketches, sketches->len - 1),
+				              pk_model_column_get_sample(column, index_));
+			} else {
+				pk_model_level_build_sketches(level, column);
+			}
+		}
+	}
+}
+
+
+/**
+ * pk_model_level_restat:
+ * @level: (in): A #PkModelLevel.
+ * @columns: (in): The columns of the model.
+ * @column: (in): The #PkModelColumn whose values changed.
+ *
+ * Recomputes the bucket stats of @column from its values, such as after
+ * a builder filled in a derived column for samples that were already
+ * rolled up.  Samples that have expired no longer contribute.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_level_restat (PkModelLevel  *level,
+                       GPtrArray     *columns,
+                       PkModelColumn *column)
+{
+	PkModelBucketStat *stat;
+	GArray *stats;
+	gdouble v;
+	gint offset;
+	gint end;
+	gint i;
+	guint b;
+
+	pk_model_level_add_columns(level, columns);
+	if (!(stats = g_ptr_array_index(level->stats, column->index))) {
+		return;
+	}
+
+	for (b = 0; b < level->times->len; b++) {
+		offset = g_array_index(level->offsets, gint, b);
+		end = offset + g_array_index(level->counts, guint, b);
+		end = MIN(end, (gint)column->values->len);
+		stat = &g_array_index(stats, PkModelBucketStat, b);
+		memset(stat, 0, sizeof *stat);
+		for (i = MAX(offset, 0); i < end; i++) {
+			v = pk_model_column_get_double(column, i);
+			if (i == MAX(offset, 0)) {
+				stat->min = stat->max = stat->first = v;
+			} else {
+				stat->min = MIN(stat->min, v);
+				stat->max = MAX(stat->max, v);
+			}
+			stat->sum += v;
+			stat->last = v;
+		}
+	}
+}
+
+
+static void
+pk_model_level_remove_buckets (PkModelLevel *level,
+                               guint         n_buckets)
+{
+	GPtrArray *sketches;
+	GArray *stats;
+	guint n_sketches;
+	guint j;
+	gint i;
+
+	if (!n_buckets) {
+		return;
+	}
+
+	g_array_remove_range(level->times, 0, n_buckets);
+	g_array_remove_range(level->offsets, 0, n_buckets);
+	g_array_remove_range(level->counts, 0, n_buckets);
+	for (i = 0; i < level->stats->len; i++) {
+		if ((stats = g_ptr_array_index(level->stats, i))) {
+			g_array_remove_range(stats, 0, n_buckets);
+		}
+	}
+	for (i = 0; i < level->sketches->len; i++) {
+		if ((sketches = g_ptr_array_index(level->sketches, i))) {
+			n_sketches = MIN(n_buckets, sketches->len);
+			for (j = 0; j < n_sketches; j++) {
+				pk_sketch_unref(g_ptr_array_index(sketches, j));
+			}
+			g_ptr_array_remove_range(sketches, 0, n_sketches);
+		}
+	}
+}
+
+
+/**
+ * pk_model_level_expire:
+ * @level: (in): A #PkModelLevel.
+ * @n_samples: (in): The number of samples removed from the model.
+ * @max_expired: (in): The number of expired buckets to keep.
+ *
+ * Rebases the bucket offsets after @n_samples were removed from the front
+ * of the model, and removes all but @max_expired of the buckets that no
+ * longer cover any sample.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_level_expire (PkModelLevel *level,
+                       guint         n_samples,
+                       guint         max_expired)
+{
+	gint *offsets;
+	guint *counts;
+	guint n_expired = 0;
+	gint i;
+
+	offsets = (gint *)level->offsets->data;
+	counts = (guint *)level->counts->data;
+	for (i = 0; i < level->offsets->len; i++) {
+		offsets[i] -= (gint)n_samples;
+		if (offsets[i] + (gint)counts[i] <= 0) {
+			n_expired++;
+		}
+	}
+
+	if (n_expired > max_expired) {
+		pk_model_level_remove_buckets(level, n_expired - max_expired);
+		n_expired = max_expired;
+	}
+	level->n_expired = n_expired;
+}
+
+
+/**
+ * pk_model_level_new_coarser:
+ * @finer: (in): A #PkModelLevel.
+ * @columns: (in): The columns of the model.
+ *
+ * Creates the level with buckets twice as wide as those of @finer by
+ * merging pairs of its buckets.  Since the buckets of both levels are
+ * aligned, every bucket of @finer falls within a single new bucket.  This
+ * keeps the history of expired samples that @finer holds on to.
+ *
+ * Returns: The newly created #PkModelLevel.
+ * Side effects: None.
+ */
+static PkModelLevel*
+pk_model_level_new_coarser (PkModelLevel *finer,
+                            GPtrArray    *columns)
+{
+	PkModelBucketStat *from;
+	PkModelBucketStat *stat;
+	PkModelColumn *column;
+	PkModelLevel *level;
+	GPtrArray *finer_sketches;
+	GPtrArray *sketches;
+	GArray *stats;
+	gboolean new_bucket;
+	gdouble time_;
+	gint64 key;
+	guint count;
+	guint b;
+	gint i;
+
+	level = pk_model_level_new(finer->width * 2.0);
+	pk_model_level_add_columns(finer, columns);
+	pk_model_level_add_columns(level, columns);
+
+	for (b = 0; b < finer->times->len; b++) {
+		time_ = g_array_index(finer->times, gdouble, b);
+		count = g_array_index(finer->counts, guint, b);
+		key = (gint64)floor(time_ / level->width);
+		new_bucket = (!level->times->len || key != level->last_key);
+		if (new_bucket) {
+			level->last_key = key;
+			g_array_append_val(level->times, time_);
+			g_array_append_val(level->offsets,
+			                   g_array_index(finer->offsets, gint, b));
+			g_array_append_val(level->counts, count);
+		} else {
+			g_array_index(level->counts, guint, level->counts->len - 1) +=
+				count;
+		}
+
+		for (i = 0; i < columns->len; i++) {
+			if (!(stats = g_ptr_array_index(level->stats, i))) {
+				continue;
+			}
+			from = &g_array_index((GArray *)g_ptr_array_index(finer->stats, i),
+			                      PkModelBucketStat, b);
+			if (new_bucket) {
+				g_array_append_vals(stats, from, 1);
+				continue;
+			}
+			stat = &g_array_index(stats, PkModelBucketStat, stats->len - 1);
+			stat->min = MIN(stat->min, from->min);
+			stat->max = MAX(stat->max, from->max);
+			stat->sum += from->sum;
+			stat->last = from->last;
+		}
+
+		/*
+		 * Sketches merge just like the stats, so sketched columns do not
+		 * need their samples, which may have expired.
+		 */
+		for (i = 0; i < finer->sketches->len; i++) {
+			finer_sketches = g_ptr_array_index(finer->sketches, i);
+			if (!finer_sketches || finer_sketches->len != finer->times->len) {
+				continue;
+			}
+			while (level->sketches->len <= i) {
+				g_ptr_array_add(level->sketches, NULL);
+			}
+			if (!(sketches = g_ptr_array_index(level->sketches, i))) {
+				sketches = g_ptr_array_new();
+				g_ptr_array_index(level->sketches, i) = sketches;
+			}
+			if (new_bucket) {
+				g_ptr_array_add(sketches,
+				                pk_sketch_new(PK_SKETCH_DEFAULT_ACCURACY));
+			}
+			pk_sketch_merge(g_ptr_array_index(sketches, sketches->len - 1),
+			                g_ptr_array_index(finer_sketches, b));
+		}
+	}
+
+	for (b = 0; b < level->times->len; b++) {
+		if (g_array_index(level->offsets, gint, b) +
+		    (gint)g_array_index(level->counts, guint, b) > 0) {
+			break;
+		}
+	}
+	level->n_expired = b;
+
+	for (i = 0; i < columns->len; i++) {
+		column = g_ptr_array_index(columns, i);
+		if (column->sketched) {
+			pk_model_level_build_sketches(level, column);
+		}
+	}
+
+	return level;
+}
+
+
+/**
+ * pk_model_columnar_plan_levels:
+ * @columnar: (in): A #PkModelColumnar.
+ *
+ * Creates the finest level of the pyramid from the mean interval of the
+ * samples inserted so far.  Finer levels would hold about one sample per
+ * bucket and be dropped anyway, so they are never created.
+ *
+ * Returns: %TRUE if the pyramid was started.
+ * Side effects: None.
+ */
+static gboolean
+pk_model_columnar_plan_levels (PkModelColumnar *columnar)
+{
+	PkModelColumnarPrivate *priv = columnar->priv;
+	PkModelLevel *level;
+	gdouble interval;
+	guint length;
+	guint i;
+	gint first;
+
+	if ((length = priv->times->len) < 2) {
+		return FALSE;
+	}
+
+	interval = (g_array_index(priv->times, gdouble, length - 1) -
+	            g_array_index(priv->times, gdouble, 0)) / (length - 1);
+	for (first = 0; first < PYRAMID_N_LEVELS - 1; first++) {
+		if (ldexp(1.0, first + PYRAMID_MIN_EXP) >= interval * 2.0) {
+			break;
+		}
+	}
+
+	level = pk_model_level_new(ldexp(1.0, first + PYRAMID_MIN_EXP));
+	for (i = 0; i < length; i++) {
+		pk_model_level_append(level, priv->columns,
+		                      g_array_index(priv->times, gdouble, i), i);
+	}
+	priv->levels[first] = level;
+	priv->coarsest = first;
+	return TRUE;
+}
+
+
+static void
+pk_model_columnar_rollup (PkModelColumnar *columnar,
+                          guint            index_)
+{
+	PkModelColumnarPrivate *priv = columnar->priv;
+	PkModelLevel *level;
+	gdouble time_;
+	gint i;
+
+	if (priv->coarsest < 0) {
+		if (priv->times->len >= PYRAMID_PLAN_SAMPLES) {
+			pk_model_columnar_plan_levels(columnar);
+		}
+		return;
+	}
+
+	time_ = g_array_index(priv->times, gdouble, index_);
+	for (i = 0; i <= priv->coarsest; i++) {
+		if ((level = priv->levels[i])) {
+			pk_model_level_append(level, priv->columns, time_, index_);
+		}
+	}
+}
+
+
+static void
+pk_model_columnar_prune_levels (PkModelColumnar *columnar)
+{
+	PkModelColumnarPrivate *priv = columnar->priv;
+	PkModelLevel *level;
+	gint i;
+
+	if (priv->times->len < PYRAMID_MIN_SAMPLES) {
+		return;
+	}
+
+	/*
+	 * A level that does not at least halve the number of items costs
+	 * more memory than it saves in iteration. Since the finer levels
+	 * always have more buckets, stop at the first level worth keeping.
+	 * The coarsest level is always kept so the pyramid can grow from it.
+	 */
+	for (i = 0; i < priv->coarsest; i++) {
+		if (!(level = priv->levels[i])) {
+			continue;
+		}
+		if ((level->times->len - level->n_expired) * 2 <= priv->times->len) {
+			break;
+		}
+		pk_model_level_free(level);
+		priv->levels[i] = NULL;
+	}
+}
+
+
+static gint
+pk_model_columnar_find_level (PkModelColumnar *columnar,
+                              gdouble          aggregate_time)
+{
+	PkModelColumnarPrivate *priv = columnar->priv;
+	gint i;
+
+	if (priv->coarsest < 0 && !pk_model_columnar_plan_levels(columnar)) {
+		return -1;
+	}
+
+	/*
+	 * Use the coarsest level whose buckets are no wider than requested,
+	 * creating it from the levels below if it does not exist yet. If
+	 * that level was dropped, the raw samples are just as good.
+	 */
+	for (i = PYRAMID_N_LEVELS - 1; i >= 0; i--) {
+		if (ldexp(1.0, i + PYRAMID_MIN_EXP) <= aggregate_time) {
+			break;
+		}
+	}
+	if (i < 0) {
+		return -1;
+	}
+	while (priv->coarsest < i) {
+		priv->levels[priv->coarsest + 1] =
+			pk_model_level_new_coarser(priv->levels[priv->coarsest],
+			                           priv->columns);
+		priv->coarsest++;
+	}
+	return priv->levels[i] ? i : -1;
+}
+
+
+static inline void
+set_iter (PkModelColumnar *columnar,
+          PkModelIter     *iter,
+          gint             level,
+          gint             index_,
+          gint             end_index)
+{
+	GArray *times = columnar->priv->times;
+
+	if (level >= 0) {
+		times = columnar->priv->levels[level]->times;
+	}
+	iter->time = g_array_index(times, gdouble, index_);
+	iter->user_data = GINT_TO_POINTER(index_);
+	iter->user_data2 = GINT_TO_POINTER(end_index);
+	iter->user_data3 = GINT_TO_POINTER(level + 1);
+}
+
+
+static void
+pk_model_columnar_set_manifest (PkModelColumnar *columnar,
+                                PkManifest      *manifest)
+{
+	PkModelColumnarPrivate *priv = columnar->priv;
+	PkModelColumn *column;
+	GQuark key;
+	gint n_rows;
+	gint i;
+
+	if (priv->manifest == manifest) {
+		return;
+	}
+
+	if (priv->manifest) {
+		pk_manifest_unref(priv->manifest);
+	}
+	priv->manifest = pk_manifest_ref(manifest);
+
+	n_rows = pk_manifest_get_n_rows(manifest);
+	g_ptr_array_set_size(priv->manifest_columns, 0);
+	for (i = 1; i <= n_rows; i++) {
+		key = g_quark_from_string(pk_manifest_get_row_name(manifest, i));
+		column = pk_model_columnar_get_or_create_column(
+				columnar, key, pk_manifest_get_row_type(manifest, i));
+		g_ptr_array_add(priv->manifest_columns,
+		                column->derived ? NULL : column);
+	}
+}
+
+
+static void
+pk_model_columnar_pad_columns (PkModelColumnar *columnar)
+{
+	PkModelColumnarPrivate *priv = columnar->priv;
+	PkModelColumn *column;
+	gint i;
+
+	/*
+	 * Columns that were not part of the manifest for the inserted samples
+	 * are padded with zeros to keep them aligned with the time array.
+	 */
+	for (i = 0; i < priv->columns->len; i++) {
+		column = g_ptr_array_index(priv->columns, i);
+		if (column->values->len < priv->times->len) {
+			g_array_set_size(column->values, priv->times->len);
+		}
+		pk_model_column_update_deltas(column);
+	}
+}
+
+
+static void
+pk_model_columnar_build (PkModelColumnar *columnar,
+                         PkModelColumn   *column,
+                         guint            index_)
+{
+	PkModelIter iter;
+	GValue value = { 0 };
+
+	memset(&iter, 0, sizeof iter);
+	set_iter(columnar, &iter, -1, index_, index_);
+	g_value_init(&value, G_TYPE_DOUBLE);
+	pk_model_build_value(PK_MODEL(columnar), &iter, column->key, &value);
+	g_array_index(column->values, gdouble, index_) = g_value_get_double(&value);
+	g_value_unset(&value);
+}
+
+
+/**
+ * pk_model_columnar_count_before:
+ * @columnar: (in): A #PkModelColumnar.
+ * @time_: (in): The time to search for.
+ * @inclusive: (in): If samples at @time_ should be counted.
+ *
+ * Counts the samples before @time_ using a binary search.  This is also
+ * the index of the first sample at or after @time_, or after @time_ if
+ * @inclusive is %TRUE.
+ *
+ * Returns: The number of samples.
+ * Side effects: None.
+ */
+static guint
+pk_model_columnar_count_before (PkModelColumnar *columnar,
+                                gdouble          time_,
+                                gboolean         inclusive)
+{
+	gdouble middle_time;
+	GArray *times = columnar->priv->times;
+	gint left = 0;
+	gint right = times->len;
+	gint middle;
+
+	while (left < right) {
+		middle = (left + right) / 2;
+		middle_time = g_array_index(times, gdouble, middle);
+		if (middle_time < time_ || (inclusive && middle_time == time_)) {
+			left = middle + 1;
+		} else {
+			right = middle;
+		}
+	}
+	return left;
+}
+
+
+/**
+ * pk_model_columnar_expire:
+ * @columnar: (in): A #PkModelColumnar.
+ *
+ * Removes the samples that fall outside of the retention policy of the
+ * model.  Samples are removed in batches of at least a quarter of the
+ * retained samples so that the cost of moving the arrays is amortized
+ * over many insertions.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_columnar_expire (PkModelColumnar *columnar)
+{
+	PkModelColumnarPrivate *priv = columnar->priv;
+	PkModelColumn *column;
+	gdouble max_age;
+	guint max_samples;
+	guint n_expired = 0;
+	guint length;
+	gint i;
+	gint j;
+
+	max_samples = pk_model_get_max_samples(PK_MODEL(columnar));
+	max_age = pk_model_get_max_age(PK_MODEL(columnar));
+	if (!(length = priv->times->len)) {
+		return;
+	}
+
+	if (max_samples && length > max_samples) {
+		n_expired = length - max_samples;
+	}
+	if (max_age > 0.0) {
+		n_expired = MAX(n_expired, pk_model_columnar_count_before(columnar,
+		                g_array_index(priv->times, gdouble, length - 1) - max_age,
+		                FALSE));
+	}
+	if (n_expired < MAX(EXPIRE_MIN_SAMPLES, length / 4)) {
+		return;
+	}
+
+	g_array_remove_range(priv->times, 0, n_expired);
+	for (i = 0; i < priv->columns->len; i++) {
+		column = g_ptr_array_index(priv->columns, i);
+		if (column->type == G_TYPE_STRING) {
+			for (j = 0; j < n_expired; j++) {
+				g_free(g_array_index(column->values, gchar*, j));
+			}
+		}
+		g_array_remove_range(column->values, 0, n_expired);
+		if (column->deltas) {
+			g_array_remove_range(column->deltas, 0, n_expired);
+		}
+		pk_model_column_reset_index(column);
+	}
+
+	for (i = 0; i < PYRAMID_N_LEVELS; i++) {
+		if (priv->levels[i]) {
+			pk_model_level_expire(priv->levels[i], n_expired,
+			                      priv->keep_rollups ? priv->times->len : 0);
+		}
+	}
+}
+
+
+static void
+pk_model_columnar_append_sample (PkModelColumnar *columnar,
+                                 PkSample        *sample)
+{
+	PkModelColumnarPrivate *priv = columnar->priv;
+	PkModelColumn *column;
+	gint i;
+
+	g_array_append_val(priv->times, sample->time);
+	for (i = 0; i < priv->manifest_columns->len; i++) {
+		if ((column = g_ptr_array_index(priv->manifest_columns, i))) {
+			pk_model_column_append(column, sample, i + 1);
+		}
+	}
+	pk_model_columnar_pad_columns(columnar);
+
+	/*
+	 * Builders may read any other field, including counter deltas, so
+	 * they run once the sample is otherwise complete.
+	 */
+	for (i = 0; i < priv->derived->len; i++) {
+		pk_model_columnar_build(columnar,
+		                        g_ptr_array_index(priv->derived, i),
+		                        priv->times->len - 1);
+	}
+	for (i = 0; i < priv->columns->len; i++) {
+		pk_model_column_update_index(g_ptr_array_index(priv->columns, i));
+	}
+	pk_model_columnar_rollup(columnar, priv->times->len - 1);
+}
+
+
+static void
+pk_model_columnar_insert_manifest (PkModel    *model,
+                                   PkManifest *manifest)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+
+	g_return_if_fail(PK_IS_MODEL_COLUMNAR(columnar));
+
+	pk_model_columnar_set_manifest(columnar, manifest);
+}
+
+
+static void
+pk_model_columnar_insert_sample (PkModel    *model,
+                                 PkManifest *manifest,
+                                 PkSample   *sample)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+
+	g_return_if_fail(PK_IS_MODEL_COLUMNAR(columnar));
+
+	pk_model_columnar_set_manifest(columnar, manifest);
+	pk_model_columnar_append_sample(columnar, sample);
+	pk_model_columnar_expire(columnar);
+	pk_model_columnar_prune_levels(columnar);
+}
+
+
+static void
+pk_model_columnar_insert_samples (PkModel     *model,
+                                  PkManifest  *manifest,
+                                  PkSample   **samples,
+                                  guint        n_samples)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelColumnarPrivate *priv;
+	PkModelColumn *column;
+	guint length;
+	guint i;
+
+	g_return_if_fail(PK_IS_MODEL_COLUMNAR(columnar));
+
+	priv = columnar->priv;
+
+	pk_model_columnar_set_manifest(columnar, manifest);
+
+	/*
+	 * Reserve space in every array once for the whole batch.
+	 */
+	length = priv->times->len;
+	g_array_set_size(priv->times, length + n_samples);
+	g_array_set_size(priv->times, length);
+	for (i = 0; i < priv->columns->len; i++) {
+		column = g_ptr_array_index(priv->columns, i);
+		g_array_set_size(column->values, length + n_samples);
+		g_array_set_size(column->values, length);
+	}
+
+	for (i = 0; i < n_samples; i++) {
+		pk_model_columnar_append_sample(columnar, samples[i]);
+	}
+	pk_model_columnar_expire(columnar);
+	pk_model_columnar_prune_levels(columnar);
+}
+
+
+static gint
+pk_model_columnar_find_nearest (const gdouble *times,
+                                gint           n_times,
+                                gdouble        target_time,
+                                gdouble        other_time,
+                                gboolean       prefer_right)
+{
+	gint left = 0;
+	gint middle = 0;
+	gint right;
+
+	/*
+	 * If we have no samples stored, we can immediately fail.
+	 */
+	if (!n_times) {
+		return -1;
+	}
+
+	right = n_times - 1;
+
+	/*
+	 * Binary search the time array. This matches the semantics of the
+	 * memory model; see pk_model_memory_find_nearest_sample().
+	 */
+	while (left <= right) {
+		middle = (left + right) / 2;
+		if (times[middle] < target_time) {
+			left = middle + 1;
+		} else if (times[middle] > target_time) {
+			right = middle - 1;
+		} else {
+			break;
+		}
+	}
+
+	if (!prefer_right) {
+		while (middle >= 0 && times[middle] >= target_time) {
+			middle--;
+		}
+		if (middle < 0) {
+			if (times[0] < other_time) {
+				return 0;
+			}
+			return -1;
+		}
+		return middle;
+	} else {
+		while (middle < n_times && times[middle] <= target_time) {
+			middle++;
+		}
+		if (middle >= n_times) {
+			if (times[n_times - 1] > other_time) {
+				return n_times - 1;
+			}
+			return -1;
+		}
+		return middle;
+	}
+}
+
+
+static inline PkModelLevel*
+get_iter_level (PkModelColumnar *columnar,
+                PkModelIter     *iter)
+{
+	gint level = GPOINTER_TO_INT(iter->user_data3) - 1;
+
+	if (level < 0) {
+		return NULL;
+	}
+	return columnar->priv->levels[level];
+}
+
+
+static gboolean
+pk_model_columnar_get_iter_first (PkModel     *model,
+                                  PkModelIter *iter)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelColumnarPrivate *priv;
+
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), FALSE);
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	priv = columnar->priv;
+
+	memset(iter, 0, sizeof *iter);
+	if (!priv->times->len) {
+		return FALSE;
+	}
+	set_iter(columnar, iter, -1, 0, priv->times->len - 1);
+	return TRUE;
+}
+
+
+static gboolean
+pk_model_columnar_get_iter_for_range (PkModel     *model,
+                                      PkModelIter *iter,
+                                      gdouble      begin_time,
+                                      gdouble      end_time,
+                                      gdouble      aggregate_time)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelColumnarPrivate *priv;
+	GArray *times;
+	gint level_idx = -1;
+	gint begin_idx;
+	gint end_idx;
+
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), FALSE);
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	priv = columnar->priv;
+
+	memset(iter, 0, sizeof *iter);
+
+	/*
+	 * Iterate the rollup buckets instead of raw samples if a level
+	 * satisfies the requested aggregate time.
+	 */
+	times = priv->times;
+	if (aggregate_time > 0.0) {
+		level_idx = pk_model_columnar_find_level(columnar, aggregate_time);
+		if (level_idx >= 0) {
+			times = priv->levels[level_idx]->times;
+		}
+	}
+
+	begin_idx =
+		pk_model_columnar_find_nearest((const gdouble *)times->data,
+		                               times->len, begin_time,
+		                               end_time, FALSE);
+	end_idx =
+		pk_model_columnar_find_nearest((const gdouble *)times->data,
+		                               times->len, end_time,
+		                               begin_time, TRUE);
+	if (begin_idx < 0 || end_idx < 0) {
+		return FALSE;
+	}
+
+	set_iter(columnar, iter, level_idx, begin_idx, end_idx);
+	return TRUE;
+}
+
+
+static gboolean
+pk_model_columnar_iter_next (PkModel     *model,
+                             PkModelIter *iter)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	gint index_;
+	gint end_index;
+
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), FALSE);
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	index_ = GPOINTER_TO_INT(iter->user_data);
+	end_index = GPOINTER_TO_INT(iter->user_data2);
+
+	if (++index_ <= end_index) {
+		set_iter(columnar, iter, GPOINTER_TO_INT(iter->user_data3) - 1,
+		         index_, end_index);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+
+/**
+ * pk_model_columnar_reduce:
+ * @model: (in): A #PkModelColumnar.
+ * @iter: (in): A #PkModelIter.
+ * @key: (in): The field to reduce.
+ * @stats: (out): A location for the statistics.
+ *
+ * Reduces the samples of @key from @iter to the end of its range straight
+ * from the column, or its counter deltas, and moves @iter to the end of
+ * the range.  Buckets and strings are left to the caller.
+ *
+ * Returns: %TRUE if @stats was filled in.
+ * Side effects: None.
+ */
+static gboolean
+pk_model_columnar_reduce (PkModel      *model,
+                          PkModelIter  *iter,
+                          GQuark        key,
+                          PkModelStats *stats)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelColumn *column;
+	gint end_index;
+	gint index_;
+	guint n_values;
+
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), FALSE);
+
+	if (!(column = g_hash_table_lookup(columnar->priv->columns_by_key,
+	                                   GUINT_TO_POINTER(key))) ||
+	    column->type == G_TYPE_STRING ||
+	    get_iter_level(columnar, iter)) {
+		return FALSE;
+	}
+
+	index_ = GPOINTER_TO_INT(iter->user_data);
+	end_index = GPOINTER_TO_INT(iter->user_data2);
+	n_values = end_index - index_ + 1;
+
+#define REDUCE(_name, _type) \
+	pk_model_reduce_##_name(&g_array_index(column->values, _type, index_), \
+	                        NULL, n_values, stats)
+
+	if (column->deltas) {
+		pk_model_reduce_double(&g_array_index(column->deltas, gdouble,
+		                                      index_),
+		                       NULL, n_values, stats);
+	} else {
+		switch (column->type) {
+		case G_TYPE_DOUBLE:
+			REDUCE(double, gdouble);
+			break;
+		case G_TYPE_FLOAT:
+			REDUCE(float, gfloat);
+			break;
+		case G_TYPE_INT:
+			REDUCE(int, gint32);
+			break;
+		case G_TYPE_UINT:
+			REDUCE(uint, guint32);
+			break;
+		case G_TYPE_INT64:
+			REDUCE(int64, gint64);
+			break;
+		case G_TYPE_UINT64:
+			REDUCE(uint64, guint64);
+			break;
+		default:
+			return FALSE;
+		}
+	}
+
+#undef REDUCE
+
+	set_iter(columnar, iter, -1, end_index, end_index);
+	return TRUE;
+}
+
+
+static gdouble
+pk_model_column_get_bucket_mean (PkModelColumn *column,
+                                 PkModelLevel  *level,
+                                 guint          bucket)
+{
+	PkModelBucketStat *stat;
+	GArray *stats;
+	gdouble prev;
+	guint count;
+
+	count = g_array_index(level->counts, guint, bucket);
+	stats = g_ptr_array_index(level->stats, column->index);
+	stat = &g_array_index(stats, PkModelBucketStat, bucket);
+
+	/*
+	 * The per-sample deltas of a counter sum up to the difference
+	 * between the last sample and the one before the bucket, which is
+	 * the last sample of the previous bucket. This only uses the stats
+	 * so that it works for buckets whose samples have expired.
+	 */
+	if (column->mode == PK_MODEL_COUNTER) {
+		prev = bucket ? g_array_index(stats, PkModelBucketStat, bucket - 1).last
+		              : stat->first;
+		return (stat->last - prev) / count;
+	}
+
+	return stat->sum / count;
+}
+
+
+static void
+pk_model_columnar_get_value (PkModel     *model,
+                             PkModelIter *iter,
+                             GQuark       key,
+                             GValue      *value)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelColumn *column;
+	PkModelLevel *level;
+	GValue delta = { 0 };
+	gint index_;
+	guint bucket;
+
+	g_return_if_fail(PK_IS_MODEL_COLUMNAR(columnar));
+
+	if (!(column = g_hash_table_lookup(columnar->priv->columns_by_key,
+	                                   GUINT_TO_POINTER(key)))) {
+		return;
+	}
+
+	index_ = GPOINTER_TO_INT(iter->user_data);
+
+	/*
+	 * Buckets report the mean of their numeric samples, and the last
+	 * value of strings if it has not expired.
+	 */
+	if ((level = get_iter_level(columnar, iter))) {
+		bucket = index_;
+		index_ = g_array_index(level->offsets, gint, bucket) +
+		         g_array_index(level->counts, guint, bucket) - 1;
+		if (column->type == G_TYPE_STRING && index_ < 0) {
+			return;
+		}
+		if (column->type != G_TYPE_STRING) {
+			g_value_init(&delta, G_TYPE_DOUBLE);
+			g_value_set_double(&delta,
+			                   pk_model_column_get_bucket_mean(
+			                       column, level, bucket));
+			g_value_transform(&delta, value);
+			g_value_unset(&delta);
+			return;
+		}
+	}
+
+	g_assert_cmpint(index_, <, column->values->len);
+
+	if (column->mode == PK_MODEL_COUNTER) {
+		if (index_ == 0) {
+			/*
+			 * Can't calculate value on first item.
+			 */
+			g_value_reset(value);
+		} else {
+			g_value_init(&delta, G_TYPE_DOUBLE);
+			g_value_set_double(&delta,
+			                   pk_model_column_get_sample(column, index_));
+			g_value_transform(&delta, value);
+			g_value_unset(&delta);
+		}
+		return;
+	}
+
+	pk_model_column_get_value(column, index_, value);
+}
+
+
+static gdouble
+pk_model_columnar_get_aggregate (PkModel          *model,
+                                 PkModelIter      *iter,
+                                 GQuark            key,
+                                 PkModelAggregate  aggregate)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelBucketStat *stat;
+	PkModelColumn *column;
+	PkModelLevel *level;
+	GArray *stats;
+	gint offset;
+	guint count;
+	gint index_;
+
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), 0.0);
+
+	if (!(column = g_hash_table_lookup(columnar->priv->columns_by_key,
+	                                   GUINT_TO_POINTER(key)))) {
+		return 0.0;
+	}
+
+	index_ = GPOINTER_TO_INT(iter->user_data);
+
+	if (!(level = get_iter_level(columnar, iter))) {
+		if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+			return 1.0;
+		}
+		return pk_model_column_get_sample(column, index_);
+	}
+
+	offset = g_array_index(level->offsets, gint, index_);
+	count = g_array_index(level->counts, guint, index_);
+	stats = g_ptr_array_index(level->stats, column->index);
+
+	switch (aggregate) {
+	case PK_MODEL_AGGREGATE_COUNT:
+		return count;
+	case PK_MODEL_AGGREGATE_SUM:
+		if (column->type == G_TYPE_STRING) {
+			return 0.0;
+		}
+		return pk_model_column_get_bucket_mean(column, level, index_) * count;
+	case PK_MODEL_AGGREGATE_FIRST:
+	case PK_MODEL_AGGREGATE_LAST:
+		if (column->type == G_TYPE_STRING) {
+			return 0.0;
+		}
+		stat = &g_array_index(stats, PkModelBucketStat, index_);
+		if (column->mode != PK_MODEL_COUNTER) {
+			return (aggregate == PK_MODEL_AGGREGATE_FIRST) ? stat->first
+			                                               : stat->last;
+		}
+		/*
+		 * Counter deltas need the raw samples, which may have expired.
+		 */
+		if (aggregate == PK_MODEL_AGGREGATE_LAST) {
+			offset += count - 1;
+		}
+		if (offset >= 0) {
+			return pk_model_column_get_sample(column, offset);
+		}
+		return pk_model_column_get_bucket_mean(column, level, index_);
+	case PK_MODEL_AGGREGATE_MIN:
+	case PK_MODEL_AGGREGATE_MAX:
+		/*
+		 * Buckets keep the extremes of the stored values, not of the
+		 * deltas, so counters only have their mean available.
+		 */
+		if (column->type != G_TYPE_STRING &&
+		    column->mode != PK_MODEL_COUNTER) {
+			stat = &g_array_index(stats, PkModelBucketStat, index_);
+			return (aggregate == PK_MODEL_AGGREGATE_MIN) ? stat->min
+			                                             : stat->max;
+		}
+		/* fall through */
+	case PK_MODEL_AGGREGATE_MEAN:
+	default:
+		if (column->type == G_TYPE_STRING) {
+			return 0.0;
+		}
+		return pk_model_column_get_bucket_mean(column, level, index_);
+	}
+}
+
+
+static gdouble
+pk_model_columnar_get_quantile (PkModel     *model,
+                                PkModelIter *iter,
+                                GQuark       key,
+                                gdouble      quantile)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelColumn *column;
+	PkModelLevel *level;
+	GPtrArray *sketches;
+	PkSketch *sketch;
+	gint index_;
+
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), 0.0);
+
+	if (!(column = g_hash_table_lookup(columnar->priv->columns_by_key,
+	                                   GUINT_TO_POINTER(key))) ||
+	    column->type == G_TYPE_STRING) {
+		return 0.0;
+	}
+
+	index_ = GPOINTER_TO_INT(iter->user_data);
+	if (!(level = get_iter_level(columnar, iter))) {
+		return pk_model_column_get_sample(column, index_);
+	}
+
+	/*
+	 * Without a sketch, the mean is the best estimate we have.
+	 */
+	if (column->index < level->sketches->len &&
+	    (sketches = g_ptr_array_index(level->sketches, column->index)) &&
+	    index_ < sketches->len) {
+		sketch = g_ptr_array_index(sketches, index_);
+		if (pk_sketch_get_count(sketch)) {
+			return pk_sketch_get_quantile(sketch, quantile);
+		}
+	}
+	return pk_model_column_get_bucket_mean(column, level, index_);
+}
+
+
+static gdouble
+pk_model_columnar_get_range_aggregate (PkModel          *model,
+                                       GQuark            key,
+                                       gdouble           begin_time,
+                                       gdouble           end_time,
+                                       PkModelAggregate  aggregate)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelColumn *column;
+	PkModelExtent extent;
+	gdouble sum;
+	guint begin;
+	guint end;
+
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), 0.0);
+
+	if (!(column = g_hash_table_lookup(columnar->priv->columns_by_key,
+	                                   GUINT_TO_POINTER(key)))) {
+		return 0.0;
+	}
+
+	begin = pk_model_columnar_count_before(columnar, begin_time, FALSE);
+	end = pk_model_columnar_count_before(columnar, end_time, TRUE);
+	if (begin >= end) {
+		return 0.0;
+	}
+	if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+		return end - begin;
+	}
+	if (!column->prefix) {
+		return 0.0;
+	}
+
+	switch (aggregate) {
+	case PK_MODEL_AGGREGATE_FIRST:
+		return pk_model_column_get_sample(column, begin);
+	case PK_MODEL_AGGREGATE_LAST:
+		return pk_model_column_get_sample(column, end - 1);
+	case PK_MODEL_AGGREGATE_MIN:
+	case PK_MODEL_AGGREGATE_MAX:
+		pk_model_column_get_extent(column, begin, end, &extent);
+		return (aggregate == PK_MODEL_AGGREGATE_MIN) ? extent.min
+		                                             : extent.max;
+	case PK_MODEL_AGGREGATE_SUM:
+	case PK_MODEL_AGGREGATE_MEAN:
+	default:
+		sum = g_array_index(column->prefix, gdouble, end) -
+		      g_array_index(column->prefix, gdouble, begin);
+		if (aggregate == PK_MODEL_AGGREGATE_SUM) {
+			return sum;
+		}
+		return sum / (end - begin);
+	}
+}
+
+
+static void
+pk_model_columnar_set_field_mode (PkModel     *model,
+                                  GQuark       key,
+                                  PkModelMode  mode)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelColumnarPrivate *priv;
+	PkModelColumn *column;
+
+	g_return_if_fail(PK_IS_MODEL_COLUMNAR(columnar));
+
+	priv = columnar->priv;
+
+	g_hash_table_insert(priv->modes, GUINT_TO_POINTER(key),
+	                    GINT_TO_POINTER(mode));
+	if ((column = g_hash_table_lookup(priv->columns_by_key,
+	                                  GUINT_TO_POINTER(key))) &&
+	    !column->derived) {
+		pk_model_column_set_mode(column, mode);
+	}
+}
+
+
+static void
+pk_model_columnar_builder_added (PkModel *model,
+                                 GQuark   key)
+{
+	PkModelColumnar *columnar = (PkModelColumnar *)model;
+	PkModelColumnarPrivate *priv;
+	PkModelColumn *column;
+	guint i;
+
+	g_return_if_fail(PK_IS_MODEL_COLUMNAR(columnar));
+
+	priv = columnar->priv;
+
+	/*
+	 * A builder replacing a field that is stored already is left to be
+	 * evaluated on read.
+	 */
+	if (g_hash_table_lookup(priv->columns_by_key, GUINT_TO_POINTER(key))) {
+		return;
+	}
+
+	column = pk_model_columnar_get_or_create_column(columnar, key,
+	                                                G_TYPE_DOUBLE);
+	column->derived = TRUE;
+	g_ptr_array_add(priv->derived, column);
+	pk_model_set_materialized(model, key);
+
+	/*
+	 * Fill in the samples that were inserted before the builder, and the
+	 * rollup buckets that already cover them.
+	 */
+	for (i = 0; i < priv->times->len; i++) {
+		pk_model_columnar_build(columnar, column, i);
+	}
+	pk_model_column_reset_index(column);
+	for (i = 0; i < PYRAMID_N_LEVELS; i++) {
+		if (priv->levels[i]) {
+			pk_model_level_restat(priv->levels[i], priv->columns, column);
+		}
+	}
+}
+
+
+/**
+ * pk_model_columnar_get_length:
+ * @columnar: (in): A #PkModelColumnar.
+ *
+ * Retrieves the number of samples stored in the model.  This is the
+ * length of the arrays returned from pk_model_columnar_get_times() and
+ * pk_model_columnar_get_column().
+ *
+ * Returns: The number of samples.
+ * Side effects: None.
+ */
+guint
+pk_model_columnar_get_length (PkModelColumnar *columnar)
+{
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), 0);
+	return columnar->priv->times->len;
+}
+
+
+/**
+ * pk_model_columnar_get_times:
+ * @columnar: (in): A #PkModelColumnar.
+ *
+ * Retrieves the sorted array of sample times.  The index of a time in
+ * the array matches the index of its values in each column, and the
+ * iterators of this model.  The array is owned by the model and is only
+ * valid until the next insertion.
+ *
+ * Returns: An array of pk_model_columnar_get_length() times.
+ * Side effects: None.
+ */
+const gdouble*
+pk_model_columnar_get_times (PkModelColumnar *columnar)
+{
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), NULL);
+	return (const gdouble *)columnar->priv->times->data;
+}
+
+
+/**
+ * pk_model_columnar_get_column:
+ * @columnar: (in): A #PkModelColumnar.
+ * @key: (in): The field to retrieve.
+ * @type: (out): A location for the element type of the column.
+ *
+ * Retrieves the raw array of values stored for @key.  The elements are
+ * of C type matching @type; gint32 for %G_TYPE_INT, gdouble for
+ * %G_TYPE_DOUBLE, and so on.  Field modes are not applied.  Registered
+ * builders are available as %G_TYPE_DOUBLE columns.
+ * The array is owned by the model and is only valid until the next
+ * insertion.
+ *
+ * Returns: The column array, or %NULL if @key is unknown.
+ * Side effects: None.
+ */
+gconstpointer
+pk_model_columnar_get_column (PkModelColumnar *columnar,
+                              GQuark           key,
+                              GType           *type)
+{
+	PkModelColumn *column;
+
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), NULL);
+
+	if (!(column = g_hash_table_lookup(columnar->priv->columns_by_key,
+	                                   GUINT_TO_POINTER(key)))) {
+		return NULL;
+	}
+	if (type) {
+		*type = column->type;
+	}
+	return column->values->data;
+}
+
+
+/**
+ * pk_model_columnar_add_sketch:
+ * @columnar: (in): A #PkModelColumnar.
+ * @key: (in): The field to sketch.
+ *
+ * Keeps a quantile sketch of @key for every rollup bucket, so that
+ * pk_model_get_quantile() can report percentiles such as the p99 of each
+ * bucket at any zoom level without scanning the raw samples.  Sketches
+ * are kept along with rollups of expired samples.  Buckets that exist
+ * already are sketched from the samples still in the model.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_columnar_add_sketch (PkModelColumnar *columnar,
+                              GQuark           key)
+{
+	PkModelColumnarPrivate *priv;
+	PkModelColumn *column;
+	gint i;
+
+	g_return_if_fail(PK_IS_MODEL_COLUMNAR(columnar));
+	g_return_if_fail(key > 0);
+
+	priv = columnar->priv;
+
+	g_hash_table_insert(priv->sketched, GUINT_TO_POINTER(key),
+	                    GINT_TO_POINTER(TRUE));
+	if (!(column = g_hash_table_lookup(priv->columns_by_key,
+	                                   GUINT_TO_POINTER(key))) ||
+	    column->sketched || column->type == G_TYPE_STRING) {
+		return;
+	}
+
+	column->sketched = TRUE;
+	for (i = 0; i < PYRAMID_N_LEVELS; i++) {
+		if (priv->levels[i]) {
+			pk_model_level_build_sketches(priv->levels[i], column);
+		}
+	}
+}
+
+
+/**
+ * pk_model_columnar_get_keep_rollups:
+ * @columnar: (in): A #PkModelColumnar.
+ *
+ * Retrieves whether rollups of expired samples are kept.  See
+ * pk_model_columnar_set_keep_rollups().
+ *
+ * Returns: %TRUE if rollups are kept.
+ * Side effects: None.
+ */
+gboolean
+pk_model_columnar_get_keep_rollups (PkModelColumnar *columnar)
+{
+	g_return_val_if_fail(PK_IS_MODEL_COLUMNAR(columnar), FALSE);
+	return columnar->priv->keep_rollups;
+}
+
+
+/**
+ * pk_model_columnar_set_keep_rollups:
+ * @columnar: (in): A #PkModelColumnar.
+ * @keep_rollups: (in): If rollups of expired samples should be kept.
+ *
+ * When the model has a retention policy (see pk_model_set_retention()),
+ * samples that expire are normally dropped along with their rollups.  If
+ * @keep_rollups is %TRUE, the rollups are kept instead so that older
+ * samples are still available, downsampled, to range queries with a
+ * large enough aggregate time.  Each rollup level keeps at most as many
+ * expired buckets as there are retained samples.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_columnar_set_keep_rollups (PkModelColumnar *columnar,
+                                    gboolean         keep_rollups)
+{
+	g_return_if_fail(PK_IS_MODEL_COLUMNAR(columnar));
+	columnar->priv->keep_rollups = keep_rollups;
+}
+
+
+/**
+ * pk_model_columnar_finalize:
+ * @object: (in): A #PkModelColumnar.
+ *
+ * Finalizer for a #PkModelColumnar instance.  Frees any resources held by
+ * the instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_columnar_finalize (GObject *object)
+{
+	PkModelColumnarPrivate *priv = PK_MODEL_COLUMNAR(object)->priv;
+	gint i;
+
+	for (i = 0; i < PYRAMID_N_LEVELS; i++) {
+		if (priv->levels[i]) {
+			pk_model_level_free(priv->levels[i]);
+			priv->levels[i] = NULL;
+		}
+	}
+
+	if (priv->manifest) {
+		pk_manifest_unref(priv->manifest);
+		priv->manifest = NULL;
+	}
+	g_ptr_array_free(priv->manifest_columns, TRUE);
+	priv->manifest_columns = NULL;
+
+	g_hash_table_destroy(priv->columns_by_key);
+	priv->columns_by_key = NULL;
+
+	g_ptr_array_free(priv->derived, TRUE);
+	priv->derived = NULL;
+
+	g_ptr_array_foreach(priv->columns, (GFunc)pk_model_column_free, NULL);
+	g_ptr_array_free(priv->columns, TRUE);
+	priv->columns = NULL;
+
+	g_array_free(priv->times, TRUE);
+	priv->times = NULL;
+
+	g_hash_table_destroy(priv->modes);
+	priv->modes = NULL;
+
+	g_hash_table_destroy(priv->sketched);
+	priv->sketched = NULL;
+
+	G_OBJECT_CLASS(pk_model_columnar_parent_class)->finalize(object);
+}
+
+
+/**
+ * pk_model_columnar_class_init:
+ * @klass: (in): A #PkModelColumnarClass.
+ *
+ * Initializes the #PkModelColumnarClass and prepares the vtable.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_columnar_class_init (PkModelColumnarClass *klass)
+{
+	GObjectClass *object_class;
+	PkModelClass *model_class;
+
+	object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = pk_model_columnar_finalize;
+	g_type_class_add_private(object_class, sizeof(PkModelColumnarPrivate));
+
+	model_class = PK_MODEL_CLASS(klass);
+	model_class->builder_added = pk_model_columnar_builder_added;
+	model_class->get_aggregate = pk_model_columnar_get_aggregate;
+	model_class->get_iter_first = pk_model_columnar_get_iter_first;
+	model_class->get_iter_for_range = pk_model_columnar_get_iter_for_range;
+	model_class->get_quantile = pk_model_columnar_get_quantile;
+	model_class->get_range_aggregate = pk_model_columnar_get_range_aggregate;
+	model_class->get_value = pk_model_columnar_get_value;
+	model_class->insert_manifest = pk_model_columnar_insert_manifest;
+	model_class->insert_sample = pk_model_columnar_insert_sample;
+	model_class->insert_samples = pk_model_columnar_insert_samples;
+	model_class->iter_next = pk_model_columnar_iter_next;
+	model_class->reduce = pk_model_columnar_reduce;
+	model_class->set_field_mode = pk_model_columnar_set_field_mode;
+}
+
+
+/**
+ * pk_model_columnar_init:
+ * @columnar: (in): A #PkModelColumnar.
+ *
+ * Initializes the newly created #PkModelColumnar instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_columnar_init (PkModelColumnar *columnar)
+{
+	columnar->priv = G_TYPE_INSTANCE_GET_PRIVATE(columnar,
+	                                             PK_TYPE_MODEL_COLUMNAR,
+	                                             PkModelColumnarPrivate);
+
+	columnar->priv->times = g_array_sized_new(FALSE, FALSE,
+	                                          sizeof(gdouble), 16);
+	columnar->priv->columns = g_ptr_array_new();
+	columnar->priv->columns_by_key = g_hash_table_new(g_direct_hash,
+	                                                  g_direct_equal);
+	columnar->priv->modes = g_hash_table_new(g_direct_hash, g_direct_equal);
+	columnar->priv->sketched = g_hash_table_new(g_direct_hash, g_direct_equal);
+	columnar->priv->manifest_columns = g_ptr_array_new();
+	columnar->priv->derived = g_ptr_array_new();
+	columnar->priv->coarsest = -1;
+}
@@ -0,0 +1,65 @@
+/* pk-model-columnar.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PK_MODEL_COLUMNAR_H
+#define PK_MODEL_COLUMNAR_H
+
+#include "pk-model.h"
+
+G_BEGIN_DECLS
+
+#define PK_TYPE_MODEL_COLUMNAR            (pk_model_columnar_get_type())
+#define PK_MODEL_COLUMNAR(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), PK_TYPE_MODEL_COLUMNAR, PkModelColumnar))
+#define PK_MODEL_COLUMNAR_CONST(obj)      (G_TYPE_CHECK_INSTANCE_CAST ((obj), PK_TYPE_MODEL_COLUMNAR, PkModelColumnar const))
+#define PK_MODEL_COLUMNAR_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  PK_TYPE_MODEL_COLUMNAR, PkModelColumnarClass))
+#define PK_IS_MODEL_COLUMNAR(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), PK_TYPE_MODEL_COLUMNAR))
+#define PK_IS_MODEL_COLUMNAR_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  PK_TYPE_MODEL_COLUMNAR))
+#define PK_MODEL_COLUMNAR_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  PK_TYPE_MODEL_COLUMNAR, PkModelColumnarClass))
+
+typedef struct _PkModelColumnar        PkModelColumnar;
+typedef struct _PkModelColumnarClass   PkModelColumnarClass;
+typedef struct _PkModelColumnarPrivate PkModelColumnarPrivate;
+
+struct _PkModelColumnar
+{
+	PkModel parent;
+
+	/*< private >*/
+	PkModelColumnarPrivate *priv;
+};
+
+struct _PkModelColumnarClass
+{
+	PkModelClass parent_class;
+};
+
+GType          pk_model_columnar_get_type         (void) G_GNUC_CONST;
+void           pk_model_columnar_add_sketch       (PkModelColumnar *columnar,
+                                                   GQuark           key);
+gconstpointer  pk_model_columnar_get_column       (PkModelColumnar *columnar,
+                                                   GQuark           key,
+                                                   GType           *type);
+gboolean       pk_model_columnar_get_keep_rollups (PkModelColumnar *columnar);
+guint          pk_model_columnar_get_length       (PkModelColumnar *columnar);
+const gdouble* pk_model_columnar_get_times        (PkModelColumnar *columnar);
+void           pk_model_columnar_set_keep_rollups (PkModelColumnar *columnar,
+                                                   gboolean         keep_rollups);
+
+G_END_DECLS
+
+#endif /* PK_MODEL_COLUMNAR_H */
@@ -0,0 +1,1904 @@
+/* pk-model-compressed.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "pk-log.h"
+#include "pk-model-compressed.h"
+
+/*
+ * PkModelCompressed keeps samples in memory in a compressed form, for long
+ * captures where even PkModelColumnar uses too much memory.
+ *
+ * Samples are appended to a raw tail chunk with the same layout as the
+ * tail of PkModelMapped. Once the tail holds CHUNK_N_SAMPLES samples it
+ * is sealed; every column is bit-packed and the raw arrays are freed.
+ *
+ *  - Integer columns store the delta of each delta, which is zero for a
+ *    steady counter and small for most gauges, in a variable number of
+ *    bits.
+ *  - Floating point columns store the XOR of each value with the previous
+ *    one, as described for Gorilla, so repeated and slowly changing
+ *    values take a handful of bits.
+ *  - Times are converted back to the whole microseconds or nanoseconds
+ *    they were created from (see pk_sample_decode_timespec()) and packed
+ *    like integers. Chunks with times that do not convert back exactly
+ *    are XOR packed instead.
+ *
+ * Sealed chunks are unpacked on demand. The unpacked chunks are kept in a
+ * small LRU so that walking a range only unpacks each chunk once. Reading
+ * a sample therefore modifies the model, so every reader must hold
+ * pk_model_lock(), even on the main loop where samples are inserted.
+ *
+ * Every column of a sealed chunk also keeps the min, max, sum, first and
+ * last of its values. Iters with an aggregate time step over whole chunks
+ * and answer from these without unpacking anything.
+ *
+ * Iterators are a global sample index, counted across all chunks. String
+ * fields are not stored. Retention expires whole sealed chunks.
+ */
+
+
+#define CHUNK_N_SAMPLES (1024)
+#define CACHE_N_CHUNKS  (8)
+#define NSEC_PER_SEC    (G_GINT64_CONSTANT(1000000000))
+
+
+typedef struct
+{
+	GByteArray *bytes;
+	guint       n_bits; /* Bits used in the last byte */
+} PkBitWriter;
+
+
+typedef struct
+{
+	const guint8 *data;
+	gsize         pos;  /* Position in bits */
+} PkBitReader;
+
+
+typedef struct
+{
+	gdouble min;
+	gdouble max;
+	gdouble sum;
+	gdouble first;
+	gdouble last;
+} PkPackedStat;
+
+
+typedef struct
+{
+	GQuark       key;
+	GType        type;
+	gpointer     values;     /* Raw values, or NULL if not unpacked */
+	guint8      *packed;     /* Packed values once sealed */
+	gsize        packed_len;
+	PkPackedStat stat;       /* Summary of the values once sealed */
+} PkPackedColumn;
+
+
+typedef struct
+{
+	guint    first;       /* Global index of the first sample */
+	guint    n_samples;
+	gdouble  begin_time;
+	gdouble  end_time;
+	gboolean sealed;
+	gdouble *times;       /* Raw times, or NULL if not unpacked */
+	guint8  *packed_times;
+	gsize    packed_times_len;
+	gint64   time_unit;   /* Nanoseconds per packed time, or 0 for XOR */
+	GArray  *columns;     /* Array of PkPackedColumn */
+	GList   *cached;      /* Link within the LRU if unpacked */
+} PkPackedChunk;
+
+
+struct _PkModelCompressedPrivate
+{
+	GPtrArray     *chunks;
+	PkPackedChunk *tail;
+	GQueue        *cache;
+	GHashTable    *modes;
+	GArray        *builders;
+
+	/*
+	 * Index into the tail's columns for each row of the current manifest.
+	 */
+	PkManifest    *manifest;
+	GArray        *manifest_columns;
+};
+
+
+G_DEFINE_TYPE(PkModelCompressed, pk_model_compressed, PK_TYPE_MODEL)
+
+
+static void
+pk_bit_writer_write (PkBitWriter *writer,
+                     guint64      value,
+                     guint        n_bits)
+{
+	guint8 zero = 0;
+	guint free_bits;
+	guint n;
+
+	while (n_bits) {
+		if (!writer->bytes->len || writer->n_bits == 8) {
+			g_byte_array_append(writer->bytes, &zero, 1);
+			writer->n_bits = 0;
+		}
+		free_bits = 8 - writer->n_bits;
+		n = MIN(free_bits, n_bits);
+		writer->bytes->data[writer->bytes->len - 1] |=
+			((value >> (n_bits - n)) & ((1 << n) - 1)) << (free_bits - n);
+		writer->n_bits += n;
+		n_bits -= n;
+	}
+}
+
+
+static guint64
+pk_bit_reader_read (PkBitReader *reader,
+                    guint        n_bits)
+{
+	guint64 value = 0;
+	guint avail;
+	guint8 byte;
+	guint n;
+
+	while (n_bits) {
+		byte = reader->data[reader->pos / 8];
+		avail = 8 - (reader->pos % 8);
+		n = MIN(avail, n_bits);
+		value = (value << n) | ((byte >> (avail - n)) & ((1 << n) - 1));
+		reader->pos += n;
+		n_bits -= n;
+	}
+	return value;
+}
+
+
+/*
+ * Deltas of deltas are zigzag encoded, so that small negative values
+ * are small too, and stored behind a prefix of up to five bits giving
+ * their width.
+ */
+static const guint delta_widths[] = { 0, 7, 9, 12, 32, 64 };
+
+
+static void
+pk_packed_write_delta (PkBitWriter *writer,
+                       gint64       delta)
+{
+	guint64 zigzag;
+	guint i;
+
+	zigzag = ((guint64)delta << 1) ^ (guint64)(delta >> 63);
+	for (i = 0; i < G_N_ELEMENTS(delta_widths) - 1; i++) {
+		if (!delta_widths[i] ? !zigzag
+		                     : zigzag < (G_GUINT64_CONSTANT(1) << delta_widths[i])) {
+			break;
+		}
+	}
+
+	/*
+	 * i ones followed by a zero, except for the widest width.
+	 */
+	if (i < G_N_ELEMENTS(delta_widths) - 1) {
+		pk_bit_writer_write(writer, ((1 << i) - 1) << 1, i + 1);
+	} else {
+		pk_bit_writer_write(writer, (1 << i) - 1, i);
+	}
+	pk_bit_writer_write(writer, zigzag, delta_widths[i]);
+}
+
+
+static gint64
+pk_packed_read_delta (PkBitReader *reader)
+{
+	guint64 zigzag;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(delta_widths) - 1; i++) {
+		if (!pk_bit_reader_read(reader, 1)) {
+			break;
+		}
+	}
+	if (!i) {
+		return 0;
+	}
+	zigzag = pk_bit_reader_read(reader, delta_widths[i]);
+	return (gint64)(zigzag >> 1) ^ -(gint64)(zigzag & 1);
+}
+
+
+static inline guint
+count_leading_zeros (guint64 v)
+{
+	guint n = 0;
+	guint shift;
+
+	for (shift = 32; shift; shift >>= 1) {
+		if (!(v >> (64 - shift))) {
+			n += shift;
+			v <<= shift;
+		}
+	}
+	return n;
+}
+
+
+static inline guint
+count_trailing_zeros (guint64 v)
+{
+	guint n = 0;
+	guint shift;
+
+	for (shift = 32; shift; shift >>= 1) {
+		if (!(v & ((G_GUINT64_CONSTANT(1) << shift) - 1))) {
+			n += shift;
+			v >>= shift;
+		}
+	}
+	return n;
+}
+
+
+typedef struct
+{
+	guint64 prev;
+	guint   leading;
+	guint   trailing;
+} PkXorState;
+
+
+static void
+pk_packed_write_xor (PkBitWriter *writer,
+                     PkXorState  *state,
+                     gdouble      value)
+{
+	guint64 bits;
+	guint64 xor;
+	guint leading;
+	guint trailing;
+
+	memcpy(&bits, &value, sizeof bits);
+	xor = bits ^ state->prev;
+	state->prev = bits;
+
+	if (!xor) {
+		pk_bit_writer_write(writer, 0, 1);
+		return;
+	}
+
+	leading = count_leading_zeros(xor);
+	trailing = count_trailing_zeros(xor);
+
+	/*
+	 * Reuse the window of meaningful bits from the previous value if the
+	 * changed bits fit within it.
+	 */
+	if (leading >= state->leading && trailing >= state->trailing) {
+		pk_bit_writer_write(writer, 0x2, 2);
+		pk_bit_writer_write(writer, xor >> state->trailing,
+		                    64 - state->leading - state->trailing);
+		return;
+	}
+
+	pk_bit_writer_write(writer, 0x3, 2);
+	pk_bit_writer_write(writer, leading, 6);
+	pk_bit_writer_write(writer, 63 - leading - trailing, 6);
+	pk_bit_writer_write(writer, xor >> trailing, 64 - leading - trailing);
+	state->leading = leading;
+	state->trailing = trailing;
+}
+
+
+static gdouble
+pk_packed_read_xor (PkBitReader *reader,
+                    PkXorState  *state)
+{
+	gdouble value;
+	guint length;
+
+	if (pk_bit_reader_read(reader, 1)) {
+		if (pk_bit_reader_read(reader, 1)) {
+			state->leading = pk_bit_reader_read(reader, 6);
+			length = pk_bit_reader_read(reader, 6) + 1;
+			state->trailing = 64 - state->leading - length;
+		}
+		length = 64 - state->leading - state->trailing;
+		state->prev ^= pk_bit_reader_read(reader, length) << state->trailing;
+	}
+	memcpy(&value, &state->prev, sizeof value);
+	return value;
+}
+
+
+static GType
+pk_packed_storage_type (GType type)
+{
+	switch (type) {
+	case G_TYPE_DOUBLE:
+	case G_TYPE_FLOAT:
+	case G_TYPE_INT:
+	case G_TYPE_INT64:
+	case G_TYPE_UINT:
+	case G_TYPE_UINT64:
+		return type;
+	case G_TYPE_STRING:
+		/*
+		 * Strings have no fixed size and are not stored.
+		 */
+		return G_TYPE_INVALID;
+	default:
+		return G_TYPE_DOUBLE;
+	}
+}
+
+
+static guint
+pk_packed_element_size (GType type)
+{
+	switch (type) {
+	case G_TYPE_FLOAT:
+	case G_TYPE_INT:
+	case G_TYPE_UINT:
+		return 4;
+	case G_TYPE_DOUBLE:
+	case G_TYPE_INT64:
+	case G_TYPE_UINT64:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+
+static inline gdouble
+pk_packed_column_get_double (PkPackedColumn *column,
+                             guint           index_)
+{
+	switch (column->type) {
+	case G_TYPE_DOUBLE:
+		return ((gdouble *)column->values)[index_];
+	case G_TYPE_FLOAT:
+		return ((gfloat *)column->values)[index_];
+	case G_TYPE_INT:
+		return ((gint32 *)column->values)[index_];
+	case G_TYPE_INT64:
+		return ((gint64 *)column->values)[index_];
+	case G_TYPE_UINT:
+		return ((guint32 *)column->values)[index_];
+	case G_TYPE_UINT64:
+		return ((guint64 *)column->values)[index_];
+	default:
+		return 0.0;
+	}
+}
+
+
+static inline guint64
+pk_packed_column_get_bits (PkPackedColumn *column,
+                           guint           index_)
+{
+	switch (column->type) {
+	case G_TYPE_INT:
+		return ((gint32 *)column->values)[index_];
+	case G_TYPE_INT64:
+		return ((gint64 *)column->values)[index_];
+	case G_TYPE_UINT:
+		return ((guint32 *)column->values)[index_];
+	case G_TYPE_UINT64:
+		return ((guint64 *)column->values)[index_];
+	default:
+		g_assert_not_reached();
+		return 0;
+	}
+}
+
+
+static inline void
+pk_packed_column_set_bits (PkPackedColumn *column,
+                           guint           index_,
+                           guint64         bits)
+{
+	switch (column->type) {
+	case G_TYPE_INT:
+		((gint32 *)column->values)[index_] = (gint32)bits;
+		break;
+	case G_TYPE_INT64:
+		((gint64 *)column->values)[index_] = (gint64)bits;
+		break;
+	case G_TYPE_UINT:
+		((guint32 *)column->values)[index_] = (guint32)bits;
+		break;
+	case G_TYPE_UINT64:
+		((guint64 *)column->values)[index_] = bits;
+		break;
+	default:
+		g_assert_not_reached();
+	}
+}
+
+
+static void
+pk_packed_column_set_value (PkPackedColumn *column,
+                            guint           index_,
+                            const GValue   *value)
+{
+	switch (column->type) {
+	case G_TYPE_DOUBLE:
+		((gdouble *)column->values)[index_] = g_value_get_double(value);
+		break;
+	case G_TYPE_FLOAT:
+		((gfloat *)column->values)[index_] = g_value_get_float(value);
+		break;
+	case G_TYPE_INT:
+		((gint32 *)column->values)[index_] = g_value_get_int(value);
+		break;
+	case G_TYPE_INT64:
+		((gint64 *)column->values)[index_] = g_value_get_int64(value);
+		break;
+	case G_TYPE_UINT:
+		((guint32 *)column->values)[index_] = g_value_get_uint(value);
+		break;
+	case G_TYPE_UINT64:
+		((guint64 *)column->values)[index_] = g_value_get_uint64(value);
+		break;
+	default:
+		g_assert_not_reached();
+	}
+}
+
+
+static void
+pk_packed_column_get_value (PkPackedColumn *column,
+                            guint           index_,
+                            GValue         *value)
+{
+	GValue tmp = { 0 };
+
+	g_value_init(&tmp, column->type);
+	switch (column->type) {
+	case G_TYPE_DOUBLE:
+		g_value_set_double(&tmp, ((gdouble *)column->values)[index_]);
+		break;
+	case G_TYPE_FLOAT:
+		g_value_set_float(&tmp, ((gfloat *)column->values)[index_]);
+		break;
+	case G_TYPE_INT:
+		g_value_set_int(&tmp, ((gint32 *)column->values)[index_]);
+		break;
+	case G_TYPE_INT64:
+		g_value_set_int64(&tmp, ((gint64 *)column->values)[index_]);
+		break;
+	case G_TYPE_UINT:
+		g_value_set_uint(&tmp, ((guint32 *)column->values)[index_]);
+		break;
+	case G_TYPE_UINT64:
+		g_value_set_uint64(&tmp, ((guint64 *)column->values)[index_]);
+		break;
+	default:
+		g_assert_not_reached();
+	}
+	if (G_VALUE_TYPE(value) == column->type) {
+		g_value_copy(&tmp, value);
+	} else {
+		g_value_transform(&tmp, value);
+	}
+	g_value_unset(&tmp);
+}
+
+
+static inline void
+pk_packed_stat_merge (PkPackedStat       *stat,
+                      guint              *count,
+                      const PkPackedStat *other,
+                      guint               other_count)
+{
+	if (!*count) {
+		*stat = *other;
+	} else {
+		stat->min = MIN(stat->min, other->min);
+		stat->max = MAX(stat->max, other->max);
+		stat->sum += other->sum;
+		stat->last = other->last;
+	}
+	*count += other_count;
+}
+
+
+static inline void
+pk_packed_stat_add (PkPackedStat *stat,
+                    guint        *count,
+                    gdouble       value)
+{
+	PkPackedStat one;
+
+	one.min = one.max = one.sum = one.first = one.last = value;
+	pk_packed_stat_merge(stat, count, &one, 1);
+}
+
+
+static void
+pk_packed_column_pack (PkPackedColumn *column,
+                       guint           n_samples)
+{
+	PkBitWriter writer = { NULL, 0 };
+	PkXorState state = { 0, 64, 64 };
+	guint64 prev = 0;
+	guint64 bits;
+	gint64 prev_delta = 0;
+	gint64 delta;
+	guint count = 0;
+	guint i;
+
+	writer.bytes = g_byte_array_new();
+	for (i = 0; i < n_samples; i++) {
+		pk_packed_stat_add(&column->stat, &count,
+		                   pk_packed_column_get_double(column, i));
+		if (column->type == G_TYPE_DOUBLE || column->type == G_TYPE_FLOAT) {
+			pk_packed_write_xor(&writer, &state,
+			                    pk_packed_column_get_double(column, i));
+		} else {
+			bits = pk_packed_column_get_bits(column, i);
+			delta = (gint64)(bits - prev);
+			pk_packed_write_delta(&writer, delta - prev_delta);
+			prev_delta = delta;
+			prev = bits;
+		}
+	}
+
+	column->packed_len = writer.bytes->len;
+	column->packed = g_byte_array_free(writer.bytes, FALSE);
+	g_free(column->values);
+	column->values = NULL;
+}
+
+
+static void
+pk_packed_column_unpack (PkPackedColumn *column,
+                         guint           n_samples)
+{
+	PkBitReader reader = { NULL, 0 };
+	PkXorState state = { 0, 64, 64 };
+	guint64 prev = 0;
+	gint64 delta = 0;
+	gdouble value;
+	guint i;
+
+	reader.data = column->packed;
+	column->values = g_malloc(n_samples * pk_packed_element_size(column->type));
+	for (i = 0; i < n_samples; i++) {
+		if (column->type == G_TYPE_DOUBLE) {
+			((gdouble *)column->values)[i] = pk_packed_read_xor(&reader, &state);
+		} else if (column->type == G_TYPE_FLOAT) {
+			value = pk_packed_read_xor(&reader, &state);
+			((gfloat *)column->values)[i] = (gfloat)value;
+		} else {
+			delta += pk_packed_read_delta(&reader);
+			prev += (guint64)delta;
+			pk_packed_column_set_bits(column, i, prev);
+		}
+	}
+}
+
+
+static inline gdouble
+pk_packed_time_from_nsec (gint64 nsec)
+{
+	/*
+	 * This must match the arithmetic of pk_sample_decode_timespec() so
+	 * that the times are restored exactly.
+	 */
+	return (gdouble)(nsec / NSEC_PER_SEC) +
+	       (nsec % NSEC_PER_SEC) / (G_USEC_PER_SEC * 1000.0);
+}
+
+
+/**
+ * pk_packed_time_to_units:
+ * @time_: (in): A sample time.
+ * @unit: (in): The number of nanoseconds per unit.
+ * @units: (out): A location for the time in units.
+ *
+ * Converts @time_ to a whole number of @unit since the epoch.  The
+ * fraction is rounded to the unit, since the double precision time
+ * cannot hold every nanosecond.
+ *
+ * Returns: %TRUE if @units converts back to exactly @time_.
+ * Side effects: None.
+ */
+static gboolean
+pk_packed_time_to_units (gdouble  time_,
+                         gint64   unit,
+                         gint64  *units)
+{
+	gdouble sec;
+
+	if (time_ < 0.0 || time_ >= (gdouble)(G_MAXINT64 / NSEC_PER_SEC)) {
+		return FALSE;
+	}
+	sec = floor(time_);
+	*units = (gint64)sec * (NSEC_PER_SEC / unit) +
+	         (gint64)floor((time_ - sec) * (NSEC_PER_SEC / unit) + 0.5);
+	return pk_packed_time_from_nsec(*units * unit) == time_;
+}
+
+
+static void
+pk_packed_chunk_pack_times (PkPackedChunk *chunk)
+{
+	PkBitWriter writer = { NULL, 0 };
+	PkXorState state = { 0, 64, 64 };
+	gint64 prev_delta = 0;
+	gint64 prev = 0;
+	gint64 delta;
+	gint64 units;
+	guint i;
+
+	/*
+	 * Times from a sampling interval are usually whole microseconds. Use
+	 * the coarsest unit that restores every time in the chunk exactly.
+	 */
+	for (chunk->time_unit = 1000; chunk->time_unit; chunk->time_unit /= 1000) {
+		for (i = 0; i < chunk->n_samples; i++) {
+			if (!pk_packed_time_to_units(chunk->times[i], chunk->time_unit,
+			                             &units)) {
+				break;
+			}
+		}
+		if (i == chunk->n_samples) {
+			break;
+		}
+	}
+
+	writer.bytes = g_byte_array_new();
+	for (i = 0; i < chunk->n_samples; i++) {
+		if (!chunk->time_unit) {
+			pk_packed_write_xor(&writer, &state, chunk->times[i]);
+			continue;
+		}
+		pk_packed_time_to_units(chunk->times[i], chunk->time_unit, &units);
+		delta = units - prev;
+		pk_packed_write_delta(&writer, delta - prev_delta);
+		prev_delta = delta;
+		prev = units;
+	}
+
+	chunk->packed_times_len = writer.bytes->len;
+	chunk->packed_times = g_byte_array_free(writer.bytes, FALSE);
+	g_free(chunk->times);
+	chunk->times = NULL;
+}
+
+
+static void
+pk_packed_chunk_unpack_times (PkPackedChunk *chunk)
+{
+	PkBitReader reader = { NULL, 0 };
+	PkXorState state = { 0, 64, 64 };
+	gint64 delta = 0;
+	gint64 units = 0;
+	guint i;
+
+	reader.data = chunk->packed_times;
+	chunk->times = g_new(gdouble, chunk->n_samples);
+	for (i = 0; i < chunk->n_samples; i++) {
+		if (!chunk->time_unit) {
+			chunk->times[i] = pk_packed_read_xor(&reader, &state);
+			continue;
+		}
+		delta += pk_packed_read_delta(&reader);
+		units += delta;
+		chunk->times[i] = pk_packed_time_from_nsec(units * chunk->time_unit);
+	}
+}
+
+
+static PkPackedChunk*
+pk_packed_chunk_new_tail (guint first)
+{
+	PkPackedChunk *chunk;
+
+	chunk = g_slice_new0(PkPackedChunk);
+	chunk->first = first;
+	chunk->times = g_new(gdouble, CHUNK_N_SAMPLES);
+	chunk->columns = g_array_new(FALSE, FALSE, sizeof(PkPackedColumn));
+	return chunk;
+}
+
+
+/**
+ * pk_packed_chunk_evict:
+ * @chunk: (in): A sealed #PkPackedChunk.
+ *
+ * Frees the unpacked times and values of @chunk.  The packed data is
+ * kept so that the chunk can be unpacked again.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_packed_chunk_evict (PkPackedChunk *chunk)
+{
+	PkPackedColumn *column;
+	gint i;
+
+	for (i = 0; i < chunk->columns->len; i++) {
+		column = &g_array_index(chunk->columns, PkPackedColumn, i);
+		g_free(column->values);
+		column->values = NULL;
+	}
+	g_free(chunk->times);
+	chunk->times = NULL;
+	chunk->cached = NULL;
+}
+
+
+static void
+pk_packed_chunk_free (PkPackedChunk *chunk)
+{
+	PkPackedColumn *column;
+	gint i;
+
+	for (i = 0; i < chunk->columns->len; i++) {
+		column = &g_array_index(chunk->columns, PkPackedColumn, i);
+		g_free(column->values);
+		g_free(column->packed);
+	}
+	g_array_free(chunk->columns, TRUE);
+	g_free(chunk->times);
+	g_free(chunk->packed_times);
+	g_slice_free(PkPackedChunk, chunk);
+}
+
+
+static PkPackedColumn*
+pk_packed_chunk_find_column (PkPackedChunk *chunk,
+                             GQuark         key)
+{
+	PkPackedColumn *column;
+	gint i;
+
+	for (i = 0; i < chunk->columns->len; i++) {
+		column = &g_array_index(chunk->columns, PkPackedColumn, i);
+		if (column->key == key) {
+			return column;
+		}
+	}
+	return NULL;
+}
+
+
+static PkPackedColumn*
+pk_packed_chunk_get_column (PkPackedChunk *chunk,
+                            GQuark         key)
+{
+	PkPackedColumn *column;
+
+	/*
+	 * The chunk has been unpacked by the caller, the column is unpacked
+	 * the first time it is needed.
+	 */
+	if ((column = pk_packed_chunk_find_column(chunk, key)) &&
+	    !column->values) {
+		pk_packed_column_unpack(column, chunk->n_samples);
+	}
+	return column;
+}
+
+
+/**
+ * pk_model_compressed_unpack:
+ * @compressed: (in): A #PkModelCompressed.
+ * @chunk: (in): A #PkPackedChunk.
+ *
+ * Makes sure the times of @chunk are unpacked and marks it as the most
+ * recently used chunk.  If this pushes the LRU over CACHE_N_CHUNKS, the
+ * least recently used chunk is evicted.  Columns are unpacked lazily by
+ * pk_packed_chunk_get_column().  Callers must hold pk_model_lock().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_compressed_unpack (PkModelCompressed *compressed,
+                            PkPackedChunk     *chunk)
+{
+	PkModelCompressedPrivate *priv = compressed->priv;
+
+	if (!chunk->sealed) {
+		return;
+	}
+
+	if (chunk->cached) {
+		g_queue_unlink(priv->cache, chunk->cached);
+		g_queue_push_head_link(priv->cache, chunk->cached);
+		return;
+	}
+
+	pk_packed_chunk_unpack_times(chunk);
+	g_queue_push_head(priv->cache, chunk);
+	chunk->cached = priv->cache->head;
+	while (priv->cache->length > CACHE_N_CHUNKS) {
+		pk_packed_chunk_evict(g_queue_pop_tail(priv->cache));
+	}
+}
+
+
+static void
+pk_model_compressed_expire (PkModelCompressed *compressed)
+{
+	PkModelCompressedPrivate *priv = compressed->priv;
+	PkPackedChunk *chunk;
+	gdouble max_age;
+	gdouble end_time;
+	guint max_samples;
+	guint length;
+
+	max_samples = pk_model_get_max_samples(PK_MODEL(compressed));
+	max_age = pk_model_get_max_age(PK_MODEL(compressed));
+	end_time = pk_model_get_end_time(PK_MODEL(compressed));
+	length = priv->tail->n_samples;
+	if (priv->chunks->len) {
+		chunk = g_ptr_array_index(priv->chunks, 0);
+		length += priv->tail->first - chunk->first;
+	}
+
+	while (priv->chunks->len) {
+		chunk = g_ptr_array_index(priv->chunks, 0);
+		if (!(max_samples && length - chunk->n_samples >= max_samples) &&
+		    !(max_age > 0.0 && chunk->end_time < end_time - max_age)) {
+			break;
+		}
+		if (chunk->cached) {
+			g_queue_delete_link(priv->cache, chunk->cached);
+		}
+		length -= chunk->n_samples;
+		g_ptr_array_remove_index(priv->chunks, 0);
+		pk_packed_chunk_free(chunk);
+	}
+}
+
+
+/**
+ * pk_model_compressed_seal_tail:
+ * @compressed: (in): A #PkModelCompressed.
+ *
+ * Packs the tail chunk and starts a new, empty tail.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_compressed_seal_tail (PkModelCompressed *compressed)
+{
+	PkModelCompressedPrivate *priv = compressed->priv;
+	PkPackedChunk *tail = priv->tail;
+	gint i;
+
+	if (!tail->n_samples) {
+		return;
+	}
+
+	pk_packed_chunk_pack_times(tail);
+	for (i = 0; i < tail->columns->len; i++) {
+		pk_packed_column_pack(&g_array_index(tail->columns, PkPackedColumn, i),
+		                      tail->n_samples);
+	}
+	tail->sealed = TRUE;
+	g_ptr_array_add(priv->chunks, tail);
+
+	/*
+	 * Start a new tail. The manifest columns are recreated with it.
+	 */
+	priv->tail = pk_packed_chunk_new_tail(tail->first + tail->n_samples);
+	if (priv->manifest) {
+		g_array_set_size(priv->manifest_columns, 0);
+		pk_manifest_unref(priv->manifest);
+		priv->manifest = NULL;
+	}
+
+	pk_model_compressed_expire(compressed);
+}
+
+
+static guint
+pk_model_compressed_get_tail_column (PkModelCompressed *compressed,
+                                     GQuark             key,
+                                     GType              type)
+{
+	PkPackedChunk *tail = compressed->priv->tail;
+	PkPackedColumn *column;
+	PkPackedColumn new_column;
+
+	if ((column = pk_packed_chunk_get_column(tail, key))) {
+		return column - (PkPackedColumn *)tail->columns->data;
+	}
+
+	/*
+	 * Columns are allocated at full chunk size and zeroed, which covers
+	 * samples in the tail that did not have this row.
+	 */
+	memset(&new_column, 0, sizeof new_column);
+	new_column.key = key;
+	new_column.type = type;
+	new_column.values = g_malloc0(CHUNK_N_SAMPLES * pk_packed_element_size(type));
+	g_array_append_val(tail->columns, new_column);
+	return tail->columns->len - 1;
+}
+
+
+static void
+pk_model_compressed_set_manifest (PkModelCompressed *compressed,
+                                  PkManifest        *manifest)
+{
+	PkModelCompressedPrivate *priv = compressed->priv;
+	GQuark key;
+	GType type;
+	guint idx;
+	gint n_rows;
+	gint i;
+
+	if (priv->manifest == manifest) {
+		return;
+	}
+
+	if (priv->manifest) {
+		pk_manifest_unref(priv->manifest);
+	}
+	priv->manifest = pk_manifest_ref(manifest);
+
+	n_rows = pk_manifest_get_n_rows(manifest);
+	g_array_set_size(priv->manifest_columns, 0);
+	for (i = 1; i <= n_rows; i++) {
+		key = g_quark_from_string(pk_manifest_get_row_name(manifest, i));
+		type = pk_packed_storage_type(pk_manifest_get_row_type(manifest, i));
+		idx = G_MAXUINT;
+		if (type != G_TYPE_INVALID) {
+			idx = pk_model_compressed_get_tail_column(compressed, key, type);
+		}
+		g_array_append_val(priv->manifest_columns, idx);
+	}
+}
+
+
+static inline guint
+pk_model_compressed_get_first (PkModelCompressed *compressed)
+{
+	PkModelCompressedPrivate *priv = compressed->priv;
+
+	if (priv->chunks->len) {
+		return ((PkPackedChunk *)g_ptr_array_index(priv->chunks, 0))->first;
+	}
+	return priv->tail->first;
+}
+
+
+static inline guint
+pk_model_compressed_get_length (PkModelCompressed *compressed)
+{
+	return compressed->priv->tail->first + compressed->priv->tail->n_samples;
+}
+
+
+/**
+ * pk_model_compressed_find_chunk:
+ * @compressed: (in): A #PkModelCompressed.
+ * @index_: (in): A global sample index.
+ *
+ * Finds the chunk containing the sample at @index_ without unpacking it.
+ *
+ * Returns: The chunk containing @index_.
+ * Side effects: None.
+ */
+static PkPackedChunk*
+pk_model_compressed_find_chunk (PkModelCompressed *compressed,
+                                guint              index_)
+{
+	PkModelCompressedPrivate *priv = compressed->priv;
+	PkPackedChunk *chunk;
+	gint left = 0;
+	gint right;
+	gint middle;
+
+	if (index_ >= priv->tail->first) {
+		return priv->tail;
+	}
+
+	right = priv->chunks->len - 1;
+	while (left <= right) {
+		middle = (left + right) / 2;
+		chunk = g_ptr_array_index(priv->chunks, middle);
+		if (index_ < chunk->first) {
+			right = middle - 1;
+		} else if (index_ >= chunk->first + chunk->n_samples) {
+			left = middle + 1;
+		} else {
+			return chunk;
+		}
+	}
+
+	g_assert_not_reached();
+	return NULL;
+}
+
+
+/**
+ * pk_model_compressed_get_chunk:
+ * @compressed: (in): A #PkModelCompressed.
+ * @index_: (in): A global sample index.
+ *
+ * Finds the chunk containing the sample at @index_ and unpacks its times.
+ *
+ * Returns: The chunk containing @index_.
+ * Side effects: None.
+ */
+static PkPackedChunk*
+pk_model_compressed_get_chunk (PkModelCompressed *compressed,
+                               guint              index_)
+{
+	PkPackedChunk *chunk;
+
+	chunk = pk_model_compressed_find_chunk(compressed, index_);
+	pk_model_compressed_unpack(compressed, chunk);
+	return chunk;
+}
+
+
+static inline gdouble
+pk_model_compressed_time_at (PkModelCompressed *compressed,
+                             guint              index_)
+{
+	PkPackedChunk *chunk;
+
+	chunk = pk_model_compressed_get_chunk(compressed, index_);
+	return chunk->times[index_ - chunk->first];
+}
+
+
+static gint
+pk_model_compressed_find_nearest_sample (PkModelCompressed *compressed,
+                                         gdouble            target_time,
+                                         gdouble            other_time,
+                                         gboolean           prefer_right)
+{
+	gdouble t;
+	gint first;
+	gint left;
+	gint middle;
+	gint right;
+	gint n_samples;
+
+	first = pk_model_compressed_get_first(compressed);
+	n_samples = pk_model_compressed_get_length(compressed);
+	if (first == n_samples) {
+		return -1;
+	}
+
+	left = middle = first;
+	right = n_samples - 1;
+
+	/*
+	 * Binary search across all chunks. This matches the semantics of the
+	 * memory model; see pk_model_memory_find_nearest_sample().
+	 */
+	while (left <= right) {
+		middle = (left + right) / 2;
+		t = pk_model_compressed_time_at(compressed, middle);
+		if (t < target_time) {
+			left = middle + 1;
+		} else if (t > target_time) {
+			right = middle - 1;
+		} else {
+			break;
+		}
+	}
+
+	if (!prefer_right) {
+		while (middle >= first &&
+		       pk_model_compressed_time_at(compressed, middle) >= target_time) {
+			middle--;
+		}
+		if (middle < first) {
+			if (pk_model_compressed_time_at(compressed, first) < other_time) {
+				return first;
+			}
+			return -1;
+		}
+		return middle;
+	} else {
+		while (middle < n_samples &&
+		       pk_model_compressed_time_at(compressed, middle) <= target_time) {
+			middle++;
+		}
+		if (middle >= n_samples) {
+			if (pk_model_compressed_time_at(compressed, n_samples - 1) > other_time) {
+				return n_samples - 1;
+			}
+			return -1;
+		}
+		return middle;
+	}
+}
+
+
+/*
+ * Returns the global index of the first sample after @time_, or at
+ * @time_ unless @inclusive is set.  Chunks are searched by their time
+ * span first so that only one of them is unpacked.
+ */
+static guint
+pk_model_compressed_count_before (PkModelCompressed *compressed,
+                                  gdouble            time_,
+                                  gboolean           inclusive)
+{
+	PkModelCompressedPrivate *priv = compressed->priv;
+	PkPackedChunk *chunk;
+	gdouble t;
+	guint left = 0;
+	guint right;
+	guint middle;
+
+	right = priv->chunks->len;
+	while (left < right) {
+		middle = left + (right - left) / 2;
+		t = ((PkPackedChunk *)g_ptr_array_index(priv->chunks, middle))->end_time;
+		if (t < time_ || (inclusive && t == time_)) {
+			left = middle + 1;
+		} else {
+			right = middle;
+		}
+	}
+	chunk = (left < priv->chunks->len) ? g_ptr_array_index(priv->chunks, left)
+	                                   : priv->tail;
+
+	pk_model_compressed_unpack(compressed, chunk);
+	left = 0;
+	right = chunk->n_samples;
+	while (left < right) {
+		middle = left + (right - left) / 2;
+		t = chunk->times[middle];
+		if (t < time_ || (inclusive && t == time_)) {
+			left = middle + 1;
+		} else {
+			right = middle;
+		}
+	}
+	return chunk->first + left;
+}
+
+
+/*
+ * Iters step over @span samples at a time; 1 for single samples or
+ * CHUNK_N_SAMPLES to step over the summaries of whole chunks.
+ */
+static inline void
+set_iter (PkModelCompressed *compressed,
+          PkModelIter       *iter,
+          guint              index_,
+          guint              end_index,
+          guint              span)
+{
+	PkPackedChunk *chunk = iter->user_data3;
+
+	/*
+	 * Remember the chunk so that walking forward rarely has to search.
+	 */
+	if (!chunk ||
+	    index_ < chunk->first ||
+	    index_ >= chunk->first + chunk->n_samples) {
+		chunk = pk_model_compressed_find_chunk(compressed, index_);
+	}
+
+	/*
+	 * Steps over whole chunks only need the summaries. The tail has none
+	 * yet, so it is always stepped over sample by sample.
+	 */
+	if (span > 1 && chunk->sealed) {
+		index_ = chunk->first;
+		iter->time = chunk->begin_time;
+	} else {
+		span = 1;
+		pk_model_compressed_unpack(compressed, chunk);
+		iter->time = chunk->times[index_ - chunk->first];
+	}
+	iter->user_data = GUINT_TO_POINTER(index_);
+	iter->user_data2 = GUINT_TO_POINTER(end_index);
+	iter->user_data3 = chunk;
+	iter->user_data4 = GUINT_TO_POINTER(span);
+}
+
+
+/*
+ * Returns the value of @key for a single sample, as pk_model_get_double()
+ * would.
+ */
+static gdouble
+pk_model_compressed_get_sample (PkModelCompressed *compressed,
+                                guint              index_,
+                                GQuark             key)
+{
+	PkModelIter iter;
+
+	memset(&iter, 0, sizeof iter);
+	set_iter(compressed, &iter, index_, index_, 1);
+	return pk_model_get_double(PK_MODEL(compressed), &iter, key);
+}
+
+
+static gboolean
+pk_model_compressed_has_builder (PkModelCompressed *compressed,
+                                 GQuark             key)
+{
+	gint i;
+
+	for (i = 0; i < compressed->priv->builders->len; i++) {
+		if (g_array_index(compressed->priv->builders, GQuark, i) == key) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+static void
+pk_model_compressed_build (PkModelCompressed *compressed,
+                           GQuark             key,
+                           guint              index_)
+{
+	PkPackedChunk *tail = compressed->priv->tail;
+	PkPackedColumn *column;
+	PkModelIter iter;
+	GValue value = { 0 };
+	guint idx;
+
+	idx = pk_model_compressed_get_tail_column(compressed, key, G_TYPE_DOUBLE);
+
+	memset(&iter, 0, sizeof iter);
+	set_iter(compressed, &iter, index_, index_, 1);
+	g_value_init(&value, G_TYPE_DOUBLE);
+	pk_model_build_value(PK_MODEL(compressed), &iter, key, &value);
+	column = &g_array_index(tail->columns, PkPackedColumn, idx);
+	((gdouble *)column->values)[index_ - tail->first] = g_value_get_double(&value);
+	g_value_unset(&value);
+}
+
+
+static void
+pk_model_compressed_append_sample (PkModelCompressed *compressed,
+                                   PkManifest        *manifest,
+                                   PkSample          *sample)
+{
+	PkModelCompressedPrivate *priv = compressed->priv;
+	PkPackedChunk *tail;
+	PkPackedColumn *column;
+	GValue value = { 0 };
+	guint idx;
+	gint i;
+
+	if (priv->tail->n_samples == CHUNK_N_SAMPLES) {
+		pk_model_compressed_seal_tail(compressed);
+	}
+
+	pk_model_compressed_set_manifest(compressed, manifest);
+
+	tail = priv->tail;
+	tail->times[tail->n_samples] = sample->time;
+	for (i = 0; i < priv->manifest_columns->len; i++) {
+		if ((idx = g_array_index(priv->manifest_columns, guint, i)) == G_MAXUINT) {
+			continue;
+		}
+		column = &g_array_index(tail->columns, PkPackedColumn, idx);
+		g_value_init(&value, column->type);
+		pk_sample_get_value(sample, i + 1, &value);
+		pk_packed_column_set_value(column, tail->n_samples, &value);
+		g_value_unset(&value);
+	}
+	if (!tail->n_samples) {
+		tail->begin_time = sample->time;
+	}
+	tail->end_time = sample->time;
+	tail->n_samples++;
+
+	for (i = 0; i < priv->builders->len; i++) {
+		pk_model_compressed_build(compressed,
+		                          g_array_index(priv->builders, GQuark, i),
+		                          tail->first + tail->n_samples - 1);
+	}
+}
+
+
+static void
+pk_model_compressed_insert_manifest (PkModel    *model,
+                                     PkManifest *manifest)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+
+	g_return_if_fail(PK_IS_MODEL_COMPRESSED(compressed));
+
+	pk_model_compressed_set_manifest(compressed, manifest);
+}
+
+
+static void
+pk_model_compressed_insert_sample (PkModel    *model,
+                                   PkManifest *manifest,
+                                   PkSample   *sample)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+
+	g_return_if_fail(PK_IS_MODEL_COMPRESSED(compressed));
+
+	pk_model_compressed_append_sample(compressed, manifest, sample);
+}
+
+
+static gboolean
+pk_model_compressed_get_iter_first (PkModel     *model,
+                                    PkModelIter *iter)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+	guint first;
+	guint n_samples;
+
+	g_return_val_if_fail(PK_IS_MODEL_COMPRESSED(compressed), FALSE);
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	memset(iter, 0, sizeof *iter);
+	first = pk_model_compressed_get_first(compressed);
+	if ((n_samples = pk_model_compressed_get_length(compressed)) == first) {
+		return FALSE;
+	}
+	set_iter(compressed, iter, first, n_samples - 1, 1);
+	return TRUE;
+}
+
+
+static gboolean
+pk_model_compressed_get_iter_for_range (PkModel     *model,
+                                        PkModelIter *iter,
+                                        gdouble      begin_time,
+                                        gdouble      end_time,
+                                        gdouble      aggregate_time)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+	PkModelCompressedPrivate *priv;
+	PkPackedChunk *first;
+	PkPackedChunk *last;
+	gdouble interval;
+	guint n_samples;
+	guint span = 1;
+	gint begin_idx;
+	gint end_idx;
+
+	g_return_val_if_fail(PK_IS_MODEL_COMPRESSED(compressed), FALSE);
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	priv = compressed->priv;
+
+	memset(iter, 0, sizeof *iter);
+
+	/*
+	 * Step over whole chunks if they typically span no more than the
+	 * requested aggregate time, like the levels of PkModelColumnar.
+	 */
+	n_samples = pk_model_compressed_get_length(compressed) -
+	            pk_model_compressed_get_first(compressed);
+	if (aggregate_time > 0.0 && n_samples > 1) {
+		first = priv->chunks->len ? g_ptr_array_index(priv->chunks, 0)
+		                          : priv->tail;
+		last = priv->tail->n_samples
+		     ? priv->tail
+		     : g_ptr_array_index(priv->chunks, priv->chunks->len - 1);
+		interval = (last->end_time - first->begin_time) / (n_samples - 1);
+		if (interval * CHUNK_N_SAMPLES <= aggregate_time) {
+			span = CHUNK_N_SAMPLES;
+		}
+	}
+
+	begin_idx =
+		pk_model_compressed_find_nearest_sample(compressed, begin_time,
+		                                        end_time, FALSE);
+	end_idx =
+		pk_model_compressed_find_nearest_sample(compressed, end_time,
+		                                        begin_time, TRUE);
+	if (begin_idx < 0 || end_idx < 0) {
+		return FALSE;
+	}
+
+	set_iter(compressed, iter, begin_idx, end_idx, span);
+	return TRUE;
+}
+
+
+static gboolean
+pk_model_compressed_iter_next (PkModel     *model,
+                               PkModelIter *iter)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+	PkPackedChunk *chunk;
+	guint index_;
+	guint end_index;
+	guint span;
+
+	g_return_val_if_fail(PK_IS_MODEL_COMPRESSED(compressed), FALSE);
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	index_ = GPOINTER_TO_UINT(iter->user_data);
+	end_index = GPOINTER_TO_UINT(iter->user_data2);
+	chunk = iter->user_data3;
+	span = GPOINTER_TO_UINT(iter->user_data4);
+
+	index_ = MIN(index_ + span, chunk->first + chunk->n_samples);
+	if (index_ <= end_index) {
+		set_iter(compressed, iter, index_, end_index, span);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+
+static gdouble
+pk_model_compressed_get_double_at (PkModelCompressed *compressed,
+                                   guint              index_,
+                                   GQuark             key)
+{
+	PkPackedChunk *chunk;
+	PkPackedColumn *column;
+
+	chunk = pk_model_compressed_get_chunk(compressed, index_);
+	if (!(column = pk_packed_chunk_get_column(chunk, key))) {
+		return 0.0;
+	}
+	return pk_packed_column_get_double(column, index_ - chunk->first);
+}
+
+
+static gdouble
+pk_model_compressed_get_aggregate (PkModel          *model,
+                                   PkModelIter      *iter,
+                                   GQuark            key,
+                                   PkModelAggregate  aggregate)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+	PkPackedChunk *chunk;
+	PkPackedColumn *column;
+	PkPackedColumn *prev;
+	const PkPackedStat *stat;
+	PkPackedStat scanned;
+	PkModelMode mode;
+	gdouble before;
+	gdouble sum;
+	guint index_;
+	guint n = 0;
+	guint i;
+
+	g_return_val_if_fail(PK_IS_MODEL_COMPRESSED(compressed), 0.0);
+
+	index_ = GPOINTER_TO_UINT(iter->user_data);
+	chunk = iter->user_data3;
+	g_assert(chunk);
+
+	if (GPOINTER_TO_UINT(iter->user_data4) <= 1) {
+		if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+			return 1.0;
+		}
+		return pk_model_get_double(model, iter, key);
+	}
+
+	if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+		return chunk->n_samples;
+	}
+
+	if (!(column = pk_packed_chunk_find_column(chunk, key))) {
+		/*
+		 * Chunks sealed before a builder was registered have no summary
+		 * for it, so its samples are evaluated one by one.
+		 */
+		if (!pk_model_compressed_has_builder(compressed, key)) {
+			return 0.0;
+		}
+		memset(&scanned, 0, sizeof scanned);
+		for (i = 0; i < chunk->n_samples; i++) {
+			pk_packed_stat_add(&scanned, &n,
+			                   pk_model_compressed_get_sample(compressed,
+			                                                  index_ + i,
+			                                                  key));
+		}
+		stat = &scanned;
+	} else {
+		stat = &column->stat;
+	}
+
+	mode = GPOINTER_TO_INT(g_hash_table_lookup(compressed->priv->modes,
+	                                           GUINT_TO_POINTER(key)));
+	if (column && mode == PK_MODEL_COUNTER) {
+		/*
+		 * The summaries are of the counter rather than its deltas. The
+		 * deltas sum up to the difference between the last sample and the
+		 * last sample of the previous chunk; as with PkModelColumnar, the
+		 * extremes of the deltas are not known and the mean is used
+		 * instead.
+		 */
+		before = stat->first;
+		if (index_ > pk_model_compressed_get_first(compressed)) {
+			prev = pk_packed_chunk_find_column(
+				pk_model_compressed_find_chunk(compressed, index_ - 1), key);
+			before = prev ? prev->stat.last : 0.0;
+		}
+		switch (aggregate) {
+		case PK_MODEL_AGGREGATE_FIRST:
+			return stat->first - before;
+		case PK_MODEL_AGGREGATE_LAST:
+			return pk_model_compressed_get_sample(compressed,
+			                                      index_ + chunk->n_samples - 1,
+			                                      key);
+		default:
+			break;
+		}
+		sum = stat->last - before;
+		if (aggregate == PK_MODEL_AGGREGATE_SUM) {
+			return sum;
+		}
+		return sum / chunk->n_samples;
+	}
+
+	switch (aggregate) {
+	case PK_MODEL_AGGREGATE_MIN:
+		return stat->min;
+	case PK_MODEL_AGGREGATE_MAX:
+		return stat->max;
+	case PK_MODEL_AGGREGATE_FIRST:
+		return stat->first;
+	case PK_MODEL_AGGREGATE_LAST:
+		return stat->last;
+	case PK_MODEL_AGGREGATE_SUM:
+		return stat->sum;
+	case PK_MODEL_AGGREGATE_MEAN:
+	default:
+		return stat->sum / chunk->n_samples;
+	}
+}
+
+
+static gdouble
+pk_model_compressed_get_range_aggregate (PkModel          *model,
+                                         GQuark            key,
+                                         gdouble           begin_time,
+                                         gdouble           end_time,
+                                         PkModelAggregate  aggregate)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+	PkPackedChunk *chunk;
+	PkPackedColumn *column;
+	PkPackedStat stat;
+	PkModelMode mode;
+	guint index_;
+	guint begin;
+	guint end;
+	guint count = 0;
+
+	g_return_val_if_fail(PK_IS_MODEL_COMPRESSED(compressed), 0.0);
+
+	begin = pk_model_compressed_count_before(compressed, begin_time, FALSE);
+	end = pk_model_compressed_count_before(compressed, end_time, TRUE);
+	if (begin >= end) {
+		return 0.0;
+	}
+	if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+		return end - begin;
+	}
+
+	memset(&stat, 0, sizeof stat);
+	mode = GPOINTER_TO_INT(g_hash_table_lookup(compressed->priv->modes,
+	                                           GUINT_TO_POINTER(key)));
+
+	for (index_ = begin; index_ < end;) {
+		chunk = pk_model_compressed_find_chunk(compressed, index_);
+
+		/*
+		 * Whole chunks within the range are taken from their summaries.
+		 * Counters are aggregated over their deltas, which are not
+		 * summarized, so their samples are always walked.
+		 */
+		if (chunk->sealed &&
+		    mode != PK_MODEL_COUNTER &&
+		    index_ == chunk->first &&
+		    chunk->first + chunk->n_samples <= end &&
+		    (column = pk_packed_chunk_find_column(chunk, key))) {
+			pk_packed_stat_merge(&stat, &count, &column->stat,
+			                     chunk->n_samples);
+			index_ += chunk->n_samples;
+			continue;
+		}
+
+		pk_packed_stat_add(&stat, &count,
+		                   pk_model_compressed_get_sample(compressed, index_,
+		                                                  key));
+		index_++;
+	}
+
+	switch (aggregate) {
+	case PK_MODEL_AGGREGATE_MIN:
+		return stat.min;
+	case PK_MODEL_AGGREGATE_MAX:
+		return stat.max;
+	case PK_MODEL_AGGREGATE_FIRST:
+		return stat.first;
+	case PK_MODEL_AGGREGATE_LAST:
+		return stat.last;
+	case PK_MODEL_AGGREGATE_SUM:
+		return stat.sum;
+	case PK_MODEL_AGGREGATE_MEAN:
+	default:
+		return stat.sum / count;
+	}
+}
+
+
+static void
+pk_model_compressed_get_value (PkModel     *model,
+                               PkModelIter *iter,
+                               GQuark       key,
+                               GValue      *value)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+	PkPackedChunk *chunk;
+	PkPackedColumn *column;
+	PkModelMode mode;
+	GValue delta = { 0 };
+	guint index_;
+
+	g_return_if_fail(PK_IS_MODEL_COMPRESSED(compressed));
+
+	index_ = GPOINTER_TO_UINT(iter->user_data);
+	chunk = iter->user_data3;
+	g_assert(chunk);
+
+	/*
+	 * Steps over whole chunks report the mean, as PkModelColumnar does.
+	 */
+	if (GPOINTER_TO_UINT(iter->user_data4) > 1) {
+		if (pk_packed_chunk_find_column(chunk, key) ||
+		    pk_model_compressed_has_builder(compressed, key)) {
+			g_value_init(&delta, G_TYPE_DOUBLE);
+			g_value_set_double(&delta,
+			                   pk_model_compressed_get_aggregate(
+			                       model, iter, key,
+			                       PK_MODEL_AGGREGATE_MEAN));
+			g_value_transform(&delta, value);
+			g_value_unset(&delta);
+		}
+		return;
+	}
+
+	/*
+	 * The chunk may have been evicted since the iter was set.
+	 */
+	pk_model_compressed_unpack(compressed, chunk);
+	if (!(column = pk_packed_chunk_get_column(chunk, key))) {
+		if (pk_model_compressed_has_builder(compressed, key)) {
+			pk_model_build_value(model, iter, key, value);
+		}
+		return;
+	}
+
+	mode = GPOINTER_TO_INT(g_hash_table_lookup(compressed->priv->modes,
+	                                           GUINT_TO_POINTER(key)));
+	if (mode == PK_MODEL_COUNTER) {
+		if (index_ == pk_model_compressed_get_first(compressed)) {
+			/*
+			 * Can't calculate value on first item.
+			 */
+			g_value_reset(value);
+		} else {
+			g_value_init(&delta, G_TYPE_DOUBLE);
+			g_value_set_double(&delta,
+			                   pk_packed_column_get_double(column, index_ - chunk->first) -
+			                   pk_model_compressed_get_double_at(compressed, index_ - 1, key));
+			g_value_transform(&delta, value);
+			g_value_unset(&delta);
+		}
+		return;
+	}
+
+	pk_packed_column_get_value(column, index_ - chunk->first, value);
+}
+
+
+static void
+pk_model_compressed_builder_added (PkModel *model,
+                                   GQuark   key)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+	PkPackedChunk *tail;
+	guint i;
+
+	g_return_if_fail(PK_IS_MODEL_COMPRESSED(compressed));
+
+	tail = compressed->priv->tail;
+
+	/*
+	 * A builder replacing a field that is stored already is left to be
+	 * evaluated on read.
+	 */
+	if (pk_packed_chunk_get_column(tail, key)) {
+		return;
+	}
+
+	g_array_append_val(compressed->priv->builders, key);
+	pk_model_set_materialized(model, key);
+
+	for (i = 0; i < tail->n_samples; i++) {
+		pk_model_compressed_build(compressed, key, tail->first + i);
+	}
+}
+
+
+static void
+pk_model_compressed_set_field_mode (PkModel     *model,
+                                    GQuark       key,
+                                    PkModelMode  mode)
+{
+	PkModelCompressed *compressed = (PkModelCompressed *)model;
+
+	g_return_if_fail(PK_IS_MODEL_COMPRESSED(compressed));
+
+	g_hash_table_insert(compressed->priv->modes, GUINT_TO_POINTER(key),
+	                    GINT_TO_POINTER(mode));
+}
+
+
+/**
+ * pk_model_compressed_get_size:
+ * @compressed: (in): A #PkModelCompressed.
+ *
+ * Retrieves the number of bytes used to store samples, counting sealed
+ * chunks at their packed size and the open tail chunk at its raw size.
+ * Unpacked chunks held in the cache are not counted.
+ *
+ * Returns: The size in bytes.
+ * Side effects: None.
+ */
+gsize
+pk_model_compressed_get_size (PkModelCompressed *compressed)
+{
+	PkModelCompressedPrivate *priv;
+	PkPackedChunk *chunk;
+	PkPackedColumn *column;
+	gsize size;
+	gint i;
+	gint j;
+
+	g_return_val_if_fail(PK_IS_MODEL_COMPRESSED(compressed), 0);
+
+	priv = compressed->priv;
+
+	size = priv->tail->n_samples * sizeof(gdouble);
+	for (i = 0; i < priv->tail->columns->len; i++) {
+		column = &g_array_index(priv->tail->columns, PkPackedColumn, i);
+		size += priv->tail->n_samples * pk_packed_element_size(column->type);
+	}
+
+	for (i = 0; i < priv->chunks->len; i++) {
+		chunk = g_ptr_array_index(priv->chunks, i);
+		size += chunk->packed_times_len;
+		for (j = 0; j < chunk->columns->len; j++) {
+			size += g_array_index(chunk->columns, PkPackedColumn, j).packed_len;
+		}
+	}
+
+	return size;
+}
+
+
+/**
+ * pk_model_compressed_finalize:
+ * @object: (in): A #PkModelCompressed.
+ *
+ * Finalizer for a #PkModelCompressed instance.  Frees any resources held
+ * by the instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_compressed_finalize (GObject *object)
+{
+	PkModelCompressedPrivate *priv = PK_MODEL_COMPRESSED(object)->priv;
+
+	if (priv->manifest) {
+		pk_manifest_unref(priv->manifest);
+		priv->manifest = NULL;
+	}
+	g_array_free(priv->manifest_columns, TRUE);
+
+	g_queue_free(priv->cache);
+	g_ptr_array_foreach(priv->chunks, (GFunc)pk_packed_chunk_free, NULL);
+	g_ptr_array_free(priv->chunks, TRUE);
+	pk_packed_chunk_free(priv->tail);
+
+	g_hash_table_destroy(priv->modes);
+	g_array_free(priv->builders, TRUE);
+
+	G_OBJECT_CLASS(pk_model_compressed_parent_class)->finalize(object);
+}
+
+
+/**
+ * pk_model_compressed_class_init:
+ * @klass: (in): A #PkModelCompressedClass.
+ *
+ * Initializes the #PkModelCompressedClass and prepares the vtable.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_compressed_class_init (PkModelCompressedClass *klass)
+{
+	GObjectClass *object_class;
+	PkModelClass *model_class;
+
+	object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = pk_model_compressed_finalize;
+	g_type_class_add_private(object_class, sizeof(PkModelCompressedPrivate));
+
+	model_class = PK_MODEL_CLASS(klass);
+	model_class->builder_added = pk_model_compressed_builder_added;
+	model_class->get_aggregate = pk_model_compressed_get_aggregate;
+	model_class->get_iter_first = pk_model_compressed_get_iter_first;
+	model_class->get_iter_for_range = pk_model_compressed_get_iter_for_range;
+	model_class->get_range_aggregate = pk_model_compressed_get_range_aggregate;
+	model_class->get_value = pk_model_compressed_get_value;
+	model_class->insert_manifest = pk_model_compressed_insert_manifest;
+	model_class->insert_sample = pk_model_compressed_insert_sample;
+	model_class->iter_next = pk_model_compressed_iter_next;
+	model_class->set_field_mode = pk_model_compressed_set_field_mode;
+}
+
+
+/**
+ * pk_model_compressed_init:
+ * @compressed: (in): A #PkModelCompressed.
+ *
+ * Initializes the newly created #PkModelCompressed instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_compressed_init (PkModelCompressed *compressed)
+{
+	compressed->priv = G_TYPE_INSTANCE_GET_PRIVATE(compressed,
+	                                               PK_TYPE_MODEL_COMPRESSED,
+	                                               PkModelCompressedPrivate);
+
+	compressed->priv->chunks = g_ptr_array_new();
+	compressed->priv->tail = pk_packed_chunk_new_tail(0);
+	compressed->priv->cache = g_queue_new();
+	compressed->priv->modes = g_hash_table_new(g_direct_hash, g_direct_equal);
+	compressed->priv->builders = g_array_new(FALSE, FALSE, sizeof(GQuark));
+	compressed->priv->manifest_columns = g_array_new(FALSE, FALSE, sizeof(guint));
+}
@@ -0,0 +1,56 @@
+/* pk-model-compressed.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PK_MODEL_COMPRESSED_H
+#define PK_MODEL_COMPRESSED_H
+
+#include "pk-model.h"
+
+G_BEGIN_DECLS
+
+#define PK_TYPE_MODEL_COMPRESSED            (pk_model_compressed_get_type())
+#define PK_MODEL_COMPRESSED(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), PK_TYPE_MODEL_COMPRESSED, PkModelCompressed))
+#define PK_MODEL_COMPRESSED_CONST(obj)      (G_TYPE_CHECK_INSTANCE_CAST ((obj), PK_TYPE_MODEL_COMPRESSED, PkModelCompressed const))
+#define PK_MODEL_COMPRESSED_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  PK_TYPE_MODEL_COMPRESSED, PkModelCompressedClass))
+#define PK_IS_MODEL_COMPRESSED(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), PK_TYPE_MODEL_COMPRESSED))
+#define PK_IS_MODEL_COMPRESSED_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  PK_TYPE_MODEL_COMPRESSED))
+#define PK_MODEL_COMPRESSED_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  PK_TYPE_MODEL_COMPRESSED, PkModelCompressedClass))
+
+typedef struct _PkModelCompressed        PkModelCompressed;
+typedef struct _PkModelCompressedClass   PkModelCompressedClass;
+typedef struct _PkModelCompressedPrivate PkModelCompressedPrivate;
+
+struct _PkModelCompressed
+{
+	PkModel parent;
+
+	/*< private >*/
+	PkModelCompressedPrivate *priv;
+};
+
+struct _PkModelCompressedClass
+{
+	PkModelClass parent_class;
+};
+
+GType pk_model_compressed_get_type (void) G_GNUC_CONST;
+gsize pk_model_compressed_get_size (PkModelCompressed *compressed);
+
+G_END_DECLS
+
+#endif /* PK_MODEL_COMPRESSED_H */
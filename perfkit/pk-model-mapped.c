@@ -0,0 +1,1683 @@
+/* pk-model-mapped.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pk-log.h"
+#include "pk-model-mapped.h"
+
+
+/*
+ * PkModelMapped stores samples in a file so that the size of a capture is
+ * limited by disk rather than memory.
+ *
+ * The file is a sequence of chunks. Each chunk holds up to CHUNK_N_SAMPLES
+ * samples in the same column layout as PkModelColumnar; a header, a header
+ * per column, the array of sample times, one array per column and then the
+ * summaries of each column. Chunks are written with the host byte order.
+ *
+ * The summaries hold the min, max, sum, first and last value of every block
+ * of BLOCK_N_SAMPLES samples, followed by one for the whole chunk. Iters
+ * with an aggregate time step over blocks or chunks using them, so that a
+ * zoomed out view of a long capture only pages in the summaries.
+ *
+ * Samples are appended to an in-memory tail chunk. Once the tail is full
+ * it is written to the end of the file and mapped back in read-only, so
+ * only the most recent samples take up heap memory. Reopening a capture
+ * only reads the chunk headers.
+ *
+ * Iterators are a global sample index, counted across all chunks.
+ *
+ * Registered builders are evaluated as samples are inserted and stored as
+ * double columns in the chunk, so they are persisted with the capture.
+ * Chunks written before a builder was registered evaluate it on read.
+ */
+
+
+#define CHUNK_MAGIC      (0x504B4D43) /* "PKMC" */
+#define CHUNK_N_SAMPLES  (4096)
+#define CHUNK_NAME_LEN   (52)
+#define BLOCK_N_SAMPLES  (64)
+#define ALIGN8(_n)       (((_n) + 7) & ~7)
+
+
+typedef struct
+{
+	guint32 magic;
+	guint32 n_samples;
+	guint32 n_columns;
+	guint32 size;
+	gdouble begin_time;
+	gdouble end_time;
+} PkChunkHeader;
+
+
+typedef struct
+{
+	guint32 type;
+	guint32 offset;
+	guint32 stats;     /* Offset of the summaries */
+	gchar   name[CHUNK_NAME_LEN];
+} PkChunkColumnHeader;
+
+
+typedef struct
+{
+	gdouble min;
+	gdouble max;
+	gdouble sum;
+	gdouble first;
+	gdouble last;
+} PkChunkStat;
+
+
+typedef struct
+{
+	GQuark             key;
+	GType              type;
+	guint8            *data;
+	const PkChunkStat *stats; /* Summaries, or NULL for the tail chunk */
+} PkMappedColumn;
+
+
+typedef struct
+{
+	guint    first;     /* Global index of the first sample */
+	guint    n_samples;
+	gdouble  begin_time;
+	gdouble  end_time;
+	gdouble *times;
+	GArray  *columns;   /* Array of PkMappedColumn */
+	guint32  size;      /* Size of the chunk within the file */
+	gpointer map;       /* Mapping, or NULL for the tail chunk */
+	gsize    map_len;
+} PkMappedChunk;
+
+
+struct _PkModelMappedPrivate
+{
+	gchar         *filename;
+	gboolean       anonymous;
+	gint           fd;
+	goffset        length;
+	GPtrArray     *chunks;
+	PkMappedChunk *tail;
+	GHashTable    *modes;
+	GArray        *builders;
+
+	/*
+	 * Index into the tail's columns for each row of the current manifest.
+	 */
+	PkManifest    *manifest;
+	GArray        *manifest_columns;
+};
+
+
+G_DEFINE_TYPE(PkModelMapped, pk_model_mapped, PK_TYPE_MODEL)
+
+
+static GType
+pk_mapped_storage_type (GType type)
+{
+	switch (type) {
+	case G_TYPE_DOUBLE:
+	case G_TYPE_FLOAT:
+	case G_TYPE_INT:
+	case G_TYPE_INT64:
+	case G_TYPE_UINT:
+	case G_TYPE_UINT64:
+		return type;
+	case G_TYPE_STRING:
+		/*
+		 * Strings have no fixed size and are not stored.
+		 */
+		return G_TYPE_INVALID;
+	default:
+		return G_TYPE_DOUBLE;
+	}
+}
+
+
+static guint
+pk_mapped_element_size (GType type)
+{
+	switch (type) {
+	case G_TYPE_FLOAT:
+	case G_TYPE_INT:
+	case G_TYPE_UINT:
+		return 4;
+	case G_TYPE_DOUBLE:
+	case G_TYPE_INT64:
+	case G_TYPE_UINT64:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+
+static inline gdouble
+pk_mapped_column_get_double (PkMappedColumn *column,
+                             guint           index_)
+{
+	switch (column->type) {
+	case G_TYPE_DOUBLE:
+		return ((gdouble *)column->data)[index_];
+	case G_TYPE_FLOAT:
+		return ((gfloat *)column->data)[index_];
+	case G_TYPE_INT:
+		return ((gint32 *)column->data)[index_];
+	case G_TYPE_INT64:
+		return ((gint64 *)column->data)[index_];
+	case G_TYPE_UINT:
+		return ((guint32 *)column->data)[index_];
+	case G_TYPE_UINT64:
+		return ((guint64 *)column->data)[index_];
+	default:
+		return 0.0;
+	}
+}
+
+
+static void
+pk_mapped_column_set_value (PkMappedColumn *column,
+                            guint           index_,
+                            const GValue   *value)
+{
+	switch (column->type) {
+	case G_TYPE_DOUBLE:
+		((gdouble *)column->data)[index_] = g_value_get_double(value);
+		break;
+	case G_TYPE_FLOAT:
+		((gfloat *)column->data)[index_] = g_value_get_float(value);
+		break;
+	case G_TYPE_INT:
+		((gint32 *)column->data)[index_] = g_value_get_int(value);
+		break;
+	case G_TYPE_INT64:
+		((gint64 *)column->data)[index_] = g_value_get_int64(value);
+		break;
+	case G_TYPE_UINT:
+		((guint32 *)column->data)[index_] = g_value_get_uint(value);
+		break;
+	case G_TYPE_UINT64:
+		((guint64 *)column->data)[index_] = g_value_get_uint64(value);
+		break;
+	default:
+		g_assert_not_reached();
+	}
+}
+
+
+static void
+pk_mapped_column_get_value (PkMappedColumn *column,
+                            guint           index_,
+                            GValue         *value)
+{
+	GValue tmp = { 0 };
+
+	g_value_init(&tmp, column->type);
+	switch (column->type) {
+	case G_TYPE_DOUBLE:
+		g_value_set_double(&tmp, ((gdouble *)column->data)[index_]);
+		break;
+	case G_TYPE_FLOAT:
+		g_value_set_float(&tmp, ((gfloat *)column->data)[index_]);
+		break;
+	case G_TYPE_INT:
+		g_value_set_int(&tmp, ((gint32 *)column->data)[index_]);
+		break;
+	case G_TYPE_INT64:
+		g_value_set_int64(&tmp, ((gint64 *)column->data)[index_]);
+		break;
+	case G_TYPE_UINT:
+		g_value_set_uint(&tmp, ((guint32 *)column->data)[index_]);
+		break;
+	case G_TYPE_UINT64:
+		g_value_set_uint64(&tmp, ((guint64 *)column->data)[index_]);
+		break;
+	default:
+		g_assert_not_reached();
+	}
+	if (G_VALUE_TYPE(value) == column->type) {
+		g_value_copy(&tmp, value);
+	} else {
+		g_value_transform(&tmp, value);
+	}
+	g_value_unset(&tmp);
+}
+
+
+static inline guint
+pk_mapped_n_blocks (guint n_samples)
+{
+	return (n_samples + BLOCK_N_SAMPLES - 1) / BLOCK_N_SAMPLES;
+}
+
+
+static inline void
+pk_chunk_stat_merge (PkChunkStat       *stat,
+                     guint             *count,
+                     const PkChunkStat *other,
+                     guint              other_count)
+{
+	if (!*count) {
+		*stat = *other;
+	} else {
+		stat->min = MIN(stat->min, other->min);
+		stat->max = MAX(stat->max, other->max);
+		stat->sum += other->sum;
+		stat->last = other->last;
+	}
+	*count += other_count;
+}
+
+
+static inline void
+pk_chunk_stat_add (PkChunkStat *stat,
+                   guint       *count,
+                   gdouble      value)
+{
+	PkChunkStat one;
+
+	one.min = one.max = one.sum = one.first = one.last = value;
+	pk_chunk_stat_merge(stat, count, &one, 1);
+}
+
+
+/**
+ * pk_mapped_column_get_stats:
+ * @column: (in): A #PkMappedColumn.
+ * @n_samples: (in): The number of samples in the column.
+ * @stats: (out): A location for pk_mapped_n_blocks() + 1 summaries.
+ *
+ * Summarizes every block of the column, followed by the whole column.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_mapped_column_get_stats (PkMappedColumn *column,
+                            guint           n_samples,
+                            PkChunkStat    *stats)
+{
+	guint n_blocks = pk_mapped_n_blocks(n_samples);
+	guint count = 0;
+	guint i;
+
+	for (i = 0; i < n_samples; i++) {
+		if (!(i % BLOCK_N_SAMPLES)) {
+			count = 0;
+		}
+		pk_chunk_stat_add(&stats[i / BLOCK_N_SAMPLES], &count,
+		                  pk_mapped_column_get_double(column, i));
+	}
+	count = 0;
+	for (i = 0; i < n_blocks; i++) {
+		pk_chunk_stat_merge(&stats[n_blocks], &count, &stats[i], 1);
+	}
+}
+
+
+static PkMappedChunk*
+pk_mapped_chunk_new_tail (guint first)
+{
+	PkMappedChunk *chunk;
+
+	chunk = g_slice_new0(PkMappedChunk);
+	chunk->first = first;
+	chunk->times = g_new(gdouble, CHUNK_N_SAMPLES);
+	chunk->columns = g_array_new(FALSE, FALSE, sizeof(PkMappedColumn));
+	return chunk;
+}
+
+
+static void
+pk_mapped_chunk_free (PkMappedChunk *chunk)
+{
+	gint i;
+
+	if (chunk->map) {
+		munmap(chunk->map, chunk->map_len);
+	} else {
+		for (i = 0; i < chunk->columns->len; i++) {
+			g_free(g_array_index(chunk->columns, PkMappedColumn, i).data);
+		}
+		g_free(chunk->times);
+	}
+	g_array_free(chunk->columns, TRUE);
+	g_slice_free(PkMappedChunk, chunk);
+}
+
+
+static PkMappedColumn*
+pk_mapped_chunk_get_column (PkMappedChunk *chunk,
+                            GQuark         key)
+{
+	PkMappedColumn *column;
+	gint i;
+
+	for (i = 0; i < chunk->columns->len; i++) {
+		column = &g_array_index(chunk->columns, PkMappedColumn, i);
+		if (column->key == key) {
+			return column;
+		}
+	}
+	return NULL;
+}
+
+
+/**
+ * pk_mapped_chunk_map:
+ * @fd: (in): The file descriptor.
+ * @offset: (in): The offset of the chunk within the file.
+ * @length: (in): The length of the file.
+ * @error: (out): A location for a #GError, or %NULL.
+ *
+ * Maps the chunk found at @offset within the file and builds the column
+ * table pointing into the mapping.
+ *
+ * Returns: The newly mapped chunk, or %NULL if it is not valid.
+ * Side effects: None.
+ */
+static PkMappedChunk*
+pk_mapped_chunk_map (gint      fd,
+                     goffset   offset,
+                     goffset   length,
+                     GError  **error)
+{
+	PkChunkColumnHeader *col_header;
+	PkChunkHeader header;
+	PkMappedChunk *chunk;
+	PkMappedColumn column;
+	goffset aligned;
+	guint64 data_offset;
+	guint64 column_size;
+	guint64 stats_size;
+	guint8 *base;
+	gpointer map;
+	gsize map_len;
+	guint element_size;
+	gint i;
+
+	/*
+	 * The headers and the times must fit within the chunk, which must fit
+	 * within the file. Captures cut short by a crash fail here rather than
+	 * fault when reading past the end of the mapping.
+	 */
+	data_offset = 0;
+	if (pread(fd, &header, sizeof header, offset) == sizeof header) {
+		data_offset = sizeof header +
+		              (guint64)header.n_columns * sizeof *col_header +
+		              (guint64)header.n_samples * sizeof(gdouble);
+	}
+	if (!data_offset ||
+	    header.magic != CHUNK_MAGIC ||
+	    data_offset > header.size ||
+	    offset + header.size > length) {
+		g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+		            "Invalid chunk at offset %" G_GINT64_FORMAT,
+		            (gint64)offset);
+		return NULL;
+	}
+
+	/*
+	 * Mappings must start on a page boundary.
+	 */
+	aligned = offset - (offset % sysconf(_SC_PAGESIZE));
+	map_len = header.size + (offset - aligned);
+	map = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fd, aligned);
+	if (map == MAP_FAILED) {
+		g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+		            "%s", g_strerror(errno));
+		return NULL;
+	}
+	base = (guint8 *)map + (offset - aligned);
+
+	chunk = g_slice_new0(PkMappedChunk);
+	chunk->map = map;
+	chunk->map_len = map_len;
+	chunk->size = header.size;
+	chunk->n_samples = header.n_samples;
+	chunk->begin_time = header.begin_time;
+	chunk->end_time = header.end_time;
+	chunk->times = (gdouble *)(base + sizeof header +
+	                           header.n_columns * sizeof *col_header);
+	chunk->columns = g_array_sized_new(FALSE, FALSE, sizeof(PkMappedColumn),
+	                                   header.n_columns);
+
+	stats_size = (guint64)(pk_mapped_n_blocks(header.n_samples) + 1) *
+	             sizeof(PkChunkStat);
+	col_header = (PkChunkColumnHeader *)(base + sizeof header);
+	for (i = 0; i < header.n_columns; i++, col_header++) {
+		/*
+		 * Each column and its summaries must be a stored type, aligned,
+		 * and lie after the times within the chunk. Names must be
+		 * terminated.
+		 */
+		element_size = 0;
+		if (pk_mapped_storage_type(col_header->type) == col_header->type) {
+			element_size = pk_mapped_element_size(col_header->type);
+		}
+		column_size = (guint64)header.n_samples * element_size;
+		if (!element_size ||
+		    col_header->offset % element_size ||
+		    col_header->offset < data_offset ||
+		    col_header->offset + column_size > header.size ||
+		    col_header->stats % sizeof(gdouble) ||
+		    col_header->stats < data_offset ||
+		    col_header->stats + stats_size > header.size ||
+		    !memchr(col_header->name, '\0', sizeof col_header->name)) {
+			g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+			            "Invalid column %d of chunk at offset %"
+			            G_GINT64_FORMAT, i, (gint64)offset);
+			pk_mapped_chunk_free(chunk);
+			return NULL;
+		}
+		column.key = g_quark_from_string(col_header->name);
+		column.type = col_header->type;
+		column.data = base + col_header->offset;
+		column.stats = (const PkChunkStat *)(base + col_header->stats);
+		g_array_append_val(chunk->columns, column);
+	}
+
+	return chunk;
+}
+
+
+static gboolean
+write_all (gint           fd,
+           gconstpointer  data,
+           gsize          len,
+           GError       **error)
+{
+	const guint8 *buf = data;
+	gssize r;
+
+	while (len) {
+		if ((r = write(fd, buf, len)) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+			            "%s", g_strerror(errno));
+			return FALSE;
+		}
+		buf += r;
+		len -= r;
+	}
+	return TRUE;
+}
+
+
+/**
+ * pk_model_mapped_seal_tail:
+ * @mapped: (in): A #PkModelMapped.
+ * @error: (out): A location for a #GError, or %NULL.
+ *
+ * Appends the tail chunk to the end of the file and replaces it with the
+ * read-only mapping of what was written.  A new, empty tail is started.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+static gboolean
+pk_model_mapped_seal_tail (PkModelMapped  *mapped,
+                           GError        **error)
+{
+	PkModelMappedPrivate *priv = mapped->priv;
+	PkChunkColumnHeader col_header;
+	PkChunkHeader header;
+	PkMappedChunk *tail = priv->tail;
+	PkMappedChunk *chunk;
+	PkMappedColumn *column;
+	PkChunkStat *stats;
+	static const guint8 padding[8] = { 0 };
+	guint32 offset;
+	guint32 stats_offset;
+	gsize stats_size;
+	gsize size;
+	gint i;
+
+	if (!tail->n_samples) {
+		return TRUE;
+	}
+
+	memset(&header, 0, sizeof header);
+	header.magic = CHUNK_MAGIC;
+	header.n_samples = tail->n_samples;
+	header.n_columns = tail->columns->len;
+	header.begin_time = tail->begin_time;
+	header.end_time = tail->end_time;
+
+	stats_size = (pk_mapped_n_blocks(tail->n_samples) + 1) * sizeof *stats;
+	offset = sizeof header + header.n_columns * sizeof col_header;
+	offset += tail->n_samples * sizeof(gdouble);
+	for (i = 0; i < tail->columns->len; i++) {
+		column = &g_array_index(tail->columns, PkMappedColumn, i);
+		offset += ALIGN8(tail->n_samples * pk_mapped_element_size(column->type));
+	}
+	stats_offset = offset;
+	header.size = offset + header.n_columns * stats_size;
+
+	if (lseek(priv->fd, priv->length, SEEK_SET) < 0) {
+		g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+		            "%s", g_strerror(errno));
+		return FALSE;
+	}
+	if (!write_all(priv->fd, &header, sizeof header, error)) {
+		return FALSE;
+	}
+
+	offset = sizeof header + header.n_columns * sizeof col_header;
+	offset += tail->n_samples * sizeof(gdouble);
+	for (i = 0; i < tail->columns->len; i++) {
+		column = &g_array_index(tail->columns, PkMappedColumn, i);
+		memset(&col_header, 0, sizeof col_header);
+		col_header.type = column->type;
+		col_header.offset = offset;
+		col_header.stats = stats_offset + i * stats_size;
+		g_strlcpy(col_header.name, g_quark_to_string(column->key),
+		          sizeof col_header.name);
+		if (!write_all(priv->fd, &col_header, sizeof col_header, error)) {
+			return FALSE;
+		}
+		offset += ALIGN8(tail->n_samples * pk_mapped_element_size(column->type));
+	}
+
+	if (!write_all(priv->fd, tail->times,
+	               tail->n_samples * sizeof(gdouble), error)) {
+		return FALSE;
+	}
+	for (i = 0; i < tail->columns->len; i++) {
+		column = &g_array_index(tail->columns, PkMappedColumn, i);
+		size = tail->n_samples * pk_mapped_element_size(column->type);
+		if (!write_all(priv->fd, column->data, size, error) ||
+		    !write_all(priv->fd, padding, ALIGN8(size) - size, error)) {
+			return FALSE;
+		}
+	}
+	stats = g_malloc0(stats_size);
+	for (i = 0; i < tail->columns->len; i++) {
+		column = &g_array_index(tail->columns, PkMappedColumn, i);
+		pk_mapped_column_get_stats(column, tail->n_samples, stats);
+		if (!write_all(priv->fd, stats, stats_size, error)) {
+			g_free(stats);
+			return FALSE;
+		}
+	}
+	g_free(stats);
+
+	if (!(chunk = pk_mapped_chunk_map(priv->fd, priv->length,
+	                                  priv->length + header.size, error))) {
+		return FALSE;
+	}
+	chunk->first = tail->first;
+	priv->length += header.size;
+	g_ptr_array_add(priv->chunks, chunk);
+
+	/*
+	 * Start a new tail. The manifest columns are recreated with it.
+	 */
+	priv->tail = pk_mapped_chunk_new_tail(tail->first + tail->n_samples);
+	pk_mapped_chunk_free(tail);
+	if (priv->manifest) {
+		g_array_set_size(priv->manifest_columns, 0);
+		pk_manifest_unref(priv->manifest);
+		priv->manifest = NULL;
+	}
+
+	return TRUE;
+}
+
+
+static guint
+pk_model_mapped_get_tail_column (PkModelMapped *mapped,
+                                 GQuark         key,
+                                 GType          type)
+{
+	PkMappedChunk *tail = mapped->priv->tail;
+	PkMappedColumn *column;
+	PkMappedColumn new_column;
+
+	if ((column = pk_mapped_chunk_get_column(tail, key))) {
+		return column - (PkMappedColumn *)tail->columns->data;
+	}
+
+	/*
+	 * Columns are allocated at full chunk size and zeroed, which covers
+	 * samples in the tail that did not have this row.
+	 */
+	new_column.key = key;
+	new_column.type = type;
+	new_column.data = g_malloc0(CHUNK_N_SAMPLES * pk_mapped_element_size(type));
+	new_column.stats = NULL;
+	g_array_append_val(tail->columns, new_column);
+	return tail->columns->len - 1;
+}
+
+
+static void
+pk_model_mapped_set_manifest (PkModelMapped *mapped,
+                              PkManifest    *manifest)
+{
+	PkModelMappedPrivate *priv = mapped->priv;
+	GQuark key;
+	GType type;
+	guint idx;
+	gint n_rows;
+	gint i;
+
+	if (priv->manifest == manifest) {
+		return;
+	}
+
+	if (priv->manifest) {
+		pk_manifest_unref(priv->manifest);
+	}
+	priv->manifest = pk_manifest_ref(manifest);
+
+	n_rows = pk_manifest_get_n_rows(manifest);
+	g_array_set_size(priv->manifest_columns, 0);
+	for (i = 1; i <= n_rows; i++) {
+		key = g_quark_from_string(pk_manifest_get_row_name(manifest, i));
+		type = pk_mapped_storage_type(pk_manifest_get_row_type(manifest, i));
+		idx = G_MAXUINT;
+		if (type != G_TYPE_INVALID) {
+			idx = pk_model_mapped_get_tail_column(mapped, key, type);
+		}
+		g_array_append_val(priv->manifest_columns, idx);
+	}
+}
+
+
+static inline guint
+pk_model_mapped_get_length (PkModelMapped *mapped)
+{
+	return mapped->priv->tail->first + mapped->priv->tail->n_samples;
+}
+
+
+static PkMappedChunk*
+pk_model_mapped_get_chunk (PkModelMapped *mapped,
+                           guint          index_)
+{
+	PkModelMappedPrivate *priv = mapped->priv;
+	PkMappedChunk *chunk;
+	gint left = 0;
+	gint right;
+	gint middle;
+
+	if (index_ >= priv->tail->first) {
+		return priv->tail;
+	}
+
+	right = priv->chunks->len - 1;
+	while (left <= right) {
+		middle = (left + right) / 2;
+		chunk = g_ptr_array_index(priv->chunks, middle);
+		if (index_ < chunk->first) {
+			right = middle - 1;
+		} else if (index_ >= chunk->first + chunk->n_samples) {
+			left = middle + 1;
+		} else {
+			return chunk;
+		}
+	}
+
+	g_assert_not_reached();
+	return NULL;
+}
+
+
+static inline gdouble
+pk_model_mapped_time_at (PkModelMapped *mapped,
+                         guint          index_)
+{
+	PkMappedChunk *chunk;
+
+	chunk = pk_model_mapped_get_chunk(mapped, index_);
+	return chunk->times[index_ - chunk->first];
+}
+
+
+static gint
+pk_model_mapped_find_nearest_sample (PkModelMapped *mapped,
+                                     gdouble        target_time,
+                                     gdouble        other_time,
+                                     gboolean       prefer_right)
+{
+	gdouble t;
+	gint left = 0;
+	gint middle = 0;
+	gint right;
+	gint n_samples;
+
+	if (!(n_samples = pk_model_mapped_get_length(mapped))) {
+		return -1;
+	}
+
+	right = n_samples - 1;
+
+	/*
+	 * Binary search across all chunks. This matches the semantics of the
+	 * memory model; see pk_model_memory_find_nearest_sample().
+	 */
+	while (left <= right) {
+		middle = (left + right) / 2;
+		t = pk_model_mapped_time_at(mapped, middle);
+		if (t < target_time) {
+			left = middle + 1;
+		} else if (t > target_time) {
+			right = middle - 1;
+		} else {
+			break;
+		}
+	}
+
+	if (!prefer_right) {
+		while (middle >= 0 &&
+		       pk_model_mapped_time_at(mapped, middle) >= target_time) {
+			middle--;
+		}
+		if (middle < 0) {
+			if (pk_model_mapped_time_at(mapped, 0) < other_time) {
+				return 0;
+			}
+			return -1;
+		}
+		return middle;
+	} else {
+		while (middle < n_samples &&
+		       pk_model_mapped_time_at(mapped, middle) <= target_time) {
+			middle++;
+		}
+		if (middle >= n_samples) {
+			if (pk_model_mapped_time_at(mapped, n_samples - 1) > other_time) {
+				return n_samples - 1;
+			}
+			return -1;
+		}
+		return middle;
+	}
+}
+
+
+/*
+ * Returns the number of samples before @time_, or up to and including
+ * @time_ if @inclusive is set.
+ */
+static guint
+pk_model_mapped_count_before (PkModelMapped *mapped,
+                              gdouble        time_,
+                              gboolean       inclusive)
+{
+	gdouble t;
+	guint left = 0;
+	guint right;
+	guint middle;
+
+	right = pk_model_mapped_get_length(mapped);
+	while (left < right) {
+		middle = left + (right - left) / 2;
+		t = pk_model_mapped_time_at(mapped, middle);
+		if (t < time_ || (inclusive && t == time_)) {
+			left = middle + 1;
+		} else {
+			right = middle;
+		}
+	}
+	return left;
+}
+
+
+/*
+ * Iters step over @span samples at a time; 1 for single samples, or
+ * BLOCK_N_SAMPLES or CHUNK_N_SAMPLES to step over the summaries.
+ */
+static inline void
+set_iter (PkModelMapped *mapped,
+          PkModelIter   *iter,
+          guint          index_,
+          guint          end_index,
+          guint          span)
+{
+	PkMappedChunk *chunk = iter->user_data3;
+
+	/*
+	 * Remember the chunk so that walking forward rarely has to search.
+	 */
+	if (!chunk ||
+	    index_ < chunk->first ||
+	    index_ >= chunk->first + chunk->n_samples) {
+		chunk = pk_model_mapped_get_chunk(mapped, index_);
+	}
+
+	/*
+	 * Steps start at the block or chunk containing index_. The tail has
+	 * no summaries yet, so it is always stepped over sample by sample.
+	 */
+	if (!chunk->map) {
+		span = 1;
+	} else if (span == CHUNK_N_SAMPLES) {
+		index_ = chunk->first;
+	} else if (span == BLOCK_N_SAMPLES) {
+		index_ -= (index_ - chunk->first) % BLOCK_N_SAMPLES;
+	}
+
+	iter->time = chunk->times[index_ - chunk->first];
+	iter->user_data = GUINT_TO_POINTER(index_);
+	iter->user_data2 = GUINT_TO_POINTER(end_index);
+	iter->user_data3 = chunk;
+	iter->user_data4 = GUINT_TO_POINTER(span);
+}
+
+
+/*
+ * Returns the value of @key for a single sample, as pk_model_get_double()
+ * would.
+ */
+static gdouble
+pk_model_mapped_get_sample (PkModelMapped *mapped,
+                            guint          index_,
+                            GQuark         key)
+{
+	PkModelIter iter;
+
+	memset(&iter, 0, sizeof iter);
+	set_iter(mapped, &iter, index_, index_, 1);
+	return pk_model_get_double(PK_MODEL(mapped), &iter, key);
+}
+
+
+static gboolean
+pk_model_mapped_has_builder (PkModelMapped *mapped,
+                             GQuark         key)
+{
+	gint i;
+
+	for (i = 0; i < mapped->priv->builders->len; i++) {
+		if (g_array_index(mapped->priv->builders, GQuark, i) == key) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+static void
+pk_model_mapped_build (PkModelMapped *mapped,
+                       GQuark         key,
+                       guint          index_)
+{
+	PkMappedChunk *tail = mapped->priv->tail;
+	PkMappedColumn *column;
+	PkModelIter iter;
+	GValue value = { 0 };
+	guint idx;
+
+	idx = pk_model_mapped_get_tail_column(mapped, key, G_TYPE_DOUBLE);
+
+	memset(&iter, 0, sizeof iter);
+	set_iter(mapped, &iter, index_, index_, 1);
+	g_value_init(&value, G_TYPE_DOUBLE);
+	pk_model_build_value(PK_MODEL(mapped), &iter, key, &value);
+	column = &g_array_index(tail->columns, PkMappedColumn, idx);
+	((gdouble *)column->data)[index_ - tail->first] = g_value_get_double(&value);
+	g_value_unset(&value);
+}
+
+
+static void
+pk_model_mapped_append_sample (PkModelMapped *mapped,
+                               PkManifest    *manifest,
+                               PkSample      *sample)
+{
+	PkModelMappedPrivate *priv = mapped->priv;
+	PkMappedChunk *tail;
+	PkMappedColumn *column;
+	GError *error = NULL;
+	GValue value = { 0 };
+	guint idx;
+	gint i;
+
+	if (priv->tail->n_samples == CHUNK_N_SAMPLES) {
+		if (!pk_model_mapped_seal_tail(mapped, &error)) {
+			g_critical("Failed to write samples to %s: %s",
+			           priv->filename, error->message);
+			g_error_free(error);
+			return;
+		}
+	}
+
+	pk_model_mapped_set_manifest(mapped, manifest);
+
+	tail = priv->tail;
+	tail->times[tail->n_samples] = sample->time;
+	for (i = 0; i < priv->manifest_columns->len; i++) {
+		if ((idx = g_array_index(priv->manifest_columns, guint, i)) == G_MAXUINT) {
+			continue;
+		}
+		column = &g_array_index(tail->columns, PkMappedColumn, idx);
+		g_value_init(&value, column->type);
+		pk_sample_get_value(sample, i + 1, &value);
+		pk_mapped_column_set_value(column, tail->n_samples, &value);
+		g_value_unset(&value);
+	}
+	if (!tail->n_samples) {
+		tail->begin_time = sample->time;
+	}
+	tail->end_time = sample->time;
+	tail->n_samples++;
+
+	for (i = 0; i < priv->builders->len; i++) {
+		pk_model_mapped_build(mapped, g_array_index(priv->builders, GQuark, i),
+		                      tail->first + tail->n_samples - 1);
+	}
+}
+
+
+static void
+pk_model_mapped_insert_manifest (PkModel    *model,
+                                 PkManifest *manifest)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+
+	g_return_if_fail(PK_IS_MODEL_MAPPED(mapped));
+
+	pk_model_mapped_set_manifest(mapped, manifest);
+}
+
+
+static void
+pk_model_mapped_insert_sample (PkModel    *model,
+                               PkManifest *manifest,
+                               PkSample   *sample)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+
+	g_return_if_fail(PK_IS_MODEL_MAPPED(mapped));
+
+	pk_model_mapped_append_sample(mapped, manifest, sample);
+}
+
+
+static gboolean
+pk_model_mapped_get_iter_first (PkModel     *model,
+                                PkModelIter *iter)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+	guint n_samples;
+
+	g_return_val_if_fail(PK_IS_MODEL_MAPPED(mapped), FALSE);
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	memset(iter, 0, sizeof *iter);
+	if (!(n_samples = pk_model_mapped_get_length(mapped))) {
+		return FALSE;
+	}
+	set_iter(mapped, iter, 0, n_samples - 1, 1);
+	return TRUE;
+}
+
+
+static gboolean
+pk_model_mapped_get_iter_for_range (PkModel     *model,
+                                    PkModelIter *iter,
+                                    gdouble      begin_time,
+                                    gdouble      end_time,
+                                    gdouble      aggregate_time)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+	gdouble interval;
+	guint n_samples;
+	guint span = 1;
+	gint begin_idx;
+	gint end_idx;
+
+	g_return_val_if_fail(PK_IS_MODEL_MAPPED(mapped), FALSE);
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	memset(iter, 0, sizeof *iter);
+
+	/*
+	 * Step over the widest summaries that typically span no more than
+	 * the requested aggregate time, like the levels of PkModelColumnar.
+	 */
+	n_samples = pk_model_mapped_get_length(mapped);
+	if (aggregate_time > 0.0 && n_samples > 1) {
+		interval = (pk_model_mapped_time_at(mapped, n_samples - 1) -
+		            pk_model_mapped_time_at(mapped, 0)) / (n_samples - 1);
+		if (interval * CHUNK_N_SAMPLES <= aggregate_time) {
+			span = CHUNK_N_SAMPLES;
+		} else if (interval * BLOCK_N_SAMPLES <= aggregate_time) {
+			span = BLOCK_N_SAMPLES;
+		}
+	}
+
+	begin_idx =
+		pk_model_mapped_find_nearest_sample(mapped, begin_time,
+		                                    end_time, FALSE);
+	end_idx =
+		pk_model_mapped_find_nearest_sample(mapped, end_time,
+		                                    begin_time, TRUE);
+	if (begin_idx < 0 || end_idx < 0) {
+		return FALSE;
+	}
+
+	set_iter(mapped, iter, begin_idx, end_idx, span);
+	return TRUE;
+}
+
+
+static gboolean
+pk_model_mapped_iter_next (PkModel     *model,
+                           PkModelIter *iter)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+	PkMappedChunk *chunk;
+	guint index_;
+	guint end_index;
+	guint span;
+
+	g_return_val_if_fail(PK_IS_MODEL_MAPPED(mapped), FALSE);
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	index_ = GPOINTER_TO_UINT(iter->user_data);
+	end_index = GPOINTER_TO_UINT(iter->user_data2);
+	chunk = iter->user_data3;
+	span = GPOINTER_TO_UINT(iter->user_data4);
+
+	index_ = MIN(index_ + span, chunk->first + chunk->n_samples);
+	if (index_ <= end_index) {
+		set_iter(mapped, iter, index_, end_index, span);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+
+static gdouble
+pk_model_mapped_get_double_at (PkModelMapped *mapped,
+                               guint          index_,
+                               GQuark         key)
+{
+	PkMappedChunk *chunk;
+	PkMappedColumn *column;
+
+	chunk = pk_model_mapped_get_chunk(mapped, index_);
+	if (!(column = pk_mapped_chunk_get_column(chunk, key))) {
+		return 0.0;
+	}
+	return pk_mapped_column_get_double(column, index_ - chunk->first);
+}
+
+
+static gdouble
+pk_model_mapped_get_aggregate (PkModel          *model,
+                               PkModelIter      *iter,
+                               GQuark            key,
+                               PkModelAggregate  aggregate)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+	PkMappedChunk *chunk;
+	PkMappedColumn *column;
+	const PkChunkStat *stat;
+	PkChunkStat scanned;
+	PkModelMode mode;
+	gdouble sum;
+	guint index_;
+	guint count;
+	guint span;
+	guint n = 0;
+	guint i;
+
+	g_return_val_if_fail(PK_IS_MODEL_MAPPED(mapped), 0.0);
+
+	index_ = GPOINTER_TO_UINT(iter->user_data);
+	chunk = iter->user_data3;
+	span = GPOINTER_TO_UINT(iter->user_data4);
+	g_assert(chunk);
+
+	if (span <= 1) {
+		if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+			return 1.0;
+		}
+		return pk_model_get_double(model, iter, key);
+	}
+
+	count = MIN(span, chunk->first + chunk->n_samples - index_);
+	if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+		return count;
+	}
+
+	if (!(column = pk_mapped_chunk_get_column(chunk, key))) {
+		/*
+		 * Chunks written before a builder was registered have no
+		 * summaries for it, so its samples are evaluated one by one.
+		 */
+		if (!pk_model_mapped_has_builder(mapped, key)) {
+			return 0.0;
+		}
+		memset(&scanned, 0, sizeof scanned);
+		for (i = 0; i < count; i++) {
+			pk_chunk_stat_add(&scanned, &n,
+			                  pk_model_mapped_get_sample(mapped, index_ + i,
+			                                             key));
+		}
+		stat = &scanned;
+	} else if (span == BLOCK_N_SAMPLES) {
+		stat = &column->stats[(index_ - chunk->first) / BLOCK_N_SAMPLES];
+	} else {
+		stat = &column->stats[pk_mapped_n_blocks(chunk->n_samples)];
+	}
+
+	mode = GPOINTER_TO_INT(g_hash_table_lookup(mapped->priv->modes,
+	                                           GUINT_TO_POINTER(key)));
+	if (column && mode == PK_MODEL_COUNTER) {
+		/*
+		 * The summaries are of the counter rather than its deltas. The
+		 * deltas sum up to the difference between the last sample and the
+		 * one before the step; as with PkModelColumnar, the extremes of
+		 * the deltas are not known and the mean is used instead.
+		 */
+		switch (aggregate) {
+		case PK_MODEL_AGGREGATE_FIRST:
+			return pk_model_mapped_get_sample(mapped, index_, key);
+		case PK_MODEL_AGGREGATE_LAST:
+			return pk_model_mapped_get_sample(mapped, index_ + count - 1, key);
+		default:
+			break;
+		}
+		sum = stat->last - (index_ ? pk_model_mapped_get_double_at(mapped,
+		                                                           index_ - 1,
+		                                                           key)
+		                           : stat->first);
+		if (aggregate == PK_MODEL_AGGREGATE_SUM) {
+			return sum;
+		}
+		return sum / count;
+	}
+
+	switch (aggregate) {
+	case PK_MODEL_AGGREGATE_MIN:
+		return stat->min;
+	case PK_MODEL_AGGREGATE_MAX:
+		return stat->max;
+	case PK_MODEL_AGGREGATE_FIRST:
+		return stat->first;
+	case PK_MODEL_AGGREGATE_LAST:
+		return stat->last;
+	case PK_MODEL_AGGREGATE_SUM:
+		return stat->sum;
+	case PK_MODEL_AGGREGATE_MEAN:
+	default:
+		return stat->sum / count;
+	}
+}
+
+
+static gdouble
+pk_model_mapped_get_range_aggregate (PkModel          *model,
+                                     GQuark            key,
+                                     gdouble           begin_time,
+                                     gdouble           end_time,
+                                     PkModelAggregate  aggregate)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+	PkMappedChunk *chunk;
+	PkMappedColumn *column;
+	PkChunkStat stat;
+	PkModelMode mode;
+	guint offset;
+	guint index_;
+	guint begin;
+	guint end;
+	guint count = 0;
+	guint n;
+
+	g_return_val_if_fail(PK_IS_MODEL_MAPPED(mapped), 0.0);
+
+	begin = pk_model_mapped_count_before(mapped, begin_time, FALSE);
+	end = pk_model_mapped_count_before(mapped, end_time, TRUE);
+	if (begin >= end) {
+		return 0.0;
+	}
+	if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+		return end - begin;
+	}
+
+	memset(&stat, 0, sizeof stat);
+	mode = GPOINTER_TO_INT(g_hash_table_lookup(mapped->priv->modes,
+	                                           GUINT_TO_POINTER(key)));
+
+	for (index_ = begin; index_ < end;) {
+		chunk = pk_model_mapped_get_chunk(mapped, index_);
+		offset = index_ - chunk->first;
+
+		/*
+		 * Whole chunks and blocks within the range are taken from their
+		 * summaries. Counters are aggregated over their deltas, which are
+		 * not summarized, so their samples are always walked.
+		 */
+		column = NULL;
+		if (mode != PK_MODEL_COUNTER) {
+			column = pk_mapped_chunk_get_column(chunk, key);
+		}
+		if (column && column->stats && !(offset % BLOCK_N_SAMPLES)) {
+			if (!offset && chunk->first + chunk->n_samples <= end) {
+				pk_chunk_stat_merge(&stat, &count,
+				                    &column->stats[pk_mapped_n_blocks(
+				                        chunk->n_samples)],
+				                    chunk->n_samples);
+				index_ += chunk->n_samples;
+				continue;
+			}
+			n = MIN(BLOCK_N_SAMPLES, chunk->n_samples - offset);
+			if (index_ + n <= end) {
+				pk_chunk_stat_merge(&stat, &count,
+				                    &column->stats[offset / BLOCK_N_SAMPLES],
+				                    n);
+				index_ += n;
+				continue;
+			}
+		}
+
+		pk_chunk_stat_add(&stat, &count,
+		                  column ? pk_mapped_column_get_double(column, offset)
+		                         : pk_model_mapped_get_sample(mapped, index_,
+		                                                      key));
+		index_++;
+	}
+
+	switch (aggregate) {
+	case PK_MODEL_AGGREGATE_MIN:
+		return stat.min;
+	case PK_MODEL_AGGREGATE_MAX:
+		return stat.max;
+	case PK_MODEL_AGGREGATE_FIRST:
+		return stat.first;
+	case PK_MODEL_AGGREGATE_LAST:
+		return stat.last;
+	case PK_MODEL_AGGREGATE_SUM:
+		return stat.sum;
+	case PK_MODEL_AGGREGATE_MEAN:
+	default:
+		return stat.sum / count;
+	}
+}
+
+
+static void
+pk_model_mapped_get_value (PkModel     *model,
+                           PkModelIter *iter,
+                           GQuark       key,
+                           GValue      *value)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+	PkMappedChunk *chunk;
+	PkMappedColumn *column;
+	PkModelMode mode;
+	GValue delta = { 0 };
+	guint index_;
+
+	g_return_if_fail(PK_IS_MODEL_MAPPED(mapped));
+
+	index_ = GPOINTER_TO_UINT(iter->user_data);
+	chunk = iter->user_data3;
+	g_assert(chunk);
+
+	column = pk_mapped_chunk_get_column(chunk, key);
+
+	/*
+	 * Steps over summaries report the mean, as PkModelColumnar does.
+	 */
+	if (GPOINTER_TO_UINT(iter->user_data4) > 1) {
+		if (column || pk_model_mapped_has_builder(mapped, key)) {
+			g_value_init(&delta, G_TYPE_DOUBLE);
+			g_value_set_double(&delta,
+			                   pk_model_mapped_get_aggregate(
+			                       model, iter, key,
+			                       PK_MODEL_AGGREGATE_MEAN));
+			g_value_transform(&delta, value);
+			g_value_unset(&delta);
+		}
+		return;
+	}
+
+	if (!column) {
+		if (pk_model_mapped_has_builder(mapped, key)) {
+			pk_model_build_value(model, iter, key, value);
+		}
+		return;
+	}
+
+	mode = GPOINTER_TO_INT(g_hash_table_lookup(mapped->priv->modes,
+	                                           GUINT_TO_POINTER(key)));
+	if (mode == PK_MODEL_COUNTER) {
+		if (index_ == 0) {
+			/*
+			 * Can't calculate value on first item.
+			 */
+			g_value_reset(value);
+		} else {
+			g_value_init(&delta, G_TYPE_DOUBLE);
+			g_value_set_double(&delta,
+			                   pk_mapped_column_get_double(column, index_ - chunk->first) -
+			                   pk_model_mapped_get_double_at(mapped, index_ - 1, key));
+			g_value_transform(&delta, value);
+			g_value_unset(&delta);
+		}
+		return;
+	}
+
+	pk_mapped_column_get_value(column, index_ - chunk->first, value);
+}
+
+
+static void
+pk_model_mapped_builder_added (PkModel *model,
+                               GQuark   key)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+	PkMappedChunk *tail;
+	guint i;
+
+	g_return_if_fail(PK_IS_MODEL_MAPPED(mapped));
+
+	tail = mapped->priv->tail;
+
+	/*
+	 * A builder replacing a field that is stored already is left to be
+	 * evaluated on read.
+	 */
+	if (pk_mapped_chunk_get_column(tail, key)) {
+		return;
+	}
+
+	g_array_append_val(mapped->priv->builders, key);
+	pk_model_set_materialized(model, key);
+
+	for (i = 0; i < tail->n_samples; i++) {
+		pk_model_mapped_build(mapped, key, tail->first + i);
+	}
+}
+
+
+static void
+pk_model_mapped_set_field_mode (PkModel     *model,
+                                GQuark       key,
+                                PkModelMode  mode)
+{
+	PkModelMapped *mapped = (PkModelMapped *)model;
+
+	g_return_if_fail(PK_IS_MODEL_MAPPED(mapped));
+
+	g_hash_table_insert(mapped->priv->modes, GUINT_TO_POINTER(key),
+	                    GINT_TO_POINTER(mode));
+}
+
+
+/**
+ * pk_model_mapped_open:
+ * @mapped: (in): A #PkModelMapped.
+ * @filename: (in) (allow-none): The file to store samples in.
+ * @error: (out): A location for a #GError, or %NULL.
+ *
+ * Opens @filename and maps any chunks it already contains.  A trailing
+ * chunk that was only partially written is discarded.  If @filename is
+ * %NULL, an anonymous temporary file is used.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+static gboolean
+pk_model_mapped_open (PkModelMapped  *mapped,
+                      const gchar    *filename,
+                      GError        **error)
+{
+	PkModelMappedPrivate *priv = mapped->priv;
+	PkMappedChunk *chunk;
+	struct stat st;
+	gchar *tmpname = NULL;
+	goffset offset = 0;
+	guint first = 0;
+
+	if (filename) {
+		priv->fd = g_open(filename, O_RDWR | O_CREAT, 0640);
+		priv->filename = g_strdup(filename);
+	} else {
+		priv->fd = g_file_open_tmp("perfkit-model-XXXXXX", &tmpname, error);
+		if (priv->fd < 0) {
+			return FALSE;
+		}
+		g_unlink(tmpname);
+		priv->filename = tmpname;
+		priv->anonymous = TRUE;
+	}
+
+	if (priv->fd < 0 || fstat(priv->fd, &st) < 0) {
+		g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+		            "%s: %s", priv->filename, g_strerror(errno));
+		return FALSE;
+	}
+
+	while (offset < st.st_size) {
+		if (!(chunk = pk_mapped_chunk_map(priv->fd, offset, st.st_size, NULL))) {
+			g_warning("Truncating %s to the last complete chunk",
+			          priv->filename);
+			if (ftruncate(priv->fd, offset) < 0) {
+				g_set_error(error, G_FILE_ERROR,
+				            g_file_error_from_errno(errno),
+				            "%s: %s", priv->filename, g_strerror(errno));
+				return FALSE;
+			}
+			break;
+		}
+		chunk->first = first;
+		first += chunk->n_samples;
+		offset += chunk->size;
+		g_ptr_array_add(priv->chunks, chunk);
+	}
+
+	priv->length = offset;
+	priv->tail->first = first;
+
+	if (priv->chunks->len) {
+		chunk = g_ptr_array_index(priv->chunks, priv->chunks->len - 1);
+		pk_model_set_end_time(PK_MODEL(mapped), chunk->end_time);
+	}
+
+	return TRUE;
+}
+
+
+/**
+ * pk_model_mapped_new:
+ * @filename: (in) (allow-none): The file to store samples in.
+ * @error: (out): A location for a #GError, or %NULL.
+ *
+ * Creates a new #PkModelMapped storing its samples in @filename.  If
+ * @filename already contains samples from a previous capture, they are
+ * available immediately and new samples are appended.  If @filename is
+ * %NULL, an anonymous temporary file is used which is removed when the
+ * model is finalized.
+ *
+ * Returns: A new #PkModel, or %NULL if the file could not be opened.
+ * Side effects: None.
+ */
+PkModel*
+pk_model_mapped_new (const gchar  *filename,
+                     GError      **error)
+{
+	PkModelMapped *mapped;
+
+	mapped = g_object_new(PK_TYPE_MODEL_MAPPED, NULL);
+	if (!pk_model_mapped_open(mapped, filename, error)) {
+		g_object_unref(mapped);
+		return NULL;
+	}
+	return PK_MODEL(mapped);
+}
+
+
+/**
+ * pk_model_mapped_flush:
+ * @mapped: (in): A #PkModelMapped.
+ * @error: (out): A location for a #GError, or %NULL.
+ *
+ * Writes the samples held in memory to the file.  This happens
+ * automatically as the in-memory chunk fills up and when the model is
+ * finalized.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ * Side effects: None.
+ */
+gboolean
+pk_model_mapped_flush (PkModelMapped  *mapped,
+                       GError        **error)
+{
+	g_return_val_if_fail(PK_IS_MODEL_MAPPED(mapped), FALSE);
+	return pk_model_mapped_seal_tail(mapped, error);
+}
+
+
+/**
+ * pk_model_mapped_get_filename:
+ * @mapped: (in): A #PkModelMapped.
+ *
+ * Retrieves the name of the file backing the model.
+ *
+ * Returns: The filename.
+ * Side effects: None.
+ */
+const gchar*
+pk_model_mapped_get_filename (PkModelMapped *mapped)
+{
+	g_return_val_if_fail(PK_IS_MODEL_MAPPED(mapped), NULL);
+	return mapped->priv->filename;
+}
+
+
+/**
+ * pk_model_mapped_finalize:
+ * @object: (in): A #PkModelMapped.
+ *
+ * Finalizer for a #PkModelMapped instance.  Frees any resources held by
+ * the instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_mapped_finalize (GObject *object)
+{
+	PkModelMappedPrivate *priv = PK_MODEL_MAPPED(object)->priv;
+	GError *error = NULL;
+
+	if (priv->fd >= 0 && !priv->anonymous) {
+		if (!pk_model_mapped_seal_tail(PK_MODEL_MAPPED(object), &error)) {
+			g_warning("Failed to write samples to %s: %s",
+			          priv->filename, error->message);
+			g_error_free(error);
+		}
+	}
+
+	if (priv->manifest) {
+		pk_manifest_unref(priv->manifest);
+		priv->manifest = NULL;
+	}
+	g_array_free(priv->manifest_columns, TRUE);
+
+	g_ptr_array_foreach(priv->chunks, (GFunc)pk_mapped_chunk_free, NULL);
+	g_ptr_array_free(priv->chunks, TRUE);
+	pk_mapped_chunk_free(priv->tail);
+
+	if (priv->fd >= 0) {
+		close(priv->fd);
+	}
+	g_free(priv->filename);
+	g_hash_table_destroy(priv->modes);
+	g_array_free(priv->builders, TRUE);
+
+	G_OBJECT_CLASS(pk_model_mapped_parent_class)->finalize(object);
+}
+
+
+/**
+ * pk_model_mapped_class_init:
+ * @klass: (in): A #PkModelMappedClass.
+ *
+ * Initializes the #PkModelMappedClass and prepares the vtable.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_mapped_class_init (PkModelMappedClass *klass)
+{
+	GObjectClass *object_class;
+	PkModelClass *model_class;
+
+	object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = pk_model_mapped_finalize;
+	g_type_class_add_private(object_class, sizeof(PkModelMappedPrivate));
+
+	model_class = PK_MODEL_CLASS(klass);
+	model_class->builder_added = pk_model_mapped_builder_added;
+	model_class->get_aggregate = pk_model_mapped_get_aggregate;
+	model_class->get_iter_first = pk_model_mapped_get_iter_first;
+	model_class->get_iter_for_range = pk_model_mapped_get_iter_for_range;
+	model_class->get_range_aggregate = pk_model_mapped_get_range_aggregate;
+	model_class->get_value = pk_model_mapped_get_value;
+	model_class->insert_manifest = pk_model_mapped_insert_manifest;
+	model_class->insert_sample = pk_model_mapped_insert_sample;
+	model_class->iter_next = pk_model_mapped_iter_next;
+	model_class->set_field_mode = pk_model_mapped_set_field_mode;
+}
+
+
+/**
+ * pk_model_mapped_init:
+ * @mapped: (in): A #PkModelMapped.
+ *
+ * Initializes the newly created #PkModelMapped instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_mapped_init (PkModelMapped *mapped)
+{
+	mapped->priv = G_TYPE_INSTANCE_GET_PRIVATE(mapped, PK_TYPE_MODEL_MAPPED,
+	                                           PkModelMappedPrivate);
+
+	mapped->priv->fd = -1;
+	mapped->priv->chunks = g_ptr_array_new();
+	mapped->priv->tail = pk_mapped_chunk_new_tail(0);
+	mapped->priv->modes = g_hash_table_new(g_direct_hash, g_direct_equal);
+	mapped->priv->builders = g_array_new(FALSE, FALSE, sizeof(GQuark));
+	mapped->priv->manifest_columns = g_array_new(FALSE, FALSE, sizeof(guint));
+}
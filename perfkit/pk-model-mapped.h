@@ -0,0 +1,60 @@
+/* pk-model-mapped.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PK_MODEL_MAPPED_H
+#define PK_MODEL_MAPPED_H
+
+#include "pk-model.h"
+
+G_BEGIN_DECLS
+
+#define PK_TYPE_MODEL_MAPPED            (pk_model_mapped_get_type())
+#define PK_MODEL_MAPPED(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), PK_TYPE_MODEL_MAPPED, PkModelMapped))
+#define PK_MODEL_MAPPED_CONST(obj)      (G_TYPE_CHECK_INSTANCE_CAST ((obj), PK_TYPE_MODEL_MAPPED, PkModelMapped const))
+#define PK_MODEL_MAPPED_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  PK_TYPE_MODEL_MAPPED, PkModelMappedClass))
+#define PK_IS_MODEL_MAPPED(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), PK_TYPE_MODEL_MAPPED))
+#define PK_IS_MODEL_MAPPED_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  PK_TYPE_MODEL_MAPPED))
+#define PK_MODEL_MAPPED_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  PK_TYPE_MODEL_MAPPED, PkModelMappedClass))
+
+typedef struct _PkModelMapped        PkModelMapped;
+typedef struct _PkModelMappedClass   PkModelMappedClass;
+typedef struct _PkModelMappedPrivate PkModelMappedPrivate;
+
+struct _PkModelMapped
+{
+	PkModel parent;
+
+	/*< private >*/
+	PkModelMappedPrivate *priv;
+};
+
+struct _PkModelMappedClass
+{
+	PkModelClass parent_class;
+};
+
+GType        pk_model_mapped_get_type     (void) G_GNUC_CONST;
+PkModel*     pk_model_mapped_new          (const gchar    *filename,
+                                           GError        **error);
+gboolean     pk_model_mapped_flush        (PkModelMapped  *mapped,
+                                           GError        **error);
+const gchar* pk_model_mapped_get_filename (PkModelMapped  *mapped);
+
+G_END_DECLS
+
+#endif /* PK_MODEL_MAPPED_H */
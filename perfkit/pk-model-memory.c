@@ -22,11 +22,52 @@
 #include "pk-model-memory.h"
 
 
+/*
+ * Samples are stored in a ring so that the oldest can be discarded in
+ * constant time when the model has a retention policy. The ring is grown
+ * by doubling when full, so without a retention policy it behaves like
+ * an array. Index 0 of the model is always the oldest sample, at head.
+ *
+ * Counter deltas and the values of registered builders are computed once
+ * as each sample is inserted and kept in rings of doubles alongside the
+ * samples, so reading them is a single array access.
+ *
+ * Each manifest starts a span of samples that it describes, up to the
+ * time of the next manifest. Spans keep a table from field quark to row
+ * id. Iterators remember their span and only look it up again when they
+ * step across its boundary, so iterating and reading values does not
+ * search the manifests or their rows.
+ */
+
+
+#define RING_MIN_SIZE (64)
+
+
+typedef struct
+{
+	GQuark    key;
+	gboolean  builder;
+	gdouble  *ring;
+} PkModelMemoryDerived;
+
+
+typedef struct
+{
+	PkManifest *manifest;
+	gdouble     begin_time;
+	gdouble     end_time;
+	GHashTable *rows;     /* GQuark to row id */
+} PkModelMemorySpan;
+
+
 struct _PkModelMemoryPrivate
 {
-	GPtrArray  *manifests;
-	GPtrArray  *samples;
-	GHashTable *modes;
+	GPtrArray  *spans;
+	PkSample  **ring;
+	guint       ring_size;
+	guint       head;
+	guint       n_samples;
+	GPtrArray  *derived;
 };
 
 
@@ -46,17 +87,224 @@ compare_double (const gdouble *xp,
 }
 
 
+static inline guint
+pk_model_memory_get_slot (PkModelMemoryPrivate *priv,
+                          guint                 index_)
+{
+	return (priv->head + index_) & (priv->ring_size - 1);
+}
+
+
+static inline PkSample*
+pk_model_memory_get_sample (PkModelMemoryPrivate *priv,
+                            guint                 index_)
+{
+	return priv->ring[pk_model_memory_get_slot(priv, index_)];
+}
+
+
+static PkModelMemoryDerived*
+pk_model_memory_get_derived (PkModelMemory *memory,
+                             GQuark         key)
+{
+	PkModelMemoryDerived *derived;
+	gint i;
+
+	for (i = 0; i < memory->priv->derived->len; i++) {
+		derived = g_ptr_array_index(memory->priv->derived, i);
+		if (derived->key == key) {
+			return derived;
+		}
+	}
+	return NULL;
+}
+
+
+static void
+pk_model_memory_derived_free (PkModelMemoryDerived *derived)
+{
+	g_free(derived->ring);
+	g_slice_free(PkModelMemoryDerived, derived);
+}
+
+
+static PkModelMemorySpan*
+pk_model_memory_span_new (PkManifest *manifest)
+{
+	PkModelMemorySpan *span;
+	gint n_rows;
+	gint i;
+
+	span = g_slice_new0(PkModelMemorySpan);
+	span->manifest = pk_manifest_ref(manifest);
+	span->begin_time = manifest->time;
+	span->end_time = G_MAXDOUBLE;
+	span->rows = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	n_rows = pk_manifest_get_n_rows(manifest);
+	for (i = 1; i <= n_rows; i++) {
+		g_hash_table_insert(span->rows,
+		                    GUINT_TO_POINTER(g_quark_from_string(
+		                        pk_manifest_get_row_name(manifest, i))),
+		                    GINT_TO_POINTER(i));
+	}
+
+	return span;
+}
+
+
+static void
+pk_model_memory_span_free (PkModelMemorySpan *span)
+{
+	pk_manifest_unref(span->manifest);
+	g_hash_table_destroy(span->rows);
+	g_slice_free(PkModelMemorySpan, span);
+}
+
+
+static inline gint
+pk_model_memory_span_get_row_id (PkModelMemorySpan *span,
+                                 GQuark             key)
+{
+	gpointer row_id;
+
+	if (!(row_id = g_hash_table_lookup(span->rows, GUINT_TO_POINTER(key)))) {
+		return -1;
+	}
+	return GPOINTER_TO_INT(row_id);
+}
+
+
+static void
+pk_model_memory_grow (PkModelMemoryPrivate *priv,
+                      guint                 n_samples)
+{
+	PkModelMemoryDerived *derived;
+	PkSample **ring;
+	gdouble *values;
+	guint ring_size;
+	guint i;
+	guint j;
+
+	if (priv->ring_size >= n_samples) {
+		return;
+	}
+
+	ring_size = MAX(priv->ring_size, RING_MIN_SIZE);
+	while (ring_size < n_samples) {
+		ring_size <<= 1;
+	}
+
+	/*
+	 * Unwrap the rings into the new buffers so that head starts at zero.
+	 */
+	ring = g_new(PkSample*, ring_size);
+	for (i = 0; i < priv->n_samples; i++) {
+		ring[i] = pk_model_memory_get_sample(priv, i);
+	}
+	for (j = 0; j < priv->derived->len; j++) {
+		derived = g_ptr_array_index(priv->derived, j);
+		values = g_new0(gdouble, ring_size);
+		for (i = 0; i < priv->n_samples; i++) {
+			values[i] = derived->ring[pk_model_memory_get_slot(priv, i)];
+		}
+		g_free(derived->ring);
+		derived->ring = values;
+	}
+	g_free(priv->ring);
+	priv->ring = ring;
+	priv->ring_size = ring_size;
+	priv->head = 0;
+}
+
+
+static inline void
+pk_model_memory_push (PkModelMemoryPrivate *priv,
+                      PkSample             *sample)
+{
+	guint idx;
+
+	idx = pk_model_memory_get_slot(priv, priv->n_samples);
+	priv->ring[idx] = pk_sample_ref(sample);
+	priv->n_samples++;
+}
+
+
+/**
+ * pk_model_memory_expire:
+ * @memory: (in): A #PkModelMemory.
+ *
+ * Discards the samples that fall outside of the retention policy of the
+ * model, along with the spans of manifests that no longer describe a
+ * sample.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_memory_expire (PkModelMemory *memory)
+{
+	PkModelMemoryPrivate *priv = memory->priv;
+	PkModelMemorySpan *span;
+	PkSample *first;
+	gdouble cutoff = 0.0;
+	gdouble max_age;
+	guint max_samples;
+	guint n_spans = 0;
+
+	max_samples = pk_model_get_max_samples(PK_MODEL(memory));
+	max_age = pk_model_get_max_age(PK_MODEL(memory));
+	if ((!max_samples && max_age <= 0.0) || !priv->n_samples) {
+		return;
+	}
+
+	if (max_age > 0.0) {
+		cutoff = pk_model_memory_get_sample(priv, priv->n_samples - 1)->time
+		         - max_age;
+	}
+
+	while (priv->n_samples) {
+		first = pk_model_memory_get_sample(priv, 0);
+		if (!(max_samples && priv->n_samples > max_samples) &&
+		    !(max_age > 0.0 && first->time < cutoff)) {
+			break;
+		}
+		pk_sample_unref(first);
+		priv->head = (priv->head + 1) & (priv->ring_size - 1);
+		priv->n_samples--;
+	}
+
+	/*
+	 * Keep the span containing the first sample, and everything after it.
+	 */
+	if (priv->n_samples) {
+		first = pk_model_memory_get_sample(priv, 0);
+		while (n_spans + 1 < priv->spans->len) {
+			span = g_ptr_array_index(priv->spans, n_spans + 1);
+			if (span->begin_time > first->time) {
+				break;
+			}
+			pk_model_memory_span_free(g_ptr_array_index(priv->spans, n_spans));
+			n_spans++;
+		}
+		if (n_spans) {
+			g_ptr_array_remove_range(priv->spans, 0, n_spans);
+			span = g_ptr_array_index(priv->spans, 0);
+			span->begin_time = -G_MAXDOUBLE;
+		}
+	}
+}
+
+
 static gint
-pk_model_memory_find_manifest_for_time (PkModelMemory *memory,
-                                        gdouble        target_time)
+pk_model_memory_find_span (PkModelMemory *memory,
+                           gdouble        target_time)
 {
 	PkModelMemoryPrivate *priv;
-	PkManifest **manifests;
+	PkModelMemorySpan *span;
 	gint left = 0;
-	gint middle = 0;
-	gint ret;
+	gint middle;
 	gint right;
-	guint n_manifests;
 
 	g_return_val_if_fail(PK_IS_MODEL_MEMORY(memory), -1);
 
@@ -65,45 +313,26 @@ pk_model_memory_find_manifest_for_time (PkModelMemory *memory,
 	/*
 	 * If we have no manifests stored, we can immediately fail.
 	 */
-	if (!(n_manifests = priv->manifests->len)) {
+	if (!priv->spans->len) {
 		return -1;
 	}
 
 	/*
-	 * Lets use the array of manfiests directly. Makes the code a bit
-	 * cleaner and less macros used.
+	 * Binary search for the last span beginning at or before the target
+	 * time. Samples older than the first manifest belong to the first span.
 	 */
-	manifests = (PkManifest **)priv->manifests->pdata;
-	right = n_manifests - 1;
-
-	/*
-	 * Binary search through the array of samples until we find a match
-	 * or have exhausted our divide-and-conquer (which with a normal
-	 * binary search would be a failure).
-	 */
-	while (left <= right) {
-		middle = (left + right) / 2;
-		ret = compare_double(&manifests[middle]->time, &target_time);
-		switch (ret) {
-		case -1:
-			left = middle + 1;
-			break;
-		case 1:
+	right = priv->spans->len - 1;
+	while (left < right) {
+		middle = (left + right + 1) / 2;
+		span = g_ptr_array_index(priv->spans, middle);
+		if (span->begin_time <= target_time) {
+			left = middle;
+		} else {
 			right = middle - 1;
-			break;
-		case 0:
-			return middle;
-		default:
-			g_assert_not_reached();
-			return -1;
 		}
 	}
 
-	/*
-	 * The item on the left must be the closest. However, there is a chance
-	 * we overran the end of the items so clip to the end.
-	 */
-	return MIN(left, n_manifests - 1);
+	return left;
 }
 
 
@@ -114,7 +343,6 @@ pk_model_memory_find_nearest_sample (PkModelMemory *memory,
                                      gboolean       prefer_right)
 {
 	PkModelMemoryPrivate *priv;
-	PkSample **samples;
 	gint left = 0;
 	gint middle = 0;
 	gint ret;
@@ -128,17 +356,14 @@ pk_model_memory_find_nearest_sample (PkModelMemory *memory,
 	/*
 	 * If we have no samples stored, we can immediately fail.
 	 */
-	if (!(n_samples = priv->samples->len)) {
+	if (!(n_samples = priv->n_samples)) {
 		return -1;
 	}
 
-	/*
-	 * Lets use the array of samples directly. Makes the code a bit
-	 * cleaner and less macros used.
-	 */
-	samples = (PkSample **)priv->samples->pdata;
 	right = n_samples - 1;
 
+#define SAMPLE(_i) pk_model_memory_get_sample(priv, (_i))
+
 	/*
 	 * Binary search through the array of samples until we find a match
 	 * or have exhausted our divide-and-conquer (which with a normal
@@ -146,7 +371,7 @@ pk_model_memory_find_nearest_sample (PkModelMemory *memory,
 	 */
 	while (left <= right) {
 		middle = (left + right) / 2;
-		ret = compare_double(&samples[middle]->time, &target_time);
+		ret = compare_double(&SAMPLE(middle)->time, &target_time);
 		switch (ret) {
 		case -1:
 			left = middle + 1;
@@ -171,37 +396,30 @@ pk_model_memory_find_nearest_sample (PkModelMemory *memory,
 	 * on @prefer_right.
 	 */
 	if (!prefer_right) {
-		while (middle >= 0 && samples[middle]->time >= target_time) {
+		while (middle >= 0 && SAMPLE(middle)->time >= target_time) {
 			middle--;
 		}
 		if (middle < 0) {
-			if (samples[0]->time < other_time) {
+			if (SAMPLE(0)->time < other_time) {
 				return 0;
 			}
 			return -1;
 		}
 		return middle;
 	} else {
-		while (middle < n_samples && samples[middle]->time <= target_time) {
+		while (middle < n_samples && SAMPLE(middle)->time <= target_time) {
 			middle++;
 		}
 		if (middle >= n_samples) {
-			if (samples[n_samples-1]->time > other_time) {
+			if (SAMPLE(n_samples - 1)->time > other_time) {
 				return n_samples - 1;
 			}
 			return -1;
 		}
 		return middle;
 	}
-}
 
-
-static PkModelMode
-pk_model_memory_get_field_mode (PkModelMemory *memory,
-                                GQuark         key)
-{
-	g_return_val_if_fail(PK_IS_MODEL_MEMORY(memory), 0);
-	return (PkModelMode)g_hash_table_lookup(memory->priv->modes, &key);
+#undef SAMPLE
 }
 
 
@@ -211,28 +429,21 @@ pk_model_memory_insert_manifest (PkModel    *model,
 {
 	PkModelMemory *memory = (PkModelMemory *)model;
 	PkModelMemoryPrivate *priv;
+	PkModelMemorySpan *span;
+	PkModelMemorySpan *last;
 
 	g_return_if_fail(PK_IS_MODEL_MEMORY(memory));
 
 	priv = memory->priv;
 
-	g_ptr_array_add(priv->manifests, pk_manifest_ref(manifest));
-}
-
-
-static void
-pk_model_memory_insert_sample (PkModel    *model,
-                               PkManifest *manifest,
-                               PkSample   *sample)
-{
-	PkModelMemory *memory = (PkModelMemory *)model;
-	PkModelMemoryPrivate *priv;
-
-	g_return_if_fail(PK_IS_MODEL_MEMORY(memory));
-
-	priv = memory->priv;
-
-	g_ptr_array_add(priv->samples, pk_sample_ref(sample));
+	span = pk_model_memory_span_new(manifest);
+	if (priv->spans->len) {
+		last = g_ptr_array_index(priv->spans, priv->spans->len - 1);
+		last->end_time = span->begin_time;
+	} else {
+		span->begin_time = -G_MAXDOUBLE;
+	}
+	g_ptr_array_add(priv->spans, span);
 }
 
 
@@ -243,7 +454,8 @@ set_iter (PkModelMemory *memory,
           gint           begin_index,
           gint           end_index)
 {
-	gint manifest_idx;
+	PkModelMemorySpan *span = iter->user_data;
+	gint span_idx;
 
 	/*
 	 * Update the time of the current event.
@@ -251,12 +463,17 @@ set_iter (PkModelMemory *memory,
 	iter->time = sample->time;
 
 	/*
-	 * Get the manifest for this sample.
+	 * Get the span of the manifest for this sample, unless the sample is
+	 * still within the span of the previous one.
 	 */
-	manifest_idx = pk_model_memory_find_manifest_for_time(memory, sample->time);
-	g_assert_cmpint(manifest_idx, >=, 0);
-	g_assert_cmpint(manifest_idx, <, memory->priv->manifests->len);
-	iter->user_data = g_ptr_array_index(memory->priv->manifests, manifest_idx);
+	if (!span ||
+	    sample->time < span->begin_time ||
+	    sample->time >= span->end_time) {
+		span_idx = pk_model_memory_find_span(memory, sample->time);
+		g_assert_cmpint(span_idx, >=, 0);
+		g_assert_cmpint(span_idx, <, memory->priv->spans->len);
+		iter->user_data = g_ptr_array_index(memory->priv->spans, span_idx);
+	}
 
 	/*
 	 * Update the active sample.
@@ -272,23 +489,190 @@ set_iter (PkModelMemory *memory,
 
 
 static void
-get_iter (PkModelMemory  *memory,
-          PkModelIter    *iter,
-          PkManifest    **manifest,
-          PkSample      **sample,
-          gint           *begin_index,
-          gint           *end_index)
+get_iter (PkModelMemory      *memory,
+          PkModelIter        *iter,
+          PkModelMemorySpan **span,
+          PkSample          **sample,
+          gint               *begin_index,
+          gint               *end_index)
 {
 	g_assert(iter->user_data);
 	g_assert(iter->user_data2);
 
-	*manifest = iter->user_data;
+	*span = iter->user_data;
 	*sample = iter->user_data2;
 	*begin_index = GPOINTER_TO_INT(iter->user_data3);
 	*end_index = GPOINTER_TO_INT(iter->user_data4);
 }
 
 
+static gdouble
+pk_model_memory_get_raw_double (PkModelMemory *memory,
+                                guint          index_,
+                                GQuark         key)
+{
+	PkModelMemoryPrivate *priv = memory->priv;
+	PkModelMemorySpan *span;
+	PkSample *sample;
+	GValue value = { 0 };
+	gdouble ret;
+	gint span_idx;
+
+	sample = pk_model_memory_get_sample(priv, index_);
+	if ((span_idx = pk_model_memory_find_span(memory, sample->time)) < 0) {
+		return 0.0;
+	}
+	span = g_ptr_array_index(priv->spans, span_idx);
+
+	g_value_init(&value, G_TYPE_DOUBLE);
+	pk_sample_get_value(sample, pk_model_memory_span_get_row_id(span, key),
+	                    &value);
+	ret = g_value_get_double(&value);
+	g_value_unset(&value);
+
+	return ret;
+}
+
+
+/**
+ * pk_model_memory_derive:
+ * @memory: (in): A #PkModelMemory.
+ * @derived: (in): The derived field to compute.
+ * @index_: (in): The index of the sample.
+ *
+ * Computes and stores the counter delta or builder value of @derived for
+ * the sample at @index_.  Counters are computed before builders so that
+ * builders may read them.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_memory_derive (PkModelMemory        *memory,
+                        PkModelMemoryDerived *derived,
+                        guint                 index_)
+{
+	PkModelMemoryPrivate *priv = memory->priv;
+	PkModelIter iter;
+	GValue value = { 0 };
+	gdouble *slot;
+
+	slot = &derived->ring[pk_model_memory_get_slot(priv, index_)];
+
+	if (!derived->builder) {
+		*slot = 0.0;
+		if (index_ > 0) {
+			*slot = pk_model_memory_get_raw_double(memory, index_, derived->key) -
+			        pk_model_memory_get_raw_double(memory, index_ - 1, derived->key);
+		}
+		return;
+	}
+
+	memset(&iter, 0, sizeof iter);
+	set_iter(memory, &iter, pk_model_memory_get_sample(priv, index_),
+	         index_, index_);
+	g_value_init(&value, G_TYPE_DOUBLE);
+	pk_model_build_value(PK_MODEL(memory), &iter, derived->key, &value);
+	*slot = g_value_get_double(&value);
+	g_value_unset(&value);
+}
+
+
+static void
+pk_model_memory_derive_all (PkModelMemory *memory,
+                            guint          index_)
+{
+	PkModelMemoryDerived *derived;
+	gint i;
+
+	for (i = 0; i < memory->priv->derived->len; i++) {
+		derived = g_ptr_array_index(memory->priv->derived, i);
+		if (!derived->builder) {
+			pk_model_memory_derive(memory, derived, index_);
+		}
+	}
+	for (i = 0; i < memory->priv->derived->len; i++) {
+		derived = g_ptr_array_index(memory->priv->derived, i);
+		if (derived->builder) {
+			pk_model_memory_derive(memory, derived, index_);
+		}
+	}
+}
+
+
+static PkModelMemoryDerived*
+pk_model_memory_add_derived (PkModelMemory *memory,
+                             GQuark         key,
+                             gboolean       builder)
+{
+	PkModelMemoryPrivate *priv = memory->priv;
+	PkModelMemoryDerived *derived;
+	guint i;
+
+	derived = g_slice_new0(PkModelMemoryDerived);
+	derived->key = key;
+	derived->builder = builder;
+	if (priv->ring_size) {
+		derived->ring = g_new0(gdouble, priv->ring_size);
+	}
+	g_ptr_array_add(priv->derived, derived);
+
+	/*
+	 * Fill in the samples that were inserted before the field was.
+	 */
+	for (i = 0; i < priv->n_samples; i++) {
+		pk_model_memory_derive(memory, derived, i);
+	}
+
+	return derived;
+}
+
+
+static void
+pk_model_memory_insert_sample (PkModel    *model,
+                               PkManifest *manifest,
+                               PkSample   *sample)
+{
+	PkModelMemory *memory = (PkModelMemory *)model;
+	PkModelMemoryPrivate *priv;
+
+	g_return_if_fail(PK_IS_MODEL_MEMORY(memory));
+
+	priv = memory->priv;
+
+	pk_model_memory_grow(priv, priv->n_samples + 1);
+	pk_model_memory_push(priv, sample);
+	pk_model_memory_derive_all(memory, priv->n_samples - 1);
+	pk_model_memory_expire(memory);
+}
+
+
+static void
+pk_model_memory_insert_samples (PkModel     *model,
+                                PkManifest  *manifest,
+                                PkSample   **samples,
+                                guint        n_samples)
+{
+	PkModelMemory *memory = (PkModelMemory *)model;
+	PkModelMemoryPrivate *priv;
+	guint i;
+
+	g_return_if_fail(PK_IS_MODEL_MEMORY(memory));
+
+	priv = memory->priv;
+
+	/*
+	 * Grow the ring once for the whole batch rather than per sample.
+	 */
+	pk_model_memory_grow(priv, priv->n_samples + n_samples);
+	for (i = 0; i < n_samples; i++) {
+		pk_model_memory_push(priv, samples[i]);
+		pk_model_memory_derive_all(memory, priv->n_samples - 1);
+	}
+	pk_model_memory_expire(memory);
+}
+
+
 static gboolean
 pk_model_memory_get_iter_first (PkModel     *model,
                                 PkModelIter *iter)
@@ -302,9 +686,10 @@ pk_model_memory_get_iter_first (PkModel     *model,
 
 	priv = memory->priv;
 
-	if ((ret = !!priv->samples->len)) {
-		set_iter(memory, iter, g_ptr_array_index(priv->samples, 0),
-		         0, priv->samples->len - 1);
+	memset(iter, 0, sizeof *iter);
+	if ((ret = !!priv->n_samples)) {
+		set_iter(memory, iter, pk_model_memory_get_sample(priv, 0),
+		         0, priv->n_samples - 1);
 	}
 	return ret;
 }
@@ -344,104 +729,19 @@ pk_model_memory_get_iter_for_range (PkModel     *model,
 		return FALSE;
 	}
 
-	g_assert_cmpint(begin_idx, <, priv->samples->len);
-	g_assert_cmpint(end_idx, <, priv->samples->len);
+	g_assert_cmpint(begin_idx, <, priv->n_samples);
+	g_assert_cmpint(end_idx, <, priv->n_samples);
 
 	/*
 	 * Create iterator using discovered indexes.
 	 */
-	sample = g_ptr_array_index(priv->samples, begin_idx);
+	sample = pk_model_memory_get_sample(priv, begin_idx);
 	set_iter(memory, iter, sample, begin_idx, end_idx);
 
 	return TRUE;
 }
 
 
-static void
-subtract (const GValue *x,
-          const GValue *y,
-          GValue       *result)
-{
-	gdouble xd;
-	gdouble yd;
-	gdouble v;
-
-	switch (x->g_type) {
-	case G_TYPE_DOUBLE:
-		xd = g_value_get_double(x);
-		break;
-	case G_TYPE_INT:
-		xd = g_value_get_int(x);
-		break;
-	case G_TYPE_INT64:
-		xd = g_value_get_int64(x);
-		break;
-	case G_TYPE_UINT:
-		xd = g_value_get_uint(x);
-		break;
-	case G_TYPE_UINT64:
-		xd = g_value_get_uint64(x);
-		break;
-	default:
-		/*
-		 * TODO: Add types.
-		 */
-		g_assert_not_reached();
-		return;
-	}
-
-	switch (y->g_type) {
-	case G_TYPE_DOUBLE:
-		yd = g_value_get_double(y);
-		break;
-	case G_TYPE_INT:
-		yd = g_value_get_int(y);
-		break;
-	case G_TYPE_INT64:
-		yd = g_value_get_int64(y);
-		break;
-	case G_TYPE_UINT:
-		yd = g_value_get_uint(y);
-		break;
-	case G_TYPE_UINT64:
-		yd = g_value_get_uint64(y);
-		break;
-	default:
-		/*
-		 * TODO: Add types.
-		 */
-		g_assert_not_reached();
-		return;
-	}
-
-	v = xd - yd;
-
-	switch (result->g_type) {
-	case G_TYPE_DOUBLE:
-		g_value_set_double(result, v);
-		break;
-	case G_TYPE_INT:
-		g_value_set_int(result, v);
-		break;
-	case G_TYPE_INT64:
-		g_value_set_int64(result, v);
-		break;
-	case G_TYPE_UINT:
-		g_value_set_uint(result, v);
-		break;
-	case G_TYPE_UINT64:
-		g_value_set_uint64(result, v);
-		break;
-	default:
-		/*
-		 * TODO: Add types.
-		 */
-		g_assert_not_reached();
-		return;
-	}
-}
-
-
 static void
 pk_model_memory_get_value (PkModel     *model,
                            PkModelIter *iter,
@@ -450,10 +750,10 @@ pk_model_memory_get_value (PkModel     *model,
 {
 	PkModelMemoryPrivate *priv;
 	PkModelMemory *memory = (PkModelMemory *)model;
-	PkManifest *manifest = NULL;
+	PkModelMemoryDerived *derived;
+	PkModelMemorySpan *span = NULL;
 	PkSample *sample = NULL;
-	PkSample *last;
-	GValue last_value = { 0 };
+	GValue derived_value = { 0 };
 	gint end_index;
 	gint row_id;
 	gint begin_index;
@@ -462,38 +762,28 @@ pk_model_memory_get_value (PkModel     *model,
 
 	priv = memory->priv;
 
-	/*
-	 * TODO: This is likely to be a hot method that could use some optimization
-	 *       on how we determine the row id for lookup. Alternatively, we could
-	 *       use a quark like system for all keys and use them.
-	 */
-
-	get_iter(memory, iter, &manifest, &sample, &begin_index, &end_index);
-	g_assert(manifest);
+	get_iter(memory, iter, &span, &sample, &begin_index, &end_index);
+	g_assert(span);
 	g_assert(sample);
 
-	row_id = pk_manifest_get_row_id_from_quark(manifest, key);
-	pk_sample_get_value(sample, row_id, value);
-
-	/*
-	 * XXX: Obviously, this is a shitty way to do things.
-	 */
-	if (pk_model_memory_get_field_mode(memory, key) == PK_MODEL_COUNTER) {
-		if (begin_index == 0) {
+	if ((derived = pk_model_memory_get_derived(memory, key))) {
+		if (!derived->builder && begin_index == 0) {
 			/*
 			 * Can't calculate value on first item.
 			 */
 			g_value_reset(value);
-		} else {
-			/*
-			 * TODO: There is a chance the last item doesnt share the manifest
-			 *       and therefore has a different row id.
-			 */
-			last = g_ptr_array_index(priv->samples, begin_index - 1);
-			pk_sample_get_value(last, row_id, &last_value);
-			subtract(value, &last_value, value);
+			return;
 		}
+		g_value_init(&derived_value, G_TYPE_DOUBLE);
+		g_value_set_double(&derived_value,
+		                   derived->ring[pk_model_memory_get_slot(priv, begin_index)]);
+		g_value_transform(&derived_value, value);
+		g_value_unset(&derived_value);
+		return;
 	}
+
+	row_id = pk_model_memory_span_get_row_id(span, key);
+	pk_sample_get_value(sample, row_id, value);
 }
 
 
@@ -503,7 +793,7 @@ pk_model_memory_iter_next (PkModel     *model,
 {
 	PkModelMemoryPrivate *priv;
 	PkModelMemory *memory = (PkModelMemory *)model;
-	PkManifest *manifest = NULL;
+	PkModelMemorySpan *span = NULL;
 	PkSample *sample = NULL;
 	gint end_index = 0;
 	gint begin_index = 0;
@@ -513,10 +803,10 @@ pk_model_memory_iter_next (PkModel     *model,
 
 	priv = memory->priv;
 
-	get_iter(memory, iter, &manifest, &sample, &begin_index, &end_index);
+	get_iter(memory, iter, &span, &sample, &begin_index, &end_index);
 
 	if (++begin_index <= end_index) {
-		sample = g_ptr_array_index(priv->samples, begin_index);
+		sample = pk_model_memory_get_sample(priv, begin_index);
 		set_iter(memory, iter, sample, begin_index, end_index);
 		return TRUE;
 	}
@@ -531,16 +821,34 @@ pk_model_memory_set_field_mode (PkModel     *model,
                                 PkModelMode  mode)
 {
 	PkModelMemory *memory = (PkModelMemory *)model;
-	PkModelMemoryPrivate *priv;
-	GQuark *pkey;
+	PkModelMemoryDerived *derived;
 
 	g_return_if_fail(PK_IS_MODEL_MEMORY(memory));
 
-	priv = memory->priv;
+	derived = pk_model_memory_get_derived(memory, key);
+	if (mode == PK_MODEL_COUNTER) {
+		if (!derived) {
+			pk_model_memory_add_derived(memory, key, FALSE);
+		}
+	} else if (derived && !derived->builder) {
+		g_ptr_array_remove(memory->priv->derived, derived);
+		pk_model_memory_derived_free(derived);
+	}
+}
+
 
-	pkey = g_new0(GQuark, 1);
-	*pkey = key;
-	g_hash_table_insert(priv->modes, pkey, GINT_TO_POINTER(mode));
+static void
+pk_model_memory_builder_added (PkModel *model,
+                               GQuark   key)
+{
+	PkModelMemory *memory = (PkModelMemory *)model;
+
+	g_return_if_fail(PK_IS_MODEL_MEMORY(memory));
+
+	if (!pk_model_memory_get_derived(memory, key)) {
+		pk_model_memory_add_derived(memory, key, TRUE);
+		pk_model_set_materialized(model, key);
+	}
 }
 
 
@@ -558,17 +866,22 @@ static void
 pk_model_memory_finalize (GObject *object)
 {
 	PkModelMemoryPrivate *priv = PK_MODEL_MEMORY(object)->priv;
+	guint i;
 
-	g_ptr_array_foreach(priv->manifests, (GFunc)pk_manifest_unref, NULL);
-	g_ptr_array_free(priv->manifests, TRUE);
-	priv->manifests = NULL;
+	g_ptr_array_foreach(priv->spans, (GFunc)pk_model_memory_span_free, NULL);
+	g_ptr_array_free(priv->spans, TRUE);
+	priv->spans = NULL;
 
-	g_ptr_array_foreach(priv->samples, (GFunc)pk_sample_unref, NULL);
-	g_ptr_array_free(priv->samples, TRUE);
-	priv->samples = NULL;
+	for (i = 0; i < priv->n_samples; i++) {
+		pk_sample_unref(pk_model_memory_get_sample(priv, i));
+	}
+	g_free(priv->ring);
+	priv->ring = NULL;
 
-	g_hash_table_destroy(priv->modes);
-	priv->modes = NULL;
+	g_ptr_array_foreach(priv->derived, (GFunc)pk_model_memory_derived_free,
+	                    NULL);
+	g_ptr_array_free(priv->derived, TRUE);
+	priv->derived = NULL;
 
 	G_OBJECT_CLASS(pk_model_memory_parent_class)->finalize(object);
 }
@@ -594,11 +907,13 @@ pk_model_memory_class_init (PkModelMemoryClass *klass)
 	g_type_class_add_private(object_class, sizeof(PkModelMemoryPrivate));
 
 	model_class = PK_MODEL_CLASS(klass);
+	model_class->builder_added = pk_model_memory_builder_added;
 	model_class->get_iter_first = pk_model_memory_get_iter_first;
 	model_class->get_iter_for_range = pk_model_memory_get_iter_for_range;
 	model_class->get_value = pk_model_memory_get_value;
 	model_class->insert_manifest = pk_model_memory_insert_manifest;
 	model_class->insert_sample = pk_model_memory_insert_sample;
+	model_class->insert_samples = pk_model_memory_insert_samples;
 	model_class->iter_next = pk_model_memory_iter_next;
 	model_class->set_field_mode = pk_model_memory_set_field_mode;
 }
@@ -619,8 +934,6 @@ pk_model_memory_init (PkModelMemory *memory)
 	memory->priv = G_TYPE_INSTANCE_GET_PRIVATE(memory, PK_TYPE_MODEL_MEMORY,
 	                                           PkModelMemoryPrivate);
 
-	memory->priv->manifests = g_ptr_array_new();
-	memory->priv->samples = g_ptr_array_new();
-	memory->priv->modes =
-		g_hash_table_new_full(g_int_hash, g_int_equal, g_free, NULL);
+	memory->priv->spans = g_ptr_array_new();
+	memory->priv->derived = g_ptr_array_new();
 }
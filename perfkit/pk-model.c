@@ -16,15 +16,27 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include "pk-marshal.h"
 #include "pk-model.h"
+#include "pk-sketch.h"
 
 
 struct _PkModelPrivate
 {
 	GHashTable *accumulators;
+	GHashTable *reducible;    /* Keys using a built-in accumulator */
 	GHashTable *builders;
+	GHashTable *materialized;
 	gdouble     end_time;
+	guint       max_samples;
+	gdouble     max_age;
+
+	/*
+	 * Held while inserting, and by readers outside of the main loop.
+	 */
+	GStaticRecMutex lock;
 };
 
 
@@ -42,6 +54,8 @@ enum
 	PROP_0,
 
 	PROP_END_TIME,
+	PROP_MAX_AGE,
+	PROP_MAX_SAMPLES,
 
 	LAST_PROP
 };
@@ -54,6 +68,57 @@ static GParamSpec *pspecs[LAST_PROP] = { NULL };
 static guint       signals[LAST_SIGNAL] = { 0 };
 
 
+/**
+ * pk_model_accumulate_reduced:
+ * @model: (in): A #PkModel.
+ * @iter: (in): A #PkModelIter.
+ * @key: (in): The field to accumulate.
+ * @return_value: (out): A location for the mean.
+ *
+ * Accumulates the mean of @key for the built-in accumulators.  Models that
+ * store their samples in columns reduce the slice of the column covered
+ * by @iter in place, rather than boxing each value into a #GValue.  Other
+ * models have each value fetched with pk_model_get_double() and reduced
+ * with pk_model_reduce_double().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+pk_model_accumulate_reduced (PkModel     *model,
+                             PkModelIter *iter,
+                             GQuark       key,
+                             GValue      *return_value)
+{
+	PkModelClass *klass;
+	PkModelStats stats;
+	GValue mean = { 0 };
+	GArray *values;
+	gdouble value;
+
+	klass = PK_MODEL_GET_CLASS(model);
+	if (!klass->reduce ||
+	    (g_hash_table_lookup(model->priv->builders, &key) &&
+	     !g_hash_table_lookup(model->priv->materialized, GUINT_TO_POINTER(key))) ||
+	    !klass->reduce(model, iter, key, &stats)) {
+		values = g_array_sized_new(FALSE, FALSE, sizeof(gdouble), 256);
+		do {
+			value = pk_model_get_double(model, iter, key);
+			g_array_append_val(values, value);
+		} while (pk_model_iter_next(model, iter));
+
+		pk_model_reduce_double((const gdouble *)values->data, NULL,
+		                       values->len, &stats);
+		g_array_free(values, TRUE);
+	}
+
+	g_value_init(&mean, G_TYPE_DOUBLE);
+	g_value_set_double(&mean, stats.mean);
+	g_value_transform(&mean, return_value);
+	g_value_unset(&mean);
+}
+
+
 void
 pk_model_accumulate (PkModel     *model,
                      PkModelIter *iter,
@@ -78,6 +143,11 @@ pk_model_accumulate (PkModel     *model,
 		return;
 	}
 
+	if (g_hash_table_lookup(priv->reducible, GUINT_TO_POINTER(key))) {
+		pk_model_accumulate_reduced(model, iter, key, return_value);
+		return;
+	}
+
 	values = g_value_array_new(8);
 	g_value_init(&params[0], G_TYPE_VALUE);
 	g_value_init(&params[1], G_TYPE_VALUE_ARRAY);
@@ -114,7 +184,9 @@ pk_model_insert_manifest (PkModel    *model,
 	g_return_if_fail(PK_IS_MODEL(model));
 	g_return_if_fail(manifest != NULL);
 
+	g_static_rec_mutex_lock(&model->priv->lock);
 	PK_MODEL_GET_CLASS(model)->insert_manifest(model, manifest);
+	g_static_rec_mutex_unlock(&model->priv->lock);
 }
 
 
@@ -132,7 +204,103 @@ pk_model_insert_sample (PkModel    *model,
 		g_object_notify_by_pspec(G_OBJECT(model), pspecs[PROP_END_TIME]);
 	}
 
+	g_static_rec_mutex_lock(&model->priv->lock);
 	PK_MODEL_GET_CLASS(model)->insert_sample(model, manifest, sample);
+	g_static_rec_mutex_unlock(&model->priv->lock);
+}
+
+
+/**
+ * pk_model_insert_samples:
+ * @model: (in): A #PkModel.
+ * @manifest: (in): The #PkManifest shared by all of @samples.
+ * @samples: (in) (array length=n_samples): An array of #PkSample.
+ * @n_samples: (in): The number of samples in @samples.
+ *
+ * Inserts a batch of samples that share @manifest into the model. This is
+ * equivalent to calling pk_model_insert_sample() for each sample, but
+ * allows implementations to store the batch at once and only notifies
+ * "end-time" a single time.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_insert_samples (PkModel     *model,
+                         PkManifest  *manifest,
+                         PkSample   **samples,
+                         guint        n_samples)
+{
+	PkModelClass *klass;
+	gdouble end_time;
+	guint i;
+
+	g_return_if_fail(PK_IS_MODEL(model));
+	g_return_if_fail(manifest != NULL);
+	g_return_if_fail(samples != NULL || n_samples == 0);
+
+	if (!n_samples) {
+		return;
+	}
+
+	end_time = model->priv->end_time;
+	for (i = 0; i < n_samples; i++) {
+		if (samples[i]->time > end_time) {
+			end_time = samples[i]->time;
+		}
+	}
+
+	if (G_LIKELY(end_time > model->priv->end_time)) {
+		model->priv->end_time = end_time;
+		g_object_notify_by_pspec(G_OBJECT(model), pspecs[PROP_END_TIME]);
+	}
+
+	klass = PK_MODEL_GET_CLASS(model);
+	g_static_rec_mutex_lock(&model->priv->lock);
+	if (klass->insert_samples) {
+		klass->insert_samples(model, manifest, samples, n_samples);
+	} else {
+		for (i = 0; i < n_samples; i++) {
+			klass->insert_sample(model, manifest, samples[i]);
+		}
+	}
+	g_static_rec_mutex_unlock(&model->priv->lock);
+}
+
+
+/**
+ * pk_model_lock:
+ * @model: (in): A #PkModel.
+ *
+ * Locks @model against inserts.  Samples are inserted from the main loop,
+ * so code reading @model from another thread must hold the lock for as
+ * long as it uses a #PkModelIter.  The lock is recursive.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_lock (PkModel *model)
+{
+	g_return_if_fail(PK_IS_MODEL(model));
+	g_static_rec_mutex_lock(&model->priv->lock);
+}
+
+
+/**
+ * pk_model_unlock:
+ * @model: (in): A #PkModel.
+ *
+ * Releases a lock acquired with pk_model_lock().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_unlock (PkModel *model)
+{
+	g_return_if_fail(PK_IS_MODEL(model));
+	g_static_rec_mutex_unlock(&model->priv->lock);
 }
 
 
@@ -182,8 +350,6 @@ pk_model_get_value (PkModel     *model,
                     GValue      *value)
 {
 	PkModelPrivate *priv;
-	GClosure *closure;
-	GValue values[4] = {{ 0 }};
 
 	g_return_if_fail(PK_IS_MODEL(model));
 	g_return_if_fail(iter != NULL);
@@ -192,26 +358,330 @@ pk_model_get_value (PkModel     *model,
 
 	priv = model->priv;
 
-	if (G_UNLIKELY((closure = g_hash_table_lookup(priv->builders, &key)))) {
-		g_value_init(&values[0], G_TYPE_OBJECT);
-		g_value_init(&values[1], G_TYPE_POINTER);
-		g_value_init(&values[2], G_TYPE_UINT);
-		g_value_init(&values[3], G_TYPE_POINTER);
+	/*
+	 * Builders that the implementation materializes are stored along
+	 * with the samples and read back like any other field.
+	 */
+	if (G_UNLIKELY(g_hash_table_lookup(priv->builders, &key)) &&
+	    !g_hash_table_lookup(priv->materialized, GUINT_TO_POINTER(key))) {
+		pk_model_build_value(model, iter, key, value);
+	} else {
+		PK_MODEL_GET_CLASS(model)->get_value(model, iter, key, value);
+	}
+}
 
-		g_value_set_object(&values[0], model);
-		g_value_set_pointer(&values[1], iter);
-		g_value_set_uint(&values[2], key);
-		g_value_set_pointer(&values[3], value);
 
-		g_closure_invoke(closure, NULL, 4, values, NULL);
+/**
+ * pk_model_build_value:
+ * @model: (in): A #PkModel.
+ * @iter: (in): A #PkModelIter.
+ * @key: (in): The key of a registered builder.
+ * @value: (out): A #GValue to store the result.
+ *
+ * Invokes the builder registered for @key.  This is for use by
+ * implementations that materialize builders (see
+ * pk_model_set_materialized()) to compute the value for a newly
+ * inserted sample.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_build_value (PkModel     *model,
+                      PkModelIter *iter,
+                      GQuark       key,
+                      GValue      *value)
+{
+	GClosure *closure;
+	GValue values[4] = {{ 0 }};
 
-		g_value_unset(&values[0]);
-		g_value_unset(&values[1]);
-		g_value_unset(&values[2]);
-		g_value_unset(&values[3]);
-	} else {
-		PK_MODEL_GET_CLASS(model)->get_value(model, iter, key, value);
+	g_return_if_fail(PK_IS_MODEL(model));
+	g_return_if_fail(iter != NULL);
+	g_return_if_fail(value != NULL);
+
+	if (!(closure = g_hash_table_lookup(model->priv->builders, &key))) {
+		return;
+	}
+
+	g_value_init(&values[0], G_TYPE_OBJECT);
+	g_value_init(&values[1], G_TYPE_POINTER);
+	g_value_init(&values[2], G_TYPE_UINT);
+	g_value_init(&values[3], G_TYPE_POINTER);
+
+	g_value_set_object(&values[0], model);
+	g_value_set_pointer(&values[1], iter);
+	g_value_set_uint(&values[2], key);
+	g_value_set_pointer(&values[3], value);
+
+	g_closure_invoke(closure, NULL, 4, values, NULL);
+
+	g_value_unset(&values[0]);
+	g_value_unset(&values[1]);
+	g_value_unset(&values[2]);
+	g_value_unset(&values[3]);
+}
+
+
+/**
+ * pk_model_set_materialized:
+ * @model: (in): A #PkModel.
+ * @key: (in): The key of a registered builder.
+ *
+ * Marks the builder for @key as materialized by the implementation.  The
+ * implementation computes the value with pk_model_build_value() as each
+ * sample is inserted and stores it, and pk_model_get_value() reads it
+ * back through the get_value vfunc instead of invoking the builder on
+ * every call.  Implementations typically call this from their
+ * builder_added handler.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_set_materialized (PkModel *model,
+                           GQuark   key)
+{
+	g_return_if_fail(PK_IS_MODEL(model));
+	g_return_if_fail(key > 0);
+
+	g_hash_table_insert(model->priv->materialized, GUINT_TO_POINTER(key),
+	                    GINT_TO_POINTER(TRUE));
+}
+
+
+/**
+ * pk_model_get_aggregate:
+ * @model: (in): A #PkModel.
+ * @iter: (in): A #PkModelIter.
+ * @key: (in): The field to aggregate.
+ * @aggregate: (in): The statistic to retrieve.
+ *
+ * Retrieves a statistic for @key over the samples represented by @iter.
+ * When the iter was created with pk_model_get_iter_for_range() and a
+ * non-zero aggregate time, a model may return an iter where each step
+ * covers a bucket of samples rather than a single sample.  For iters
+ * over single samples, %PK_MODEL_AGGREGATE_COUNT is 1 and every other
+ * statistic is the value of the field as returned by
+ * pk_model_get_double().
+ *
+ * Returns: The requested statistic.
+ * Side effects: None.
+ */
+gdouble
+pk_model_get_aggregate (PkModel          *model,
+                        PkModelIter      *iter,
+                        GQuark            key,
+                        PkModelAggregate  aggregate)
+{
+	PkModelClass *klass;
+
+	g_return_val_if_fail(PK_IS_MODEL(model), 0.0);
+	g_return_val_if_fail(iter != NULL, 0.0);
+
+	klass = PK_MODEL_GET_CLASS(model);
+	if (klass->get_aggregate &&
+	    (!g_hash_table_lookup(model->priv->builders, &key) ||
+	     g_hash_table_lookup(model->priv->materialized, GUINT_TO_POINTER(key)))) {
+		return klass->get_aggregate(model, iter, key, aggregate);
+	}
+
+	if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+		return 1.0;
+	}
+	return pk_model_get_double(model, iter, key);
+}
+
+
+/**
+ * pk_model_get_quantile:
+ * @model: (in): A #PkModel.
+ * @iter: (in): A #PkModelIter.
+ * @key: (in): The field to retrieve.
+ * @quantile: (in): The quantile between 0 and 1, such as 0.99.
+ *
+ * Retrieves a quantile of @key over the samples represented by @iter,
+ * such as the 99th percentile of a latency within a bucket.  Models that
+ * keep quantile sketches for their buckets answer within the accuracy of
+ * the sketch; others, and iters over single samples, return the value of
+ * the field as returned by pk_model_get_double().
+ *
+ * Returns: The requested quantile.
+ * Side effects: None.
+ */
+gdouble
+pk_model_get_quantile (PkModel     *model,
+                       PkModelIter *iter,
+                       GQuark       key,
+                       gdouble      quantile)
+{
+	PkModelClass *klass;
+
+	g_return_val_if_fail(PK_IS_MODEL(model), 0.0);
+	g_return_val_if_fail(iter != NULL, 0.0);
+
+	klass = PK_MODEL_GET_CLASS(model);
+	if (klass->get_quantile &&
+	    (!g_hash_table_lookup(model->priv->builders, &key) ||
+	     g_hash_table_lookup(model->priv->materialized, GUINT_TO_POINTER(key)))) {
+		return klass->get_quantile(model, iter, key, quantile);
+	}
+
+	return pk_model_get_double(model, iter, key);
+}
+
+
+/**
+ * pk_model_get_range_aggregate:
+ * @model: (in): A #PkModel.
+ * @key: (in): The field to aggregate.
+ * @begin_time: (in): The time of the first sample to include.
+ * @end_time: (in): The time of the last sample to include.
+ * @aggregate: (in): The statistic to retrieve.
+ *
+ * Retrieves a statistic for @key over every sample between @begin_time
+ * and @end_time, inclusive.  Unlike walking the range with
+ * pk_model_get_iter_for_range(), models may answer this from indexes
+ * maintained as samples are inserted, so that the cost does not depend
+ * on the size of the range.  Counter fields are aggregated over their
+ * deltas.
+ *
+ * Returns: The requested statistic, or 0 if the range is empty.
+ * Side effects: None.
+ */
+gdouble
+pk_model_get_range_aggregate (PkModel          *model,
+                              GQuark            key,
+                              gdouble           begin_time,
+                              gdouble           end_time,
+                              PkModelAggregate  aggregate)
+{
+	PkModelClass *klass;
+	PkModelIter iter;
+	gdouble result = 0.0;
+	gdouble value;
+	guint count = 0;
+
+	g_return_val_if_fail(PK_IS_MODEL(model), 0.0);
+	g_return_val_if_fail(key > 0, 0.0);
+
+	klass = PK_MODEL_GET_CLASS(model);
+	if (klass->get_range_aggregate &&
+	    (!g_hash_table_lookup(model->priv->builders, &key) ||
+	     g_hash_table_lookup(model->priv->materialized, GUINT_TO_POINTER(key)))) {
+		return klass->get_range_aggregate(model, key, begin_time, end_time,
+		                                  aggregate);
+	}
+
+	if (!pk_model_get_iter_for_range(model, &iter, begin_time, end_time, 0.0)) {
+		return 0.0;
 	}
+
+	do {
+		if (iter.time < begin_time || iter.time > end_time) {
+			continue;
+		}
+		value = pk_model_get_double(model, &iter, key);
+		switch (aggregate) {
+		case PK_MODEL_AGGREGATE_MIN:
+			result = count ? MIN(result, value) : value;
+			break;
+		case PK_MODEL_AGGREGATE_MAX:
+			result = count ? MAX(result, value) : value;
+			break;
+		case PK_MODEL_AGGREGATE_FIRST:
+			if (!count) {
+				result = value;
+			}
+			break;
+		case PK_MODEL_AGGREGATE_LAST:
+			result = value;
+			break;
+		case PK_MODEL_AGGREGATE_COUNT:
+			break;
+		case PK_MODEL_AGGREGATE_MEAN:
+		case PK_MODEL_AGGREGATE_SUM:
+		default:
+			result += value;
+			break;
+		}
+		count++;
+	} while (pk_model_iter_next(model, &iter));
+
+	if (aggregate == PK_MODEL_AGGREGATE_COUNT) {
+		return count;
+	} else if (aggregate == PK_MODEL_AGGREGATE_MEAN && count) {
+		return result / count;
+	}
+	return result;
+}
+
+
+/**
+ * pk_model_get_range_extents:
+ * @model: (in): A #PkModel.
+ * @key: (in): The field to inspect.
+ * @begin_time: (in): The time of the first sample to include.
+ * @end_time: (in): The time of the last sample to include.
+ * @min: (out): A location for the smallest value.
+ * @max: (out): A location for the largest value.
+ *
+ * Retrieves the smallest and largest value of @key between @begin_time
+ * and @end_time, inclusive.  This is equivalent to asking
+ * pk_model_get_range_aggregate() for %PK_MODEL_AGGREGATE_MIN and
+ * %PK_MODEL_AGGREGATE_MAX, but models without indexes for the range
+ * only walk their samples once.
+ *
+ * Returns: %TRUE if there were any samples within the range.
+ * Side effects: None.
+ */
+gboolean
+pk_model_get_range_extents (PkModel *model,
+                            GQuark   key,
+                            gdouble  begin_time,
+                            gdouble  end_time,
+                            gdouble *min,
+                            gdouble *max)
+{
+	PkModelClass *klass;
+	PkModelIter iter;
+	gdouble value;
+	guint count = 0;
+
+	g_return_val_if_fail(PK_IS_MODEL(model), FALSE);
+	g_return_val_if_fail(key > 0, FALSE);
+	g_return_val_if_fail(min != NULL, FALSE);
+	g_return_val_if_fail(max != NULL, FALSE);
+
+	klass = PK_MODEL_GET_CLASS(model);
+	if (klass->get_range_aggregate &&
+	    (!g_hash_table_lookup(model->priv->builders, &key) ||
+	     g_hash_table_lookup(model->priv->materialized, GUINT_TO_POINTER(key)))) {
+		if (!klass->get_range_aggregate(model, key, begin_time, end_time,
+		                                PK_MODEL_AGGREGATE_COUNT)) {
+			return FALSE;
+		}
+		*min = klass->get_range_aggregate(model, key, begin_time, end_time,
+		                                  PK_MODEL_AGGREGATE_MIN);
+		*max = klass->get_range_aggregate(model, key, begin_time, end_time,
+		                                  PK_MODEL_AGGREGATE_MAX);
+		return TRUE;
+	}
+
+	if (!pk_model_get_iter_for_range(model, &iter, begin_time, end_time, 0.0)) {
+		return FALSE;
+	}
+
+	do {
+		if (iter.time < begin_time || iter.time > end_time) {
+			continue;
+		}
+		value = pk_model_get_double(model, &iter, key);
+		*min = count ? MIN(*min, value) : value;
+		*max = count ? MAX(*max, value) : value;
+		count++;
+	} while (pk_model_iter_next(model, &iter));
+
+	return count > 0;
 }
 
 
@@ -255,6 +725,20 @@ pk_model_register_accumulator (PkModel             *model,
 	closure = g_cclosure_new(G_CALLBACK(accumulator), user_data,
 	                         (GClosureNotify)notify);
 	g_hash_table_insert(priv->accumulators, pkey, closure);
+
+	/*
+	 * The built-in accumulators all compute the mean, which can be done
+	 * without boxing the values.
+	 */
+	if (accumulator == pk_model_accumulate_double ||
+	    accumulator == pk_model_accumulate_float ||
+	    accumulator == pk_model_accumulate_int ||
+	    accumulator == pk_model_accumulate_int64 ||
+	    accumulator == pk_model_accumulate_uint ||
+	    accumulator == pk_model_accumulate_uint64) {
+		g_hash_table_insert(priv->reducible, GUINT_TO_POINTER(key),
+		                    GINT_TO_POINTER(TRUE));
+	}
 	g_signal_emit(model, signals[ACCUMULATOR_ADDED], 0, key);
 }
 
@@ -301,6 +785,105 @@ pk_model_get_end_time (PkModel *model)
 }
 
 
+/**
+ * pk_model_set_end_time:
+ * @model: A #PkModel.
+ * @end_time: The time of the last sample.
+ *
+ * Updates the "end-time" of the model.  This is for use by implementations
+ * which already contain samples before any are inserted, such as a model
+ * reopened from disk.  The end time is never moved backwards.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_set_end_time (PkModel *model,
+                       gdouble  end_time)
+{
+	g_return_if_fail(PK_IS_MODEL(model));
+
+	if (end_time > model->priv->end_time) {
+		model->priv->end_time = end_time;
+		g_object_notify_by_pspec(G_OBJECT(model), pspecs[PROP_END_TIME]);
+	}
+}
+
+
+/**
+ * pk_model_get_max_age:
+ * @model: A #PkModel.
+ *
+ * Retrieves the number of seconds of samples the model retains, counted
+ * back from the most recent sample.
+ *
+ * Returns: The retention period in seconds, or 0 if unlimited.
+ * Side effects: None.
+ */
+gdouble
+pk_model_get_max_age (PkModel *model)
+{
+	g_return_val_if_fail(PK_IS_MODEL(model), 0.0);
+	return model->priv->max_age;
+}
+
+
+/**
+ * pk_model_get_max_samples:
+ * @model: A #PkModel.
+ *
+ * Retrieves the number of most recent samples the model retains.
+ *
+ * Returns: The maximum number of samples, or 0 if unlimited.
+ * Side effects: None.
+ */
+guint
+pk_model_get_max_samples (PkModel *model)
+{
+	g_return_val_if_fail(PK_IS_MODEL(model), 0);
+	return model->priv->max_samples;
+}
+
+
+/**
+ * pk_model_set_retention:
+ * @model: A #PkModel.
+ * @max_samples: The number of samples to keep, or 0.
+ * @max_age: The number of seconds of samples to keep, or 0.
+ *
+ * Bounds the samples kept by the model so that its memory use does not
+ * grow with the length of the capture.  Samples that are older than
+ * @max_age seconds before the most recent sample, or that are not among
+ * the @max_samples most recent samples, may be discarded by the model as
+ * new samples are inserted.  Passing 0 for both removes the bound.
+ *
+ * Models may discard samples in batches, so slightly more than requested
+ * can be retained.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_set_retention (PkModel *model,
+                        guint    max_samples,
+                        gdouble  max_age)
+{
+	g_return_if_fail(PK_IS_MODEL(model));
+	g_return_if_fail(max_age >= 0.0);
+
+	g_object_freeze_notify(G_OBJECT(model));
+	if (model->priv->max_samples != max_samples) {
+		model->priv->max_samples = max_samples;
+		g_object_notify_by_pspec(G_OBJECT(model), pspecs[PROP_MAX_SAMPLES]);
+	}
+	if (model->priv->max_age != max_age) {
+		model->priv->max_age = max_age;
+		g_object_notify_by_pspec(G_OBJECT(model), pspecs[PROP_MAX_AGE]);
+	}
+	g_object_thaw_notify(G_OBJECT(model));
+}
+
+
 #define GETTER(_name, _type, _TYPE)               \
 _type                                             \
 pk_model_get_##_name (PkModel     *model,         \
@@ -354,6 +937,158 @@ ACCUMULATOR(uint, guint32)
 ACCUMULATOR(uint64, guint64)
 
 
+/**
+ * pk_model_accumulate_sketch:
+ * @model: (in): A #PkModel.
+ * @values: (in): The values to accumulate.
+ * @return_value: (out): A #GValue initialized to %PK_TYPE_SKETCH.
+ * @user_data: (in): Unused.
+ *
+ * An accumulator that reduces the values to a #PkSketch with the default
+ * accuracy, from which any quantile can be read with
+ * pk_sketch_get_quantile().  Sketches of separate ranges can be combined
+ * with pk_sketch_merge().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_model_accumulate_sketch (PkModel     *model,
+                            GValueArray *values,
+                            GValue      *return_value,
+                            gpointer     user_data)
+{
+	PkSketch *sketch;
+	GValue value = { 0 };
+	gint i;
+
+	g_return_if_fail(G_VALUE_HOLDS(return_value, PK_TYPE_SKETCH));
+
+	sketch = pk_sketch_new(PK_SKETCH_DEFAULT_ACCURACY);
+	g_value_init(&value, G_TYPE_DOUBLE);
+	for (i = 0; i < values->n_values; i++) {
+		if (g_value_transform(g_value_array_get_nth(values, i), &value)) {
+			pk_sketch_add(sketch, g_value_get_double(&value));
+		}
+	}
+	g_value_unset(&value);
+	g_value_take_boxed(return_value, sketch);
+}
+
+
+/*
+ * The reducers keep REDUCE_LANES independent partial results so that no
+ * iteration depends on the previous one, which lets the compiler
+ * vectorize the loops. Variance is computed in a second pass around the
+ * mean to avoid the cancellation of the sum of squares.
+ */
+#define REDUCE_LANES 4
+#define REDUCER(_name, _type)                                             \
+void                                                                      \
+pk_model_reduce_##_name (const _type   *values,                           \
+                         const gdouble *times,                            \
+                         guint          n_values,                         \
+                         PkModelStats  *stats)                            \
+{                                                                         \
+	gdouble sum[REDUCE_LANES];                                            \
+	gdouble min[REDUCE_LANES];                                            \
+	gdouble max[REDUCE_LANES];                                            \
+	gdouble dev[REDUCE_LANES];                                            \
+	gdouble value;                                                        \
+	gdouble span;                                                         \
+	guint i;                                                              \
+	guint j;                                                              \
+                                                                          \
+	g_return_if_fail(values != NULL || n_values == 0);                    \
+	g_return_if_fail(stats != NULL);                                      \
+                                                                          \
+	memset(stats, 0, sizeof *stats);                                      \
+	if (!n_values) {                                                      \
+		return;                                                           \
+	}                                                                     \
+                                                                          \
+	for (j = 0; j < REDUCE_LANES; j++) {                                  \
+		sum[j] = dev[j] = 0.0;                                            \
+		min[j] = max[j] = values[0];                                      \
+	}                                                                     \
+	for (i = 0; i + REDUCE_LANES <= n_values; i += REDUCE_LANES) {        \
+		for (j = 0; j < REDUCE_LANES; j++) {                              \
+			value = values[i + j];                                        \
+			sum[j] += value;                                              \
+			min[j] = MIN(min[j], value);                                  \
+			max[j] = MAX(max[j], value);                                  \
+		}                                                                 \
+	}                                                                     \
+	for (; i < n_values; i++) {                                           \
+		value = values[i];                                                \
+		sum[0] += value;                                                  \
+		min[0] = MIN(min[0], value);                                      \
+		max[0] = MAX(max[0], value);                                      \
+	}                                                                     \
+                                                                          \
+	stats->count = n_values;                                              \
+	stats->min = min[0];                                                  \
+	stats->max = max[0];                                                  \
+	for (j = 0; j < REDUCE_LANES; j++) {                                  \
+		stats->sum += sum[j];                                             \
+		stats->min = MIN(stats->min, min[j]);                             \
+		stats->max = MAX(stats->max, max[j]);                             \
+	}                                                                     \
+	stats->mean = stats->sum / n_values;                                  \
+                                                                          \
+	for (i = 0; i + REDUCE_LANES <= n_values; i += REDUCE_LANES) {        \
+		for (j = 0; j < REDUCE_LANES; j++) {                              \
+			value = values[i + j] - stats->mean;                          \
+			dev[j] += value * value;                                      \
+		}                                                                 \
+	}                                                                     \
+	for (; i < n_values; i++) {                                           \
+		value = values[i] - stats->mean;                                  \
+		dev[0] += value * value;                                          \
+	}                                                                     \
+	for (j = 0; j < REDUCE_LANES; j++) {                                  \
+		stats->variance += dev[j];                                        \
+	}                                                                     \
+	stats->variance /= n_values;                                          \
+                                                                          \
+	if (n_values > 1) {                                                   \
+		span = times ? times[n_values - 1] - times[0] : n_values - 1;     \
+		if (span > 0.0) {                                                 \
+			stats->rate = ((gdouble)values[n_values - 1] -                \
+			               (gdouble)values[0]) / span;                    \
+		}                                                                 \
+	}                                                                     \
+}
+
+
+/**
+ * pk_model_reduce_double:
+ * @values: (in): An array of values.
+ * @times: (in) (allow-none): The time of each value, or %NULL.
+ * @n_values: (in): The number of values.
+ * @stats: (out): A location for the statistics.
+ *
+ * Computes the count, sum, extremes, mean and population variance of
+ * @values in a single call.  The rate is the change from the first to
+ * the last value per second of @times, or per sample if @times is
+ * %NULL, which is the average rate of a counter.
+ *
+ * pk_model_reduce_float(), pk_model_reduce_int(), pk_model_reduce_int64(),
+ * pk_model_reduce_uint() and pk_model_reduce_uint64() do the same for
+ * other element types, such as the columns returned from
+ * pk_model_columnar_get_column().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+REDUCER(double, gdouble)
+REDUCER(float, gfloat)
+REDUCER(int, gint32)
+REDUCER(int64, gint64)
+REDUCER(uint, guint32)
+REDUCER(uint64, guint64)
+
+
 /**
  * pk_model_finalize:
  * @object: (in): A #PkModel.
@@ -367,6 +1102,10 @@ ACCUMULATOR(uint64, guint64)
 static void
 pk_model_finalize (GObject *object)
 {
+	g_hash_table_destroy(PK_MODEL(object)->priv->materialized);
+	g_hash_table_destroy(PK_MODEL(object)->priv->reducible);
+	g_static_rec_mutex_free(&PK_MODEL(object)->priv->lock);
+
 	G_OBJECT_CLASS(pk_model_parent_class)->finalize(object);
 }
 
@@ -392,6 +1131,44 @@ pk_model_get_property (GObject    *object,
 	case PROP_END_TIME:
 		g_value_set_double(value, model->priv->end_time);
 		break;
+	case PROP_MAX_AGE:
+		g_value_set_double(value, model->priv->max_age);
+		break;
+	case PROP_MAX_SAMPLES:
+		g_value_set_uint(value, model->priv->max_samples);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+	}
+}
+
+
+/**
+ * pk_model_set_property:
+ * @object: (in): A #GObject.
+ * @prop_id: (in): The property identifier.
+ * @value: (in): The given property.
+ * @pspec: (in): A #ParamSpec.
+ *
+ * Set a given #GObject property.
+ */
+static void
+pk_model_set_property (GObject      *object,
+                       guint         prop_id,
+                       const GValue *value,
+                       GParamSpec   *pspec)
+{
+	PkModel *model = PK_MODEL(object);
+
+	switch (prop_id) {
+	case PROP_MAX_AGE:
+		pk_model_set_retention(model, model->priv->max_samples,
+		                       g_value_get_double(value));
+		break;
+	case PROP_MAX_SAMPLES:
+		pk_model_set_retention(model, g_value_get_uint(value),
+		                       model->priv->max_age);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
 	}
@@ -415,6 +1192,7 @@ pk_model_class_init (PkModelClass *klass)
 	object_class = G_OBJECT_CLASS(klass);
 	object_class->finalize = pk_model_finalize;
 	object_class->get_property = pk_model_get_property;
+	object_class->set_property = pk_model_set_property;
 	g_type_class_add_private(object_class, sizeof(PkModelPrivate));
 
 	pspecs[PROP_END_TIME] = 
@@ -428,6 +1206,28 @@ pk_model_class_init (PkModelClass *klass)
 	g_object_class_install_property(object_class, PROP_END_TIME,
 	                                pspecs[PROP_END_TIME]);
 
+	pspecs[PROP_MAX_AGE] =
+		g_param_spec_double("max-age",
+		                    "MaxAge",
+		                    "The number of seconds of samples to retain",
+		                    0.0,
+		                    G_MAXDOUBLE,
+		                    0.0,
+		                    G_PARAM_READWRITE);
+	g_object_class_install_property(object_class, PROP_MAX_AGE,
+	                                pspecs[PROP_MAX_AGE]);
+
+	pspecs[PROP_MAX_SAMPLES] =
+		g_param_spec_uint("max-samples",
+		                  "MaxSamples",
+		                  "The number of samples to retain",
+		                  0,
+		                  G_MAXUINT,
+		                  0,
+		                  G_PARAM_READWRITE);
+	g_object_class_install_property(object_class, PROP_MAX_SAMPLES,
+	                                pspecs[PROP_MAX_SAMPLES]);
+
 	signals[ACCUMULATOR_ADDED] = g_signal_new("accumulator-added",
 	                                          PK_TYPE_MODEL,
 	                                          G_SIGNAL_RUN_FIRST,
@@ -474,4 +1274,8 @@ pk_model_init (PkModel *model)
 	model->priv->builders =
 		g_hash_table_new_full(g_int_hash, g_int_equal,
 		                      g_free, (GDestroyNotify)g_closure_unref);
+
+	model->priv->materialized = g_hash_table_new(g_direct_hash, g_direct_equal);
+	model->priv->reducible = g_hash_table_new(g_direct_hash, g_direct_equal);
+	g_static_rec_mutex_init(&model->priv->lock);
 }
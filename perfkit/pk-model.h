@@ -38,7 +38,9 @@ typedef struct _PkModel        PkModel;
 typedef struct _PkModelClass   PkModelClass;
 typedef struct _PkModelPrivate PkModelPrivate;
 typedef struct _PkModelIter    PkModelIter;
+typedef struct _PkModelStats   PkModelStats;
 typedef enum   _PkModelMode    PkModelMode;
+typedef enum   _PkModelAggregate PkModelAggregate;
 
 typedef void (*PkModelAccumulator) (PkModel     *model,
                                     GValueArray *values,
@@ -62,12 +64,34 @@ struct _PkModelIter
 	gpointer user_data4;
 };
 
+struct _PkModelStats
+{
+	guint   count;
+	gdouble sum;
+	gdouble min;
+	gdouble max;
+	gdouble mean;
+	gdouble variance;
+	gdouble rate;
+};
+
 enum _PkModelMode
 {
 	PK_MODEL_RAW,
 	PK_MODEL_COUNTER,
 };
 
+enum _PkModelAggregate
+{
+	PK_MODEL_AGGREGATE_MEAN,
+	PK_MODEL_AGGREGATE_MIN,
+	PK_MODEL_AGGREGATE_MAX,
+	PK_MODEL_AGGREGATE_COUNT,
+	PK_MODEL_AGGREGATE_FIRST,
+	PK_MODEL_AGGREGATE_LAST,
+	PK_MODEL_AGGREGATE_SUM,
+};
+
 struct _PkModel
 {
 	GObject parent;
@@ -84,6 +108,10 @@ struct _PkModelClass
 	                                GQuark       key);
 	void     (*builder_added)      (PkModel     *model,
 	                                GQuark       key);
+	gdouble  (*get_aggregate)      (PkModel     *model,
+	                                PkModelIter *iter,
+	                                GQuark       key,
+	                                PkModelAggregate aggregate);
 	gboolean (*get_iter_first)     (PkModel     *model,
 	                                PkModelIter *iter);
 	gboolean (*get_iter_for_range) (PkModel     *model,
@@ -91,6 +119,15 @@ struct _PkModelClass
 	                                gdouble      begin_time,
 	                                gdouble      end_time,
 	                                gdouble      aggregate_time);
+	gdouble  (*get_quantile)       (PkModel     *model,
+	                                PkModelIter *iter,
+	                                GQuark       key,
+	                                gdouble      quantile);
+	gdouble  (*get_range_aggregate) (PkModel    *model,
+	                                GQuark       key,
+	                                gdouble      begin_time,
+	                                gdouble      end_time,
+	                                PkModelAggregate aggregate);
 	void     (*get_value)          (PkModel     *model,
 	                                PkModelIter *iter,
 	                                GQuark       key,
@@ -100,8 +137,16 @@ struct _PkModelClass
 	void     (*insert_sample)      (PkModel     *model,
 	                                PkManifest  *manifest,
 	                                PkSample    *sample);
+	void     (*insert_samples)     (PkModel     *model,
+	                                PkManifest  *manifest,
+	                                PkSample   **samples,
+	                                guint        n_samples);
 	gboolean (*iter_next)          (PkModel     *model,
 	                                PkModelIter *iter);
+	gboolean (*reduce)             (PkModel     *model,
+	                                PkModelIter *iter,
+	                                GQuark       key,
+	                                PkModelStats *stats);
 	void     (*set_field_mode)     (PkModel     *model,
 	                                GQuark       key,
 	                                PkModelMode  mode);
@@ -127,6 +172,10 @@ void     pk_model_accumulate_int64     (PkModel             *model,
                                         GValueArray         *values,
                                         GValue              *return_value,
                                         gpointer             user_data);
+void     pk_model_accumulate_sketch    (PkModel             *model,
+                                        GValueArray         *values,
+                                        GValue              *return_value,
+                                        gpointer             user_data);
 void     pk_model_accumulate_uint      (PkModel             *model,
                                         GValueArray         *values,
                                         GValue              *return_value,
@@ -135,6 +184,14 @@ void     pk_model_accumulate_uint64    (PkModel             *model,
                                         GValueArray         *values,
                                         GValue              *return_value,
                                         gpointer             user_data);
+void     pk_model_build_value          (PkModel             *model,
+                                        PkModelIter         *iter,
+                                        GQuark               key,
+                                        GValue              *value);
+gdouble  pk_model_get_aggregate        (PkModel             *model,
+                                        PkModelIter         *iter,
+                                        GQuark               key,
+                                        PkModelAggregate     aggregate);
 gdouble  pk_model_get_double           (PkModel             *model,
                                         PkModelIter         *iter,
                                         GQuark               key);
@@ -148,6 +205,8 @@ gint32   pk_model_get_int              (PkModel             *model,
 gint64   pk_model_get_int64            (PkModel             *model,
                                         PkModelIter         *iter,
                                         GQuark               key);
+gdouble  pk_model_get_max_age          (PkModel             *model);
+guint    pk_model_get_max_samples      (PkModel             *model);
 gboolean pk_model_get_iter_first       (PkModel             *model,
                                         PkModelIter         *iter);
 gboolean pk_model_get_iter_for_range   (PkModel             *model,
@@ -155,6 +214,21 @@ gboolean pk_model_get_iter_for_range   (PkModel             *model,
                                         gdouble              begin_time,
                                         gdouble              end_time,
                                         gdouble              aggregate_time);
+gdouble  pk_model_get_quantile         (PkModel             *model,
+                                        PkModelIter         *iter,
+                                        GQuark               key,
+                                        gdouble              quantile);
+gdouble  pk_model_get_range_aggregate  (PkModel             *model,
+                                        GQuark               key,
+                                        gdouble              begin_time,
+                                        gdouble              end_time,
+                                        PkModelAggregate     aggregate);
+gboolean pk_model_get_range_extents    (PkModel             *model,
+                                        GQuark               key,
+                                        gdouble              begin_time,
+                                        gdouble              end_time,
+                                        gdouble             *min,
+                                        gdouble             *max);
 GType    pk_model_get_type             (void) G_GNUC_CONST;
 guint32  pk_model_get_uint             (PkModel             *model,
                                         PkModelIter         *iter,
@@ -171,8 +245,37 @@ void     pk_model_insert_manifest      (PkModel             *model,
 void     pk_model_insert_sample        (PkModel             *model,
                                         PkManifest          *manifest,
                                         PkSample            *sample);
+void     pk_model_insert_samples       (PkModel             *model,
+                                        PkManifest          *manifest,
+                                        PkSample           **samples,
+                                        guint                n_samples);
 gboolean pk_model_iter_next            (PkModel             *model,
                                         PkModelIter         *iter);
+void     pk_model_lock                 (PkModel             *model);
+void     pk_model_reduce_double        (const gdouble       *values,
+                                        const gdouble       *times,
+                                        guint                n_values,
+                                        PkModelStats        *stats);
+void     pk_model_reduce_float         (const gfloat        *values,
+                                        const gdouble       *times,
+                                        guint                n_values,
+                                        PkModelStats        *stats);
+void     pk_model_reduce_int           (const gint32        *values,
+                                        const gdouble       *times,
+                                        guint                n_values,
+                                        PkModelStats        *stats);
+void     pk_model_reduce_int64         (const gint64        *values,
+                                        const gdouble       *times,
+                                        guint                n_values,
+                                        PkModelStats        *stats);
+void     pk_model_reduce_uint          (const guint32       *values,
+                                        const gdouble       *times,
+                                        guint                n_values,
+                                        PkModelStats        *stats);
+void     pk_model_reduce_uint64        (const guint64       *values,
+                                        const gdouble       *times,
+                                        guint                n_values,
+                                        PkModelStats        *stats);
 void     pk_model_register_accumulator (PkModel             *model,
                                         GQuark               key,
                                         PkModelAccumulator   accumulator,
@@ -183,9 +286,17 @@ void     pk_model_register_builder     (PkModel             *model,
                                         PkValueBuilder       builder,
                                         gpointer             user_data,
                                         GDestroyNotify       notify);
+void     pk_model_set_end_time         (PkModel             *model,
+                                        gdouble              end_time);
 void     pk_model_set_field_mode       (PkModel             *model,
                                         GQuark               key,
                                         PkModelMode          mode);
+void     pk_model_set_materialized     (PkModel             *model,
+                                        GQuark               key);
+void     pk_model_set_retention        (PkModel             *model,
+                                        guint                max_samples,
+                                        gdouble              max_age);
+void     pk_model_unlock               (PkModel             *model);
 
 G_END_DECLS
 
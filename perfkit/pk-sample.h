@@ -56,6 +56,24 @@ typedef void (*PkSampleFunc) (PkManifest  *manifest,
                               PkSample    *sample,
                               gpointer     user_data);
 
+/**
+ * PkSamplesFunc:
+ * @manifest: A #PkManifest.
+ * @samples: An array of #PkSample which all share @manifest.
+ * @n_samples: The number of samples in @samples.
+ *
+ * Batched variant of #PkSampleFunc. All of the samples decoded from a
+ * single buffer that share a manifest are delivered in one call. The
+ * samples are only valid for the duration of the callback; use
+ * pk_sample_ref() to keep them longer.
+ *
+ * Returns: None.
+ */
+typedef void (*PkSamplesFunc) (PkManifest  *manifest,
+                               PkSample   **samples,
+                               guint        n_samples,
+                               gpointer     user_data);
+
 /**
  * PkManifestResolver:
  * @source_id: The source identifier for which to retrieve the manifest.
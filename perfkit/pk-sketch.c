@@ -0,0 +1,372 @@
+/* pk-sketch.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "pk-sketch.h"
+
+/*
+ * PkSketch is a mergeable quantile sketch in the style of DDSketch.
+ * Values are counted in logarithmically sized bins, so that any
+ * quantile is reported within the relative accuracy of the sketch no
+ * matter how the values are distributed. Two sketches with the same
+ * accuracy merge by adding their bins, which is what lets rollup buckets
+ * be combined without the raw samples.
+ */
+
+
+#define SKETCH_MAX_BINS  (2048)
+#define SKETCH_MIN_VALUE (1e-9)
+
+
+typedef struct
+{
+	gint    offset; /* Bin index of the first count */
+	GArray *counts; /* guint64 count per bin */
+} PkSketchStore;
+
+
+struct _PkSketch
+{
+	volatile gint ref_count;
+	gdouble       gamma;
+	gdouble       log_gamma;
+	guint64       count;
+	guint64       zero_count; /* Values too small to index */
+	gdouble       min;
+	gdouble       max;
+	PkSketchStore positive;
+	PkSketchStore negative;   /* Indexed by magnitude */
+};
+
+
+static void
+pk_sketch_store_add (PkSketchStore *store,
+                     gint           index_,
+                     guint64        count)
+{
+	GArray *counts = store->counts;
+	guint64 collapsed = 0;
+	guint length;
+	guint grow;
+	guint i;
+
+	if (!counts->len) {
+		store->offset = index_;
+		g_array_set_size(counts, 1);
+	} else if (index_ < store->offset) {
+		length = counts->len;
+		grow = store->offset - index_;
+		g_array_set_size(counts, length + grow);
+		memmove(&g_array_index(counts, guint64, grow),
+		        &g_array_index(counts, guint64, 0),
+		        length * sizeof(guint64));
+		memset(&g_array_index(counts, guint64, 0), 0,
+		       grow * sizeof(guint64));
+		store->offset = index_;
+	} else if (index_ - store->offset >= (gint)counts->len) {
+		g_array_set_size(counts, index_ - store->offset + 1);
+	}
+	g_array_index(counts, guint64, index_ - store->offset) += count;
+
+	/*
+	 * Bound the memory of the sketch by folding the smallest magnitudes
+	 * into a single bin. Only the lowest quantiles lose accuracy.
+	 */
+	if (counts->len > SKETCH_MAX_BINS) {
+		grow = counts->len - SKETCH_MAX_BINS;
+		for (i = 0; i <= grow; i++) {
+			collapsed += g_array_index(counts, guint64, i);
+		}
+		g_array_remove_range(counts, 0, grow);
+		g_array_index(counts, guint64, 0) = collapsed;
+		store->offset += grow;
+	}
+}
+
+
+static inline gint
+pk_sketch_get_index (PkSketch *sketch,
+                     gdouble   magnitude)
+{
+	return (gint)ceil(log(magnitude) / sketch->log_gamma);
+}
+
+
+static inline gdouble
+pk_sketch_get_bin_value (PkSketch *sketch,
+                         gint      index_)
+{
+	return 2.0 * pow(sketch->gamma, index_) / (sketch->gamma + 1.0);
+}
+
+
+/**
+ * pk_sketch_new:
+ * @relative_accuracy: (in): The relative error allowed for quantiles.
+ *
+ * Creates a new, empty #PkSketch.  Quantiles are reported within
+ * @relative_accuracy of the true value, such as 0.01 for 1%.  Use
+ * %PK_SKETCH_DEFAULT_ACCURACY unless there is reason not to; only
+ * sketches with the same accuracy can be merged.
+ *
+ * Returns: A newly created #PkSketch which should be freed with
+ *   pk_sketch_unref().
+ * Side effects: None.
+ */
+PkSketch*
+pk_sketch_new (gdouble relative_accuracy)
+{
+	PkSketch *sketch;
+
+	g_return_val_if_fail(relative_accuracy > 0.0, NULL);
+	g_return_val_if_fail(relative_accuracy < 1.0, NULL);
+
+	sketch = g_slice_new0(PkSketch);
+	sketch->ref_count = 1;
+	sketch->gamma = (1.0 + relative_accuracy) / (1.0 - relative_accuracy);
+	sketch->log_gamma = log(sketch->gamma);
+	sketch->positive.counts = g_array_new(FALSE, TRUE, sizeof(guint64));
+	sketch->negative.counts = g_array_new(FALSE, TRUE, sizeof(guint64));
+	return sketch;
+}
+
+
+/**
+ * pk_sketch_ref:
+ * @sketch: A #PkSketch.
+ *
+ * Atomically increments the reference count of @sketch by one.
+ *
+ * Returns: @sketch.
+ * Side effects: None.
+ */
+PkSketch*
+pk_sketch_ref (PkSketch *sketch)
+{
+	g_return_val_if_fail(sketch != NULL, NULL);
+	g_return_val_if_fail(sketch->ref_count > 0, NULL);
+
+	g_atomic_int_inc(&sketch->ref_count);
+	return sketch;
+}
+
+
+/**
+ * pk_sketch_unref:
+ * @sketch: A #PkSketch.
+ *
+ * Atomically decrements the reference count of @sketch by one.  When the
+ * reference count reaches zero, the sketch is freed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_sketch_unref (PkSketch *sketch)
+{
+	g_return_if_fail(sketch != NULL);
+	g_return_if_fail(sketch->ref_count > 0);
+
+	if (g_atomic_int_dec_and_test(&sketch->ref_count)) {
+		g_array_free(sketch->positive.counts, TRUE);
+		g_array_free(sketch->negative.counts, TRUE);
+		g_slice_free(PkSketch, sketch);
+	}
+}
+
+
+/**
+ * pk_sketch_add:
+ * @sketch: A #PkSketch.
+ * @value: (in): The value to add.
+ *
+ * Adds @value to the distribution described by @sketch.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_sketch_add (PkSketch *sketch,
+               gdouble   value)
+{
+	g_return_if_fail(sketch != NULL);
+
+	if (value > SKETCH_MIN_VALUE) {
+		pk_sketch_store_add(&sketch->positive,
+		                    pk_sketch_get_index(sketch, value), 1);
+	} else if (value < -SKETCH_MIN_VALUE) {
+		pk_sketch_store_add(&sketch->negative,
+		                    pk_sketch_get_index(sketch, -value), 1);
+	} else {
+		sketch->zero_count++;
+	}
+
+	if (!sketch->count || value < sketch->min) {
+		sketch->min = value;
+	}
+	if (!sketch->count || value > sketch->max) {
+		sketch->max = value;
+	}
+	sketch->count++;
+}
+
+
+/**
+ * pk_sketch_merge:
+ * @sketch: A #PkSketch.
+ * @other: A #PkSketch with the same relative accuracy.
+ *
+ * Adds the values described by @other to @sketch.  The result is the same
+ * as if every value of @other had been added to @sketch.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+pk_sketch_merge (PkSketch *sketch,
+                 PkSketch *other)
+{
+	guint64 count;
+	guint i;
+
+	g_return_if_fail(sketch != NULL);
+	g_return_if_fail(other != NULL);
+	g_return_if_fail(sketch->gamma == other->gamma);
+
+	if (!other->count) {
+		return;
+	}
+
+	for (i = 0; i < other->positive.counts->len; i++) {
+		if ((count = g_array_index(other->positive.counts, guint64, i))) {
+			pk_sketch_store_add(&sketch->positive,
+			                    other->positive.offset + i, count);
+		}
+	}
+	for (i = 0; i < other->negative.counts->len; i++) {
+		if ((count = g_array_index(other->negative.counts, guint64, i))) {
+			pk_sketch_store_add(&sketch->negative,
+			                    other->negative.offset + i, count);
+		}
+	}
+
+	if (!sketch->count || other->min < sketch->min) {
+		sketch->min = other->min;
+	}
+	if (!sketch->count || other->max > sketch->max) {
+		sketch->max = other->max;
+	}
+	sketch->zero_count += other->zero_count;
+	sketch->count += other->count;
+}
+
+
+/**
+ * pk_sketch_get_count:
+ * @sketch: A #PkSketch.
+ *
+ * Retrieves the number of values added to @sketch.
+ *
+ * Returns: The number of values.
+ * Side effects: None.
+ */
+guint64
+pk_sketch_get_count (PkSketch *sketch)
+{
+	g_return_val_if_fail(sketch != NULL, 0);
+	return sketch->count;
+}
+
+
+/**
+ * pk_sketch_get_quantile:
+ * @sketch: A #PkSketch.
+ * @quantile: (in): The quantile between 0 and 1, such as 0.99.
+ *
+ * Retrieves an estimate of the value below which @quantile of the added
+ * values fall.  The estimate is within the relative accuracy of the
+ * sketch, and always within the range of the added values.
+ *
+ * Returns: The estimated quantile, or 0 if the sketch is empty.
+ * Side effects: None.
+ */
+gdouble
+pk_sketch_get_quantile (PkSketch *sketch,
+                        gdouble   quantile)
+{
+	PkSketchStore *store;
+	gdouble rank;
+	gdouble value;
+	guint64 seen = 0;
+	gint i;
+
+	g_return_val_if_fail(sketch != NULL, 0.0);
+
+	if (!sketch->count) {
+		return 0.0;
+	}
+
+	rank = CLAMP(quantile, 0.0, 1.0) * (sketch->count - 1);
+
+	/*
+	 * Walk the bins from the most negative value up.
+	 */
+	store = &sketch->negative;
+	for (i = store->counts->len - 1; i >= 0; i--) {
+		seen += g_array_index(store->counts, guint64, i);
+		if (seen > rank) {
+			value = -pk_sketch_get_bin_value(sketch, store->offset + i);
+			return CLAMP(value, sketch->min, sketch->max);
+		}
+	}
+
+	seen += sketch->zero_count;
+	if (seen > rank) {
+		return CLAMP(0.0, sketch->min, sketch->max);
+	}
+
+	store = &sketch->positive;
+	for (i = 0; i < store->counts->len; i++) {
+		seen += g_array_index(store->counts, guint64, i);
+		if (seen > rank) {
+			value = pk_sketch_get_bin_value(sketch, store->offset + i);
+			return CLAMP(value, sketch->min, sketch->max);
+		}
+	}
+
+	return sketch->max;
+}
+
+
+GType
+pk_sketch_get_type (void)
+{
+	static GType type_id = 0;
+	GType _type_id;
+
+	if (g_once_init_enter((gsize *)&type_id)) {
+		_type_id =
+			g_boxed_type_register_static("PkSketch",
+			                             (GBoxedCopyFunc)pk_sketch_ref,
+			                             (GBoxedFreeFunc)pk_sketch_unref);
+		g_once_init_leave((gsize *)&type_id, _type_id);
+	}
+	return type_id;
+}
@@ -0,0 +1,45 @@
+/* pk-sketch.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PK_SKETCH_H
+#define PK_SKETCH_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define PK_TYPE_SKETCH             (pk_sketch_get_type())
+#define PK_SKETCH_DEFAULT_ACCURACY (0.01)
+
+typedef struct _PkSketch PkSketch;
+
+GType     pk_sketch_get_type     (void) G_GNUC_CONST;
+void      pk_sketch_add          (PkSketch *sketch,
+                                  gdouble   value);
+guint64   pk_sketch_get_count    (PkSketch *sketch);
+gdouble   pk_sketch_get_quantile (PkSketch *sketch,
+                                  gdouble   quantile);
+void      pk_sketch_merge        (PkSketch *sketch,
+                                  PkSketch *other);
+PkSketch* pk_sketch_new          (gdouble   relative_accuracy);
+PkSketch* pk_sketch_ref          (PkSketch *sketch);
+void      pk_sketch_unref        (PkSketch *sketch);
+
+G_END_DECLS
+
+#endif /* PK_SKETCH_H */
@@ -0,0 +1,142 @@
+#include <math.h>
+
+#include "ppg-raster.h"
+
+#define WIDTH   (1024)
+#define HEIGHT  (64)
+#define N_FRAMES (200)
+
+static guint32
+get_pixel (cairo_surface_t *surface,
+           gint             x,
+           gint             y)
+{
+	guchar *data;
+
+	cairo_surface_flush(surface);
+	data = cairo_image_surface_get_data(surface);
+	data += y * cairo_image_surface_get_stride(surface);
+	return ((guint32 *)data)[x];
+}
+
+static void
+test_PpgRaster_fill_spans (void)
+{
+	cairo_surface_t *surface;
+	gfloat tops[] = { G_MAXFLOAT, 0.5, 0.0 };
+	gfloat bottoms[] = { -G_MAXFLOAT, 2.5, 4.0 };
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 4, 4);
+	ppg_raster_fill_spans(surface, 0, tops, bottoms, G_N_ELEMENTS(tops),
+	                      1.0, 1.0, 1.0, 1.0);
+
+	/*
+	 * Empty spans and columns past the spans are left alone.
+	 */
+	g_assert_cmphex(get_pixel(surface, 0, 1), ==, 0);
+	g_assert_cmphex(get_pixel(surface, 3, 1), ==, 0);
+
+	/*
+	 * Pixels the span ends within are covered in part.
+	 */
+	g_assert_cmphex(get_pixel(surface, 1, 0), ==, 0x80808080);
+	g_assert_cmphex(get_pixel(surface, 1, 1), ==, 0xFFFFFFFF);
+	g_assert_cmphex(get_pixel(surface, 1, 2), ==, 0x80808080);
+	g_assert_cmphex(get_pixel(surface, 1, 3), ==, 0);
+	g_assert_cmphex(get_pixel(surface, 2, 3), ==, 0xFFFFFFFF);
+
+	/*
+	 * Spans are clipped to the surface.
+	 */
+	ppg_raster_fill_spans(surface, -2, tops, bottoms, G_N_ELEMENTS(tops),
+	                      1.0, 0.0, 0.0, 0.5);
+	g_assert_cmphex(get_pixel(surface, 0, 0), ==, 0x80800000);
+	g_assert_cmphex(get_pixel(surface, 1, 0), ==, 0x80808080);
+
+	cairo_surface_destroy(surface);
+}
+
+static void
+test_PpgRaster_benchmark (void)
+{
+	cairo_surface_t *surface;
+	cairo_t *cr;
+	GTimer *timer;
+	gdouble values[WIDTH * 4];
+	gfloat tops[WIDTH];
+	gfloat bottoms[WIDTH];
+	gdouble cairo_time;
+	gdouble raster_time;
+	gdouble value = HEIGHT / 2.0;
+	gint frame;
+	gint i;
+	gint j;
+
+	if (!g_test_perf()) {
+		return;
+	}
+
+	/*
+	 * A random walk with four samples per pixel column, drawn the way
+	 * the line renderer draws it: a path through the samples stroked by
+	 * cairo, or a span per column covering the samples.
+	 */
+	for (i = 0; i < G_N_ELEMENTS(values); i++) {
+		value += g_test_rand_double_range(-2.0, 2.0);
+		values[i] = value = CLAMP(value, 0.0, HEIGHT);
+	}
+	for (i = 0; i < WIDTH; i++) {
+		tops[i] = G_MAXFLOAT;
+		bottoms[i] = -G_MAXFLOAT;
+		for (j = MAX(0, i * 4 - 1); j < (i + 1) * 4; j++) {
+			tops[i] = MIN(tops[i], values[j] - 0.5);
+			bottoms[i] = MAX(bottoms[i], values[j] + 0.5);
+		}
+	}
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, WIDTH, HEIGHT);
+	cr = cairo_create(surface);
+	cairo_set_line_width(cr, 1.0);
+	timer = g_timer_new();
+
+	for (frame = 0; frame < N_FRAMES; frame++) {
+		cairo_move_to(cr, 0.0, values[0]);
+		for (i = 1; i < G_N_ELEMENTS(values); i++) {
+			cairo_line_to(cr, i / 4.0, values[i]);
+		}
+		cairo_stroke(cr);
+	}
+	cairo_surface_flush(surface);
+	cairo_time = g_timer_elapsed(timer, NULL) / N_FRAMES;
+
+	g_timer_start(timer);
+	for (frame = 0; frame < N_FRAMES; frame++) {
+		ppg_raster_fill_spans(surface, 0, tops, bottoms, WIDTH,
+		                      0.2, 0.4, 0.6, 1.0);
+	}
+	raster_time = g_timer_elapsed(timer, NULL) / N_FRAMES;
+
+	g_test_message("%d columns, %d samples: cairo %.3f ms, raster %.3f ms",
+	               WIDTH, (gint)G_N_ELEMENTS(values),
+	               cairo_time * 1000.0, raster_time * 1000.0);
+	g_test_minimized_result(raster_time, "raster frame time: %f s",
+	                        raster_time);
+	g_test_maximized_result(cairo_time / raster_time,
+	                        "speedup over cairo: %f", cairo_time / raster_time);
+
+	g_timer_destroy(timer);
+	cairo_destroy(cr);
+	cairo_surface_destroy(surface);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_func("/PpgRaster/fill_spans",
+	                test_PpgRaster_fill_spans);
+	g_test_add_func("/PpgRaster/benchmark",
+	                test_PpgRaster_benchmark);
+	return g_test_run();
+}
@@ -0,0 +1,284 @@
+#include <egg-buffer.h>
+#include <perfkit/perfkit.h>
+
+#include "manifest.h"
+#include "ppg-renderer-event.h"
+#include "ppg-renderer-line.h"
+
+#define HEIGHT         (64)
+#define N_FRAMES       (10)
+#define N_BATCH        (4096)
+#define SAMPLE_PERIOD  (1000) /* usec */
+#define USER_FIELD     (2)
+
+static const gint widths[] = { 256, 1024, 4096 };
+static const gint zooms[] = { 1, 10, 100, 1000 };
+
+static gboolean
+manifest_resolver (gint         source_id,
+                   PkManifest **manifest,
+                   gpointer     real_manifest)
+{
+	*manifest = real_manifest;
+	return TRUE;
+}
+
+/*
+ * Encodes a sample the way the agent does, carrying only the "User"
+ * field of the test manifest.
+ */
+static PkSample*
+make_sample (PkManifest *manifest,
+             guint64     offset,
+             guint       value)
+{
+	EggBuffer *buffer;
+	EggBuffer *fields;
+	const guint8 *data;
+	PkSample *sample;
+	gsize len;
+
+	fields = egg_buffer_new();
+	egg_buffer_write_tag(fields, USER_FIELD, EGG_BUFFER_UINT);
+	egg_buffer_write_uint(fields, value);
+	egg_buffer_get_buffer(fields, &data, &len);
+
+	buffer = egg_buffer_new();
+	egg_buffer_write_tag(buffer, 1, EGG_BUFFER_UINT);
+	egg_buffer_write_uint(buffer, 2);
+	egg_buffer_write_tag(buffer, 2, EGG_BUFFER_UINT64);
+	egg_buffer_write_uint64(buffer, offset);
+	egg_buffer_write_tag(buffer, 3, EGG_BUFFER_DATA);
+	egg_buffer_write_data(buffer, data, len);
+	egg_buffer_get_buffer(buffer, &data, &len);
+
+	sample = pk_sample_new_from_data(manifest_resolver, manifest,
+	                                 data, len, NULL);
+	g_assert(sample);
+
+	egg_buffer_unref(fields);
+	egg_buffer_unref(buffer);
+	return sample;
+}
+
+/*
+ * Fills @model with @n_points samples, one every SAMPLE_PERIOD, following
+ * a random walk between 0 and 100.
+ */
+static void
+fill_model (PkModel *model,
+            gint     n_points,
+            gdouble *begin_time,
+            gdouble *end_time)
+{
+	PkManifest *manifest;
+	PkSample *samples[N_BATCH];
+	GTimer *timer;
+	gint value = 50;
+	gint n;
+	gint i;
+	gint j;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	pk_model_insert_manifest(model, manifest);
+	timer = g_timer_new();
+
+	for (i = 0; i < n_points; i += n) {
+		n = MIN(N_BATCH, n_points - i);
+		for (j = 0; j < n; j++) {
+			value += g_test_rand_int_range(-2, 3);
+			value = CLAMP(value, 0, 100);
+			samples[j] = make_sample(manifest,
+			                         (guint64)(i + j) * SAMPLE_PERIOD,
+			                         value);
+		}
+		if (i == 0) {
+			*begin_time = samples[0]->time;
+		}
+		pk_model_insert_samples(model, manifest, samples, n);
+		for (j = 0; j < n; j++) {
+			pk_sample_unref(samples[j]);
+		}
+	}
+	*end_time = *begin_time + (gdouble)n_points * SAMPLE_PERIOD /
+	                          G_USEC_PER_SEC;
+
+	g_test_message("%s: built %d points in %.3f s",
+	               G_OBJECT_TYPE_NAME(model), n_points,
+	               g_timer_elapsed(timer, NULL));
+
+	g_timer_destroy(timer);
+	pk_manifest_unref(manifest);
+}
+
+static void
+benchmark_renderer (const gchar *name,
+                    PpgRenderer *renderer,
+                    PkModel     *model,
+                    gdouble      begin_time,
+                    gdouble      end_time)
+{
+	cairo_surface_t *surface;
+	PpgTask *task;
+	GTimer *timer;
+	GQuark user;
+	gdouble frame_time;
+	gdouble n_visible;
+	gdouble span;
+	gdouble begin;
+	gdouble end;
+	gint width;
+	gint frame;
+	gint i;
+	gint j;
+
+	user = g_quark_from_static_string("User");
+	timer = g_timer_new();
+
+	for (i = 0; i < G_N_ELEMENTS(widths); i++) {
+		width = widths[i];
+		surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+		                                     width, HEIGHT);
+
+		for (j = 0; j < G_N_ELEMENTS(zooms); j++) {
+			/*
+			 * Zoom into the middle of the timeline.
+			 */
+			span = (end_time - begin_time) / zooms[j];
+			begin = begin_time + (end_time - begin_time - span) / 2.0;
+			end = begin + span;
+			n_visible = pk_model_get_range_aggregate(model, user,
+			                                         begin, end,
+			                                         PK_MODEL_AGGREGATE_COUNT);
+			ppg_renderer_set_time(renderer, begin, end);
+
+			g_timer_start(timer);
+			for (frame = 0; frame < N_FRAMES; frame++) {
+				task = ppg_renderer_draw(renderer, surface, begin, end,
+				                         0.0, 0.0, width, HEIGHT);
+				g_object_ref_sink(task);
+				ppg_task_run(task);
+				g_object_unref(task);
+				while (g_main_context_iteration(NULL, FALSE));
+			}
+			frame_time = g_timer_elapsed(timer, NULL) / N_FRAMES;
+
+			g_test_message("%s: %4d px, 1/%-4d of %.0f points: %.3f ms, "
+			               "%.0f points/s",
+			               name, width, zooms[j], n_visible,
+			               frame_time * 1000.0, n_visible / frame_time);
+			g_test_minimized_result(frame_time, "%s frame time: %f s",
+			                        name, frame_time);
+			g_test_maximized_result(n_visible / frame_time,
+			                        "%s throughput: %f points/s",
+			                        name, n_visible / frame_time);
+		}
+
+		cairo_surface_destroy(surface);
+	}
+
+	g_timer_destroy(timer);
+}
+
+static void
+benchmark_model (const gchar *model_name,
+                 PkModel     *model,
+                 gint         n_points)
+{
+	PpgRendererEvent *event;
+	PpgRendererLine *line;
+	GQuark user;
+	gdouble begin_time;
+	gdouble end_time;
+	gchar *name;
+
+	user = g_quark_from_static_string("User");
+	fill_model(model, n_points, &begin_time, &end_time);
+
+	line = g_object_new(PPG_TYPE_RENDERER_LINE, NULL);
+	g_object_ref_sink(line);
+	ppg_renderer_line_append(line, model, user);
+	ppg_renderer_line_set_rasterize(line, FALSE);
+	name = g_strdup_printf("%s line", model_name);
+	benchmark_renderer(name, PPG_RENDERER(line), model,
+	                   begin_time, end_time);
+	g_free(name);
+	ppg_renderer_line_set_rasterize(line, TRUE);
+	name = g_strdup_printf("%s line (rasterized)", model_name);
+	benchmark_renderer(name, PPG_RENDERER(line), model,
+	                   begin_time, end_time);
+	g_free(name);
+	g_object_unref(line);
+
+	event = g_object_new(PPG_TYPE_RENDERER_EVENT, NULL);
+	g_object_ref_sink(event);
+	ppg_renderer_event_append(event, model, user);
+	name = g_strdup_printf("%s event", model_name);
+	benchmark_renderer(name, PPG_RENDERER(event), model,
+	                   begin_time, end_time);
+	g_free(name);
+	g_object_unref(event);
+}
+
+static void
+test_PpgRenderer_benchmark (gconstpointer data)
+{
+	PkModel *model;
+	GError *error = NULL;
+	gint n_points = GPOINTER_TO_INT(data);
+
+	if (!g_test_perf()) {
+		return;
+	}
+
+	/*
+	 * Ten million points and up take minutes to build and gigabytes to
+	 * hold, so they only run in thorough mode.
+	 */
+	if (n_points >= 10000000 && !g_test_thorough()) {
+		return;
+	}
+
+	/*
+	 * Sessions store samples in any of these, depending on the
+	 * store-on-disk and compress-samples preferences; see
+	 * ppg_session_create_model().
+	 */
+	model = g_object_new(PK_TYPE_MODEL_COLUMNAR, NULL);
+	benchmark_model("columnar", model, n_points);
+	g_object_unref(model);
+
+	model = pk_model_mapped_new(NULL, &error);
+	g_assert_no_error(error);
+	benchmark_model("mapped", model, n_points);
+	g_object_unref(model);
+
+	model = g_object_new(PK_TYPE_MODEL_COMPRESSED, NULL);
+	benchmark_model("compressed", model, n_points);
+	g_object_unref(model);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+	g_thread_init(NULL);
+	g_type_init();
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_data_func("/PpgRenderer/benchmark/1K",
+	                     GINT_TO_POINTER(1000),
+	                     test_PpgRenderer_benchmark);
+	g_test_add_data_func("/PpgRenderer/benchmark/100K",
+	                     GINT_TO_POINTER(100000),
+	                     test_PpgRenderer_benchmark);
+	g_test_add_data_func("/PpgRenderer/benchmark/1M",
+	                     GINT_TO_POINTER(1000000),
+	                     test_PpgRenderer_benchmark);
+	g_test_add_data_func("/PpgRenderer/benchmark/10M",
+	                     GINT_TO_POINTER(10000000),
+	                     test_PpgRenderer_benchmark);
+	g_test_add_data_func("/PpgRenderer/benchmark/100M",
+	                     GINT_TO_POINTER(100000000),
+	                     test_PpgRenderer_benchmark);
+	return g_test_run();
+}
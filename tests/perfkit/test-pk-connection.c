@@ -10,17 +10,344 @@ test_PkConnection_new_from_uri (void)
 	g_object_unref(conn);
 }
 
+static void
+test_PkConnection_snapshot_manifest_cb (PkManifest *manifest,
+                                        gpointer    user_data)
+{
+	(*(gint *)user_data)++;
+}
+
+static void
+test_PkConnection_inproc (void)
+{
+	PkConnection *conn;
+	GError *error = NULL;
+	gint *channels = NULL;
+	gsize channels_len = 0;
+	gboolean removed = FALSE;
+	gint channel = 0;
+	gint subscription = 0;
+	guint8 *snapshot = NULL;
+	gsize snapshot_len = 0;
+	gint n_manifests = 0;
+
+	conn = pk_connection_new_from_uri("inproc://");
+	g_assert(conn);
+	g_assert(pk_connection_connect(conn, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_is_local(conn));
+
+	g_assert(pk_connection_manager_add_channel(conn, &channel, &error));
+	g_assert_no_error(error);
+	g_assert_cmpint(channel, >, 0);
+	g_assert(pk_connection_manager_get_channels(conn, &channels,
+	                                            &channels_len, &error));
+	g_assert_no_error(error);
+	g_assert_cmpint(channels_len, ==, 1);
+	g_assert_cmpint(channels[0], ==, channel);
+	g_free(channels);
+
+	g_assert(pk_connection_manager_add_subscription(conn, 0, 0,
+	                                                &subscription, &error));
+	g_assert_no_error(error);
+	g_assert_cmpint(subscription, >, 0);
+	g_assert(pk_connection_manager_remove_subscription(conn, subscription,
+	                                                   &removed, &error));
+	g_assert_no_error(error);
+	g_assert(removed);
+	g_assert(pk_connection_manager_get_snapshot(conn, &snapshot,
+	                                            &snapshot_len, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_parse_snapshot(snapshot, snapshot_len,
+	                                      test_PkConnection_snapshot_manifest_cb,
+	                                      NULL, &n_manifests));
+	g_assert_cmpint(n_manifests, ==, 0);
+	g_free(snapshot);
+
+	g_assert(pk_connection_manager_remove_channel(conn, channel,
+	                                              &removed, &error));
+	g_assert_no_error(error);
+	g_assert(removed);
+
+	g_assert(pk_connection_disconnect(conn, &error));
+	g_assert_no_error(error);
+	g_object_unref(conn);
+}
+
+typedef struct
+{
+	gint   source;
+	gint   n_manifests;
+	gint   n_samples;
+	gchar *first_row;
+	gint   cpu;
+	gint   user;
+} Snapshot;
+
+static void
+test_PkConnection_snapshot_parse_manifest_cb (PkManifest *manifest,
+                                              gpointer    user_data)
+{
+	Snapshot *snapshot = user_data;
+
+	g_assert_cmpint(pk_manifest_get_source_id(manifest), ==, snapshot->source);
+	g_assert_cmpint(pk_manifest_get_n_rows(manifest), ==, 10);
+	g_free(snapshot->first_row);
+	snapshot->first_row = g_strdup(pk_manifest_get_row_name(manifest, 1));
+	snapshot->n_manifests++;
+}
+
+static void
+test_PkConnection_snapshot_parse_sample_cb (PkManifest *manifest,
+                                            PkSample   *sample,
+                                            gpointer    user_data)
+{
+	Snapshot *snapshot = user_data;
+	GValue value = { 0 };
+
+	g_assert_cmpint(pk_sample_get_source_id(sample), ==, snapshot->source);
+	g_assert(pk_sample_get_value(sample, 1, &value));
+	g_assert(G_VALUE_HOLDS_INT(&value));
+	snapshot->cpu = g_value_get_int(&value);
+	g_value_unset(&value);
+	g_assert(pk_sample_get_value(sample, 2, &value));
+	snapshot->user = g_value_get_int(&value);
+	g_value_unset(&value);
+	snapshot->n_samples++;
+}
+
+static void
+test_PkConnection_snapshot (void)
+{
+	PkConnection *conn;
+	Snapshot parsed = { 0 };
+	GError *error = NULL;
+	guint8 *snapshot = NULL;
+	gsize snapshot_len = 0;
+	gint i;
+
+	conn = pk_connection_new_from_uri("inproc://");
+	g_assert(conn);
+	g_assert(pk_connection_connect(conn, &error));
+	g_assert_no_error(error);
+
+	/*
+	 * The cpu source delivers its manifest along with its first samples,
+	 * so wait for the snapshot to hold a sample.
+	 */
+	g_assert(pk_connection_source_acquire(conn, "Cpu", &parsed.source,
+	                                      &error));
+	g_assert_no_error(error);
+	for (i = 0; i < 50 && !parsed.n_samples; i++) {
+		while (g_main_context_iteration(NULL, FALSE));
+		g_usleep(G_USEC_PER_SEC / 10);
+		parsed.n_manifests = 0;
+		g_assert(pk_connection_manager_get_snapshot(conn, &snapshot,
+		                                            &snapshot_len, &error));
+		g_assert_no_error(error);
+		g_assert(pk_connection_parse_snapshot(
+				snapshot, snapshot_len,
+				test_PkConnection_snapshot_parse_manifest_cb,
+				test_PkConnection_snapshot_parse_sample_cb,
+				&parsed));
+		g_free(snapshot);
+	}
+
+	g_assert_cmpint(parsed.n_manifests, ==, 1);
+	g_assert_cmpint(parsed.n_samples, ==, 1);
+	g_assert_cmpstr(parsed.first_row, ==, "CPU Number");
+	g_assert_cmpint(parsed.cpu, >=, 0);
+	g_assert_cmpint(parsed.user, >=, 0);
+	g_free(parsed.first_row);
+
+	g_assert(pk_connection_source_release(conn, parsed.source, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_disconnect(conn, &error));
+	g_assert_no_error(error);
+	g_object_unref(conn);
+}
+
+typedef struct
+{
+	gint          source;
+	volatile gint n_manifests;
+	volatile gint n_samples;
+} Delivery;
+
+static void
+test_PkConnection_delivery_manifest_cb (PkManifest *manifest,
+                                        gpointer    user_data)
+{
+	Delivery *delivery = user_data;
+
+	g_assert_cmpint(pk_manifest_get_source_id(manifest), ==, delivery->source);
+	g_atomic_int_inc(&delivery->n_manifests);
+}
+
+static void
+test_PkConnection_delivery_samples_cb (PkManifest  *manifest,
+                                       PkSample   **samples,
+                                       guint        n_samples,
+                                       gpointer     user_data)
+{
+	Delivery *delivery = user_data;
+	gint i;
+
+	g_assert(manifest);
+	g_assert_cmpint(pk_manifest_get_source_id(manifest), ==, delivery->source);
+	for (i = 0; i < n_samples; i++) {
+		g_assert_cmpint(pk_sample_get_source_id(samples[i]), ==,
+		                delivery->source);
+	}
+	g_atomic_int_add(&delivery->n_samples, n_samples);
+}
+
+static void
+test_PkConnection_delivery (void)
+{
+	PkConnection *conn;
+	Delivery delivery = { 0 };
+	GError *error = NULL;
+	gint consumer = 0;
+	gint i;
+
+	conn = pk_connection_new_from_uri("inproc://");
+	g_assert(conn);
+	g_assert(pk_connection_connect(conn, &error));
+	g_assert_no_error(error);
+
+	/*
+	 * The agent delivers from its own threads, so poll for the first
+	 * samples of the cpu source to reach the consumer.
+	 */
+	g_assert(pk_connection_source_acquire(conn, "Cpu", &delivery.source,
+	                                      &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_subscription_acquire(
+			conn, &delivery.source, 1, 0, 0, 0,
+			test_PkConnection_delivery_manifest_cb,
+			test_PkConnection_delivery_samples_cb,
+			&delivery, NULL, &consumer, &error));
+	g_assert_no_error(error);
+	for (i = 0; i < 50 && !g_atomic_int_get(&delivery.n_samples); i++) {
+		while (g_main_context_iteration(NULL, FALSE));
+		g_usleep(G_USEC_PER_SEC / 10);
+	}
+
+	g_assert_cmpint(g_atomic_int_get(&delivery.n_manifests), >, 0);
+	g_assert_cmpint(g_atomic_int_get(&delivery.n_samples), >, 0);
+
+	g_assert(pk_connection_subscription_release(conn, consumer, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_source_release(conn, delivery.source, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_disconnect(conn, &error));
+	g_assert_no_error(error);
+	g_object_unref(conn);
+}
+
+static void
+test_PkConnection_shared_source (void)
+{
+	PkConnection *conn;
+	GError *error = NULL;
+	gint *subscriptions = NULL;
+	gsize subscriptions_len = 0;
+	gint *sources = NULL;
+	gsize sources_len = 0;
+	gint source[2] = { 0 };
+	gint consumer[2] = { 0 };
+	gint i;
+
+	conn = pk_connection_new_from_uri("inproc://");
+	g_assert(conn);
+	g_assert(pk_connection_connect(conn, &error));
+	g_assert_no_error(error);
+
+	/*
+	 * Both consumers are given the same source, and so share a single
+	 * subscription on the agent.
+	 */
+	for (i = 0; i < 2; i++) {
+		g_assert(pk_connection_source_acquire(conn, "Cpu", &source[i],
+		                                      &error));
+		g_assert_no_error(error);
+		g_assert(pk_connection_subscription_acquire(conn, &source[i], 1,
+		                                            0, 0, 0, NULL, NULL,
+		                                            NULL, NULL,
+		                                            &consumer[i], &error));
+		g_assert_no_error(error);
+	}
+	g_assert_cmpint(source[0], >, 0);
+	g_assert_cmpint(source[0], ==, source[1]);
+	g_assert_cmpint(consumer[0], !=, consumer[1]);
+
+	g_assert(pk_connection_manager_get_sources(conn, &sources,
+	                                           &sources_len, &error));
+	g_assert_no_error(error);
+	g_assert_cmpint(sources_len, ==, 1);
+	g_free(sources);
+	g_assert(pk_connection_manager_get_subscriptions(conn, &subscriptions,
+	                                                 &subscriptions_len,
+	                                                 &error));
+	g_assert_no_error(error);
+	g_assert_cmpint(subscriptions_len, ==, 1);
+	g_free(subscriptions);
+
+	/*
+	 * The source and subscription go away with their last consumer.
+	 */
+	for (i = 0; i < 2; i++) {
+		g_assert(pk_connection_subscription_release(conn, consumer[i],
+		                                            &error));
+		g_assert_no_error(error);
+		g_assert(pk_connection_source_release(conn, source[i], &error));
+		g_assert_no_error(error);
+		g_assert(pk_connection_manager_get_sources(conn, &sources,
+		                                           &sources_len, &error));
+		g_assert_no_error(error);
+		g_assert_cmpint(sources_len, ==, 1 - i);
+		g_free(sources);
+	}
+	g_assert(pk_connection_manager_get_subscriptions(conn, &subscriptions,
+	                                                 &subscriptions_len,
+	                                                 &error));
+	g_assert_no_error(error);
+	g_assert_cmpint(subscriptions_len, ==, 0);
+	g_free(subscriptions);
+
+	g_assert(pk_connection_disconnect(conn, &error));
+	g_assert_no_error(error);
+	g_object_unref(conn);
+}
+
 gint
 main (gint   argc,
       gchar *argv[])
 {
 	g_setenv("PERFKIT_CONNECTIONS_DIR", PERFKIT_CONNECTIONS_DIR, FALSE);
+	g_setenv("PERFKIT_PLUGINS_PATH", PERFKIT_PLUGINS_PATH, FALSE);
 
+	g_thread_init(NULL);
 	g_type_init();
 	g_test_init(&argc, &argv, NULL);
 
+	/*
+	 * The in-process agent warns about files in the plugin directory that
+	 * are not agent plugins, such as the gtk modules.
+	 */
+	g_log_set_always_fatal(G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
+
 	g_test_add_func("/PkConnection/new_from_uri",
 	                test_PkConnection_new_from_uri);
+	g_test_add_func("/PkConnection/inproc",
+	                test_PkConnection_inproc);
+	g_test_add_func("/PkConnection/snapshot",
+	                test_PkConnection_snapshot);
+	g_test_add_func("/PkConnection/delivery",
+	                test_PkConnection_delivery);
+	g_test_add_func("/PkConnection/shared_source",
+	                test_PkConnection_shared_source);
 
 	return g_test_run();
 }
@@ -0,0 +1,416 @@
+#include <perfkit/perfkit.h>
+
+#include "manifest.h"
+#include "sample.h"
+
+static gboolean
+manifest_resolver (gint         source_id,
+                   PkManifest **manifest,
+                   gpointer     real_manifest)
+{
+	*manifest = real_manifest;
+	return TRUE;
+}
+
+#define LOAD_SAMPLE(_n)                                  \
+    pk_sample_new_from_data(manifest_resolver, manifest, \
+                            (_n), sizeof (_n), NULL)
+
+static void
+test_PkModelColumnar_insert_tests (void)
+{
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkSample *samples[3];
+	PkModel *model;
+	const gdouble *times;
+	gint count;
+	gint i;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	g_assert(manifest);
+
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+
+	model = g_object_new(PK_TYPE_MODEL_COLUMNAR, NULL);
+	g_assert(model);
+
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_sample(model, manifest, samples[0]);
+	pk_model_insert_samples(model, manifest, &samples[1], 2);
+
+	g_assert_cmpint(pk_model_columnar_get_length(PK_MODEL_COLUMNAR(model)), ==, 3);
+	times = pk_model_columnar_get_times(PK_MODEL_COLUMNAR(model));
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		g_assert_cmpfloat(times[i], ==, samples[i]->time);
+	}
+
+	count = 0;
+	if (pk_model_get_iter_first(model, &iter)) {
+		do {
+			g_assert_cmpfloat(iter.time, ==, samples[count]->time);
+			count++;
+		} while (pk_model_iter_next(model, &iter));
+	}
+	g_assert_cmpint(count, ==, 3);
+
+	count = 0;
+	if (pk_model_get_iter_for_range(model, &iter,
+	                                1293594062.0,
+	                                1293594063.0,
+	                                0.0)) {
+		do {
+			count++;
+		} while (pk_model_iter_next(model, &iter));
+	}
+	g_assert_cmpint(count, ==, 2);
+
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+	g_object_unref(model);
+}
+
+static void
+test_PkModelColumnar_matches_memory (void)
+{
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkModelIter iter2;
+	PkSample *samples[3];
+	PkModel *memory;
+	PkModel *model;
+	GQuark user;
+	GQuark idle;
+	gint count;
+	gint i;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+
+	user = g_quark_from_static_string("User");
+	idle = g_quark_from_static_string("Idle");
+
+	memory = g_object_new(PK_TYPE_MODEL_MEMORY, NULL);
+	model = g_object_new(PK_TYPE_MODEL_COLUMNAR, NULL);
+	pk_model_set_field_mode(memory, idle, PK_MODEL_COUNTER);
+	pk_model_set_field_mode(model, idle, PK_MODEL_COUNTER);
+	pk_model_insert_manifest(memory, manifest);
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_samples(memory, manifest, samples, G_N_ELEMENTS(samples));
+	pk_model_insert_samples(model, manifest, samples, G_N_ELEMENTS(samples));
+
+	count = 0;
+	g_assert(pk_model_get_iter_first(memory, &iter));
+	g_assert(pk_model_get_iter_first(model, &iter2));
+	do {
+		g_assert_cmpfloat(iter.time, ==, iter2.time);
+		g_assert_cmpfloat(pk_model_get_double(memory, &iter, user), ==,
+		                  pk_model_get_double(model, &iter2, user));
+		g_assert_cmpint(pk_model_get_uint(memory, &iter, idle), ==,
+		                pk_model_get_uint(model, &iter2, idle));
+		count++;
+		g_assert(pk_model_iter_next(model, &iter2) ==
+		         pk_model_iter_next(memory, &iter));
+	} while (count < G_N_ELEMENTS(samples));
+	g_assert_cmpint(count, ==, 3);
+
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+	g_object_unref(memory);
+	g_object_unref(model);
+}
+
+static void
+test_PkModelColumnar_aggregate (void)
+{
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkSample *samples[3];
+	PkModel *model;
+	GQuark user;
+	gdouble values[3];
+	gdouble min;
+	gdouble max;
+	gint count;
+	gint i;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+	user = g_quark_from_static_string("User");
+
+	model = g_object_new(PK_TYPE_MODEL_COLUMNAR, NULL);
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_samples(model, manifest, samples, G_N_ELEMENTS(samples));
+
+	count = 0;
+	g_assert(pk_model_get_iter_first(model, &iter));
+	do {
+		values[count] = pk_model_get_double(model, &iter, user);
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_COUNT),
+		                  ==, 1.0);
+		count++;
+	} while (pk_model_iter_next(model, &iter));
+	g_assert_cmpint(count, ==, 3);
+
+	min = MIN(values[0], MIN(values[1], values[2]));
+	max = MAX(values[0], MAX(values[1], values[2]));
+
+	/*
+	 * All three samples fall within the same 1024 second bucket.
+	 */
+	count = 0;
+	g_assert(pk_model_get_iter_for_range(model, &iter,
+	                                     1293594061.0,
+	                                     1293594064.0,
+	                                     1024.0));
+	do {
+		g_assert_cmpfloat(iter.time, ==, samples[0]->time);
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_COUNT),
+		                  ==, 3.0);
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_MIN),
+		                  ==, min);
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_MAX),
+		                  ==, max);
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_FIRST),
+		                  ==, values[0]);
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_LAST),
+		                  ==, values[2]);
+		g_assert_cmpfloat(pk_model_get_double(model, &iter, user), ==,
+		                  (values[0] + values[1] + values[2]) / 3.0);
+		count++;
+	} while (pk_model_iter_next(model, &iter));
+	g_assert_cmpint(count, ==, 1);
+
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+	g_object_unref(model);
+}
+
+static void
+double_user_builder (PkModel     *model,
+                     PkModelIter *iter,
+                     GQuark       key,
+                     GValue      *value,
+                     gpointer     user_data)
+{
+	gint *n_calls = user_data;
+
+	(*n_calls)++;
+	g_value_set_double(value,
+	                   pk_model_get_double(model, iter,
+	                                       g_quark_from_static_string("User")) * 2.0);
+}
+
+static void
+test_PkModelColumnar_materialized (void)
+{
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkSample *samples[3];
+	PkModel *model;
+	GQuark doubled;
+	GQuark user;
+	gint n_calls = 0;
+	gint count;
+	gint i;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+	user = g_quark_from_static_string("User");
+	doubled = g_quark_from_static_string("DoubledUser");
+
+	model = g_object_new(PK_TYPE_MODEL_COLUMNAR, NULL);
+	pk_model_set_field_mode(model, user, PK_MODEL_COUNTER);
+	pk_model_register_builder(model, doubled, double_user_builder,
+	                          &n_calls, NULL);
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_samples(model, manifest, samples, G_N_ELEMENTS(samples));
+	g_assert_cmpint(n_calls, ==, 3);
+
+	/*
+	 * Reading the builder field uses the stored values.
+	 */
+	for (i = 0; i < 2; i++) {
+		count = 0;
+		g_assert(pk_model_get_iter_first(model, &iter));
+		do {
+			g_assert_cmpfloat(pk_model_get_double(model, &iter, doubled), ==,
+			                  pk_model_get_double(model, &iter, user) * 2.0);
+			count++;
+		} while (pk_model_iter_next(model, &iter));
+		g_assert_cmpint(count, ==, 3);
+	}
+	g_assert_cmpint(n_calls, ==, 3);
+
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+	g_object_unref(model);
+}
+
+static void
+test_PkModelColumnar_builder_rollup (void)
+{
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkSample *samples[3];
+	PkModel *model;
+	GQuark doubled;
+	GQuark user;
+	gint n_calls = 0;
+	gint i;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+	user = g_quark_from_static_string("User");
+	doubled = g_quark_from_static_string("DoubledUser");
+
+	model = g_object_new(PK_TYPE_MODEL_COLUMNAR, NULL);
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_samples(model, manifest, samples, G_N_ELEMENTS(samples));
+
+	/*
+	 * Roll the samples up before the builder exists, so that its buckets
+	 * have to be filled in when it is registered.
+	 */
+	g_assert(pk_model_get_iter_for_range(model, &iter,
+	                                     1293594061.0,
+	                                     1293594064.0,
+	                                     1024.0));
+	pk_model_register_builder(model, doubled, double_user_builder,
+	                          &n_calls, NULL);
+	g_assert_cmpint(n_calls, ==, 3);
+
+	g_assert(pk_model_get_iter_for_range(model, &iter,
+	                                     1293594061.0,
+	                                     1293594064.0,
+	                                     1024.0));
+	g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, doubled,
+	                                         PK_MODEL_AGGREGATE_COUNT),
+	                  ==, 3.0);
+	g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, doubled,
+	                                         PK_MODEL_AGGREGATE_MIN),
+	                  ==, pk_model_get_aggregate(model, &iter, user,
+	                                             PK_MODEL_AGGREGATE_MIN) * 2.0);
+	g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, doubled,
+	                                         PK_MODEL_AGGREGATE_MAX),
+	                  ==, pk_model_get_aggregate(model, &iter, user,
+	                                             PK_MODEL_AGGREGATE_MAX) * 2.0);
+	g_assert_cmpfloat(pk_model_get_double(model, &iter, doubled), ==,
+	                  pk_model_get_double(model, &iter, user) * 2.0);
+
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+	g_object_unref(model);
+}
+
+static void
+test_PkModelColumnar_range_aggregate (void)
+{
+	PkModelAggregate aggregate;
+	PkManifest *manifest;
+	PkSample *samples[3];
+	PkModel *memory;
+	PkModel *model;
+	GQuark user;
+	gdouble expected;
+	gint i;
+	gint j;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+	user = g_quark_from_static_string("User");
+
+	/*
+	 * PkModelMemory walks the range, so it serves as the reference for
+	 * the indexes of PkModelColumnar.
+	 */
+	memory = g_object_new(PK_TYPE_MODEL_MEMORY, NULL);
+	model = g_object_new(PK_TYPE_MODEL_COLUMNAR, NULL);
+	pk_model_insert_manifest(memory, manifest);
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_samples(memory, manifest, samples, G_N_ELEMENTS(samples));
+	pk_model_insert_samples(model, manifest, samples, G_N_ELEMENTS(samples));
+
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		for (j = i; j < G_N_ELEMENTS(samples); j++) {
+			for (aggregate = PK_MODEL_AGGREGATE_MEAN;
+			     aggregate <= PK_MODEL_AGGREGATE_SUM;
+			     aggregate++) {
+				expected = pk_model_get_range_aggregate(memory, user,
+				                                        samples[i]->time,
+				                                        samples[j]->time,
+				                                        aggregate);
+				g_assert_cmpfloat(ABS(expected -
+				                      pk_model_get_range_aggregate(
+				                          model, user,
+				                          samples[i]->time,
+				                          samples[j]->time,
+				                          aggregate)),
+				                  <, 0.0001);
+			}
+		}
+	}
+
+	g_assert_cmpfloat(pk_model_get_range_aggregate(model, user,
+	                                               samples[2]->time + 1.0,
+	                                               samples[2]->time + 2.0,
+	                                               PK_MODEL_AGGREGATE_COUNT),
+	                  ==, 0.0);
+
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+	g_object_unref(memory);
+	g_object_unref(model);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+	g_setenv("PERFKIT_CONNECTIONS_DIR", PERFKIT_CONNECTIONS_DIR, FALSE);
+	g_type_init();
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_func("/PkModelColumnar/insert_tests",
+	                test_PkModelColumnar_insert_tests);
+	g_test_add_func("/PkModelColumnar/matches_memory",
+	                test_PkModelColumnar_matches_memory);
+	g_test_add_func("/PkModelColumnar/aggregate",
+	                test_PkModelColumnar_aggregate);
+	g_test_add_func("/PkModelColumnar/materialized",
+	                test_PkModelColumnar_materialized);
+	g_test_add_func("/PkModelColumnar/builder_rollup",
+	                test_PkModelColumnar_builder_rollup);
+	g_test_add_func("/PkModelColumnar/range_aggregate",
+	                test_PkModelColumnar_range_aggregate);
+	return g_test_run();
+}
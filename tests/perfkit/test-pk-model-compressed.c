@@ -0,0 +1,219 @@
+#include <egg-buffer.h>
+#include <perfkit/perfkit.h>
+
+#include "manifest.h"
+
+/*
+ * Eight sealed chunks and a single raw sample in the tail.
+ */
+#define N_SAMPLES (8 * 1024 + 1)
+#define N_FIELDS  (10)
+#define USER      (2)
+#define SYSTEM    (4)
+#define IDLE      (5)
+#define IOWAIT    (6)
+
+static gboolean
+manifest_resolver (gint         source_id,
+                   PkManifest **manifest,
+                   gpointer     real_manifest)
+{
+	*manifest = real_manifest;
+	return TRUE;
+}
+
+/*
+ * Encodes a sample the way the agent does, @offset microseconds after the
+ * manifest, carrying a value for each field of the test manifest.
+ */
+static PkSample*
+make_sample (PkManifest *manifest,
+             guint64     offset,
+             const gint *values)
+{
+	EggBuffer *buffer;
+	EggBuffer *fields;
+	const guint8 *data;
+	PkSample *sample;
+	gsize len;
+	gint i;
+
+	fields = egg_buffer_new();
+	for (i = 0; i < N_FIELDS; i++) {
+		egg_buffer_write_tag(fields, i + 1, EGG_BUFFER_INT);
+		egg_buffer_write_int(fields, values[i]);
+	}
+	egg_buffer_get_buffer(fields, &data, &len);
+
+	buffer = egg_buffer_new();
+	egg_buffer_write_tag(buffer, 1, EGG_BUFFER_UINT);
+	egg_buffer_write_uint(buffer, pk_manifest_get_source_id(manifest));
+	egg_buffer_write_tag(buffer, 2, EGG_BUFFER_UINT64);
+	egg_buffer_write_uint64(buffer, offset);
+	egg_buffer_write_tag(buffer, 3, EGG_BUFFER_DATA);
+	egg_buffer_write_data(buffer, data, len);
+	egg_buffer_get_buffer(buffer, &data, &len);
+
+	sample = pk_sample_new_from_data(manifest_resolver, manifest,
+	                                 data, len, NULL);
+	g_assert(sample);
+
+	egg_buffer_unref(fields);
+	egg_buffer_unref(buffer);
+	return sample;
+}
+
+static void
+test_PkModelCompressed_matches_memory (void)
+{
+	PkModelAggregate aggregate;
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkModelIter iter2;
+	PkSample *sample;
+	PkModel *memory;
+	PkModel *model;
+	GQuark user;
+	GQuark idle;
+	GQuark keys[2];
+	GRand *rng;
+	gdouble expected;
+	gdouble begin_time = 0.0;
+	gdouble times[3] = { 0.0 };
+	gdouble bytes_per_point;
+	gint values[N_FIELDS] = { 0 };
+	gint count;
+	gint i;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	rng = g_rand_new_with_seed(0x504b);
+
+	user = g_quark_from_static_string("User");
+	idle = g_quark_from_static_string("Idle");
+	keys[0] = user;
+	keys[1] = idle;
+
+	memory = g_object_new(PK_TYPE_MODEL_MEMORY, NULL);
+	model = g_object_new(PK_TYPE_MODEL_COMPRESSED, NULL);
+	pk_model_set_field_mode(memory, idle, PK_MODEL_COUNTER);
+	pk_model_set_field_mode(model, idle, PK_MODEL_COUNTER);
+	pk_model_insert_manifest(memory, manifest);
+	pk_model_insert_manifest(model, manifest);
+
+	/*
+	 * One sample a second, like the cpu source. User and system time are
+	 * gauges that wander, idle time is a counter with uneven increments
+	 * and the remaining fields are mostly or always zero.
+	 */
+	for (i = 0; i < N_SAMPLES; i++) {
+		values[USER - 1] += g_rand_int_range(rng, -5, 6);
+		values[USER - 1] = CLAMP(values[USER - 1], 0, 100);
+		values[SYSTEM - 1] += g_rand_int_range(rng, -2, 3);
+		values[SYSTEM - 1] = CLAMP(values[SYSTEM - 1], 0, 20);
+		values[IDLE - 1] += g_rand_int_range(rng, 60, 91);
+		values[IOWAIT - 1] = g_rand_int_range(rng, 0, 8) ? 0 : 1;
+		sample = make_sample(manifest, (guint64)i * G_USEC_PER_SEC, values);
+		if (!i) {
+			begin_time = sample->time;
+		}
+		if (i >= 1499 && i <= 1501) {
+			times[i - 1499] = sample->time;
+		}
+		pk_model_insert_sample(memory, manifest, sample);
+		pk_model_insert_sample(model, manifest, sample);
+		pk_sample_unref(sample);
+	}
+
+	count = 0;
+	g_assert(pk_model_get_iter_first(memory, &iter));
+	g_assert(pk_model_get_iter_first(model, &iter2));
+	g_assert_cmpfloat(iter2.time, ==, begin_time);
+	do {
+		g_assert_cmpfloat(iter.time, ==, iter2.time);
+		g_assert_cmpfloat(pk_model_get_double(memory, &iter, user), ==,
+		                  pk_model_get_double(model, &iter2, user));
+		g_assert_cmpfloat(pk_model_get_double(memory, &iter, idle), ==,
+		                  pk_model_get_double(model, &iter2, idle));
+		count++;
+		g_assert(pk_model_iter_next(model, &iter2) ==
+		         pk_model_iter_next(memory, &iter));
+	} while (count < N_SAMPLES);
+	g_assert_cmpint(count, ==, N_SAMPLES);
+
+	/*
+	 * A range within the second chunk starts at the sample before it.
+	 */
+	g_assert(pk_model_get_iter_for_range(model, &iter2,
+	                                     times[1], times[2], 0.0));
+	g_assert_cmpfloat(iter2.time, ==, times[0]);
+
+	/*
+	 * Ranges are answered from the chunk summaries, with the samples at
+	 * the edges walked. PkModelMemory walks the whole range.
+	 */
+	for (aggregate = PK_MODEL_AGGREGATE_MEAN;
+	     aggregate <= PK_MODEL_AGGREGATE_SUM;
+	     aggregate++) {
+		for (i = 0; i < G_N_ELEMENTS(keys); i++) {
+			expected = pk_model_get_range_aggregate(memory, keys[i],
+			                                        times[1], times[1] + 5000.0,
+			                                        aggregate);
+			g_assert_cmpfloat(ABS(expected -
+			                      pk_model_get_range_aggregate(
+			                          model, keys[i],
+			                          times[1], times[1] + 5000.0,
+			                          aggregate)),
+			                  <, 0.0001);
+		}
+	}
+
+	/*
+	 * With a sample a second, every sealed chunk fits within a step of
+	 * 1024 seconds. The sample in the tail is stepped over on its own.
+	 * Each step is compared with the range ending half a second before
+	 * the next one.
+	 */
+	count = 0;
+	g_assert(pk_model_get_iter_for_range(model, &iter2, begin_time,
+	                                     begin_time + N_SAMPLES, 1024.0));
+	do {
+		g_assert_cmpfloat(ABS(pk_model_get_double(model, &iter2, user) -
+		                      pk_model_get_range_aggregate(
+		                          memory, user, iter2.time,
+		                          iter2.time + pk_model_get_aggregate(
+		                              model, &iter2, user,
+		                              PK_MODEL_AGGREGATE_COUNT) - 0.5,
+		                          PK_MODEL_AGGREGATE_MEAN)),
+		                  <, 0.0001);
+		count += pk_model_get_aggregate(model, &iter2, user,
+		                                PK_MODEL_AGGREGATE_COUNT);
+	} while (pk_model_iter_next(model, &iter2));
+	g_assert_cmpint(count, ==, N_SAMPLES);
+
+	/*
+	 * Each point is one field of one sample, along with its share of the
+	 * sample's time. Packed points should take one to two bytes at most.
+	 */
+	bytes_per_point =
+		(gdouble)pk_model_compressed_get_size(PK_MODEL_COMPRESSED(model)) /
+		(N_SAMPLES * N_FIELDS);
+	g_test_message("%.2f bytes per point", bytes_per_point);
+	g_assert_cmpfloat(bytes_per_point, <=, 2.0);
+
+	pk_manifest_unref(manifest);
+	g_rand_free(rng);
+	g_object_unref(memory);
+	g_object_unref(model);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+	g_setenv("PERFKIT_CONNECTIONS_DIR", PERFKIT_CONNECTIONS_DIR, FALSE);
+	g_type_init();
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_func("/PkModelCompressed/matches_memory",
+	                test_PkModelCompressed_matches_memory);
+	return g_test_run();
+}
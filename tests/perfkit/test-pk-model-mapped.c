@@ -0,0 +1,298 @@
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+#include <perfkit/perfkit.h>
+
+#include "manifest.h"
+#include "sample.h"
+
+static gboolean
+manifest_resolver (gint         source_id,
+                   PkManifest **manifest,
+                   gpointer     real_manifest)
+{
+	*manifest = real_manifest;
+	return TRUE;
+}
+
+#define LOAD_SAMPLE(_n)                                  \
+    pk_sample_new_from_data(manifest_resolver, manifest, \
+                            (_n), sizeof (_n), NULL)
+
+static gint
+count_samples (PkModel *model)
+{
+	PkModelIter iter;
+	gint count = 0;
+
+	if (pk_model_get_iter_first(model, &iter)) {
+		do {
+			count++;
+		} while (pk_model_iter_next(model, &iter));
+	}
+	return count;
+}
+
+static void
+test_PkModelMapped_reopen (void)
+{
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkSample *samples[3];
+	PkModel *model;
+	GError *error = NULL;
+	gchar *filename;
+	gint fd;
+	gint i;
+
+	fd = g_file_open_tmp("test-pk-model-mapped-XXXXXX", &filename, NULL);
+	g_assert_cmpint(fd, >=, 0);
+	close(fd);
+	g_unlink(filename);
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	g_assert(manifest);
+
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+
+	model = pk_model_mapped_new(filename, &error);
+	g_assert_no_error(error);
+	g_assert(model);
+
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_sample(model, manifest, samples[0]);
+	g_assert(pk_model_mapped_flush(PK_MODEL_MAPPED(model), &error));
+	g_assert_no_error(error);
+	pk_model_insert_samples(model, manifest, &samples[1], 2);
+	g_assert_cmpint(count_samples(model), ==, 3);
+	g_object_unref(model);
+
+	/*
+	 * Reopen the capture; both chunks should be available immediately.
+	 */
+	model = pk_model_mapped_new(filename, &error);
+	g_assert_no_error(error);
+	g_assert(model);
+	g_assert_cmpfloat(pk_model_get_end_time(model), ==, samples[2]->time);
+	g_assert_cmpint(count_samples(model), ==, 3);
+
+	g_assert(pk_model_get_iter_first(model, &iter));
+	i = 0;
+	do {
+		g_assert_cmpfloat(iter.time, ==, samples[i]->time);
+		i++;
+	} while (pk_model_iter_next(model, &iter));
+
+	/*
+	 * New samples are appended after the existing ones.
+	 */
+	pk_model_insert_sample(model, manifest, samples[2]);
+	g_assert_cmpint(count_samples(model), ==, 4);
+	g_object_unref(model);
+
+	g_unlink(filename);
+	g_free(filename);
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+}
+
+/*
+ * Chunks start with a header of their magic, sample count, column count
+ * and size, each 32 bits.
+ */
+#define HEADER_N_COLUMNS (8)
+#define HEADER_SIZE      (12)
+
+static void
+test_PkModelMapped_corrupt (void)
+{
+	PkManifest *manifest;
+	PkSample *samples[3];
+	PkModel *model;
+	GError *error = NULL;
+	gchar *filename;
+	guint32 n_columns = G_MAXUINT32;
+	guint32 size;
+	gint fd;
+	gint i;
+
+	fd = g_file_open_tmp("test-pk-model-mapped-XXXXXX", &filename, NULL);
+	g_assert_cmpint(fd, >=, 0);
+	close(fd);
+	g_unlink(filename);
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+
+	model = pk_model_mapped_new(filename, &error);
+	g_assert_no_error(error);
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_sample(model, manifest, samples[0]);
+	g_assert(pk_model_mapped_flush(PK_MODEL_MAPPED(model), &error));
+	g_assert_no_error(error);
+	pk_model_insert_samples(model, manifest, &samples[1], 2);
+	g_object_unref(model);
+
+	/*
+	 * Claim more columns in the second chunk than it has room for, as a
+	 * capture cut short while writing might.
+	 */
+	fd = g_open(filename, O_RDWR, 0);
+	g_assert_cmpint(fd, >=, 0);
+	g_assert_cmpint(pread(fd, &size, sizeof size, HEADER_SIZE), ==,
+	                sizeof size);
+	g_assert_cmpint(pwrite(fd, &n_columns, sizeof n_columns,
+	                       size + HEADER_N_COLUMNS), ==, sizeof n_columns);
+	close(fd);
+
+	/*
+	 * Reopening keeps the first chunk and drops the invalid one.
+	 */
+	model = pk_model_mapped_new(filename, &error);
+	g_assert_no_error(error);
+	g_assert(model);
+	g_assert_cmpint(count_samples(model), ==, 1);
+	g_object_unref(model);
+
+	g_unlink(filename);
+	g_free(filename);
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+}
+
+static void
+test_PkModelMapped_aggregate (void)
+{
+	PkModelAggregate aggregate;
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkSample *samples[3];
+	PkModel *memory;
+	PkModel *model;
+	GError *error = NULL;
+	GQuark user;
+	gdouble values[3];
+	gdouble expected;
+	gint count;
+	gint i;
+	gint j;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+	user = g_quark_from_static_string("User");
+
+	memory = g_object_new(PK_TYPE_MODEL_MEMORY, NULL);
+	model = pk_model_mapped_new(NULL, &error);
+	g_assert_no_error(error);
+	pk_model_insert_manifest(memory, manifest);
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_samples(memory, manifest, samples, G_N_ELEMENTS(samples));
+	pk_model_insert_samples(model, manifest, samples, G_N_ELEMENTS(samples));
+
+	/*
+	 * Only chunks written to the file are summarized.
+	 */
+	g_assert(pk_model_mapped_flush(PK_MODEL_MAPPED(model), &error));
+	g_assert_no_error(error);
+
+	count = 0;
+	g_assert(pk_model_get_iter_first(model, &iter));
+	do {
+		values[count++] = pk_model_get_double(model, &iter, user);
+	} while (pk_model_iter_next(model, &iter));
+	g_assert_cmpint(count, ==, 3);
+
+	/*
+	 * All three samples fall within the same block.
+	 */
+	count = 0;
+	g_assert(pk_model_get_iter_for_range(model, &iter,
+	                                     1293594061.0,
+	                                     1293594064.0,
+	                                     1024.0));
+	do {
+		g_assert_cmpfloat(iter.time, ==, samples[0]->time);
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_COUNT),
+		                  ==, 3.0);
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_MIN),
+		                  ==, MIN(values[0], MIN(values[1], values[2])));
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_MAX),
+		                  ==, MAX(values[0], MAX(values[1], values[2])));
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_FIRST),
+		                  ==, values[0]);
+		g_assert_cmpfloat(pk_model_get_aggregate(model, &iter, user,
+		                                         PK_MODEL_AGGREGATE_LAST),
+		                  ==, values[2]);
+		g_assert_cmpfloat(pk_model_get_double(model, &iter, user), ==,
+		                  (values[0] + values[1] + values[2]) / 3.0);
+		count++;
+	} while (pk_model_iter_next(model, &iter));
+	g_assert_cmpint(count, ==, 1);
+
+	/*
+	 * PkModelMemory walks the range, so it serves as the reference for
+	 * the summaries.
+	 */
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		for (j = i; j < G_N_ELEMENTS(samples); j++) {
+			for (aggregate = PK_MODEL_AGGREGATE_MEAN;
+			     aggregate <= PK_MODEL_AGGREGATE_SUM;
+			     aggregate++) {
+				expected = pk_model_get_range_aggregate(memory, user,
+				                                        samples[i]->time,
+				                                        samples[j]->time,
+				                                        aggregate);
+				g_assert_cmpfloat(ABS(expected -
+				                      pk_model_get_range_aggregate(
+				                          model, user,
+				                          samples[i]->time,
+				                          samples[j]->time,
+				                          aggregate)),
+				                  <, 0.0001);
+			}
+		}
+	}
+
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+	g_object_unref(memory);
+	g_object_unref(model);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+	g_setenv("PERFKIT_CONNECTIONS_DIR", PERFKIT_CONNECTIONS_DIR, FALSE);
+	g_type_init();
+	g_test_init(&argc, &argv, NULL);
+
+	/*
+	 * Invalid chunks are reported with a warning when they are dropped.
+	 */
+	g_log_set_always_fatal(G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
+
+	g_test_add_func("/PkModelMapped/reopen",
+	                test_PkModelMapped_reopen);
+	g_test_add_func("/PkModelMapped/corrupt",
+	                test_PkModelMapped_corrupt);
+	g_test_add_func("/PkModelMapped/aggregate",
+	                test_PkModelMapped_aggregate);
+	return g_test_run();
+}
@@ -84,6 +84,117 @@ test_PkModelMemory_insert_tests (void)
 	g_object_unref(model);
 }
 
+static void
+test_PkModelMemory_insert_samples (void)
+{
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkSample *samples[3];
+	PkModel *model;
+	gint count;
+	gint i;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	g_assert(manifest);
+
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+
+	model = g_object_new(PK_TYPE_MODEL_MEMORY, NULL);
+	pk_model_insert_manifest(model, manifest);
+	pk_model_insert_samples(model, manifest, samples, G_N_ELEMENTS(samples));
+
+	g_assert_cmpfloat(pk_model_get_end_time(model), ==, samples[2]->time);
+
+	count = 0;
+	if (pk_model_get_iter_first(model, &iter)) {
+		do {
+			g_assert_cmpfloat(iter.time, ==, samples[count]->time);
+			count++;
+		} while (pk_model_iter_next(model, &iter));
+	}
+	g_assert_cmpint(count, ==, 3);
+
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+	g_object_unref(model);
+}
+
+static void
+test_PkModelMemory_retention (void)
+{
+	PkManifest *manifest;
+	PkModelIter iter;
+	PkSample *samples[3];
+	PkModel *model;
+	gint count;
+	gint i;
+
+	manifest = pk_manifest_new_from_data(manifest_data, sizeof manifest_data);
+	g_assert(manifest);
+
+	samples[0] = LOAD_SAMPLE(sample_data);
+	samples[1] = LOAD_SAMPLE(sample_data2);
+	samples[2] = LOAD_SAMPLE(sample_data3);
+
+	model = g_object_new(PK_TYPE_MODEL_MEMORY,
+	                     "max-samples", 2,
+	                     NULL);
+	pk_model_insert_manifest(model, manifest);
+
+	/*
+	 * Insert enough samples to wrap the ring a few times.
+	 */
+	for (i = 0; i < 100; i++) {
+		pk_model_insert_sample(model, manifest, samples[i % 3]);
+	}
+
+	count = 0;
+	if (pk_model_get_iter_first(model, &iter)) {
+		do {
+			count++;
+		} while (pk_model_iter_next(model, &iter));
+	}
+	g_assert_cmpint(count, ==, 2);
+
+	pk_manifest_unref(manifest);
+	for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+		pk_sample_unref(samples[i]);
+	}
+	g_object_unref(model);
+}
+
+static void
+test_PkModel_reduce (void)
+{
+	PkModelStats stats;
+	gint32 values[9] = { 4, 2, 6, 1, 9, 3, 8, 5, 7 };
+	gdouble times[9];
+	gint i;
+
+	for (i = 0; i < G_N_ELEMENTS(times); i++) {
+		times[i] = i * 0.5;
+	}
+
+	pk_model_reduce_int(values, NULL, G_N_ELEMENTS(values), &stats);
+	g_assert_cmpint(stats.count, ==, 9);
+	g_assert_cmpfloat(stats.sum, ==, 45.0);
+	g_assert_cmpfloat(stats.min, ==, 1.0);
+	g_assert_cmpfloat(stats.max, ==, 9.0);
+	g_assert_cmpfloat(stats.mean, ==, 5.0);
+	g_assert_cmpfloat(ABS(stats.variance - 60.0 / 9.0), <, 0.000001);
+	g_assert_cmpfloat(stats.rate, ==, 3.0 / 8.0);
+
+	pk_model_reduce_int(values, times, G_N_ELEMENTS(values), &stats);
+	g_assert_cmpfloat(stats.rate, ==, 3.0 / 4.0);
+
+	pk_model_reduce_int(values, NULL, 0, &stats);
+	g_assert_cmpint(stats.count, ==, 0);
+}
+
 gint
 main (gint   argc,
       gchar *argv[])
@@ -93,5 +204,11 @@ main (gint   argc,
 	g_test_init(&argc, &argv, NULL);
 	g_test_add_func("/PkModelMemory/insert_tests",
 	                test_PkModelMemory_insert_tests);
+	g_test_add_func("/PkModelMemory/insert_samples",
+	                test_PkModelMemory_insert_samples);
+	g_test_add_func("/PkModelMemory/retention",
+	                test_PkModelMemory_retention);
+	g_test_add_func("/PkModel/reduce",
+	                test_PkModel_reduce);
 	return g_test_run();
 }
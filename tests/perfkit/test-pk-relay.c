@@ -0,0 +1,303 @@
+#include <glib/gstdio.h>
+#include <perfkit/perfkit.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define TIMEOUT_MSEC (10000)
+
+typedef struct
+{
+	GMainLoop  *loop;
+	gint        relay;
+	gint        source;
+	PkManifest *manifest;
+	guint       n_samples;
+	gboolean    handlers_set;
+} Relayed;
+
+static gboolean
+spawn_or_skip (gchar **argv,
+               GPid   *pid)
+{
+	GError *error = NULL;
+
+	if (!g_spawn_async(NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL,
+	                   pid, &error)) {
+		g_test_message("Skipping, cannot spawn %s: %s",
+		               argv[0], error->message);
+		g_error_free(error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+kill_child (GPid pid)
+{
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+	g_spawn_close_pid(pid);
+}
+
+static void
+write_file (const gchar *path,
+            const gchar *contents)
+{
+	GError *error = NULL;
+
+	g_file_set_contents(path, contents, -1, &error);
+	g_assert_no_error(error);
+}
+
+static void
+relayed_manifest_cb (PkManifest *manifest,
+                     gpointer    user_data)
+{
+	Relayed *relayed = user_data;
+
+	if (relayed->manifest) {
+		pk_manifest_unref(relayed->manifest);
+	}
+	relayed->manifest = pk_manifest_ref(manifest);
+}
+
+static void
+relayed_samples_cb (PkManifest  *manifest,
+                    PkSample   **samples,
+                    guint        n_samples,
+                    gpointer     user_data)
+{
+	Relayed *relayed = user_data;
+	gint i;
+
+	g_assert(manifest == relayed->manifest);
+	for (i = 0; i < n_samples; i++) {
+		g_assert_cmpint(pk_sample_get_source_id(samples[i]), ==,
+		                pk_manifest_get_source_id(manifest));
+	}
+	relayed->source = pk_manifest_get_source_id(manifest);
+	relayed->n_samples += n_samples;
+	g_main_loop_quit(relayed->loop);
+}
+
+static void
+relayed_handlers_cb (GObject      *object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+	Relayed *relayed = user_data;
+	GError *error = NULL;
+
+	g_assert(pk_connection_subscription_set_batch_handlers_finish(
+			PK_CONNECTION(object), result, &error));
+	g_assert_no_error(error);
+	relayed->handlers_set = TRUE;
+	g_main_loop_quit(relayed->loop);
+}
+
+static gboolean
+relayed_timeout_cb (gpointer user_data)
+{
+	g_main_loop_quit(((Relayed *)user_data)->loop);
+	return FALSE;
+}
+
+/*
+ * Starts an agent on a private bus, as documented for local fleets, and
+ * relays its cpu source through the in-process agent.
+ */
+static void
+test_PkRelay_dbus_unix_path (void)
+{
+	PkConnection *upstream;
+	PkConnection *local;
+	Relayed relayed = { 0 };
+	GError *error = NULL;
+	GTimeVal started_at;
+	gchar *dir;
+	gchar *bus;
+	gchar *address;
+	gchar *agent_conf;
+	gchar *relay_conf;
+	gchar *contents;
+	gchar *uri;
+	gchar *hostname;
+	gchar *daemon_argv[] = { "dbus-daemon", "--session", "--nofork",
+	                         NULL, NULL };
+	gchar *agent_argv[] = { PERFKIT_AGENT_PATH, "--conf", NULL, NULL };
+	gboolean removed;
+	GPid daemon_pid;
+	GPid agent_pid;
+	guint timeout;
+	gint upstream_source;
+	gint channel;
+	gint subscription;
+	gint i;
+
+	dir = g_build_filename(g_get_tmp_dir(), "test-pk-relay-XXXXXX", NULL);
+	g_assert(mkdtemp(dir));
+	bus = g_build_filename(dir, "bus", NULL);
+	address = g_strdup_printf("unix:path=%s", bus);
+	uri = g_strdup_printf("dbus://%s", address);
+
+	daemon_argv[3] = g_strdup_printf("--address=%s", address);
+	if (!spawn_or_skip(daemon_argv, &daemon_pid)) {
+		goto cleanup;
+	}
+	for (i = 0; i < 50 && !g_file_test(bus, G_FILE_TEST_EXISTS); i++) {
+		g_usleep(G_USEC_PER_SEC / 10);
+	}
+	g_assert(g_file_test(bus, G_FILE_TEST_EXISTS));
+
+	/*
+	 * The upstream agent registers on the private bus as its session bus.
+	 */
+	agent_conf = g_build_filename(dir, "agent.conf", NULL);
+	write_file(agent_conf, "[listener.dbus]\n"
+	                       "disabled = false\n");
+	agent_argv[2] = agent_conf;
+	g_setenv("DBUS_SESSION_BUS_ADDRESS", address, TRUE);
+	if (!spawn_or_skip(agent_argv, &agent_pid)) {
+		kill_child(daemon_pid);
+		g_free(agent_conf);
+		goto cleanup;
+	}
+
+	upstream = pk_connection_new_from_uri(uri);
+	g_assert(upstream);
+	g_assert(pk_connection_connect(upstream, &error));
+	g_assert_no_error(error);
+	for (i = 0; i < 50; i++) {
+		if (pk_connection_manager_get_hostname(upstream, &hostname, NULL)) {
+			g_free(hostname);
+			break;
+		}
+		g_usleep(G_USEC_PER_SEC / 10);
+	}
+	g_assert(pk_connection_source_acquire(upstream, "Cpu", &upstream_source,
+	                                      &error));
+	g_assert_no_error(error);
+
+	/*
+	 * The relay plugin is built with libperfkit rather than the agent.
+	 */
+	relay_conf = g_build_filename(dir, "relay.conf", NULL);
+	contents = g_strdup_printf("[listener.dbus]\n"
+	                           "disabled = true\n"
+	                           "\n"
+	                           "[source.relay]\n"
+	                           "agents = %s\n"
+	                           "buffer-timeout = 100\n", uri);
+	write_file(relay_conf, contents);
+	g_free(contents);
+	g_setenv("PERFKIT_PLUGINS_PATH",
+	         PERFKIT_PLUGINS_PATH ":" PERFKIT_CONNECTIONS_DIR, TRUE);
+
+	contents = g_strdup_printf("inproc://%s", relay_conf);
+	local = pk_connection_new_from_uri(contents);
+	g_free(contents);
+	g_assert(local);
+	g_assert(pk_connection_connect(local, &error));
+	g_assert_no_error(error);
+
+	g_assert(pk_connection_manager_add_channel(local, &channel, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_manager_add_source(local, "Relay", &relayed.relay,
+	                                          &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_channel_add_source(local, channel, relayed.relay,
+	                                          &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_manager_add_subscription(local, 0, 0,
+	                                                &subscription, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_subscription_add_channel(local, subscription,
+	                                                channel, FALSE, &error));
+	g_assert_no_error(error);
+
+	relayed.loop = g_main_loop_new(NULL, FALSE);
+	pk_connection_subscription_set_batch_handlers_async(
+			local, subscription,
+			relayed_manifest_cb, &relayed, NULL,
+			relayed_samples_cb, &relayed, NULL,
+			NULL, relayed_handlers_cb, &relayed);
+	if (!relayed.handlers_set) {
+		g_main_loop_run(relayed.loop);
+	}
+	g_assert(pk_connection_channel_start(local, channel, &started_at,
+	                                     &error));
+	g_assert_no_error(error);
+
+	timeout = g_timeout_add(TIMEOUT_MSEC, relayed_timeout_cb, &relayed);
+	g_main_loop_run(relayed.loop);
+	g_source_remove(timeout);
+
+	/*
+	 * The upstream source arrives as a source of its own, with the
+	 * manifest of the cpu source rather than a merged one.
+	 */
+	g_assert_cmpint(relayed.n_samples, >, 0);
+	g_assert(relayed.manifest);
+	g_assert_cmpint(relayed.source, >, 0);
+	g_assert_cmpint(relayed.source, !=, relayed.relay);
+	g_assert_cmpstr(pk_manifest_get_row_name(relayed.manifest, 1), ==,
+	                "CPU Number");
+
+	g_assert(pk_connection_channel_stop(local, channel, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_manager_remove_subscription(local, subscription,
+	                                                   &removed, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_disconnect(local, &error));
+	g_assert_no_error(error);
+	g_object_unref(local);
+
+	g_assert(pk_connection_source_release(upstream, upstream_source, &error));
+	g_assert_no_error(error);
+	g_assert(pk_connection_disconnect(upstream, &error));
+	g_assert_no_error(error);
+	g_object_unref(upstream);
+
+	kill_child(agent_pid);
+	kill_child(daemon_pid);
+	pk_manifest_unref(relayed.manifest);
+	g_main_loop_unref(relayed.loop);
+	g_unlink(relay_conf);
+	g_unlink(agent_conf);
+	g_free(relay_conf);
+	g_free(agent_conf);
+
+  cleanup:
+	g_unlink(bus);
+	g_rmdir(dir);
+	g_free(daemon_argv[3]);
+	g_free(uri);
+	g_free(address);
+	g_free(bus);
+	g_free(dir);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+	g_setenv("PERFKIT_CONNECTIONS_DIR", PERFKIT_CONNECTIONS_DIR, FALSE);
+	g_setenv("PERFKIT_PLUGINS_PATH", PERFKIT_PLUGINS_PATH, FALSE);
+
+	g_thread_init(NULL);
+	g_type_init();
+	g_test_init(&argc, &argv, NULL);
+
+	/*
+	 * The in-process agent warns about files in the plugin directory that
+	 * are not agent plugins, such as the connection modules.
+	 */
+	g_log_set_always_fatal(G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
+
+	g_test_add_func("/PkRelay/dbus_unix_path",
+	                test_PkRelay_dbus_unix_path);
+
+	return g_test_run();
+}
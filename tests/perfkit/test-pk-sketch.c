@@ -0,0 +1,70 @@
+#include <perfkit/perfkit.h>
+
+static void
+assert_accurate (gdouble estimate,
+                 gdouble expected)
+{
+	g_assert_cmpfloat(ABS(estimate - expected), <=,
+	                  ABS(expected) * PK_SKETCH_DEFAULT_ACCURACY);
+}
+
+static void
+test_PkSketch_quantile (void)
+{
+	PkSketch *sketch;
+	gint i;
+
+	sketch = pk_sketch_new(PK_SKETCH_DEFAULT_ACCURACY);
+	g_assert_cmpfloat(pk_sketch_get_quantile(sketch, 0.5), ==, 0.0);
+
+	for (i = 1; i <= 1000; i++) {
+		pk_sketch_add(sketch, i);
+	}
+	g_assert_cmpint(pk_sketch_get_count(sketch), ==, 1000);
+	assert_accurate(pk_sketch_get_quantile(sketch, 0.5), 500.0);
+	assert_accurate(pk_sketch_get_quantile(sketch, 0.99), 990.0);
+	assert_accurate(pk_sketch_get_quantile(sketch, 0.999), 999.0);
+	g_assert_cmpfloat(pk_sketch_get_quantile(sketch, 0.0), ==, 1.0);
+	g_assert_cmpfloat(pk_sketch_get_quantile(sketch, 1.0), ==, 1000.0);
+	pk_sketch_unref(sketch);
+}
+
+static void
+test_PkSketch_merge (void)
+{
+	PkSketch *low;
+	PkSketch *high;
+	gint i;
+
+	low = pk_sketch_new(PK_SKETCH_DEFAULT_ACCURACY);
+	high = pk_sketch_new(PK_SKETCH_DEFAULT_ACCURACY);
+	for (i = -500; i < 0; i++) {
+		pk_sketch_add(low, i);
+	}
+	for (i = 0; i < 500; i++) {
+		pk_sketch_add(high, i);
+	}
+
+	pk_sketch_merge(low, high);
+	g_assert_cmpint(pk_sketch_get_count(low), ==, 1000);
+	assert_accurate(pk_sketch_get_quantile(low, 0.25), -251.0);
+	assert_accurate(pk_sketch_get_quantile(low, 0.75), 249.0);
+	assert_accurate(pk_sketch_get_quantile(low, 0.0), -500.0);
+	assert_accurate(pk_sketch_get_quantile(low, 1.0), 499.0);
+
+	pk_sketch_unref(low);
+	pk_sketch_unref(high);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+	g_type_init();
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_func("/PkSketch/quantile",
+	                test_PkSketch_quantile);
+	g_test_add_func("/PkSketch/merge",
+	                test_PkSketch_merge);
+	return g_test_run();
+}